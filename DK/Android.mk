@@ -27,6 +27,7 @@ LOCAL_C_INCLUDES := \
 DKFOUNDATION_SRC := \
 	DKFoundation/DKAllocator.cpp \
 	DKFoundation/DKAllocatorChain.cpp \
+	DKFoundation/DKAtom.cpp \
 	DKFoundation/DKAtomicNumber32.cpp \
 	DKFoundation/DKAtomicNumber64.cpp \
 	DKFoundation/DKBuffer.cpp \
@@ -72,6 +73,7 @@ DKFRAMEWORK_SRC := \
 	DKFramework/DKAffineTransform3.cpp \
 	DKFramework/DKAnimation.cpp \
 	DKFramework/DKAnimationController.cpp \
+	DKFramework/DKAnimationPose.cpp \
 	DKFramework/DKApplication.cpp \
 	DKFramework/DKAudioListener.cpp \
 	DKFramework/DKAudioPlayer.cpp \
@@ -123,6 +125,7 @@ DKFRAMEWORK_SRC := \
 	DKFramework/DKQuaternion.cpp \
 	DKFramework/DKRect.cpp \
 	DKFramework/DKRenderer.cpp \
+	DKFramework/DKRenderQueue.cpp \
 	DKFramework/DKRenderState.cpp \
 	DKFramework/DKRenderTarget.cpp \
 	DKFramework/DKResource.cpp \
@@ -158,6 +161,7 @@ DKFRAMEWORK_SRC := \
 	DKFramework/DKVector4.cpp \
 	DKFramework/DKVertexBuffer.cpp \
 	DKFramework/DKVoxel32FileStorage.cpp \
+	DKFramework/DKVoxel32Mesher.cpp \
 	DKFramework/DKVoxel32SparseVolume.cpp \
 	DKFramework/DKVoxelIsosurfacePolygonizer.cpp \
 	DKFramework/DKVoxelPolygonizer.cpp \
@@ -17,11 +17,14 @@
 // unicode string
 #include "DKFoundation/DKString.h"
 #include "DKFoundation/DKStringU8.h"
+#include "DKFoundation/DKAtom.h"
 
 // data collections
 #include "DKFoundation/DKArray.h"
 #include "DKFoundation/DKBitArray.h"
 #include "DKFoundation/DKCircularQueue.h"
+#include "DKFoundation/DKHashMap.h"
+#include "DKFoundation/DKHashSet.h"
 #include "DKFoundation/DKList.h"
 #include "DKFoundation/DKMap.h"
 #include "DKFoundation/DKOrderedArray.h"
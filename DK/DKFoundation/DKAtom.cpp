@@ -0,0 +1,176 @@
+//
+//  File: DKAtom.cpp
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2015 Hongtae Kim. All rights reserved.
+//
+
+#include <atomic>
+#include "DKAtom.h"
+#include "DKMutex.h"
+#include "DKCriticalSection.h"
+
+namespace DKFoundation
+{
+	struct DKAtom::Entry
+	{
+		DKString string;
+		uint32_t hash;
+		uint32_t id;
+	};
+
+	namespace Private
+	{
+		namespace
+		{
+			// open addressing hash table (linear probing).
+			// slots are filled once and never cleared, readers can probe
+			// without lock. table is replaced with larger one when growing,
+			// old tables are not released because readers may still use it.
+			struct AtomBuckets
+			{
+				AtomBuckets(size_t cap) : capacity(cap)
+				{
+					slots = new std::atomic<const DKAtom::Entry*>[capacity];
+					for (size_t i = 0; i < capacity; ++i)
+						slots[i].store(NULL, std::memory_order_relaxed);
+				}
+				const DKAtom::Entry* Find(const DKString& str, uint32_t hash) const
+				{
+					const size_t mask = capacity - 1;
+					for (size_t i = hash & mask; ; i = (i + 1) & mask)
+					{
+						const DKAtom::Entry* e = slots[i].load(std::memory_order_acquire);
+						if (e == NULL)
+							return NULL;
+						if (e->hash == hash && e->string == str)
+							return e;
+					}
+				}
+				void Insert(const DKAtom::Entry* e)
+				{
+					const size_t mask = capacity - 1;
+					for (size_t i = e->hash & mask; ; i = (i + 1) & mask)
+					{
+						if (slots[i].load(std::memory_order_relaxed) == NULL)
+						{
+							slots[i].store(e, std::memory_order_release);
+							return;
+						}
+					}
+				}
+				const size_t capacity;	// power of two
+				std::atomic<const DKAtom::Entry*>* slots;
+			};
+
+			struct AtomTable
+			{
+				AtomTable(void) : buckets(new AtomBuckets(1024)), count(0) {}
+
+				const DKAtom::Entry* Find(const DKString& str) const
+				{
+					return buckets.load(std::memory_order_acquire)->Find(str, str.Hash());
+				}
+				const DKAtom::Entry* Register(const DKString& str)
+				{
+					const uint32_t hash = str.Hash();
+					const DKAtom::Entry* e = buckets.load(std::memory_order_acquire)->Find(str, hash);
+					if (e)
+						return e;
+
+					DKCriticalSection<DKMutex> guard(lock);
+					AtomBuckets* b = buckets.load(std::memory_order_relaxed);
+					e = b->Find(str, hash);		// registered by other thread.
+					if (e)
+						return e;
+
+					uint32_t n = count.load(std::memory_order_relaxed) + 1;
+					if (n * 2 > b->capacity)	// keep load factor below 0.5
+					{
+						AtomBuckets* b2 = new AtomBuckets(b->capacity * 2);
+						for (size_t i = 0; i < b->capacity; ++i)
+						{
+							const DKAtom::Entry* e2 = b->slots[i].load(std::memory_order_relaxed);
+							if (e2)
+								b2->Insert(e2);
+						}
+						buckets.store(b2, std::memory_order_release);
+						b = b2;
+					}
+					DKAtom::Entry* entry = new DKAtom::Entry();
+					entry->string = str;
+					entry->hash = hash;
+					entry->id = n;
+					b->Insert(entry);
+					count.store(n, std::memory_order_release);
+					return entry;
+				}
+
+				std::atomic<AtomBuckets*> buckets;
+				std::atomic<uint32_t> count;
+				DKMutex lock;
+			};
+
+			// table is not destroyed, atoms are valid until process terminated.
+			AtomTable& GlobalAtomTable(void)
+			{
+				static AtomTable* table = new AtomTable();
+				return *table;
+			}
+		}
+	}
+}
+
+using namespace DKFoundation;
+
+DKAtom::DKAtom(void)
+	: entry(NULL)
+{
+}
+
+DKAtom::DKAtom(const DKString& str)
+	: entry(NULL)
+{
+	if (str.Length() > 0)
+		entry = Private::GlobalAtomTable().Register(str);
+}
+
+DKAtom::DKAtom(const DKUniCharW* str)
+	: entry(NULL)
+{
+	if (str && str[0])
+		entry = Private::GlobalAtomTable().Register(DKString(str));
+}
+
+DKAtom::DKAtom(const DKUniChar8* str)
+	: entry(NULL)
+{
+	if (str && str[0])
+		entry = Private::GlobalAtomTable().Register(DKString(str));
+}
+
+DKAtom DKAtom::Find(const DKString& str)
+{
+	if (str.Length() > 0)
+		return DKAtom(Private::GlobalAtomTable().Find(str));
+	return DKAtom();
+}
+
+size_t DKAtom::NumberOfAtoms(void)
+{
+	return Private::GlobalAtomTable().count.load(std::memory_order_acquire);
+}
+
+uint32_t DKAtom::Id(void) const
+{
+	if (entry)
+		return entry->id;
+	return 0;
+}
+
+const DKString& DKAtom::String(void) const
+{
+	if (entry)
+		return entry->string;
+	return DKString::empty;
+}
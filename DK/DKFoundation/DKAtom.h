@@ -0,0 +1,73 @@
+//
+//  File: DKAtom.h
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2015 Hongtae Kim. All rights reserved.
+//
+
+#pragma once
+#include "../DKInclude.h"
+#include "DKString.h"
+#include "DKHashTable.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// DKAtom
+// interned string identifier.
+// Each distinct string is registered to global atom table once, and atoms
+// of same string share same entry. Comparing and hashing atoms are done
+// with integer id, without comparing characters.
+//
+// Looking up existing atom is lock-free, registering new string is
+// serialized. Registered strings are never removed from table.
+//
+// Note:
+//  Ordering of atoms (operator <) is ordering of registration, not ordering
+//  of strings. Use String() to sort atoms alphabetically.
+////////////////////////////////////////////////////////////////////////////////
+
+namespace DKFoundation
+{
+	class DKGL_API DKAtom
+	{
+	public:
+		struct Entry;
+
+		DKAtom(void);					// empty atom (id: 0)
+		DKAtom(const DKAtom& a) : entry(a.entry) {}
+		DKAtom(const DKString& str);	// register string if not exists.
+		DKAtom(const DKUniCharW* str);
+		DKAtom(const DKUniChar8* str);
+
+		// find atom of registered string, does not register new string.
+		// returns empty atom if string was not registered.
+		static DKAtom Find(const DKString& str);
+		// number of registered strings.
+		static size_t NumberOfAtoms(void);
+
+		uint32_t Id(void) const;
+		const DKString& String(void) const;
+		bool IsEmpty(void) const		{return entry == NULL;}
+
+		DKAtom& operator = (const DKAtom& a)				{entry = a.entry; return *this;}
+
+		bool operator == (const DKAtom& a) const			{return entry == a.entry;}
+		bool operator != (const DKAtom& a) const			{return entry != a.entry;}
+		bool operator < (const DKAtom& a) const				{return Id() < a.Id();}
+		bool operator > (const DKAtom& a) const				{return Id() > a.Id();}
+		bool operator <= (const DKAtom& a) const			{return Id() <= a.Id();}
+		bool operator >= (const DKAtom& a) const			{return Id() >= a.Id();}
+
+	private:
+		DKAtom(const Entry* e) : entry(e) {}
+		const Entry* entry;
+	};
+
+	// hash function for DKHashMap, DKHashSet.
+	template <> struct DKHashTableHasher<DKAtom>
+	{
+		uint32_t operator () (const DKAtom& a) const
+		{
+			return DKHashTableHasher<uint32_t>()(a.Id());
+		}
+	};
+}
@@ -99,78 +99,55 @@ namespace DKFoundation
 				return NULL;
 
 			CriticalSection guard(lock);
+			return AllocInternal();
+		}
 
-			if (cachedChunk && cachedChunk->occupied < MaxUnitsPerChunk)
-			{
-				uintptr_t ptr = AllocUnit(cachedChunk);
-				DKASSERT_MEM_DEBUG(ptr);
-				return reinterpret_cast<void*>(ptr);
-			}
-			// find unoccupied unit from each chunks.
-			for (size_t i = 0; i < numChunks; ++i)
+		// allocate multiple units with single lock. returns number of units allocated.
+		size_t AllocBatch(void** units, size_t count)
+		{
+			size_t n = 0;
+			if (count > 0)
 			{
-				if (chunkTable[i].occupied < MaxUnitsPerChunk)
+				CriticalSection guard(lock);
+				while (n < count)
 				{
-					cachedChunk = &chunkTable[i];
-					uintptr_t ptr = AllocUnit(cachedChunk);
-					DKASSERT_MEM_DEBUG(ptr);
-					return reinterpret_cast<void*>(ptr);
+					void* p = AllocInternal();
+					if (p == NULL)
+						break;
+					units[n++] = p;
 				}
 			}
-			// no space, create new chunk.
-			cachedChunk = NULL;
-			if (numChunks > 0)
-			{
-				ChunkInfo* table = (ChunkInfo*)BaseAllocator::Realloc(chunkTable, sizeof(ChunkInfo) * (numChunks + 1));
-				if (table == NULL) // out of memory!
-					return NULL;
-				chunkTable = table;
-
-				ChunkInfo chunk;
-				if (!AllocChunk(&chunk))
-					return NULL;	// out of memory!
-
-				uintptr_t pos = reinterpret_cast<uintptr_t>(
-															std::upper_bound(&chunkTable[0], &chunkTable[numChunks], chunk.address,
-																			 [](uintptr_t lhs, const ChunkInfo& rhs)
-																			 {
-																				 return lhs < rhs.address;
-																			 }));
-				size_t chunkIndex = (pos - reinterpret_cast<uintptr_t>(&chunkTable[0])) / sizeof(ChunkInfo);
+			return n;
+		}
 
-				if (chunkIndex < numChunks)
-				{
-#if 1
-					memmove(&chunkTable[chunkIndex + 1], &chunkTable[chunkIndex], sizeof(ChunkInfo) * (numChunks - chunkIndex));
-#else
-					for (size_t i = numChunks; i > chunkIndex; --i)
-						chunkTable[i] = chunkTable[i-1];
-#endif
-				}
-				chunkTable[chunkIndex] = chunk;
-				cachedChunk = &chunkTable[chunkIndex];
-			}
-			else
+		// deallocate multiple units with single lock, purge empty chunks if number
+		// of unoccupied units exceeds threshold. returns number of units deallocated.
+		size_t ConditionalDeallocBatchAndPurge(void** units, size_t count, size_t threshold, size_t* bytesPurged)
+		{
+			size_t n = 0;
+			if (count > 0)
 			{
-				chunkTable = (ChunkInfo*)BaseAllocator::Alloc(sizeof(ChunkInfo) * (numChunks + 1));
-				if (chunkTable == NULL)
-					return NULL; // out of memory!
-
-				cachedChunk = &chunkTable[numChunks];
-				if (!AllocChunk(cachedChunk)) // out of memory!
+				CriticalSection guard(lock);
+				if (numChunks > 0)
 				{
-					BaseAllocator::Free(chunkTable);
-					chunkTable = NULL;
-					cachedChunk = NULL;
-					return NULL;
+					for (size_t i = 0; i < count; ++i)
+					{
+						if (FindChunkAndDealloc(reinterpret_cast<uintptr_t>(units[i])))
+							n++;
+					}
+					if (this->emptyChunks > 0)
+					{
+						if ((this->numChunks * MaxUnitsPerChunk) >=
+							(this->numAllocated + threshold + MaxUnitsPerChunk))
+						{
+							size_t purged = PurgeInternal();
+							if (bytesPurged)
+								*bytesPurged = purged;
+						}
+					}
 				}
 			}
-			DKASSERT_MEM_DEBUG(cachedChunk);
-			numChunks++;
-
-			uintptr_t ptr = AllocUnit(cachedChunk);
-			DKASSERT_MEM_DEBUG(ptr);
-			return reinterpret_cast<void*>(ptr);
+			return n;
 		}
 
 		void Dealloc(void* ptr)
@@ -341,6 +318,80 @@ namespace DKFoundation
 		DKFixedSizeAllocator& operator = (const DKFixedSizeAllocator&) = delete;
 
 	private:
+		FORCEINLINE void* AllocInternal(void)
+		{
+			if (cachedChunk && cachedChunk->occupied < MaxUnitsPerChunk)
+			{
+				uintptr_t ptr = AllocUnit(cachedChunk);
+				DKASSERT_MEM_DEBUG(ptr);
+				return reinterpret_cast<void*>(ptr);
+			}
+			// find unoccupied unit from each chunks.
+			for (size_t i = 0; i < numChunks; ++i)
+			{
+				if (chunkTable[i].occupied < MaxUnitsPerChunk)
+				{
+					cachedChunk = &chunkTable[i];
+					uintptr_t ptr = AllocUnit(cachedChunk);
+					DKASSERT_MEM_DEBUG(ptr);
+					return reinterpret_cast<void*>(ptr);
+				}
+			}
+			// no space, create new chunk.
+			cachedChunk = NULL;
+			if (numChunks > 0)
+			{
+				ChunkInfo* table = (ChunkInfo*)BaseAllocator::Realloc(chunkTable, sizeof(ChunkInfo) * (numChunks + 1));
+				if (table == NULL) // out of memory!
+					return NULL;
+				chunkTable = table;
+
+				ChunkInfo chunk;
+				if (!AllocChunk(&chunk))
+					return NULL;	// out of memory!
+
+				uintptr_t pos = reinterpret_cast<uintptr_t>(
+															std::upper_bound(&chunkTable[0], &chunkTable[numChunks], chunk.address,
+																			 [](uintptr_t lhs, const ChunkInfo& rhs)
+																			 {
+																				 return lhs < rhs.address;
+																			 }));
+				size_t chunkIndex = (pos - reinterpret_cast<uintptr_t>(&chunkTable[0])) / sizeof(ChunkInfo);
+
+				if (chunkIndex < numChunks)
+				{
+#if 1
+					memmove(&chunkTable[chunkIndex + 1], &chunkTable[chunkIndex], sizeof(ChunkInfo) * (numChunks - chunkIndex));
+#else
+					for (size_t i = numChunks; i > chunkIndex; --i)
+						chunkTable[i] = chunkTable[i-1];
+#endif
+				}
+				chunkTable[chunkIndex] = chunk;
+				cachedChunk = &chunkTable[chunkIndex];
+			}
+			else
+			{
+				chunkTable = (ChunkInfo*)BaseAllocator::Alloc(sizeof(ChunkInfo) * (numChunks + 1));
+				if (chunkTable == NULL)
+					return NULL; // out of memory!
+
+				cachedChunk = &chunkTable[numChunks];
+				if (!AllocChunk(cachedChunk)) // out of memory!
+				{
+					BaseAllocator::Free(chunkTable);
+					chunkTable = NULL;
+					cachedChunk = NULL;
+					return NULL;
+				}
+			}
+			DKASSERT_MEM_DEBUG(cachedChunk);
+			numChunks++;
+
+			uintptr_t ptr = AllocUnit(cachedChunk);
+			DKASSERT_MEM_DEBUG(ptr);
+			return reinterpret_cast<void*>(ptr);
+		}
 		FORCEINLINE bool AllocChunk(ChunkInfo* info)
 		{
 			uintptr_t ptr = reinterpret_cast<uintptr_t>(UnitAllocator::Alloc(AlignedChunkSize));
@@ -10,6 +10,8 @@
 #include "DKObject.h"
 #include "DKEndianness.h"
 #include "DKString.h"
+#include "DKUuid.h"
+#include "DKHashTable.h"
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -17,6 +19,9 @@
 // following hash digest algorithms are supported.
 // CRC32, MD5, SHA1, SHA2, SHA-224, SHA-256, SHA-384, SHA-512
 //
+// DKHashTableHasher specializations for DKStringW, DKStringU8, DKUuid are
+// defined here. (used by DKHashMap, DKHashSet)
+//
 ////////////////////////////////////////////////////////////////////////////////
 
 namespace DKFoundation
@@ -155,4 +160,27 @@ namespace DKFoundation
 		DKHash512(void) : DKHash(Type512) {}
 		DKHashResult512 Result(void) const;
 	};
+
+	// hash functions for DKHashMap, DKHashSet.
+	template <> struct DKHashTableHasher<DKStringW>
+	{
+		uint32_t operator () (const DKStringW& str) const
+		{
+			return str.Hash();	// cached in string object.
+		}
+	};
+	template <> struct DKHashTableHasher<DKStringU8>
+	{
+		uint32_t operator () (const DKStringU8& str) const
+		{
+			return DKHashCRC32((const DKUniChar8*)str, str.Bytes()).digest[0];
+		}
+	};
+	template <> struct DKHashTableHasher<DKUuid>
+	{
+		uint32_t operator () (const DKUuid& uuid) const
+		{
+			return DKHashCRC32(&uuid, sizeof(DKUuid)).digest[0];
+		}
+	};
 }
@@ -0,0 +1,399 @@
+//
+//  File: DKHashMap.h
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2015 Hongtae Kim. All rights reserved.
+//
+
+#pragma once
+#include <initializer_list>
+#include "../DKInclude.h"
+#include "DKHashTable.h"
+#include "DKHash.h"
+#include "DKMap.h"
+#include "DKDummyLock.h"
+#include "DKCriticalSection.h"
+#include "DKTypeTraits.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// DKHashMap
+// unordered associative container (using DKHashTable internally).
+// interface is same as DKMap, you can replace DKMap with DKHashMap
+// if you don't need ordered enumeration.
+//
+// Insert: insert value if key is not exists.
+// Update: set value for key whether key is exists or not.
+//
+// insertion, deletion, lookup is thread-safe.
+// If you need to modify value directly, you should have lock object.
+//
+// KeyHasher should return 32bit hash value (uint32_t) of key.
+// default hasher supports integer, enum, pointer types.
+// DKString, DKUuid hashers are defined in DKHash.h
+//
+// Note:
+//  Unlike DKMap, Pair's address can be changed when inserting or removing
+//  items. You should not keep Pair pointer after lock released.
+//  Enumeration order is not defined.
+//
+// Example:
+//	{
+//		typename MyMapType::CriticalSection section(map.lock);	// lock with critical-section
+//		MyMapType::Pair* p = map.Find(something);
+//		.... // do something with p
+//	}	// auto-unlock by critical-section end
+//
+////////////////////////////////////////////////////////////////////////////////
+
+namespace DKFoundation
+{
+	template <
+		typename Key,											// key type
+		typename ValueT,										// value type
+		typename Lock = DKDummyLock,							// lock
+		typename KeyHasher = DKHashTableHasher<Key>,			// key hash
+		typename KeyEqual = DKHashTableEqual<Key>,				// key equality
+		typename ValueReplacer = DKMapValueReplacer<ValueT>,	// copy value
+		typename Allocator = DKMemoryDefaultAllocator			// memory allocator
+	>
+	class DKHashMap
+	{
+	public:
+		typedef DKMapPair<const Key, ValueT>	Pair;
+		typedef DKCriticalSection<Lock>			CriticalSection;
+		typedef DKTypeTraits<Key>				KeyTraits;
+		typedef DKTypeTraits<ValueT>			ValueTraits;
+
+		struct PairValueReplacer
+		{
+			void operator () (Pair& dst, const Pair& src) const
+			{
+				replacer(dst.value, src.value);
+			}
+			ValueReplacer replacer;
+		};
+		typedef DKHashTable<Pair, Allocator> Container;
+
+		KeyHasher hasher;
+		KeyEqual equal;
+
+		// lock is public. to provde lock object from outside!
+		// FindNoLock, CountNoLock is usable regardless of locking.
+		Lock	lock;
+
+		DKHashMap(void)
+		{
+		}
+		DKHashMap(DKHashMap&& m)
+			: hasher(static_cast<KeyHasher&&>(m.hasher))
+			, equal(static_cast<KeyEqual&&>(m.equal))
+			, container(static_cast<Container&&>(m.container))
+		{
+		}
+		DKHashMap(const DKHashMap& m)
+		{
+			CriticalSection guard(m.lock);
+			container = m.container;
+			hasher = m.hasher;
+			equal = m.equal;
+		}
+		DKHashMap(std::initializer_list<Pair> il)
+		{
+			container.Reserve(il.size());
+			for (const Pair& p : il)
+				InsertNoLock(p);
+		}
+		~DKHashMap(void)
+		{
+			Clear();
+		}
+		// Update: overwrite value if key is exists, or insert item.
+		void Update(const Pair& p)
+		{
+			CriticalSection guard(lock);
+			UpdateNoLock(p);
+		}
+		void Update(const Key& k, const ValueT& v)
+		{
+			Update(Pair(k,v));
+		}
+		void Update(const Pair* p, size_t size)
+		{
+			CriticalSection guard(lock);
+			container.Reserve(container.Count() + size);
+			for (size_t i = 0; i < size; i++)
+				UpdateNoLock(p[i]);
+		}
+		template <typename ...Args> void Update(const DKHashMap<Key, ValueT, Args...>& m)
+		{
+			CriticalSection guard(lock);
+			m.EnumerateForward([this](const typename DKHashMap<Key, ValueT, Args...>::Pair& pair)
+			{
+				UpdateNoLock(pair);
+			});
+		}
+		void Update(std::initializer_list<Pair> il)
+		{
+			CriticalSection guard(lock);
+			for (const Pair& p : il)
+				UpdateNoLock(p);
+		}
+		// Insert: insert item if key is not exist, fails otherwise.
+		bool Insert(const Pair& p)
+		{
+			CriticalSection guard(lock);
+			return InsertNoLock(p) != NULL;
+		}
+		bool Insert(const Key& k, const ValueT& v)
+		{
+			return Insert(Pair(k, v));
+		}
+		size_t Insert(const Pair* p, size_t size)
+		{
+			size_t ret = 0;
+			CriticalSection guard(lock);
+			container.Reserve(container.Count() + size);
+			for (size_t i = 0; i < size; i++)
+				if (InsertNoLock(p[i]))
+					ret++;
+			return ret;
+		}
+		template <typename ...Args> size_t Insert(const DKHashMap<Key, ValueT, Args...>& m)
+		{
+			size_t n = 0;
+			CriticalSection guard(lock);
+			m.EnumerateForward([this, &n](const typename DKHashMap<Key, ValueT, Args...>::Pair& pair)
+			{
+				if (InsertNoLock(pair) != NULL)
+					n++;
+			});
+			return n;
+		}
+		size_t Insert(std::initializer_list<Pair> il)
+		{
+			size_t n = 0;
+			CriticalSection guard(lock);
+			for (const Pair& p : il)
+			{
+				if (InsertNoLock(p) != NULL)
+					n++;
+			}
+			return n;
+		}
+		void Remove(const Key& k)
+		{
+			CriticalSection guard(lock);
+			RemoveNoLock(k);
+		}
+		void Remove(std::initializer_list<Key> il)
+		{
+			CriticalSection guard(lock);
+			for (const Key& k : il)
+				RemoveNoLock(k);
+		}
+		void Clear(void)
+		{
+			CriticalSection guard(lock);
+			container.Clear();
+		}
+		// reserve storage for n items, to avoid rehashing.
+		void Reserve(size_t n)
+		{
+			CriticalSection guard(lock);
+			container.Reserve(n);
+		}
+		// release unused storage.
+		void Shrink(void)
+		{
+			CriticalSection guard(lock);
+			container.Shrink();
+		}
+		Pair* Find(const Key& k)
+		{
+			return const_cast<Pair*>(static_cast<const DKHashMap&>(*this).Find(k));
+		}
+		const Pair* Find(const Key& k) const
+		{
+			CriticalSection guard(lock);
+			return FindNoLock(k);
+		}
+		// Perform search operation without locking.
+		// useful if you have locked already in your context.
+		Pair* FindNoLock(const Key& k)
+		{
+			return const_cast<Pair*>(static_cast<const DKHashMap&>(*this).FindNoLock(k));
+		}
+		const Pair* FindNoLock(const Key& k) const
+		{
+			return container.Find(hasher(k), k, [this](const Pair& lhs, const Key& key)
+			{
+				return equal(lhs.key, key);
+			});
+		}
+		// if key 'k' is not exist, an new value inserted and returns.
+		ValueT& Value(const Key& k)
+		{
+			CriticalSection guard(lock);
+			Pair* p = FindNoLock(k);
+			if (p == NULL)
+				p = InsertNoLock(Pair(k, ValueT()));
+			return p->value;
+		}
+		bool IsEmpty(void) const
+		{
+			CriticalSection guard(lock);
+			return container.Count() == 0;
+		}
+		size_t Count(void) const
+		{
+			CriticalSection guard(lock);
+			return container.Count();
+		}
+		size_t CountNoLock(void) const
+		{
+			return container.Count();
+		}
+		DKHashMap& operator = (DKHashMap&& m)
+		{
+			if (this != &m)
+			{
+				CriticalSection guard(lock);
+				container = static_cast<Container&&>(m.container);
+				hasher = static_cast<KeyHasher&&>(m.hasher);
+				equal = static_cast<KeyEqual&&>(m.equal);
+			}
+			return *this;
+		}
+		DKHashMap& operator = (const DKHashMap& m)
+		{
+			if (this != &m)
+			{
+				CriticalSection guardOther(m.lock);
+				CriticalSection guardSelf(lock);
+
+				container = m.container;
+				hasher = m.hasher;
+				equal = m.equal;
+			}
+			return *this;
+		}
+		DKHashMap& operator = (std::initializer_list<Pair> il)
+		{
+			CriticalSection guard(lock);
+			container.Clear();
+			for (const Pair& p : il)
+				InsertNoLock(p);
+			return *this;
+		}
+		// EnumerateForward / EnumerateBackward: enumerate all items. (storage order)
+		// You cannot insert, remove items while enumerating. (container is read-only)
+		// enumerator can be lambda or any function type that can receive arguments (VALUE&) or (VALUE&, bool*)
+		// (VALUE&, bool*) type can cancel iteration by set boolean value to true.
+		template <typename T> void EnumerateForward(T&& enumerator)
+		{
+			using Func = typename DKFunctionType<T&&>::Signature;
+			enum {ValidatePType1 = Func::template CanInvokeWithParameterTypes<Pair&>()};
+			enum {ValidatePType2 = Func::template CanInvokeWithParameterTypes<Pair&, bool*>()};
+			static_assert(ValidatePType1 || ValidatePType2, "enumerator's parameter is not compatible with (VALUE&) or (VALUE&,bool*)");
+
+			EnumerateForward(std::forward<T>(enumerator), typename Func::ParameterNumber());
+		}
+		template <typename T> void EnumerateBackward(T&& enumerator)
+		{
+			using Func = typename DKFunctionType<T&&>::Signature;
+			enum {ValidatePType1 = Func::template CanInvokeWithParameterTypes<Pair&>()};
+			enum {ValidatePType2 = Func::template CanInvokeWithParameterTypes<Pair&, bool*>()};
+			static_assert(ValidatePType1 || ValidatePType2, "enumerator's parameter is not compatible with (VALUE&) or (VALUE&,bool*)");
+
+			EnumerateBackward(std::forward<T>(enumerator), typename Func::ParameterNumber());
+		}
+		// lambda enumerator (const VALUE&) or (const VALUE&, bool*) function type.
+		template <typename T> void EnumerateForward(T&& enumerator) const
+		{
+			using Func = typename DKFunctionType<T&&>::Signature;
+			enum {ValidatePType1 = Func::template CanInvokeWithParameterTypes<const Pair&>()};
+			enum {ValidatePType2 = Func::template CanInvokeWithParameterTypes<const Pair&, bool*>()};
+			static_assert(ValidatePType1 || ValidatePType2, "enumerator's parameter is not compatible with (const VALUE&) or (const VALUE&,bool*)");
+
+			EnumerateForward(std::forward<T>(enumerator), typename Func::ParameterNumber());
+		}
+		template <typename T> void EnumerateBackward(T&& enumerator) const
+		{
+			using Func = typename DKFunctionType<T&&>::Signature;
+			enum {ValidatePType1 = Func::template CanInvokeWithParameterTypes<const Pair&>()};
+			enum {ValidatePType2 = Func::template CanInvokeWithParameterTypes<const Pair&, bool*>()};
+			static_assert(ValidatePType1 || ValidatePType2, "enumerator's parameter is not compatible with (const VALUE&) or (const VALUE&,bool*)");
+
+			EnumerateBackward(std::forward<T>(enumerator), typename Func::ParameterNumber());
+		}
+
+	private:
+		Pair* InsertNoLock(const Pair& p)
+		{
+			return container.Insert(hasher(p.key), p, p.key, [this](const Pair& lhs, const Key& key)
+			{
+				return equal(lhs.key, key);
+			});
+		}
+		Pair* UpdateNoLock(const Pair& p)
+		{
+			return container.Update(hasher(p.key), p, p.key, [this](const Pair& lhs, const Key& key)
+			{
+				return equal(lhs.key, key);
+			}, PairValueReplacer());
+		}
+		bool RemoveNoLock(const Key& k)
+		{
+			return container.Remove(hasher(k), k, [this](const Pair& lhs, const Key& key)
+			{
+				return equal(lhs.key, key);
+			});
+		}
+		// lambda enumerator (VALUE&)
+		template <typename T> void EnumerateForward(T&& enumerator, DKNumber<1>)
+		{
+			CriticalSection guard(lock);
+			container.EnumerateForward([&enumerator](Pair& val, bool*) {enumerator(val);});
+		}
+		template <typename T> void EnumerateBackward(T&& enumerator, DKNumber<1>)
+		{
+			CriticalSection guard(lock);
+			container.EnumerateBackward([&enumerator](Pair& val, bool*) {enumerator(val);});
+		}
+		// lambda enumerator (const VALUE&)
+		template <typename T> void EnumerateForward(T&& enumerator, DKNumber<1>) const
+		{
+			CriticalSection guard(lock);
+			container.EnumerateForward([&enumerator](const Pair& val, bool*) {enumerator(val);});
+		}
+		template <typename T> void EnumerateBackward(T&& enumerator, DKNumber<1>) const
+		{
+			CriticalSection guard(lock);
+			container.EnumerateBackward([&enumerator](const Pair& val, bool*) {enumerator(val);});
+		}
+		// lambda enumerator (VALUE&, bool*)
+		template <typename T> void EnumerateForward(T&& enumerator, DKNumber<2>)
+		{
+			CriticalSection guard(lock);
+			container.EnumerateForward(enumerator);
+		}
+		template <typename T> void EnumerateBackward(T&& enumerator, DKNumber<2>)
+		{
+			CriticalSection guard(lock);
+			container.EnumerateBackward(enumerator);
+		}
+		// lambda enumerator (const VALUE&, bool*)
+		template <typename T> void EnumerateForward(T&& enumerator, DKNumber<2>) const
+		{
+			CriticalSection guard(lock);
+			container.EnumerateForward(enumerator);
+		}
+		template <typename T> void EnumerateBackward(T&& enumerator, DKNumber<2>) const
+		{
+			CriticalSection guard(lock);
+			container.EnumerateBackward(enumerator);
+		}
+
+		Container	container;
+	};
+}
@@ -0,0 +1,405 @@
+//
+//  File: DKHashTable.h
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2015 Hongtae Kim. All rights reserved.
+//
+
+#pragma once
+#include <new>
+#include "../DKInclude.h"
+#include "DKTypeTraits.h"
+#include "DKFunction.h"
+#include "DKMemory.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// DKHashTable
+// open-addressing hash table template implementation.
+// using linear probing with backward-shift deletion. (no tombstones)
+//
+// hash values are stored in separated array, lookup compares hash values
+// first, and then compares items that have same hash value.
+// table capacity is always power of two, table grows when load factor
+// exceeds 3/4.
+//
+// Note:
+//  item's pointer will be changed when inserting, removing items.
+//  You should not save pointer of item.
+//
+//  This class is not thread-safe. You need to use synchronization object
+//  to serialize of access in multi-threaded environment.
+//  You can use DKHashMap, DKHashSet instead, they are thread safe.
+//
+//  Hash function should be provided by caller. (see DKHashMap, DKHashSet)
+//  Default hash functions of DKString, DKUuid are declared in DKHash.h
+////////////////////////////////////////////////////////////////////////////////
+
+namespace DKFoundation
+{
+	// default hash function for integers, enums and pointers.
+	template <typename Key> struct DKHashTableHasher
+	{
+		static_assert(std::is_integral<Key>::value || std::is_enum<Key>::value || std::is_pointer<Key>::value,
+					  "Hash function is not defined for Key type. You should provide your own hash function.");
+
+		FORCEINLINE uint32_t operator () (const Key& k) const
+		{
+			// 64bit finalizer of MurmurHash3
+			uint64_t x = (uint64_t)k;
+			x ^= x >> 33;
+			x *= 0xff51afd7ed558ccdULL;
+			x ^= x >> 33;
+			x *= 0xc4ceb9fe1a85ec53ULL;
+			x ^= x >> 33;
+			return (uint32_t)x;
+		}
+	};
+	template <typename Key> struct DKHashTableEqual
+	{
+		FORCEINLINE bool operator () (const Key& lhs, const Key& rhs) const
+		{
+			return lhs == rhs;
+		}
+	};
+
+	template <
+		typename Value,											// value-type
+		typename Allocator = DKMemoryDefaultAllocator			// memory allocator
+	>
+	class DKHashTable
+	{
+	public:
+		typedef uint32_t HashValue;
+		enum { MinimumCapacity = 16 };
+
+		DKHashTable(void)
+			: hashes(NULL), values(NULL), capacity(0), count(0)
+		{
+		}
+		DKHashTable(DKHashTable&& t)
+			: hashes(t.hashes), values(t.values), capacity(t.capacity), count(t.count)
+		{
+			t.hashes = NULL;
+			t.values = NULL;
+			t.capacity = 0;
+			t.count = 0;
+		}
+		DKHashTable(const DKHashTable& t)
+			: hashes(NULL), values(NULL), capacity(0), count(0)
+		{
+			CopyFrom(t);
+		}
+		~DKHashTable(void)
+		{
+			Clear();
+			Release();
+		}
+
+		// insert value if not exists. returns NULL if value exists already.
+		template <typename Key, typename Equal>
+		Value* Insert(HashValue hash, const Value& v, const Key& k, Equal&& equal)
+		{
+			hash = ValidHash(hash);
+			if (Lookup(hash, k, equal) != IndexNotFound)
+				return NULL;
+			return &values[InsertNew(hash, v)];
+		}
+		// insert value or replace existing value.
+		template <typename Key, typename Equal, typename Replacer>
+		Value* Update(HashValue hash, const Value& v, const Key& k, Equal&& equal, Replacer&& replacer)
+		{
+			hash = ValidHash(hash);
+			size_t index = Lookup(hash, k, equal);
+			if (index != IndexNotFound)
+			{
+				replacer(values[index], v);
+				return &values[index];
+			}
+			return &values[InsertNew(hash, v)];
+		}
+		template <typename Key, typename Equal>
+		const Value* Find(HashValue hash, const Key& k, Equal&& equal) const
+		{
+			size_t index = Lookup(ValidHash(hash), k, equal);
+			if (index != IndexNotFound)
+				return &values[index];
+			return NULL;
+		}
+		template <typename Key, typename Equal>
+		Value* Find(HashValue hash, const Key& k, Equal&& equal)
+		{
+			size_t index = Lookup(ValidHash(hash), k, equal);
+			if (index != IndexNotFound)
+				return &values[index];
+			return NULL;
+		}
+		template <typename Key, typename Equal>
+		bool Remove(HashValue hash, const Key& k, Equal&& equal)
+		{
+			size_t index = Lookup(ValidHash(hash), k, equal);
+			if (index != IndexNotFound)
+			{
+				RemoveAt(index);
+				return true;
+			}
+			return false;
+		}
+		// remove all values, capacity is not changed.
+		void Clear(void)
+		{
+			for (size_t i = 0; i < capacity && count > 0; ++i)
+			{
+				if (hashes[i])
+				{
+					values[i].~Value();
+					hashes[i] = 0;
+					count--;
+				}
+			}
+			DKASSERT_DEBUG(count == 0);
+		}
+		// reserve table to store n values without rehash.
+		void Reserve(size_t n)
+		{
+			size_t cap = MinimumCapacity;
+			while (cap - (cap >> 2) < n)
+				cap = cap << 1;
+			if (cap > capacity)
+				Rehash(cap);
+		}
+		// shrink table to fit current count.
+		void Shrink(void)
+		{
+			if (count == 0)
+			{
+				Release();
+			}
+			else
+			{
+				size_t cap = MinimumCapacity;
+				while (cap - (cap >> 2) < count)
+					cap = cap << 1;
+				if (cap < capacity)
+					Rehash(cap);
+			}
+		}
+		size_t Count(void) const			{ return count; }
+		size_t Capacity(void) const			{ return capacity; }
+
+		DKHashTable& operator = (DKHashTable&& t)
+		{
+			if (this != &t)
+			{
+				Clear();
+				Release();
+				hashes = t.hashes;
+				values = t.values;
+				capacity = t.capacity;
+				count = t.count;
+				t.hashes = NULL;
+				t.values = NULL;
+				t.capacity = 0;
+				t.count = 0;
+			}
+			return *this;
+		}
+		DKHashTable& operator = (const DKHashTable& t)
+		{
+			if (this != &t)
+			{
+				Clear();
+				CopyFrom(t);
+			}
+			return *this;
+		}
+
+		// enumerate all values. (storage order)
+		// enumerator should be (VALUE&, bool*) type.
+		template <typename T> void EnumerateForward(T&& enumerator)
+		{
+			bool stop = false;
+			for (size_t i = 0; i < capacity && !stop; ++i)
+			{
+				if (hashes[i])
+					enumerator(values[i], &stop);
+			}
+		}
+		template <typename T> void EnumerateBackward(T&& enumerator)
+		{
+			bool stop = false;
+			for (size_t i = capacity; i > 0 && !stop; --i)
+			{
+				if (hashes[i-1])
+					enumerator(values[i-1], &stop);
+			}
+		}
+		template <typename T> void EnumerateForward(T&& enumerator) const
+		{
+			bool stop = false;
+			for (size_t i = 0; i < capacity && !stop; ++i)
+			{
+				if (hashes[i])
+					enumerator(static_cast<const Value&>(values[i]), &stop);
+			}
+		}
+		template <typename T> void EnumerateBackward(T&& enumerator) const
+		{
+			bool stop = false;
+			for (size_t i = capacity; i > 0 && !stop; --i)
+			{
+				if (hashes[i-1])
+					enumerator(static_cast<const Value&>(values[i-1]), &stop);
+			}
+		}
+
+	private:
+		enum : size_t { IndexNotFound = (size_t)-1 };
+
+		// zero is reserved for empty slot.
+		FORCEINLINE static HashValue ValidHash(HashValue h)
+		{
+			return h ? h : 1;
+		}
+		template <typename Key, typename Equal>
+		FORCEINLINE size_t Lookup(HashValue hash, const Key& k, Equal& equal) const
+		{
+			if (count > 0)
+			{
+				const size_t mask = capacity - 1;
+				for (size_t i = hash & mask; hashes[i]; i = (i + 1) & mask)
+				{
+					if (hashes[i] == hash && equal(values[i], k))
+						return i;
+				}
+			}
+			return IndexNotFound;
+		}
+		size_t InsertNew(HashValue hash, const Value& v)
+		{
+			if (capacity == 0 || (count + 1) > capacity - (capacity >> 2))
+				Rehash(capacity > 0 ? capacity << 1 : (size_t)MinimumCapacity);
+
+			const size_t mask = capacity - 1;
+			size_t i = hash & mask;
+			while (hashes[i])
+				i = (i + 1) & mask;
+			new(&values[i]) Value(v);
+			hashes[i] = hash;
+			count++;
+			return i;
+		}
+		void RemoveAt(size_t index)
+		{
+			const size_t mask = capacity - 1;
+			values[index].~Value();
+			hashes[index] = 0;
+			count--;
+
+			// backward-shift following values to fill the gap.
+			size_t i = index;
+			for (size_t j = (i + 1) & mask; hashes[j]; j = (j + 1) & mask)
+			{
+				size_t k = hashes[j] & mask;	// ideal position of j
+				bool shift = (i <= j) ? (k <= i || k > j) : (k <= i && k > j);
+				if (shift)
+				{
+					new(&values[i]) Value(static_cast<Value&&>(values[j]));
+					hashes[i] = hashes[j];
+					values[j].~Value();
+					hashes[j] = 0;
+					i = j;
+				}
+			}
+		}
+		void Rehash(size_t cap)
+		{
+			DKASSERT_DEBUG((cap & (cap - 1)) == 0);
+			DKASSERT_DEBUG(cap - (cap >> 2) >= count);
+
+			HashValue* oldHashes = hashes;
+			Value* oldValues = values;
+			size_t oldCapacity = capacity;
+
+			hashes = (HashValue*)Allocator::Alloc(sizeof(HashValue) * cap);
+			values = (Value*)Allocator::Alloc(sizeof(Value) * cap);
+			if (hashes == NULL || values == NULL)
+			{
+				if (hashes)
+					Allocator::Free(hashes);
+				if (values)
+					Allocator::Free(values);
+				hashes = oldHashes;
+				values = oldValues;
+				throw std::bad_alloc();
+			}
+			memset(hashes, 0, sizeof(HashValue) * cap);
+			capacity = cap;
+
+			const size_t mask = capacity - 1;
+			for (size_t n = 0; n < oldCapacity; ++n)
+			{
+				if (oldHashes[n])
+				{
+					size_t i = oldHashes[n] & mask;
+					while (hashes[i])
+						i = (i + 1) & mask;
+					new(&values[i]) Value(static_cast<Value&&>(oldValues[n]));
+					hashes[i] = oldHashes[n];
+					oldValues[n].~Value();
+				}
+			}
+			if (oldCapacity > 0)
+			{
+				Allocator::Free(oldHashes);
+				Allocator::Free(oldValues);
+			}
+		}
+		void Release(void)
+		{
+			DKASSERT_DEBUG(count == 0);
+			if (capacity > 0)
+			{
+				Allocator::Free(hashes);
+				Allocator::Free(values);
+			}
+			hashes = NULL;
+			values = NULL;
+			capacity = 0;
+		}
+		void CopyFrom(const DKHashTable& t)
+		{
+			DKASSERT_DEBUG(count == 0);
+			if (t.count > 0)
+			{
+				if (capacity < t.capacity)
+					Rehash(t.capacity);
+
+				if (capacity == t.capacity)
+				{
+					for (size_t i = 0; i < t.capacity; ++i)
+					{
+						if (t.hashes[i])
+						{
+							new(&values[i]) Value(t.values[i]);
+							hashes[i] = t.hashes[i];
+							count++;
+						}
+					}
+				}
+				else
+				{
+					for (size_t i = 0; i < t.capacity; ++i)
+					{
+						if (t.hashes[i])
+							InsertNew(t.hashes[i], t.values[i]);
+					}
+				}
+			}
+		}
+
+		HashValue*	hashes;
+		Value*		values;
+		size_t		capacity;
+		size_t		count;
+	};
+}
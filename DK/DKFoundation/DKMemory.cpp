@@ -25,6 +25,7 @@
 #include <unistd.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
 #endif
 
 #include "DKMap.h"
@@ -36,7 +37,12 @@
 #include "DKUtils.h"
 #include "DKUuid.h"
 #include "DKFixedSizeAllocator.h"
+#include "DKAtomicNumber32.h"
 
+#ifndef DKGL_MEMORY_POOL_THREAD_CACHE
+// Set DKGL_MEMORY_POOL_THREAD_CACHE to 0 to disable thread-local cache of pool.
+#define DKGL_MEMORY_POOL_THREAD_CACHE	1
+#endif
 
 #define DKLog(...)	fprintf(stderr, __VA_ARGS__)
 
@@ -159,6 +165,7 @@ namespace DKFoundation
 				size_t addrIndex = FindAddress(reinterpret_cast<uintptr_t>(p));
 				DKASSERT_MEM_DEBUG(addrIndex < numIndexAddrs);
 				Index index = indexAddrs[addrIndex].index;
+				generation.Increment();
 				numIndexAddrs--;
 				if (numIndexAddrs > 0)
 				{
@@ -182,6 +189,26 @@ namespace DKFoundation
 					return indexAddrs[addrIndex].index;
 				return IndexNotFound;
 			}
+			// find index and chunk base address, with generation of address table.
+			// address-index pair is valid while generation is not changed.
+			Index IndexForAddress(void* p, uintptr_t* base, DKAtomicNumber32::Value* gen)
+			{
+				uintptr_t addr = reinterpret_cast<uintptr_t>(p);
+				ScopedLock guard(lock);
+				*gen = generation;
+				size_t addrIndex = FindAddress(addr);
+				if (addrIndex < numIndexAddrs && addr < indexAddrs[addrIndex].address + UnitSize)
+				{
+					*base = indexAddrs[addrIndex].address;
+					return indexAddrs[addrIndex].index;
+				}
+				return IndexNotFound;
+			}
+			// generation increases whenever chunk has been deallocated.
+			FORCEINLINE DKAtomicNumber32::Value Generation(void) const
+			{
+				return generation;
+			}
 			size_t PurgeThreshold(size_t threshold)
 			{
 				ScopedLock guard(lock);
@@ -261,6 +288,7 @@ namespace DKFoundation
 			using ScopedLock = DKCriticalSection<Lock>;
 			Lock			lock;
 			Allocator		allocator;
+			DKAtomicNumber32 generation;
 			IndexedAddress*	indexAddrs;
 			size_t			indexAddrsCapacity;
 			size_t			numIndexAddrs;
@@ -300,6 +328,9 @@ namespace DKFoundation
 			virtual size_t ConditionalPurge(size_t) = 0;
 			virtual bool ConditionalDeallocAndPurge(void*, size_t, size_t*) = 0;
 
+			virtual size_t AllocBatch(void**, size_t) = 0;
+			virtual size_t ConditionalDeallocBatchAndPurge(void**, size_t, size_t, size_t*) = 0;
+
 			virtual size_t NumberOfAllocatedUnits(void) const = 0;
 		};
 
@@ -342,6 +373,12 @@ namespace DKFoundation
 					return allocator.ConditionalDeallocAndPurge(p, s, bp);
 				}
 
+				size_t AllocBatch(void** p, size_t n) override		{ return allocator.AllocBatch(p, n); }
+				size_t ConditionalDeallocBatchAndPurge(void** p, size_t n, size_t s, size_t* bp) override
+				{
+					return allocator.ConditionalDeallocBatchAndPurge(p, n, s, bp);
+				}
+
 				size_t NumberOfAllocatedUnits(void) const override	{ return allocator.NumberOfAllocatedUnits(); }
 
 				using Allocator = DKFixedSizeAllocator<UnitSize, Alignment, NumUnits, DKSpinLock, SystemHeapAllocator, UnitAllocator>;
@@ -365,10 +402,50 @@ namespace DKFoundation
 			static int Init(AllocatorUnit*) { return 0; }
 		};
 
+		struct AllocatorPool;
+		AllocatorPool* GetAllocatorPool(void);
+
 		struct AllocatorPool : public DKAllocator
 		{
 			enum { NumAllocators = 136 };
 
+#if DKGL_MEMORY_POOL_THREAD_CACHE
+			// ThreadLocalCache : per-thread magazines of free units for each allocators.
+			//   Units are refilled from, returned to shared allocators in batch,
+			//   with single lock. Cache will be drained on thread exit.
+			struct ThreadLocalCache
+			{
+				enum { MagazineBytes = 8192 };	// max bytes of each magazine
+				enum { MaxMagazineUnits = 64 };
+				enum { MinMagazineUnits = 2 };
+				enum { ChunkIndexTableSize = 256 };
+
+				struct Magazine
+				{
+					void** units;
+					uint32_t count;
+					uint32_t capacity;
+				};
+				// cached index of backend chunk, valid while generation is not changed.
+				struct ChunkIndex
+				{
+					uintptr_t base;
+					BackendAllocator::Index index;
+				};
+
+				Magazine magazines[NumAllocators];
+				ChunkIndex chunkIndices[ChunkIndexTableSize];
+				DKAtomicNumber32::Value generation;
+
+				uint64_t hits;
+				uint64_t refills;
+				uint64_t flushes;
+
+				ThreadLocalCache* prev;
+				ThreadLocalCache* next;
+			};
+#endif
+
 			AllocatorPool(void) : backend(NULL)
 			{
 #ifdef _WIN32
@@ -404,10 +481,41 @@ namespace DKFoundation
 					  chunkSize);
 
 				maxUnitSize = allocators[NumAllocators-1].unitSize;
+
+#if DKGL_MEMORY_POOL_THREAD_CACHE
+				threadCaches = NULL;
+				retiredStats = {};
+#ifdef _WIN32
+				// use FLS instead of TLS, TLS has no destructor for thread exit.
+				tlsIndex = ::FlsAlloc(&AllocatorPool::ThreadCacheCallback);
+				threadCacheEnabled = (tlsIndex != FLS_OUT_OF_INDEXES);
+#else
+				threadCacheEnabled = pthread_key_create(&tlsKey, [](void* p)
+				{
+					GetAllocatorPool()->ReleaseThreadCache(reinterpret_cast<ThreadLocalCache*>(p));
+				}) == 0;
+#endif
+				if (!threadCacheEnabled)
+					DKLog("AllocatorPool: Thread-local cache disabled.\n");
+#endif
 			}
 
 			~AllocatorPool(void)
 			{
+#if DKGL_MEMORY_POOL_THREAD_CACHE
+				if (threadCacheEnabled)
+				{
+					threadCacheEnabled = false;
+					// drain caches of threads still alive.
+					while (threadCaches)
+						ReleaseThreadCache(threadCaches);
+#ifdef _WIN32
+					::FlsFree(tlsIndex);
+#else
+					pthread_key_delete(tlsKey);
+#endif
+				}
+#endif
 				bool cleanupHeap = true;
 				for (int i = 0; i < NumAllocators; ++i)
 				{
@@ -451,6 +559,26 @@ namespace DKFoundation
 				AllocatorUnit* unit = FindAllocatorForSize(s);
 				DKASSERT_MEM_DEBUG(unit != NULL);
 				DKASSERT_MEM_DEBUG(unit->unitSize >= s);
+#if DKGL_MEMORY_POOL_THREAD_CACHE
+				ThreadLocalCache* cache = ThreadCache();
+				if (cache)
+				{
+					ThreadLocalCache::Magazine& mag = cache->magazines[unit - allocators];
+					if (mag.count > 0)
+					{
+						cache->hits++;
+					}
+					else
+					{
+						// refill half of magazine.
+						mag.count = (uint32_t)unit->allocator->AllocBatch(mag.units, Max(mag.capacity / 2, 1U));
+						cache->refills++;
+						if (mag.count == 0)
+							return NULL;	// out of memory!
+					}
+					return mag.units[--mag.count];
+				}
+#endif
 				return unit->allocator->Alloc(s);
 			}
 
@@ -511,6 +639,23 @@ namespace DKFoundation
 			{
 				if (p)
 				{
+#if DKGL_MEMORY_POOL_THREAD_CACHE
+					ThreadLocalCache* cache = ThreadCache();
+					if (cache)
+					{
+						BackendAllocator::Index index = CachedIndexForAddress(cache, p);
+						if (index != BackendAllocator::IndexNotFound)
+						{
+							ThreadLocalCache::Magazine& mag = cache->magazines[index];
+							if (mag.count == mag.capacity)
+								FlushMagazine(cache, index, Max(mag.capacity / 2, 1U));
+							mag.units[mag.count++] = p;
+							return;
+						}
+						SystemLargeHeapAllocator::Free(p);
+						return;
+					}
+#endif
 					AllocatorUnit* unit = FindAllocator(p);
 					if (unit)
 					{
@@ -527,6 +672,21 @@ namespace DKFoundation
 
 			size_t Purge(void)
 			{
+#if DKGL_MEMORY_POOL_THREAD_CACHE
+				// return units cached by calling thread.
+				if (threadCacheEnabled)
+				{
+					ThreadLocalCache* cache = GetThreadLocalValue();
+					if (cache)
+					{
+						for (int i = 0; i < NumAllocators; ++i)
+						{
+							if (cache->magazines[i].count > 0)
+								FlushMagazine(cache, i, cache->magazines[i].count);
+						}
+					}
+				}
+#endif
 				size_t bytesPurged = 0;
 				for (int i = 0; i < NumAllocators; ++i)
 				{
@@ -554,7 +714,198 @@ namespace DKFoundation
 				return backend;
 			}
 
+			void GetStatistics(DKMemoryPoolStatistics* stats)
+			{
+				DKMemoryPoolStatistics st = {};
+#if DKGL_MEMORY_POOL_THREAD_CACHE
+				DKCriticalSection<DKSpinLock> guard(threadCacheLock);
+				st = retiredStats;
+				for (ThreadLocalCache* cache = threadCaches; cache; cache = cache->next)
+				{
+					// values of other threads are approximate.
+					st.threadCaches++;
+					st.cacheHits += cache->hits;
+					st.cacheRefills += cache->refills;
+					st.cacheFlushes += cache->flushes;
+					for (int i = 0; i < NumAllocators; ++i)
+					{
+						size_t count = cache->magazines[i].count;
+						st.cachedUnits += count;
+						st.cachedBytes += count * allocators[i].unitSize;
+					}
+				}
+#endif
+				*stats = st;
+			}
+
+#if DKGL_MEMORY_POOL_THREAD_CACHE
+			// drain cache and remove. (called on thread exit)
+			void ReleaseThreadCache(ThreadLocalCache* cache)
+			{
+				if (cache)
+				{
+					for (int i = 0; i < NumAllocators; ++i)
+					{
+						if (cache->magazines[i].count > 0)
+							FlushMagazine(cache, i, cache->magazines[i].count);
+					}
+
+					DKCriticalSection<DKSpinLock> guard(threadCacheLock);
+					if (cache->prev)
+						cache->prev->next = cache->next;
+					else
+						threadCaches = cache->next;
+					if (cache->next)
+						cache->next->prev = cache->prev;
+
+					retiredStats.cacheHits += cache->hits;
+					retiredStats.cacheRefills += cache->refills;
+					retiredStats.cacheFlushes += cache->flushes;
+
+					cache->~ThreadLocalCache();
+					SystemHeapAllocator::Free(cache);
+				}
+			}
+			void ReleaseCurrentThreadCache(void)
+			{
+				if (threadCacheEnabled)
+				{
+					ThreadLocalCache* cache = GetThreadLocalValue();
+					if (cache)
+					{
+						SetThreadLocalValue(NULL);
+						ReleaseThreadCache(cache);
+					}
+				}
+			}
+#endif
+
 		private:
+#if DKGL_MEMORY_POOL_THREAD_CACHE
+#ifdef _WIN32
+			// FLS callback, called on thread exit (including threads not created
+			// by DKThread) and FlsFree. caches are drained already if disabled.
+			static void WINAPI ThreadCacheCallback(PVOID p)
+			{
+				AllocatorPool* pool = GetAllocatorPool();
+				if (pool->threadCacheEnabled)
+					pool->ReleaseThreadCache(reinterpret_cast<ThreadLocalCache*>(p));
+			}
+#endif
+			FORCEINLINE ThreadLocalCache* GetThreadLocalValue(void) const
+			{
+#ifdef _WIN32
+				return reinterpret_cast<ThreadLocalCache*>(::FlsGetValue(tlsIndex));
+#else
+				return reinterpret_cast<ThreadLocalCache*>(pthread_getspecific(tlsKey));
+#endif
+			}
+			FORCEINLINE void SetThreadLocalValue(ThreadLocalCache* cache)
+			{
+#ifdef _WIN32
+				::FlsSetValue(tlsIndex, cache);
+#else
+				pthread_setspecific(tlsKey, cache);
+#endif
+			}
+			FORCEINLINE ThreadLocalCache* ThreadCache(void)
+			{
+				if (threadCacheEnabled)
+				{
+					ThreadLocalCache* cache = GetThreadLocalValue();
+					if (cache)
+						return cache;
+					return CreateThreadCache();
+				}
+				return NULL;
+			}
+			ThreadLocalCache* CreateThreadCache(void)
+			{
+				uint32_t capacities[NumAllocators];
+				size_t numUnits = 0;
+				for (int i = 0; i < NumAllocators; ++i)
+				{
+					size_t c = ThreadLocalCache::MagazineBytes / allocators[i].unitSize;
+					capacities[i] = (uint32_t)Clamp(c, (size_t)ThreadLocalCache::MinMagazineUnits, (size_t)ThreadLocalCache::MaxMagazineUnits);
+					numUnits += capacities[i];
+				}
+				// allocate cache and magazines at once.
+				void* p = SystemHeapAllocator::Alloc(sizeof(ThreadLocalCache) + sizeof(void*) * numUnits);
+				if (p == NULL)
+					return NULL;
+
+				ThreadLocalCache* cache = ::new(p) ThreadLocalCache();
+				void** units = reinterpret_cast<void**>(&cache[1]);
+				for (int i = 0; i < NumAllocators; ++i)
+				{
+					cache->magazines[i].units = units;
+					cache->magazines[i].count = 0;
+					cache->magazines[i].capacity = capacities[i];
+					units += capacities[i];
+				}
+				memset(cache->chunkIndices, 0, sizeof(cache->chunkIndices));
+				cache->generation = backend->Generation();
+				cache->hits = 0;
+				cache->refills = 0;
+				cache->flushes = 0;
+				cache->prev = NULL;
+
+				DKCriticalSection<DKSpinLock> guard(threadCacheLock);
+				cache->next = threadCaches;
+				if (threadCaches)
+					threadCaches->prev = cache;
+				threadCaches = cache;
+
+				SetThreadLocalValue(cache);
+				return cache;
+			}
+			// find allocator index without backend lock, if possible.
+			FORCEINLINE BackendAllocator::Index CachedIndexForAddress(ThreadLocalCache* cache, void* p)
+			{
+				DKAtomicNumber32::Value gen = backend->Generation();
+				if (cache->generation != gen)
+				{
+					// chunk has been deallocated, cached indices are no longer valid.
+					memset(cache->chunkIndices, 0, sizeof(cache->chunkIndices));
+					cache->generation = gen;
+				}
+				uintptr_t addr = reinterpret_cast<uintptr_t>(p);
+				// chunk is not aligned, check key of address and previous one.
+				uintptr_t key = addr / BackendAllocator::UnitSize;
+				for (uintptr_t k : { key, key - 1 })
+				{
+					ThreadLocalCache::ChunkIndex& ci = cache->chunkIndices[k % ThreadLocalCache::ChunkIndexTableSize];
+					if (ci.base && ci.base <= addr && addr < ci.base + BackendAllocator::UnitSize)
+						return ci.index;
+				}
+				uintptr_t base;
+				BackendAllocator::Index index = backend->IndexForAddress(p, &base, &gen);
+				if (index != BackendAllocator::IndexNotFound && gen == cache->generation)
+				{
+					ThreadLocalCache::ChunkIndex& ci = cache->chunkIndices[(base / BackendAllocator::UnitSize) % ThreadLocalCache::ChunkIndexTableSize];
+					ci.base = base;
+					ci.index = index;
+				}
+				return index;
+			}
+			// return oldest units of magazine to shared allocator.
+			void FlushMagazine(ThreadLocalCache* cache, int index, uint32_t count)
+			{
+				ThreadLocalCache::Magazine& mag = cache->magazines[index];
+				DKASSERT_MEM_DEBUG(count <= mag.count);
+				size_t purged = 0;
+				size_t n = allocators[index].allocator->ConditionalDeallocBatchAndPurge(mag.units, count, 0, &purged);
+				DKASSERT_MEM_DEBUG(n == count);
+				(void)n;
+				if (count < mag.count)
+					memmove(&mag.units[0], &mag.units[count], sizeof(void*) * (mag.count - count));
+				mag.count -= count;
+				cache->flushes++;
+				if (purged > 0)
+					backend->PurgeThreshold(16);
+			}
+#endif
+
 			FORCEINLINE bool DeallocAndPurge(AllocatorUnit* unit, void* p)
 			{
 				DKASSERT_MEM_DEBUG(unit);
@@ -602,6 +953,18 @@ namespace DKFoundation
 			BackendAllocator* backend;
 			AllocatorUnit allocators[NumAllocators];
 			size_t maxUnitSize;
+
+#if DKGL_MEMORY_POOL_THREAD_CACHE
+			bool threadCacheEnabled;
+#ifdef _WIN32
+			DWORD tlsIndex;
+#else
+			pthread_key_t tlsKey;
+#endif
+			DKSpinLock threadCacheLock;
+			ThreadLocalCache* threadCaches;
+			DKMemoryPoolStatistics retiredStats;
+#endif
 		};
 
 		AllocatorPool* GetAllocatorPool(void)
@@ -629,6 +992,14 @@ namespace DKFoundation
 			return GetAllocatorPool()->Backend();
 		}
 
+		// called by DKThread on thread exit.
+		void ReleaseThreadLocalPoolCache(void)
+		{
+#if DKGL_MEMORY_POOL_THREAD_CACHE
+			GetAllocatorPool()->ReleaseCurrentThreadCache();
+#endif
+		}
+
 		// VMSizeInfo : keep track VM-address, size pair.
 		struct VMSizeInfo
 		{
@@ -1280,4 +1651,12 @@ namespace DKFoundation
 	{
 		return GetAllocatorPool()->Size();
 	}
+
+	DKGL_API size_t DKMemoryPoolSize(DKMemoryPoolStatistics* stats)
+	{
+		AllocatorPool* pool = GetAllocatorPool();
+		if (stats)
+			pool->GetStatistics(stats);
+		return pool->Size();
+	}
 }
@@ -47,9 +47,23 @@ namespace DKFoundation
 	DKGL_API void* DKMemoryPoolRealloc(void*, size_t);
 	DKGL_API void  DKMemoryPoolFree(void*);
 	// Optional pool management functions.
+	// DKMemoryPoolPurge returns units cached by calling thread also.
 	DKGL_API size_t DKMemoryPoolPurge(void);
 	DKGL_API size_t DKMemoryPoolSize(void);
 
+	// Pool uses thread-local cache for each unit size, to reduce lock contention.
+	// values of thread-local cache are approximate. (counted without lock)
+	struct DKMemoryPoolStatistics
+	{
+		size_t threadCaches;	// number of active thread-local caches.
+		size_t cachedUnits;		// number of free units held by thread-local caches.
+		size_t cachedBytes;		// size of free units held by thread-local caches.
+		uint64_t cacheHits;		// allocations served by thread-local cache.
+		uint64_t cacheRefills;	// batch allocations from shared pool.
+		uint64_t cacheFlushes;	// batch deallocations to shared pool.
+	};
+	DKGL_API size_t DKMemoryPoolSize(DKMemoryPoolStatistics*);
+
 
 	enum DKMemoryLocation
 	{
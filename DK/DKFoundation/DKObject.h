@@ -66,6 +66,13 @@
 //     p = NULL; // destory p
 //     DKObject<OBJECT> p2 = ref;  // p2 = NULL (ref invalidated)
 //
+// Intrusive ref-counting:
+//   if OBJECT is derived from DKIntrusiveRefCounted, ref-count is stored in
+//   header of object and DKObject does not use global ref-count table.
+//   (see DKObjectRefCounter.h)
+//     class MyObject : public DKIntrusiveRefCounted { ... };
+//     DKObject<MyObject> p = DKObject<MyObject>::New();
+//
 // Note:
 //   1. You cannot use DKObject<void>
 //   2. if you have multiple-inheritanced class which does not polymorphic type,
@@ -83,6 +90,7 @@ namespace DKFoundation
 		static_assert( TypeTraits::IsReference == 0, "Reference type cannot be used!");
 
 		constexpr static bool IsPolymorphic() {return TypeTraits::IsPolymorphic();}
+		constexpr static bool IsIntrusive() {return std::is_base_of<DKIntrusiveRefCounted, T>::value;}
 		
 		using RefCounter = DKObjectRefCounter;
 		class Ref
@@ -203,7 +211,7 @@ namespace DKFoundation
 		{
 			Ref ref;
 			RefCounter::RefIdValue refId;
-			if (_target && RefCounter::RefId(BaseAddress(_target), &refId))
+			if (_target && _RefId(BaseAddress(_target), &refId))
 			{
 				ref.ptr = _target;
 				ref.refId = refId;
@@ -222,27 +230,37 @@ namespace DKFoundation
 		DKAllocator* Allocator(void) const
 		{
 			if (_target)
+			{
+				if (IsIntrusive())
+					return RefCounter::IntrusiveAllocator(BaseAddress(_target));
 				return RefCounter::Allocator(BaseAddress(_target));
+			}
 			return NULL;
 		}
 		bool IsManaged(void) const
 		{
-			if (_target && RefCounter::RefId(BaseAddress(_target), NULL))
-				return true;
+			if (_target)
+			{
+				if (IsIntrusive())
+					return true;
+				return RefCounter::RefId(BaseAddress(_target), NULL);
+			}
 			return false;
 		}
 		bool IsShared(void) const
 		{
-			RefCounter::RefCountValue ref = 0;
-			if (_target && RefCounter::RefCount(BaseAddress(_target), &ref))
-				return ref > 1;
-			return false;
+			return SharingCount() > 1;
 		}
 		RefCounter::RefCountValue SharingCount(void) const
 		{
 			RefCounter::RefCountValue ref = 0;
-			if (_target && RefCounter::RefCount(BaseAddress(_target), &ref))
-				return ref;
+			if (_target)
+			{
+				if (IsIntrusive())
+					return RefCounter::IntrusiveRefCount(BaseAddress(_target));
+				if (RefCounter::RefCount(BaseAddress(_target), &ref))
+					return ref;
+			}
 			return 0;
 		}
 		// determine base address of polymorphic type
@@ -251,22 +269,51 @@ namespace DKFoundation
 			return BaseAddress(_target);
 		}
 	private:
+		static bool _RefId(void* p, RefCounter::RefIdValue* refId)
+		{
+			if (IsIntrusive())
+				return RefCounter::IntrusiveRefId(p, refId);
+			return RefCounter::RefId(p, refId);
+		}
 		static T* _RetainObject(const Ref& ref)
 		{
-			if (ref.ptr && RefCounter::IncrementRefCount(BaseAddress(ref.ptr), ref.refId))
-				return ref.ptr;
+			if (ref.ptr)
+			{
+				if (IsIntrusive())
+				{
+					if (RefCounter::IntrusiveIncrementRefCount(BaseAddress(ref.ptr), ref.refId))
+						return ref.ptr;
+				}
+				else if (RefCounter::IncrementRefCount(BaseAddress(ref.ptr), ref.refId))
+					return ref.ptr;
+			}
 			return NULL;
 		}
 		static T* _RetainObject(T* p)
 		{
 			if (p)
-				RefCounter::IncrementRefCount(BaseAddress(p));
+			{
+				if (IsIntrusive())
+					RefCounter::IntrusiveIncrementRefCount(BaseAddress(p));
+				else
+					RefCounter::IncrementRefCount(BaseAddress(p));
+			}
 			return p;
 		}
 		static void _ReleaseObject(T* p)
 		{
 			if (p)
 			{
+				if (IsIntrusive())
+				{
+					void* ptr = BaseAddress(p);
+					if (RefCounter::IntrusiveDecrementRefCount(ptr))
+					{
+						p->~T();
+						RefCounter::IntrusiveFree(ptr);
+					}
+					return;
+				}
 				// decrease ref-count, delete if ref-count becomes zero.
 				DKAllocator* allocator = NULL;
 				if (RefCounter::DecrementRefCountAndUnsetIfZero(BaseAddress(p), &allocator))
@@ -5,12 +5,14 @@
 //  Copyright (c) 2004-2015 Hongtae Kim. All rights reserved.
 //
 
+#include <new>
 #include "DKObjectRefCounter.h"
 #include "DKSpinLock.h"
 #include "DKMap.h"
 #include "DKArray.h"
 #include "DKMemory.h"
 #include "DKFixedSizeAllocator.h"
+#include "DKAtomicNumber64.h"
 
 
 namespace DKFoundation
@@ -104,6 +106,34 @@ namespace DKFoundation
 			}
 		}
 
+		////////////////////////////////////////////////////////////////////////
+		// IntrusiveHeader
+		// header of DKIntrusiveRefCounted object, placed just before object.
+		// header size is multiple of 16 to keep alignment of allocator.
+		struct IntrusiveHeader
+		{
+			enum : uint64_t { Signature = 0x444B4952434E5448ULL };
+
+			DKAtomicNumber64	refCount;
+			DKAtomicNumber64	refId;		// zero if not inserted into table.
+			DKAllocator*		allocator;
+			uint64_t			signature;
+
+			static IntrusiveHeader* FromObject(void* p)
+			{
+				IntrusiveHeader* header = reinterpret_cast<IntrusiveHeader*>(reinterpret_cast<uintptr_t>(p) - HeaderSize);
+				DKASSERT_STD_DESC_DEBUG(header->signature == Signature, "Object is not allocated with intrusive ref-count header.");
+				return header;
+			}
+			static void* ToObject(IntrusiveHeader* header)
+			{
+				return reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(header) + HeaderSize);
+			}
+			enum : size_t { HeaderSize = 32 };
+		};
+		static_assert(sizeof(IntrusiveHeader) <= IntrusiveHeader::HeaderSize, "Invalid header size");
+		static_assert(IntrusiveHeader::HeaderSize % 16 == 0, "Header size should be multiple of 16");
+
 		void CreateAllocationTable(void) // called by Maintainer
 		{
 			AllocationTable* table = AllocationTable::Instance();
@@ -350,3 +380,112 @@ void DKObjectRefCounter::TableDump(size_t* tables)
 		tables[i] = node.container.Count();
 	}
 }
+
+void* DKObjectRefCounter::IntrusiveAlloc(size_t s, DKAllocator& alloc)
+{
+	void* p = alloc.Alloc(s + IntrusiveHeader::HeaderSize);
+	if (p)
+	{
+		IntrusiveHeader* header = new(p) IntrusiveHeader();
+		header->refCount = 0;
+		header->refId = 0;
+		header->allocator = &alloc;
+		header->signature = IntrusiveHeader::Signature;
+		return IntrusiveHeader::ToObject(header);
+	}
+	throw std::bad_alloc();
+}
+
+void DKObjectRefCounter::IntrusiveFree(void* p)
+{
+	if (p)
+	{
+		IntrusiveHeader* header = IntrusiveHeader::FromObject(p);
+		DKAllocator* alloc = header->allocator;
+		header->signature = 0;
+		header->~IntrusiveHeader();
+		alloc->Dealloc(header);
+	}
+}
+
+void DKObjectRefCounter::IntrusiveIncrementRefCount(void* p)
+{
+	if (p)
+	{
+		IntrusiveHeader::FromObject(p)->refCount.Increment();
+	}
+}
+
+bool DKObjectRefCounter::IntrusiveIncrementRefCount(void* p, RefIdValue id)
+{
+	if (p)
+	{
+		// object's header is valid while table has pair (p, id).
+		// object cannot be revived if ref-count already zero.
+		AllocationNode& node = GetAllocationNode(p);
+		AllocationNode::CriticalSection guard(node.lock);
+		AllocationNode::Container::Pair* pair = node.container.Find(p);
+		if (pair && pair->value.refId == id)
+		{
+			IntrusiveHeader* header = IntrusiveHeader::FromObject(p);
+			for (DKAtomicNumber64::Value c = header->refCount; c > 0; c = header->refCount)
+			{
+				if (header->refCount.CompareAndSet(c, c + 1))
+					return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool DKObjectRefCounter::IntrusiveDecrementRefCount(void* p)
+{
+	if (p)
+	{
+		IntrusiveHeader* header = IntrusiveHeader::FromObject(p);
+		DKAtomicNumber64::Value c = header->refCount.Decrement();
+		DKASSERT_STD_DEBUG(c > 0);
+		if (c == 1)
+		{
+			if (static_cast<DKAtomicNumber64::Value>(header->refId) != 0)
+				UnsetRefCounter(p, NULL, NULL);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool DKObjectRefCounter::IntrusiveRefId(void* p, RefIdValue* ref)
+{
+	if (p)
+	{
+		IntrusiveHeader* header = IntrusiveHeader::FromObject(p);
+		RefIdValue id = static_cast<DKAtomicNumber64::Value>(header->refId);
+		if (id == 0)
+		{
+			// insert object into table for weak-ref validation.
+			if (SetRefCounter(p, header->allocator, 0, &id))
+				header->refId.CompareAndSet(0, id);
+			else if (!RefId(p, &id))
+				return false;
+		}
+		if (ref)
+			*ref = id;
+		return true;
+	}
+	return false;
+}
+
+DKObjectRefCounter::RefCountValue DKObjectRefCounter::IntrusiveRefCount(void* p)
+{
+	if (p)
+		return static_cast<RefCountValue>(static_cast<DKAtomicNumber64::Value>(IntrusiveHeader::FromObject(p)->refCount));
+	return 0;
+}
+
+DKAllocator* DKObjectRefCounter::IntrusiveAllocator(void* p)
+{
+	if (p)
+		return IntrusiveHeader::FromObject(p)->allocator;
+	return NULL;
+}
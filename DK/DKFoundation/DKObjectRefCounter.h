@@ -17,6 +17,13 @@
 //
 // Note:
 //  Using this class is optinal.
+//
+// Intrusive ref-count:
+//  object derived from DKIntrusiveRefCounted has a header placed just before
+//  object which contains atomic ref-count and allocator. these objects are
+//  retained, released without global table lookup (lock-free).
+//  The table is used only for weak-ref (refId validation) of these objects,
+//  object will be inserted into table on first weak-ref request.
 ////////////////////////////////////////////////////////////////////////////////
 
 namespace DKFoundation
@@ -59,5 +66,69 @@ namespace DKFoundation
 		// functions for debugging.
 		static size_t TableSize(void);
 		static void TableDump(size_t*);
+
+		// intrusive ref-count functions. (DKIntrusiveRefCounted objects only)
+		// allocate object with header, ref-count begins with zero.
+		static void* IntrusiveAlloc(size_t, DKAllocator&);
+		// deallocate object and header with it's allocator.
+		static void IntrusiveFree(void*);
+		// increase ref-count +1.
+		static void IntrusiveIncrementRefCount(void*);
+		// increase ref-count +1, if object is alive and RefIdValue is valid.
+		static bool IntrusiveIncrementRefCount(void*, RefIdValue);
+		// decrease ref-count -1, return true if ref-count becomes zero.
+		// object will be removed from weak-ref table.
+		static bool IntrusiveDecrementRefCount(void*);
+		// retrieve RefId, object will be inserted into table if not exists.
+		static bool IntrusiveRefId(void*, RefIdValue*);
+		static RefCountValue IntrusiveRefCount(void*);
+		static DKAllocator* IntrusiveAllocator(void*);
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	// DKIntrusiveRefCounted
+	// base class for opt-in intrusive ref-counting.
+	// object of derived class will be allocated with ref-count header,
+	// DKObject retains, releases it atomically without global table.
+	//
+	// Note:
+	//  Object should be allocated with operator new (DKObject::New,
+	//  DKObject::Alloc, DKOBJECT_NEW or plain new), You cannot use DKObject with
+	//  stack, member or placement-new instance of derived class.
+	//  Object should be held by DKObject of type derived from this class.
+	//  (DKObject of other base class does not know about header)
+	////////////////////////////////////////////////////////////////////////////////
+	class DKIntrusiveRefCounted
+	{
+	public:
+		static void* operator new (size_t s)
+		{
+			return DKObjectRefCounter::IntrusiveAlloc(s, DKAllocator::DefaultAllocator());
+		}
+		static void* operator new (size_t s, DKAllocator& alloc)
+		{
+			return DKObjectRefCounter::IntrusiveAlloc(s, alloc);
+		}
+		static void* operator new (size_t, void* p)
+		{
+			return p;
+		}
+		static void operator delete (void* p)
+		{
+			DKObjectRefCounter::IntrusiveFree(p);
+		}
+		static void operator delete (void* p, DKAllocator&)	// invoked when allocation failed.
+		{
+			DKObjectRefCounter::IntrusiveFree(p);
+		}
+		static void operator delete (void*, void*)
+		{
+		}
+		static void* operator new[] (size_t) = delete;
+		static void operator delete[] (void*) = delete;
+
+	protected:
+		DKIntrusiveRefCounted(void) {}
+		~DKIntrusiveRefCounted(void) {}
 	};
 }
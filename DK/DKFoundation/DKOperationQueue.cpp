@@ -5,12 +5,16 @@
 //  Copyright (c) 2004-2015 Hongtae Kim. All rights reserved.
 //
 
+#include <atomic>
+#include <new>
 #include "DKObject.h"
 #include "DKOperationQueue.h"
 #include "DKFunction.h"
 #include "DKLog.h"
 #include "DKTimer.h"
 #include "DKCondition.h"
+#include "DKAtomicNumber64.h"
+#include "DKMemory.h"
 
 namespace DKFoundation
 {
@@ -26,8 +30,9 @@ namespace DKFoundation
 		struct OperationSyncState : public DKOperationQueue::OperationSync
 		{
 			State state;
+			bool processing;	// operation has been started, cannot be cancelled.
 
-			OperationSyncState(void) : state(StateUnknown)
+			OperationSyncState(void) : state(StateUnknown), processing(false)
 			{
 			}
 			bool Sync(void)
@@ -41,7 +46,7 @@ namespace DKFoundation
 			bool Cancel(void)
 			{
 				DKCriticalSection<DKCondition> guard(operationStateCond);
-				if (state == State::StatePending)
+				if (state == State::StatePending && !processing)
 				{
 					state = State::StateCancelled;
 					return true;
@@ -53,50 +58,456 @@ namespace DKFoundation
 				return state;
 			}
 		};
+
+		// Chase-Lev work-stealing deque.
+		// Push, Pop can be called by owner thread only,
+		// Steal can be called by any thread.
+		template <typename T> class WorkStealingDeque
+		{
+		public:
+			enum { InitialCapacity = 64 };
+
+			WorkStealingDeque(void) : top(0), bottom(0)
+			{
+				buffer.store(new Buffer(InitialCapacity, NULL), std::memory_order_relaxed);
+			}
+			~WorkStealingDeque(void)
+			{
+				Buffer* buf = buffer.load(std::memory_order_relaxed);
+				while (buf)
+				{
+					Buffer* prev = buf->prev;
+					delete buf;
+					buf = prev;
+				}
+			}
+			void Push(T item)
+			{
+				int64_t b = bottom.load(std::memory_order_relaxed);
+				int64_t t = top.load(std::memory_order_acquire);
+				Buffer* buf = buffer.load(std::memory_order_relaxed);
+				if (b - t > buf->capacity - 1)
+				{
+					// grow buffer. old buffer is retained until deque destroyed,
+					// because other threads may be reading it.
+					Buffer* newBuf = new Buffer(buf->capacity * 2, buf);
+					for (int64_t i = t; i < b; ++i)
+						newBuf->Put(i, buf->Get(i));
+					buffer.store(newBuf, std::memory_order_release);
+					buf = newBuf;
+				}
+				buf->Put(b, item);
+				std::atomic_thread_fence(std::memory_order_release);
+				bottom.store(b + 1, std::memory_order_relaxed);
+			}
+			bool Pop(T& item)
+			{
+				int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+				Buffer* buf = buffer.load(std::memory_order_relaxed);
+				bottom.store(b, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				int64_t t = top.load(std::memory_order_relaxed);
+				if (t <= b)
+				{
+					item = buf->Get(b);
+					if (t == b)
+					{
+						// last item, race with stealers.
+						bool result = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+						bottom.store(b + 1, std::memory_order_relaxed);
+						return result;
+					}
+					return true;
+				}
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return false;
+			}
+			bool Steal(T& item)
+			{
+				int64_t t = top.load(std::memory_order_acquire);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				int64_t b = bottom.load(std::memory_order_acquire);
+				if (t < b)
+				{
+					Buffer* buf = buffer.load(std::memory_order_acquire);
+					T tmp = buf->Get(t);
+					if (top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+					{
+						item = tmp;
+						return true;
+					}
+				}
+				return false;
+			}
+			bool IsEmpty(void) const
+			{
+				int64_t t = top.load(std::memory_order_acquire);
+				int64_t b = bottom.load(std::memory_order_acquire);
+				return b <= t;
+			}
+
+		private:
+			struct Buffer
+			{
+				Buffer(int64_t cap, Buffer* p)
+					: capacity(cap), mask(cap - 1), items(new std::atomic<T>[cap]), prev(p)
+				{
+				}
+				~Buffer(void)
+				{
+					delete[] items;
+				}
+				FORCEINLINE T Get(int64_t i) const		{ return items[i & mask].load(std::memory_order_relaxed); }
+				FORCEINLINE void Put(int64_t i, T v)	{ items[i & mask].store(v, std::memory_order_relaxed); }
+
+				const int64_t capacity;
+				const int64_t mask;
+				std::atomic<T>* items;
+				Buffer* prev;
+			};
+
+			std::atomic<int64_t> top;
+			std::atomic<int64_t> bottom;
+			std::atomic<Buffer*> buffer;
+		};
 	}
 }
 
 using namespace DKFoundation;
 using namespace DKFoundation::Private;
 
+struct DKOperationQueue::Task
+{
+	DKObject<DKOperation> operation;
+	DKObject<OperationSync> sync;
+	TaskGroup* group;
+};
+
+struct DKOperationQueue::Worker
+{
+	Worker(void) : next(NULL), threadId(DKThread::invalidId), active(false)
+	{
+		memset(&stats, 0, sizeof(stats));
+		stats.threadId = DKThread::invalidId;
+	}
+	WorkStealingDeque<Task*> deque;
+	std::atomic<Worker*> next;
+	volatile DKThread::ThreadId threadId;
+	bool active;
+	WorkerStatistics stats;		// modified by owner thread only.
+};
+
+struct DKOperationQueue::Scheduler
+{
+	Scheduler(DKOperationQueue* q)
+		: queue(q), workers(NULL), lastWorker(NULL), terminating(0)
+	{
+	}
+	~Scheduler(void)
+	{
+		DKASSERT_DEBUG(sharedQueue.Count() == 0);
+		Worker* w = workers.load(std::memory_order_acquire);
+		while (w)
+		{
+			DKASSERT_DEBUG(w->active == false);
+			DKASSERT_DEBUG(w->deque.IsEmpty());
+			Worker* next = w->next.load(std::memory_order_relaxed);
+			delete w;
+			w = next;
+		}
+	}
+
+	// worker of calling thread, NULL if calling thread is not a worker.
+	Worker* CurrentWorker(void) const
+	{
+		DKThread::ThreadId tid = DKThread::CurrentThreadId();
+		for (Worker* w = workers.load(std::memory_order_acquire); w; w = w->next.load(std::memory_order_acquire))
+		{
+			if (w->threadId == tid)
+				return w;
+		}
+		return NULL;
+	}
+	// threadCond should be locked.
+	Worker* AttachWorker(DKThread::ThreadId tid)
+	{
+		Worker* w = workers.load(std::memory_order_acquire);
+		while (w && w->active)
+			w = w->next.load(std::memory_order_acquire);
+		if (w == NULL)
+		{
+			w = new Worker();
+			if (lastWorker)
+				lastWorker->next.store(w, std::memory_order_release);
+			else
+				workers.store(w, std::memory_order_release);
+			lastWorker = w;
+		}
+		w->active = true;
+		w->threadId = tid;
+		w->stats.threadId = tid;
+		return w;
+	}
+	// threadCond should be locked.
+	void DetachWorker(Worker* w)
+	{
+		Task* t = NULL;
+		while (w->deque.Pop(t))
+			sharedQueue.PushBack(t);
+		w->threadId = DKThread::invalidId;
+		w->stats.threadId = DKThread::invalidId;
+		w->active = false;
+	}
+	// steal from other workers, starts from next of w.
+	bool Steal(Worker* w, Task*& t)
+	{
+		Worker* first = workers.load(std::memory_order_acquire);
+		Worker* start = w ? w->next.load(std::memory_order_acquire) : first;
+		for (Worker* v = start; v; v = v->next.load(std::memory_order_acquire))
+		{
+			if (v->deque.Steal(t))
+				return true;
+		}
+		for (Worker* v = first; v && v != start; v = v->next.load(std::memory_order_acquire))
+		{
+			if (v != w && v->deque.Steal(t))
+				return true;
+		}
+		return false;
+	}
+	Task* FetchTask(Worker* w)
+	{
+		Task* t = NULL;
+		if (w && w->deque.Pop(t))
+			return t;
+		if (sharedQueue.PopFront(t))
+			return t;
+		if (queuedTasks > 0)
+		{
+			if (Steal(w, t))
+			{
+				if (w)
+					w->stats.stolen++;
+				return t;
+			}
+			if (w)
+				w->stats.stealFailures++;
+		}
+		return NULL;
+	}
+	// perform or cancel task, and destroy.
+	void Execute(Task* t, Worker* w, bool cancel)
+	{
+		runningTasks.Increment();
+		queuedTasks.Decrement();
+
+		OperationSyncState* st = t->sync.StaticCast<OperationSyncState>();
+		bool perform = !cancel;
+		if (st)
+		{
+			operationStateCond.Lock();
+			if (st->state == OperationSync::StatePending)
+			{
+				if (perform)
+					st->processing = true;
+				else
+				{
+					st->state = OperationSync::StateCancelled;
+					operationStateCond.Broadcast();
+				}
+			}
+			else
+				perform = false;
+			operationStateCond.Unlock();
+		}
+		if (perform)
+		{
+			struct Wrapper : public DKOperation
+			{
+				void Perform(void) const override
+				{
+					if (filter)
+						filter->PerformOperation(op);
+					else
+						op->Perform();
+				}
+				Wrapper(ThreadFilter* f, DKOperation* o) : filter(f), op(o) {}
+				ThreadFilter* filter;
+				DKOperation* op;
+			};
+			Wrapper wr(queue->filter, t->operation);
+			PerformOperationInsidePool(&wr);
+			if (w)
+				w->stats.processed++;
+
+			if (st)
+			{
+				operationStateCond.Lock();
+				st->state = OperationSync::StateProcessed;
+				st->processing = false;
+				operationStateCond.Broadcast();
+				operationStateCond.Unlock();
+			}
+		}
+
+		bool groupCompleted = false;
+		for (TaskGroup* g = t->group; g; )
+		{
+			// group can be destroyed by waiting thread after decrement.
+			TaskGroup* parent = g->parent;
+			if (g->pending.Decrement() == 1)
+				groupCompleted = true;
+			g = parent;
+		}
+
+		t->~Task();
+		DKMemoryPoolFree(t);
+
+		if (groupCompleted)
+		{
+			if (groupWaiters > 0)
+			{
+				queue->threadCond.Lock();
+				queue->threadCond.Broadcast();
+				queue->threadCond.Unlock();
+			}
+			if (completionWaiters > 0)
+			{
+				queue->completionCond.Lock();
+				queue->completionCond.Broadcast();
+				queue->completionCond.Unlock();
+			}
+		}
+		if (runningTasks.Decrement() == 1 && queuedTasks == 0 && completionWaiters > 0)
+		{
+			queue->completionCond.Lock();
+			queue->completionCond.Broadcast();
+			queue->completionCond.Unlock();
+		}
+	}
+	void CancelAllTasks(void)
+	{
+		Task* t = NULL;
+		while (sharedQueue.PopFront(t))
+			Execute(t, NULL, true);
+		for (Worker* w = workers.load(std::memory_order_acquire); w; w = w->next.load(std::memory_order_acquire))
+		{
+			while (!w->deque.IsEmpty())
+			{
+				if (w->deque.Steal(t))
+					Execute(t, NULL, true);
+			}
+		}
+	}
+
+	DKOperationQueue* queue;
+	DKQueue<Task*, DKSpinLock> sharedQueue;	// operations posted from non-worker threads.
+	std::atomic<Worker*> workers;			// append-only list.
+	Worker* lastWorker;
+	DKAtomicNumber64 queuedTasks;
+	DKAtomicNumber64 runningTasks;
+	DKAtomicNumber32 sleepingThreads;		// threads waiting on threadCond.
+	DKAtomicNumber32 groupWaiters;			// group waiters on threadCond.
+	DKAtomicNumber32 completionWaiters;		// threads waiting on completionCond.
+	DKAtomicNumber32 terminating;			// queue is being destroyed, workers stop fetching.
+};
+
+DKOperationQueue::TaskGroup::TaskGroup(DKOperationQueue* q, TaskGroup* p)
+	: queue(q)
+	, parent(p)
+	, pending(0)
+{
+	DKASSERT_DEBUG(queue != NULL);
+	DKASSERT_DEBUG(parent == NULL || parent->queue == queue);
+}
+
+DKOperationQueue::TaskGroup::~TaskGroup(void)
+{
+	Wait();
+}
+
+void DKOperationQueue::TaskGroup::Post(DKOperation* operation)
+{
+	if (operation)
+		queue->Post(operation, NULL, this);
+}
+
+void DKOperationQueue::TaskGroup::Wait(void)
+{
+	Scheduler* s = queue->scheduler;
+	Worker* w = s->CurrentWorker();
+	bool help = w != NULL || queue->filter == NULL;
+
+	while (pending > 0)
+	{
+		if (help)
+		{
+			Task* t = s->FetchTask(w);
+			if (t)
+			{
+				s->Execute(t, w, false);
+				continue;
+			}
+			queue->threadCond.Lock();
+			s->sleepingThreads.Increment();
+			s->groupWaiters.Increment();
+			if (pending > 0 && s->queuedTasks == 0)
+				queue->threadCond.Wait();
+			s->groupWaiters.Decrement();
+			s->sleepingThreads.Decrement();
+			queue->threadCond.Unlock();
+		}
+		else
+		{
+			queue->completionCond.Lock();
+			s->completionWaiters.Increment();
+			while (pending > 0)
+				queue->completionCond.Wait();
+			s->completionWaiters.Decrement();
+			queue->completionCond.Unlock();
+		}
+	}
+}
+
+size_t DKOperationQueue::TaskGroup::PendingOperations(void) const
+{
+	return (size_t)(DKAtomicNumber32::Value)pending;
+}
+
 DKOperationQueue::DKOperationQueue(ThreadFilter* f)
-	: maxConcurrentOperations(16)
+	: scheduler(NULL)
+	, maxConcurrentOperations(16)
 	, threadCount(0)
 	, maxThreadCount(0)
-	, activeThreads(0)
 	, filter(f)
 {
+	scheduler = new Scheduler(this);
 }
 
 DKOperationQueue::~DKOperationQueue(void)
 {
+	// queued tasks are cancelled, not performed.
+	scheduler->terminating.Increment();
+
 	threadCond.Lock();
 	maxThreadCount = 0;
 	threadCond.Broadcast();
 	while (threadCount > 0)
 		threadCond.Wait();
+	threadCond.Unlock();
 
-	DKASSERT_DEBUG(activeThreads == 0);
+	scheduler->CancelAllTasks();
+	DKASSERT_DEBUG(scheduler->runningTasks == 0);
 
-	operationStateCond.Lock();
-	auto cancelOps = [](Operation& op)
-	{
-		OperationSyncState* st = op.sync.StaticCast<OperationSyncState>();
-		if (st && st->state == OperationSync::StatePending)
-			st->state = OperationSync::StateCancelled;
-	};
-	operationQueue.EnumerateForward(cancelOps);
-	operationQueue.Clear();
-
-	operationStateCond.Broadcast();
-	operationStateCond.Unlock();
-	threadCond.Unlock();
+	delete scheduler;
 }
 
 void DKOperationQueue::SetMaxConcurrentOperations(size_t maxConcurrent)
 {
 	threadCond.Lock();
 	maxConcurrentOperations = Max(maxConcurrent, 1);
+	maxThreadCount = maxConcurrentOperations;
+	threadCond.Broadcast();		// wake idle threads to terminate.
 	threadCond.Unlock();
 
 	UpdateThreadPool();
@@ -113,14 +524,34 @@ size_t DKOperationQueue::MaxConcurrentOperations(void) const
 void DKOperationQueue::Post(DKOperation* operation)
 {
 	if (operation)
+		Post(operation, NULL, NULL);
+}
+
+void DKOperationQueue::Post(DKOperation* operation, DKObject<OperationSync> sync, TaskGroup* group)
+{
+	Task* t = new(DKMemoryPoolAlloc(sizeof(Task))) Task();
+	t->operation = operation;
+	t->sync = sync;
+	t->group = group;
+
+	for (TaskGroup* g = group; g; g = g->parent)
+		g->pending.Increment();
+
+	scheduler->queuedTasks.Increment();
+	Worker* w = scheduler->CurrentWorker();
+	if (w)
+		w->deque.Push(t);
+	else
+		scheduler->sharedQueue.PushBack(t);
+
+	// wake one sleeping thread.
+	if (scheduler->sleepingThreads > 0)
 	{
-		Operation op = {operation, NULL};
 		threadCond.Lock();
-		operationQueue.PushBack(op);
-		threadCond.Broadcast();
+		threadCond.Signal();
 		threadCond.Unlock();
-		UpdateThreadPool();
 	}
+	UpdateThreadPool();
 }
 
 DKObject<DKOperationQueue::OperationSync> DKOperationQueue::ProcessAsync(DKOperation* operation)
@@ -129,13 +560,7 @@ DKObject<DKOperationQueue::OperationSync> DKOperationQueue::ProcessAsync(DKOpera
 	{
 		DKObject<OperationSyncState> sync = DKOBJECT_NEW OperationSyncState();
 		sync->state = OperationSync::StatePending;
-		Operation op = {operation, sync.StaticCast<OperationSync>()};
-		threadCond.Lock();
-		operationQueue.PushBack(op);
-		threadCond.Broadcast();
-		threadCond.Unlock();
-		UpdateThreadPool();
-
+		Post(operation, sync.StaticCast<OperationSync>(), NULL);
 		return sync.StaticCast<OperationSync>();
 	}
 	return NULL;
@@ -151,11 +576,15 @@ bool DKOperationQueue::Process(DKOperation* operation)
 
 void DKOperationQueue::UpdateThreadPool(void)
 {
+	// avoid locking if thread pool is full. (values can be stale)
+	if (threadCount >= maxConcurrentOperations || (size_t)(int64_t)scheduler->queuedTasks <= threadCount)
+		return;
+
 	threadCond.Lock();
 	maxThreadCount = maxConcurrentOperations;
 	while (threadCount < maxThreadCount)
 	{
-		if (operationQueue.Count() > threadCount)
+		if ((size_t)(int64_t)scheduler->queuedTasks > threadCount)
 		{
 			DKObject<DKThread> thread = DKThread::Create(DKFunction(this, &DKOperationQueue::OperationProc)->Invocation());
 			if (thread)
@@ -168,55 +597,34 @@ void DKOperationQueue::UpdateThreadPool(void)
 			break;
 		}
 	}
-	//size_t numThreads = threadCount;
 	threadCond.Unlock();
-
-	//DKLog("OperationQueue running %u threads (maxConcurrent:%d)\n", (unsigned int)numThreads, maxConcurrentOperations);
 }
 
 void DKOperationQueue::CancelAllOperations(void)
 {
-	threadCond.Lock();
-
-	operationStateCond.Lock();
-	auto cancelOps = [](Operation& op)
-	{
-		OperationSyncState* st = op.sync.StaticCast<OperationSyncState>();
-		if (st && st->state == OperationSync::StatePending)
-			st->state = OperationSync::StateCancelled;
-	};
-	operationQueue.EnumerateForward(cancelOps);
-	operationQueue.Clear();
-
-	operationStateCond.Broadcast();
-	operationStateCond.Unlock();
-
-	threadCond.Broadcast();
-	threadCond.Unlock();
+	scheduler->CancelAllTasks();
 }
 
 void DKOperationQueue::WaitForCompletion(void) const
 {
-	threadCond.Lock();
-	while (operationQueue.Count() > 0 || activeThreads > 0)
-		threadCond.Wait();
-	threadCond.Unlock();
+	completionCond.Lock();
+	scheduler->completionWaiters.Increment();
+	while (scheduler->queuedTasks > 0 || scheduler->runningTasks > 0)
+		completionCond.Wait();
+	scheduler->completionWaiters.Decrement();
+	completionCond.Unlock();
 }
 
 size_t DKOperationQueue::QueueLength(void) const
 {
-	threadCond.Lock();
-	size_t c = operationQueue.Count();
-	threadCond.Unlock();
-	return c;
+	int64_t c = scheduler->queuedTasks;
+	return c > 0 ? (size_t)c : 0;
 }
 
 size_t DKOperationQueue::RunningOperations(void) const
 {
-	threadCond.Lock();
-	size_t c = activeThreads;
-	threadCond.Unlock();
-	return c;
+	int64_t c = scheduler->runningTasks;
+	return c > 0 ? (size_t)c : 0;
 }
 
 size_t DKOperationQueue::RunningThreads(void) const
@@ -227,6 +635,16 @@ size_t DKOperationQueue::RunningThreads(void) const
 	return c;
 }
 
+DKArray<DKOperationQueue::WorkerStatistics> DKOperationQueue::GetWorkerStatistics(void) const
+{
+	DKArray<WorkerStatistics> result;
+	threadCond.Lock();
+	for (Worker* w = scheduler->workers.load(std::memory_order_acquire); w; w = w->next.load(std::memory_order_acquire))
+		result.Add(w->stats);
+	threadCond.Unlock();
+	return result;
+}
+
 void DKOperationQueue::OperationProc(void)
 {
 	DKThread::ThreadId threadId = DKThread::CurrentThreadId();
@@ -235,84 +653,46 @@ void DKOperationQueue::OperationProc(void)
 	size_t numOps = 0;
 
 	threadCond.Lock();
-
-	auto PerformOperation = [this](DKOperation* op)
-	{
-		struct Wrapper : public DKOperation
-		{
-			void Perform(void) const override
-			{
-				if (filter)
-					filter->PerformOperation(op);
-				else
-					op->Perform();
-			}
-			Wrapper(ThreadFilter* f, DKOperation* o) : filter(f), op(o) {}
-			ThreadFilter* filter;
-			DKOperation* op;
-		};
-		Wrapper wr(filter, op);
-		PerformOperationInsidePool(&wr);
-	};
+	Worker* worker = scheduler->AttachWorker(threadId);
 
 	if (filter)
 		filter->OnThreadInitialized();
 
 	DKLog("DKOperationQueue_Thread:0x%x started.\n", threadId);
+	threadCond.Unlock();
 
 	while (true)
 	{
-		DKASSERT_DEBUG(threadCount > 0);
-		if (threadCount > maxThreadCount)
+		Task* t = scheduler->terminating > 0 ? NULL : scheduler->FetchTask(worker);
+		if (t)
 		{
-			break; // terminate.
+			scheduler->Execute(t, worker, false);
+			numOps++;
+			continue;
 		}
 
-		Operation op = {NULL, NULL};
-		if (operationQueue.PopFront(op))
+		threadCond.Lock();
+		DKASSERT_DEBUG(threadCount > 0);
+		if (threadCount > maxThreadCount)
 		{
-			activeThreads++;
-			threadCond.Unlock();
-
-			OperationSyncState* st = op.sync.StaticCast<OperationSyncState>();
-			if (st)
-			{
-				operationStateCond.Lock();
-				if (st->state == OperationSync::StatePending)
-				{
-					if (op.operation)
-					{
-						PerformOperation(op.operation);
-						numOps++;
-						st->state = OperationSync::StateProcessed;
-					}
-					else
-					{
-						st->state = OperationSync::StateCancelled;
-					}
-					operationStateCond.Broadcast();
-				}
-				operationStateCond.Unlock();
-			}
-			else  if (op.operation)
-			{
-				PerformOperation(op.operation);
-				numOps++;
-			}
-
-			op.operation = NULL;
-			op.sync = NULL;
-
-			threadCond.Lock();
-			activeThreads--;
-			threadCond.Broadcast();
+			break; // terminate. (threadCond locked)
 		}
-		else
+
+		scheduler->sleepingThreads.Increment();
+		if (scheduler->queuedTasks == 0)
 		{
+			DKTimer idleTimer;
+			idleTimer.Reset();
+			worker->stats.idleCount++;
 			threadCond.Wait();
+			worker->stats.idleTime += idleTimer.Elapsed();
 		}
+		scheduler->sleepingThreads.Decrement();
+		threadCond.Unlock();
 	}
 
+	scheduler->DetachWorker(worker);
+
 	if (filter)
 		filter->OnThreadTerminate();
 
@@ -10,13 +10,34 @@
 #include "DKThread.h"
 #include "DKOperation.h"
 #include "DKQueue.h"
+#include "DKArray.h"
 #include "DKCondition.h"
 #include "DKSpinLock.h"
+#include "DKAtomicNumber32.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 // DKOperationQueue
 // processing operations with multi-threaded.
 // this class manages thread pool automatically.
+//
+// operations are scheduled with work-stealing. each worker thread has its
+// own deque, operations posted from worker thread are pushed to worker's
+// deque, operations posted from other threads are pushed to shared queue.
+// idle worker steals operations from other workers.
+// a posting wakes only one sleeping worker.
+//
+// TaskGroup: operations can be grouped and waited together.
+// TaskGroup::Wait() processes pending operations while waiting, so you can
+// wait for group inside of operation without blocking worker thread.
+// (useful for recursive jobs)
+//
+// Example:
+//   void Build(Node* node, TaskGroup* parent) {
+//     DKOperationQueue::TaskGroup group(queue, parent);
+//     group.Post(DKFunction([&]{ Build(node->left, &group); })->Invocation());
+//     group.Post(DKFunction([&]{ Build(node->right, &group); })->Invocation());
+//     group.Wait();
+//   }
 ////////////////////////////////////////////////////////////////////////////////
 
 namespace DKFoundation
@@ -54,6 +75,47 @@ namespace DKFoundation
 			}
 		};
 
+		// TaskGroup: set of operations can be waited together.
+		// operations of child group are counted to parent group also.
+		// group object should not be destroyed before all operations are done.
+		// (destructor waits for operations)
+		class DKGL_API TaskGroup
+		{
+		public:
+			TaskGroup(DKOperationQueue* queue, TaskGroup* parent = NULL);
+			~TaskGroup(void);
+
+			void Post(DKOperation* operation);
+			// wait until all operations (including child groups) are done.
+			// calling thread processes queued operations while waiting.
+			// (non-worker thread does not process operations if queue has ThreadFilter)
+			void Wait(void);
+			size_t PendingOperations(void) const;
+
+			DKOperationQueue* Queue(void) const { return queue; }
+			TaskGroup* Parent(void) const { return parent; }
+
+		private:
+			friend class DKOperationQueue;
+			DKOperationQueue* queue;
+			TaskGroup* parent;
+			DKAtomicNumber32 pending;
+
+			TaskGroup(const TaskGroup&);
+			TaskGroup& operator = (const TaskGroup&);
+		};
+
+		// statistics of worker thread. (values are approximate)
+		struct WorkerStatistics
+		{
+			DKThread::ThreadId threadId;	// invalidId if worker is not running.
+			uint64_t processed;				// number of operations processed.
+			uint64_t stolen;				// number of operations stolen from other workers.
+			uint64_t stealFailures;			// number of failed steal attempts.
+			uint64_t idleCount;				// number of sleeps.
+			double idleTime;				// total sleeping time in seconds.
+		};
+
 		DKOperationQueue(ThreadFilter* filter = NULL);
 		~DKOperationQueue(void);
 
@@ -70,21 +132,22 @@ namespace DKFoundation
 		size_t RunningOperations(void) const;
 		size_t RunningThreads(void) const;
 
+		DKArray<WorkerStatistics> GetWorkerStatistics(void) const;
+
 	private:
-		struct Operation
-		{
-			DKObject<DKOperation> operation;
-			DKObject<OperationSync> sync;
-		};
-		typedef DKQueue<Operation, DKDummyLock> OperationQueue;
-		OperationQueue operationQueue;
+		struct Task;
+		struct Worker;
+		struct Scheduler;
+		Scheduler* scheduler;
+
 		size_t maxConcurrentOperations;
 		size_t threadCount;			// available threads count
 		size_t maxThreadCount;		// maximum threads count
-		size_t activeThreads;		// working threads count
-		DKCondition threadCond;
+		DKCondition threadCond;		// sleeping workers, helping waiters.
+		DKCondition completionCond;	// WaitForCompletion, non-helping waiters.
 		DKObject<ThreadFilter> filter;
 
+		void Post(DKOperation* operation, DKObject<OperationSync> sync, TaskGroup* group);
 		void UpdateThreadPool(void);
 		void OperationProc(void);
 
@@ -5,14 +5,27 @@
 //  Copyright (c) 2004-2015 Hongtae Kim. All rights reserved.
 //
 
+#include <atomic>
+#include <new>
+#if defined(__linux__)
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#define DKGL_RUNLOOP_USE_FUTEX 1
+#endif
+
 #include "DKObject.h"
 #include "DKRunLoop.h"
 #include "DKMap.h"
 #include "DKArray.h"
+#include "DKQueue.h"
 #include "DKSpinLock.h"
 #include "DKFunction.h"
 #include "DKLog.h"
 #include "DKCondition.h"
+#include "DKAtomicNumber32.h"
+#include "DKMemory.h"
 
 namespace DKFoundation
 {
@@ -165,28 +178,226 @@ namespace DKFoundation
 				return state == StatePending;
 			}
 		};
+
+		// pairing heap, for delayed commands. (single thread only)
+		// Node should have 'child', 'sibling' pointers.
+		template <typename Node, typename Less> class RunLoopTimerHeap
+		{
+		public:
+			RunLoopTimerHeap(void) : root(NULL), count(0) {}
+
+			void Insert(Node* n)
+			{
+				n->child = NULL;
+				n->sibling = NULL;
+				root = Meld(root, n);
+				count++;
+			}
+			Node* Top(void) const
+			{
+				return root;
+			}
+			Node* Pop(void)
+			{
+				Node* n = root;
+				if (n)
+				{
+					root = MergePairs(n->child);
+					n->child = NULL;
+					count--;
+				}
+				return n;
+			}
+			size_t Count(void) const { return count; }
+
+		private:
+			static Node* Meld(Node* a, Node* b)
+			{
+				if (a == NULL)
+					return b;
+				if (b == NULL)
+					return a;
+				if (Less()(b, a))
+				{
+					Node* tmp = a;
+					a = b;
+					b = tmp;
+				}
+				b->sibling = a->child;
+				a->child = b;
+				return a;
+			}
+			// two-pass merge (without recursion)
+			static Node* MergePairs(Node* n)
+			{
+				Node* list = NULL;
+				while (n)
+				{
+					Node* a = n;
+					Node* b = a->sibling;
+					n = b ? b->sibling : NULL;
+					a->sibling = NULL;
+					if (b)
+						b->sibling = NULL;
+					Node* m = Meld(a, b);
+					m->sibling = list;
+					list = m;
+				}
+				Node* result = NULL;
+				while (list)
+				{
+					Node* next = list->sibling;
+					list->sibling = NULL;
+					result = Meld(result, list);
+					list = next;
+				}
+				return result;
+			}
+			Node* root;
+			size_t count;
+		};
+
+		// intrusive multi-producer, single-consumer queue. (D.Vyukov)
+		// Node should have atomic 'next' pointer.
+		template <typename Node> class RunLoopCommandQueue
+		{
+		public:
+			RunLoopCommandQueue(void) : tail(&stub)
+			{
+				stub.next.store(NULL, std::memory_order_relaxed);
+				head.store(&stub, std::memory_order_relaxed);
+			}
+			void Push(Node* n)
+			{
+				n->next.store(NULL, std::memory_order_relaxed);
+				Node* prev = head.exchange(n, std::memory_order_seq_cst);
+				prev->next.store(n, std::memory_order_release);
+			}
+			// consumer only. returns NULL if queue is empty or
+			// a producer is being pushed. (try again later)
+			Node* Pop(void)
+			{
+				Node* t = tail;
+				Node* next = t->next.load(std::memory_order_acquire);
+				if (t == &stub)
+				{
+					if (next == NULL)
+						return NULL;
+					tail = next;
+					t = next;
+					next = next->next.load(std::memory_order_acquire);
+				}
+				if (next)
+				{
+					tail = next;
+					return t;
+				}
+				if (t != head.load(std::memory_order_acquire))
+					return NULL;
+				Push(&stub);
+				next = t->next.load(std::memory_order_acquire);
+				if (next)
+				{
+					tail = next;
+					return t;
+				}
+				return NULL;
+			}
+			// consumer only.
+			bool IsEmpty(void) const
+			{
+				return tail == &stub &&
+					stub.next.load(std::memory_order_acquire) == NULL &&
+					head.load(std::memory_order_acquire) == &stub;
+			}
+		private:
+			std::atomic<Node*> head;
+			Node* tail;
+			Node stub;
+		};
 	}
 }
 
 using namespace DKFoundation;
 using namespace DKFoundation::Private;
 
-bool DKRunLoop::InternalCommandCompareOrder(const InternalCommandTick& lhs, const InternalCommandTick& rhs)
+struct DKRunLoop::InternalCommand
 {
-	return lhs.fire < rhs.fire;
-}
+	DKObject<DKOperation>		operation;
+	DKObject<OperationResult>	result;
+	DKTimer::Tick				fireTick;
+	DKDateTime					fireTime;
+	bool						timeBased;
+
+	std::atomic<InternalCommand*> next;		// command queue
+	InternalCommand* child;					// timer heap
+	InternalCommand* sibling;				// timer heap
 
-bool DKRunLoop::InternalCommandCompareOrder(const InternalCommandTime& lhs, const InternalCommandTime& rhs)
+	struct TickOrder
+	{
+		bool operator () (const InternalCommand* lhs, const InternalCommand* rhs) const
+		{
+			return lhs->fireTick < rhs->fireTick;
+		}
+	};
+	struct TimeOrder
+	{
+		bool operator () (const InternalCommand* lhs, const InternalCommand* rhs) const
+		{
+			return lhs->fireTime < rhs->fireTime;
+		}
+	};
+
+	static InternalCommand* Create(void)
+	{
+		return new(DKMemoryPoolAlloc(sizeof(InternalCommand))) InternalCommand();
+	}
+	static void Destroy(InternalCommand* cmd)
+	{
+		cmd->~InternalCommand();
+		DKMemoryPoolFree(cmd);
+	}
+};
+
+struct DKRunLoop::CommandQueue
 {
-	return lhs.fire < rhs.fire;
-}
+	enum WakeState
+	{
+		WakeStateRunning = 0,
+		WakeStateSleeping,
+		WakeStateNotified,
+	};
+
+	RunLoopCommandQueue<InternalCommand> postedCommands;	// multi-producer, single-consumer
+	DKQueue<InternalCommand*, DKDummyLock> readyCommands;	// worker-thread only
+	RunLoopTimerHeap<InternalCommand, InternalCommand::TickOrder> tickCommands;	// worker-thread only
+	RunLoopTimerHeap<InternalCommand, InternalCommand::TimeOrder> timeCommands;	// worker-thread only
+	DKAtomicNumber32 wakeState;
+
+	// move posted commands into ready-queue or timer-heaps. (worker-thread only)
+	void Drain(void)
+	{
+		while (InternalCommand* cmd = postedCommands.Pop())
+		{
+			if (cmd->timeBased)
+				timeCommands.Insert(cmd);
+			else if (cmd->fireTick <= DKTimer::SystemTick())
+				readyCommands.PushBack(cmd);
+			else
+				tickCommands.Insert(cmd);
+		}
+	}
+	size_t Count(void) const
+	{
+		return readyCommands.Count() + tickCommands.Count() + timeCommands.Count();
+	}
+};
 
 DKRunLoop::DKRunLoop(void)
-: terminate(true)
+: commandQueue(new CommandQueue())
 , thread(NULL)
 , threadId(DKThread::invalidId)
-, commandQueueTick(&DKRunLoop::InternalCommandCompareOrder)
-, commandQueueTime(&DKRunLoop::InternalCommandCompareOrder)
+, terminate(true)
 {
 }
 
@@ -198,6 +409,7 @@ DKRunLoop::~DKRunLoop(void)
 	}
 
 	RevokeAllOperations();
+	delete commandQueue;
 }
 
 bool DKRunLoop::Run(void)
@@ -226,18 +438,32 @@ bool DKRunLoop::IsRunning(void) const
 	return false;
 }
 
-void DKRunLoop::InternalPostCommand(const InternalCommandTick& cmd)
+void DKRunLoop::InternalPostCommand(InternalCommand* cmd)
 {
-	DKCriticalSection<DKCondition> guard(commandQueueCond);
-	commandQueueTick.Insert(cmd);
-	commandQueueCond.Signal();
+	commandQueue->postedCommands.Push(cmd);
+	WakeUp();
 }
 
-void DKRunLoop::InternalPostCommand(const InternalCommandTime& cmd)
+void DKRunLoop::WakeUp(void)
 {
-	DKCriticalSection<DKCondition> guard(commandQueueCond);
-	commandQueueTime.Insert(cmd);
-	commandQueueCond.Signal();
+#if DKGL_RUNLOOP_USE_FUTEX
+	if (commandQueue->wakeState.CompareAndSet(CommandQueue::WakeStateSleeping, CommandQueue::WakeStateNotified))
+	{
+		syscall(SYS_futex, &commandQueue->wakeState, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+	}
+#else
+	if (commandQueue->wakeState == CommandQueue::WakeStateSleeping)
+	{
+		DKCriticalSection<DKCondition> guard(commandQueueCond);
+		commandQueueCond.Signal();
+	}
+#endif
+}
+
+bool DKRunLoop::TerminateRequested(void) const
+{
+	DKCriticalSection<DKSpinLock> guard(threadLock);
+	return this->terminate;
 }
 
 void DKRunLoop::Terminate(bool wait)
@@ -247,6 +473,7 @@ void DKRunLoop::Terminate(bool wait)
 		threadLock.Lock();
 		terminate = true;
 		threadLock.Unlock();
+		WakeUp();
 
 		// On called by worker-thread:
 		//    post quit message and return immediately.
@@ -267,13 +494,17 @@ DKObject<DKRunLoop::OperationResult> DKRunLoop::PostOperation(const DKOperation*
 {
 	if (operation)
 	{
-		InternalCommandTick cmd;
-		cmd.operation = const_cast<DKOperation*>(operation);
-		cmd.result = DKOBJECT_NEW RunLoopResultCallback();
-		cmd.fire = DKTimer::SystemTick() + static_cast<DKTimer::Tick>(DKTimer::SystemTickFrequency() * Max(delay, 0.0));
+		DKObject<OperationResult> result = DKOBJECT_NEW RunLoopResultCallback();
+		InternalCommand* cmd = InternalCommand::Create();
+		cmd->operation = const_cast<DKOperation*>(operation);
+		cmd->result = result;
+		cmd->fireTick = DKTimer::SystemTick();
+		if (delay > 0.0)
+			cmd->fireTick += static_cast<DKTimer::Tick>(DKTimer::SystemTickFrequency() * delay);
+		cmd->timeBased = false;
 		InternalPostCommand(cmd);
 
-		return cmd.result;
+		return result;
 	}
 	return NULL;
 }
@@ -282,13 +513,16 @@ DKObject<DKRunLoop::OperationResult> DKRunLoop::PostOperation(const DKOperation*
 {
 	if (operation)
 	{
-		InternalCommandTime cmd;
-		cmd.operation = const_cast<DKOperation*>(operation);
-		cmd.result = DKOBJECT_NEW RunLoopResultCallback();
-		cmd.fire = runAfter;
+		DKObject<OperationResult> result = DKOBJECT_NEW RunLoopResultCallback();
+		InternalCommand* cmd = InternalCommand::Create();
+		cmd->operation = const_cast<DKOperation*>(operation);
+		cmd->result = result;
+		cmd->fireTick = 0;
+		cmd->fireTime = runAfter;
+		cmd->timeBased = true;
 		InternalPostCommand(cmd);
 
-		return cmd.result;
+		return result;
 	}
 	return NULL;
 }
@@ -314,63 +548,69 @@ bool DKRunLoop::ProcessOperation(const DKOperation* op)
 
 size_t DKRunLoop::RevokeAllOperations(void)
 {
-	DKCriticalSection<DKCondition> guard(this->commandQueueCond);
+	// this function should be called when worker-thread is not running.
+	// (or called by worker-thread)
+	commandQueue->Drain();
 
-	//DKTimer::Tick tick = DKTimer::SystemTick();
+	size_t numItems = commandQueue->Count();
 
-	size_t numItems = this->commandQueueTick.Count() + this->commandQueueTime.Count();
-
-	auto revoke = [](const InternalCommand& ic)
+	auto revoke = [](InternalCommand* cmd)
 	{
-		const RunLoopResultCallback* callback = ic.result.StaticCast<RunLoopResultCallback>();
+		const RunLoopResultCallback* callback = cmd->result.StaticCast<RunLoopResultCallback>();
 		if (callback)
 			callback->Revoke();
+		InternalCommand::Destroy(cmd);
 	};
 
-	for (const InternalCommand& ic : this->commandQueueTick)
-		revoke(ic);
-	for (const InternalCommand& ic : this->commandQueueTime)
-		revoke(ic);
+	InternalCommand* cmd = NULL;
+	while (commandQueue->readyCommands.PopFront(cmd))
+		revoke(cmd);
+	while ((cmd = commandQueue->tickCommands.Pop()) != NULL)
+		revoke(cmd);
+	while ((cmd = commandQueue->timeCommands.Pop()) != NULL)
+		revoke(cmd);
 
-	this->commandQueueTick.Clear();
-	this->commandQueueTime.Clear();
 	return numItems;
 }
 
 bool DKRunLoop::GetNextLoopIntervalNL(double* d) const
 {
-	DKTimer::Tick currentTick = DKTimer::SystemTick();
-	DKDateTime currentDate = DKDateTime::Now();
+	// worker-thread only.
+	commandQueue->Drain();
+
+	if (commandQueue->readyCommands.Count() > 0 || !commandQueue->postedCommands.IsEmpty())
+	{
+		*d = 0.0;
+		return true;
+	}
+
+	const InternalCommand* tickCmd = commandQueue->tickCommands.Top();
+	const InternalCommand* timeCmd = commandQueue->timeCommands.Top();
 
-	size_t numTickCmd = 0;
-	size_t numTimeCmd = 0;
 	double tickDelay = 0;
 	double timeDelay = 0;
 
-	numTickCmd = commandQueueTick.Count();
-	numTimeCmd = commandQueueTime.Count();
-
-	double freq = 1.0 / static_cast<double>(DKTimer::SystemTickFrequency());
-	if (numTickCmd > 0)
+	if (tickCmd)
 	{
-		const InternalCommandTick& cmd = commandQueueTick.Value(0);
-		if (cmd.fire > currentTick && freq > 0)
-			tickDelay = static_cast<double>(cmd.fire - currentTick) * freq;
+		DKTimer::Tick currentTick = DKTimer::SystemTick();
+		double freq = 1.0 / static_cast<double>(DKTimer::SystemTickFrequency());
+		if (tickCmd->fireTick > currentTick && freq > 0)
+			tickDelay = static_cast<double>(tickCmd->fireTick - currentTick) * freq;
 	}
-	if (numTimeCmd > 0)
+	if (timeCmd)
 	{
-		const InternalCommandTime& cmd = commandQueueTime.Value(0);
-		if (cmd.fire > currentDate)
-			timeDelay = cmd.fire.Interval(currentDate);
+		DKDateTime currentDate = DKDateTime::Now();
+		if (timeCmd->fireTime > currentDate)
+			timeDelay = timeCmd->fireTime.Interval(currentDate);
 	}
 
-	if (numTickCmd > 0 || numTimeCmd > 0)
+	if (tickCmd || timeCmd)
 	{
 		double delay = 0;
 
-		if (numTickCmd > 0 && numTimeCmd > 0)
+		if (tickCmd && timeCmd)
 			delay = Min(tickDelay, timeDelay);
-		else if (numTickCmd > 0)
+		else if (tickCmd)
 			delay = tickDelay;
 		else
 			delay = timeDelay;
@@ -381,42 +621,89 @@ bool DKRunLoop::GetNextLoopIntervalNL(double* d) const
 	return false;
 }
 
+namespace DKFoundation
+{
+	namespace Private
+	{
+		// park worker-thread until command posted or timed out. (t < 0 for infinite)
+		template <typename CommandQueue, typename Cond, typename Pred>
+		static void RunLoopWaitForCommand(CommandQueue* queue, Cond& cond, double t, Pred&& shouldWake)
+		{
+#if DKGL_RUNLOOP_USE_FUTEX
+			queue->wakeState = CommandQueue::WakeStateSleeping;
+			if (!shouldWake())
+			{
+				struct timespec ts;
+				if (t >= 0.0)
+				{
+					ts.tv_sec = static_cast<time_t>(t);
+					ts.tv_nsec = static_cast<long>((t - static_cast<double>(ts.tv_sec)) * 1000000000.0);
+				}
+				syscall(SYS_futex, &queue->wakeState, FUTEX_WAIT_PRIVATE, (int)CommandQueue::WakeStateSleeping, t >= 0.0 ? &ts : NULL, NULL, 0);
+			}
+			queue->wakeState = CommandQueue::WakeStateRunning;
+#else
+			DKCriticalSection<DKCondition> guard(cond);
+			queue->wakeState = CommandQueue::WakeStateSleeping;
+			if (!shouldWake())
+			{
+				if (t >= 0.0)
+					cond.WaitTimeout(t);
+				else
+					cond.Wait();
+			}
+			queue->wakeState = CommandQueue::WakeStateRunning;
+#endif
+		}
+	}
+}
+
 void DKRunLoop::WaitNextLoop(void)
 {
-	DKCriticalSection<DKCondition> guard(this->commandQueueCond);
+	DKASSERT_DEBUG(this->IsWrokingThread());
+
+	auto shouldWake = [this]()->bool
+	{
+		return !commandQueue->postedCommands.IsEmpty() || this->TerminateRequested();
+	};
 
 	double d = 0.0;
 	if (GetNextLoopIntervalNL(&d))
 	{
 		d = Max(d, 0.0);
 		if (d > 0.0)
-			this->commandQueueCond.WaitTimeout(d);
+			RunLoopWaitForCommand(commandQueue, commandQueueCond, d, shouldWake);
 	}
 	else
 	{
-		this->commandQueueCond.Wait();
+		RunLoopWaitForCommand(commandQueue, commandQueueCond, -1.0, shouldWake);
 	}
 }
 
 bool DKRunLoop::WaitNextLoopTimeout(double t)
 {
-	if (t > 0.0)
+	DKASSERT_DEBUG(this->IsWrokingThread());
+
+	auto shouldWake = [this]()->bool
 	{
-		DKCriticalSection<DKCondition> guard(this->commandQueueCond);
+		return !commandQueue->postedCommands.IsEmpty() || this->TerminateRequested();
+	};
 
+	if (t > 0.0)
+	{
 		double d = 0.0;
 		if (GetNextLoopIntervalNL(&d))
 		{
 			double delay = Clamp(d, 0.0, t);
 			if (delay > 0.0)
 			{
-				this->commandQueueCond.WaitTimeout(delay);
+				RunLoopWaitForCommand(commandQueue, commandQueueCond, delay, shouldWake);
 			}
 			return delay < t;
 		}
 		else
 		{
-			this->commandQueueCond.WaitTimeout(t);
+			RunLoopWaitForCommand(commandQueue, commandQueueCond, t, shouldWake);
 		}
 	}
 	return false;
@@ -444,38 +731,41 @@ bool DKRunLoop::ProcessOne(bool processIdle)
 {
 	DKASSERT_DEBUG(this->threadId == DKThread::CurrentThreadId());
 
-	DKObject<DKOperation> operation = NULL;
-	DKObject<OperationResult> result = NULL;
+	commandQueue->Drain();
 
-	commandQueueCond.Lock();
+	InternalCommand* cmd = NULL;
 
-	DKDateTime currentTime = DKDateTime::Now();
 	DKTimer::Tick currentTick = DKTimer::SystemTick();
 
-	if (operation == NULL && this->commandQueueTick.Count() > 0)
+	// ready commands and expired tick commands, ordered by fire tick.
+	InternalCommand* tickCmd = commandQueue->tickCommands.Top();
+	if (tickCmd && tickCmd->fireTick > currentTick)
+		tickCmd = NULL;
+	if (commandQueue->readyCommands.Count() > 0)
 	{
-		const InternalCommandTick& cmd = this->commandQueueTick.Value(0);
-		if (cmd.fire <= currentTick)
+		InternalCommand* readyCmd = commandQueue->readyCommands.Value(0);
+		if (tickCmd == NULL || readyCmd->fireTick <= tickCmd->fireTick)
 		{
-			operation = cmd.operation;
-			result = cmd.result;
-			this->commandQueueTick.Remove(0);
+			commandQueue->readyCommands.PopFront(cmd);
+			tickCmd = NULL;
 		}
 	}
-	if (operation == NULL && this->commandQueueTime.Count() > 0)
+	if (tickCmd)
 	{
-		const InternalCommandTime& cmd = this->commandQueueTime.Value(0);
-		if (cmd.fire <= currentTime)
-		{
-			operation = cmd.operation;
-			result = cmd.result;
-			this->commandQueueTime.Remove(0);
-		}
+		cmd = commandQueue->tickCommands.Pop();
+	}
+	if (cmd == NULL && commandQueue->timeCommands.Count() > 0)
+	{
+		if (commandQueue->timeCommands.Top()->fireTime <= DKDateTime::Now())
+			cmd = commandQueue->timeCommands.Pop();
 	}
-	commandQueueCond.Unlock();
 
-	if (operation)
+	if (cmd)
 	{
+		DKObject<DKOperation> operation = cmd->operation;
+		DKObject<OperationResult> result = cmd->result;
+		InternalCommand::Destroy(cmd);
+
 		struct OpWrapper : public DKOperation
 		{
 			OpWrapper(DKRunLoop* r, DKOperation* o) : rl(r), op(o) {}
@@ -562,13 +852,7 @@ void DKRunLoop::RunLoopProc(void)
 	this->OnInitialize();
 	DKLog("DKRunLoop Thread:0x%x initialized.\n", threadId);
 
-	auto TerminateRequest = [this]()->bool
-	{
-		DKCriticalSection<DKSpinLock> tmp(threadLock);
-		return this->terminate;
-	};
-
-	while (!TerminateRequest())
+	while (!TerminateRequested())
 	{
 		DKASSERT_DEBUG(this->threadId == this->thread->Id());
 		this->ProcessOne(true);
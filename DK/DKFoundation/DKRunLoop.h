@@ -40,6 +40,12 @@
 //   tick-based: system-tick based, calling operation with delayed time.
 //   time-based: system time based, calling operation at specified system time.
 //               if system time has changed, calling operations will adjusted.
+//
+// Operations are posted into lock-free queue (multi-producer, single-consumer)
+// worker-thread moves delayed operations into timer heaps which are accessed
+// by worker-thread only. Posting an operation does not require locking,
+// worker-thread is woken only when it is sleeping. (futex on Linux/Android)
+// WaitNextLoop, WaitNextLoopTimeout should be called in worker-thread.
 ////////////////////////////////////////////////////////////////////////////////
 
 namespace DKFoundation
@@ -95,29 +101,19 @@ namespace DKFoundation
 		void RunLoopProc(void);
 		bool GetNextLoopIntervalNL(double*) const;
 
-		struct InternalCommand
-		{
-			DKObject<DKOperation>		operation;
-			DKObject<OperationResult>	result;
+		struct InternalCommand;
+		struct CommandQueue;
+		void InternalPostCommand(InternalCommand* cmd);
+		void WakeUp(void);
+		bool TerminateRequested(void) const;
 
-			virtual ~InternalCommand(void) {}
-		};
-		struct InternalCommandTick : public InternalCommand { DKTimer::Tick fire; };
-		struct InternalCommandTime : public InternalCommand { DKDateTime fire; };
-		void InternalPostCommand(const InternalCommandTick& cmd);
-		void InternalPostCommand(const InternalCommandTime& cmd);
-
-		DKCondition								commandQueueCond;
-		DKOrderedArray<InternalCommandTick>		commandQueueTick;
-		DKOrderedArray<InternalCommandTime>		commandQueueTime;
+		CommandQueue*		commandQueue;	// accessed by worker-thread only, except posting.
+		DKCondition			commandQueueCond;
 
 		DKObject<DKThread>	thread;
 		DKThread::ThreadId	threadId;
 		DKSpinLock			threadLock;
 		bool				terminate;
-
-		static bool InternalCommandCompareOrder(const InternalCommandTick&, const InternalCommandTick&);
-		static bool InternalCommandCompareOrder(const InternalCommandTime&, const InternalCommandTime&);
 	};
 	typedef DKRunLoop::OperationResult DKRunLoopOperationResult;
 }
@@ -7,6 +7,9 @@
 
 #ifdef _WIN32
 #include <windows.h>
+#elif defined(__linux__)
+#include <limits.h>
+#define DKGL_SHAREDLOCK_USE_FUTEX 1
 #else
 #include <pthread.h>
 #include <errno.h>
@@ -14,6 +17,7 @@
 
 #include "DKSharedLock.h"
 #include "DKThread.h"
+#include "DKTimer.h"
 #include "DKMap.h"
 #include "DKSpinLock.h"
 
@@ -70,7 +74,7 @@ namespace DKFoundation
 			}
 #endif
 		public:
-			SharedLockImpl(void)
+			SharedLockImpl(bool)
 			{
 				::InitializeSRWLock(&lock);
 #ifdef DKGL_DEBUG_ENABLED
@@ -150,6 +154,243 @@ namespace DKFoundation
 		};
 	}
 }
+#elif DKGL_SHAREDLOCK_USE_FUTEX
+namespace DKFoundation
+{
+	namespace Private
+	{
+		// defined in DKSpinLock.cpp
+		void LockSpinPause(uint32_t count);
+		bool LockParkThread(volatile int32_t* p, int32_t v);
+		void LockUnparkThreads(volatile int32_t* p, int32_t numThreads);
+
+		// futex based rw-lock.
+		// state: reader count, writer bit, waiters bit.
+		// readers are not blocked by waiting writers, a thread which holds
+		// shared lock can lock shared again. (same as default pthread_rwlock)
+		// all waiters are parked on state, waiters bit is cleared only by
+		// writer's unlock which wakes all waiters.
+		//
+		// writer-preferred lock:
+		// readers are blocked while writers are waiting. (shared lock can not
+		// be nested) writers are parked on writerWake and woken one by one.
+		class SharedLockImpl
+		{
+		public:
+			enum : int32_t
+			{
+				ReaderMask = 0x0fffffff,
+				WriterLocked = 0x10000000,
+				Waiters = 0x20000000,
+			};
+			enum { MaxBackoff = 128 };
+
+			SharedLockImpl(bool wp) : state(0), waitingWriters(0), writerWake(0), writerPreferred(wp), counter(NULL)
+			{
+			}
+			~SharedLockImpl(void)
+			{
+				DKASSERT_DEBUG(state == 0);
+			}
+			void Lock(void) const
+			{
+				if (state.CompareAndSet(0, WriterLocked))
+					return;
+
+				if (writerPreferred)
+					return LockWriterPreferred();
+
+				uint32_t spins = 0;
+				uint32_t parks = 0;
+				bool acquired = false;
+				for (uint32_t backoff = 1; backoff <= MaxBackoff && !acquired; backoff = backoff << 1)
+				{
+					LockSpinPause(backoff);
+					spins += backoff;
+					int32_t s = state;
+					if ((s & (ReaderMask | WriterLocked)) == 0)
+						acquired = state.CompareAndSet(s, s | WriterLocked);
+				}
+				while (!acquired)
+				{
+					int32_t s = state;
+					if ((s & (ReaderMask | WriterLocked)) == 0)
+					{
+						acquired = state.CompareAndSet(s, s | WriterLocked);
+						continue;
+					}
+					if ((s & Waiters) == 0)
+					{
+						if (!state.CompareAndSet(s, s | Waiters))
+							continue;
+						s |= Waiters;
+					}
+					LockParkThread(Address(), s);
+					parks++;
+				}
+				if (counter)
+				{
+					counter->spins.Add(spins);
+					counter->parks.Add(parks);
+				}
+			}
+			bool TryLock(void) const
+			{
+				int32_t s = state;
+				if ((s & (ReaderMask | WriterLocked)) == 0)
+					return state.CompareAndSet(s, s | WriterLocked);
+				return false;
+			}
+			void Unlock(void) const
+			{
+				DKASSERT_DEBUG((state & WriterLocked) != 0);
+				if (writerPreferred && waitingWriters > 0)
+				{
+					// pass lock to next writer, keep readers parked.
+					int32_t s = state;
+					while (!state.CompareAndSet(s, s & Waiters))
+						s = state;
+					WakeWriter();
+					return;
+				}
+				if (state.Exchange(0) & Waiters)
+					LockUnparkThreads(Address(), INT_MAX);
+			}
+			void LockShared(void) const
+			{
+				if (TryLockShared())
+					return;
+
+				uint32_t spins = 0;
+				uint32_t parks = 0;
+				bool acquired = false;
+				for (uint32_t backoff = 1; backoff <= MaxBackoff && !acquired; backoff = backoff << 1)
+				{
+					LockSpinPause(backoff);
+					spins += backoff;
+					acquired = TryLockShared();
+				}
+				while (!acquired)
+				{
+					int32_t s = state;
+					if ((s & WriterLocked) == 0 && !WritersWaiting())
+					{
+						acquired = state.CompareAndSet(s, s + 1);
+						continue;
+					}
+					if ((s & Waiters) == 0)
+					{
+						if (!state.CompareAndSet(s, s | Waiters))
+							continue;
+						s |= Waiters;
+					}
+					// writers could be gone before waiters bit has been set.
+					if ((s & WriterLocked) == 0 && !WritersWaiting())
+						continue;
+					LockParkThread(Address(), s);
+					parks++;
+				}
+				if (counter)
+				{
+					counter->spins.Add(spins);
+					counter->parks.Add(parks);
+				}
+			}
+			bool TryLockShared(void) const
+			{
+				int32_t s = state;
+				while ((s & WriterLocked) == 0 && !WritersWaiting())
+				{
+					if (state.CompareAndSet(s, s + 1))
+						return true;
+					s = state;
+				}
+				return false;
+			}
+			void UnlockShared(void) const
+			{
+				int32_t prev = state.Decrement();
+				DKASSERT_DEBUG((prev & ReaderMask) > 0);
+				if ((prev & ReaderMask) == 1)
+				{
+					// last reader, wake one writer.
+					if (writerPreferred)
+					{
+						if (waitingWriters > 0)
+							WakeWriter();
+					}
+					else if (prev & Waiters)
+					{
+						// only writers can be parked while readers hold lock.
+						// waiters bit is kept for other writers, it will be
+						// cleared by unlocking writer.
+						LockUnparkThreads(Address(), 1);
+					}
+				}
+			}
+			void LockWriterPreferred(void) const
+			{
+				// readers do not acquire lock while writers are waiting.
+				waitingWriters.Increment();
+
+				uint32_t spins = 0;
+				uint32_t parks = 0;
+				bool acquired = false;
+				for (uint32_t backoff = 1; backoff <= MaxBackoff && !acquired; backoff = backoff << 1)
+				{
+					LockSpinPause(backoff);
+					spins += backoff;
+					int32_t s = state;
+					if ((s & (ReaderMask | WriterLocked)) == 0)
+						acquired = state.CompareAndSet(s, s | WriterLocked);
+				}
+				while (!acquired)
+				{
+					int32_t w = writerWake;
+					int32_t s = state;
+					if ((s & (ReaderMask | WriterLocked)) == 0)
+					{
+						acquired = state.CompareAndSet(s, s | WriterLocked);
+						continue;
+					}
+					// releasing thread changes state before writerWake.
+					LockParkThread(WriterWakeAddress(), w);
+					parks++;
+				}
+				waitingWriters.Decrement();
+				if (counter)
+				{
+					counter->spins.Add(spins);
+					counter->parks.Add(parks);
+				}
+			}
+			FORCEINLINE bool WritersWaiting(void) const
+			{
+				return writerPreferred && waitingWriters > 0;
+			}
+			FORCEINLINE void WakeWriter(void) const
+			{
+				writerWake.Increment();
+				LockUnparkThreads(WriterWakeAddress(), 1);
+			}
+			FORCEINLINE volatile int32_t* Address(void) const
+			{
+				static_assert(sizeof(DKAtomicNumber32) == sizeof(int32_t), "DKAtomicNumber32 should be 32bit integer");
+				return reinterpret_cast<volatile int32_t*>(&state);
+			}
+			FORCEINLINE volatile int32_t* WriterWakeAddress(void) const
+			{
+				return reinterpret_cast<volatile int32_t*>(&writerWake);
+			}
+
+			mutable DKAtomicNumber32 state;
+			mutable DKAtomicNumber32 waitingWriters;
+			mutable DKAtomicNumber32 writerWake;	// sequence, writers are parked on.
+			const bool writerPreferred;
+			DKLockContentionCounter* counter;
+		};
+	}
+}
 #else
 namespace DKFoundation
 {
@@ -158,7 +399,7 @@ namespace DKFoundation
 		class SharedLockImpl
 		{
 		public:
-			SharedLockImpl(void)
+			SharedLockImpl(bool)
 			{
 				pthread_rwlockattr_init(&attr);
 				pthread_rwlockattr_setpshared(&attr, PTHREAD_PROCESS_PRIVATE);
@@ -230,9 +471,44 @@ namespace DKFoundation
 using namespace DKFoundation;
 using namespace DKFoundation::Private;
 
+namespace DKFoundation
+{
+	namespace Private
+	{
+		// count acquisition, measure waiting time if lock is contended.
+		template <typename TryLockFunc, typename LockFunc>
+		FORCEINLINE void SharedLockCountedLock(DKLockContentionCounter* counter, TryLockFunc&& tryLock, LockFunc&& lock)
+		{
+			if (counter)
+			{
+				if (!tryLock())
+				{
+					DKTimer::Tick t0 = DKTimer::SystemTick();
+					lock();
+					counter->contentions.Increment();
+					counter->waitTicks.Add(DKTimer::SystemTick() - t0);
+				}
+				counter->acquisitions.Increment();
+			}
+			else
+			{
+				lock();
+			}
+		}
+	}
+}
+
 DKSharedLock::DKSharedLock(void)
+	: counter(NULL)
 {
-	impl = reinterpret_cast<void*>(new SharedLockImpl);
+	impl = reinterpret_cast<void*>(new SharedLockImpl(false));
+	DKASSERT_DEBUG(impl != NULL);
+}
+
+DKSharedLock::DKSharedLock(bool writerPreferred)
+	: counter(NULL)
+{
+	impl = reinterpret_cast<void*>(new SharedLockImpl(writerPreferred));
 	DKASSERT_DEBUG(impl != NULL);
 }
 
@@ -245,13 +521,20 @@ DKSharedLock::~DKSharedLock(void)
 void DKSharedLock::LockShared(void) const
 {
 	DKASSERT_DEBUG(impl != NULL);
-	return reinterpret_cast<SharedLockImpl*>(impl)->LockShared();
+	SharedLockImpl* p = reinterpret_cast<SharedLockImpl*>(impl);
+	SharedLockCountedLock(counter, [p]{ return p->TryLockShared(); }, [p]{ p->LockShared(); });
 }
 
 bool DKSharedLock::TryLockShared(void) const
 {
 	DKASSERT_DEBUG(impl != NULL);
-	return reinterpret_cast<SharedLockImpl*>(impl)->TryLockShared();
+	if (reinterpret_cast<SharedLockImpl*>(impl)->TryLockShared())
+	{
+		if (counter)
+			counter->acquisitions.Increment();
+		return true;
+	}
+	return false;
 }
 
 void DKSharedLock::UnlockShared(void) const
@@ -263,13 +546,20 @@ void DKSharedLock::UnlockShared(void) const
 void DKSharedLock::Lock(void) const
 {
 	DKASSERT_DEBUG(impl != NULL);
-	return reinterpret_cast<SharedLockImpl*>(impl)->Lock();
+	SharedLockImpl* p = reinterpret_cast<SharedLockImpl*>(impl);
+	SharedLockCountedLock(counter, [p]{ return p->TryLock(); }, [p]{ p->Lock(); });
 }
 
 bool DKSharedLock::TryLock(void) const
 {
 	DKASSERT_DEBUG(impl != NULL);
-	return reinterpret_cast<SharedLockImpl*>(impl)->TryLock();
+	if (reinterpret_cast<SharedLockImpl*>(impl)->TryLock())
+	{
+		if (counter)
+			counter->acquisitions.Increment();
+		return true;
+	}
+	return false;
 }
 
 void DKSharedLock::Unlock(void) const
@@ -277,3 +567,11 @@ void DKSharedLock::Unlock(void) const
 	DKASSERT_DEBUG(impl != NULL);
 	return reinterpret_cast<SharedLockImpl*>(impl)->Unlock();
 }
+
+void DKSharedLock::SetContentionCounter(DKLockContentionCounter* c)
+{
+	counter = c;
+#if DKGL_SHAREDLOCK_USE_FUTEX
+	reinterpret_cast<SharedLockImpl*>(impl)->counter = c;
+#endif
+}
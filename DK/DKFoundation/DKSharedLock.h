@@ -7,6 +7,7 @@
 
 #pragma once
 #include "../DKInclude.h"
+#include "DKSpinLock.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 // DKSharedLock
@@ -15,6 +16,19 @@
 // LockShared(), read-lock, can be locked by some threads concurrently.
 // Lock (write-lock, exclusive), only one thread can have lock.
 //
+// On Linux/Android, futex based implementation is used.
+// (readers do not wait for waiting writers, shared lock can be nested)
+// Win32 uses SRWLock, shared lock can not be nested. (thread which locks
+// shared again can be blocked by waiting writer)
+// other platforms use pthread_rwlock.
+//
+// Writer-preferred lock can be created optionally on Linux/Android.
+// readers wait while writers are waiting, writers are not starved by
+// continuous readers, but shared lock can not be nested. (deadlock)
+// this option is ignored on other platforms.
+//
+// Contention counter can be set optionally. (see DKSpinLock.h)
+//
 // Note:
 //  Only exclusive locking works with DKCriticalSecton.
 //  Use DKSharedLockReadOnlySecton instead for shared-locking with scoped context.
@@ -26,6 +40,7 @@ namespace DKFoundation
 	{
 	public:
 		DKSharedLock(void);
+		explicit DKSharedLock(bool writerPreferred);
 		~DKSharedLock(void);
 		void LockShared(void) const;
 		bool TryLockShared(void) const;
@@ -34,10 +49,15 @@ namespace DKFoundation
 		bool TryLock(void) const;	// exclusive
 		void Unlock(void) const;	// exclusive
 
+		// set NULL to disable counting. (default)
+		void SetContentionCounter(DKLockContentionCounter* counter);
+		DKLockContentionCounter* ContentionCounter(void) const	{ return counter; }
+
 	private:
 		DKSharedLock(const DKSharedLock&);
 		DKSharedLock& operator = (const DKSharedLock&);
 		void* impl;
+		DKLockContentionCounter* counter;
 	};
 
 	// context scope based helper class.
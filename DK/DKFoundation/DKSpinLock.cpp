@@ -5,8 +5,19 @@
 //  Copyright (c) 2004-2015 Hongtae Kim. All rights reserved.
 //
 
+#ifdef _WIN32
+#include <intrin.h>
+#endif
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#define DKGL_SPINLOCK_USE_FUTEX 1
+#endif
+
 #include "DKSpinLock.h"
 #include "DKThread.h"
+#include "DKTimer.h"
 
 namespace DKFoundation
 {
@@ -16,7 +27,48 @@ namespace DKFoundation
 		{
 			SpinLockStateFree = 0,
 			SpinLockStateLocked = 1,
+			SpinLockStateLockedWithWaiters = 2,	// futex only
 		};
+		enum { SpinLockMaxBackoff = 128 };	// pause count of last spin.
+
+		// used by DKSharedLock also.
+		void LockSpinPause(uint32_t count)
+		{
+			for (uint32_t i = 0; i < count; ++i)
+			{
+#if defined(_M_IX86) || defined(_M_X64)
+				_mm_pause();
+#elif defined(__i386__) || defined(__x86_64__)
+				__builtin_ia32_pause();
+#elif defined(__aarch64__) || (defined(__ARM_ARCH) && __ARM_ARCH >= 7)
+				__asm__ __volatile__("yield");
+#endif
+			}
+		}
+		// wait until value of p is not equal to v. (can be spurious)
+		// returns false if parking is not supported.
+		bool LockParkThread(volatile int32_t* p, int32_t v)
+		{
+#if DKGL_SPINLOCK_USE_FUTEX
+			syscall(SYS_futex, p, FUTEX_WAIT_PRIVATE, v, NULL, NULL, 0);
+			return true;
+#else
+			DKThread::Yield();
+			return false;
+#endif
+		}
+		void LockUnparkThreads(volatile int32_t* p, int32_t numThreads)
+		{
+#if DKGL_SPINLOCK_USE_FUTEX
+			syscall(SYS_futex, p, FUTEX_WAKE_PRIVATE, numThreads, NULL, NULL, 0);
+#endif
+		}
+		// atomic value address for futex.
+		FORCEINLINE volatile int32_t* AtomicAddress(DKAtomicNumber32& atomic)
+		{
+			static_assert(sizeof(DKAtomicNumber32) == sizeof(int32_t), "DKAtomicNumber32 should be 32bit integer");
+			return reinterpret_cast<volatile int32_t*>(&atomic);
+		}
 	}
 }
 
@@ -25,6 +77,7 @@ using namespace DKFoundation::Private;
 
 DKSpinLock::DKSpinLock(void)
 	: state(SpinLockStateFree)
+	, counter(NULL)
 {
 }
 
@@ -34,16 +87,75 @@ DKSpinLock::~DKSpinLock(void)
 
 void DKSpinLock::Lock(void) const
 {
-	while (!TryLock())
-		DKThread::Yield();
+	if (state.CompareAndSet(SpinLockStateFree, SpinLockStateLocked))
+	{
+		if (counter)
+			counter->acquisitions.Increment();
+		return;
+	}
+	LockContended();
+}
+
+void DKSpinLock::LockContended(void) const
+{
+	DKTimer::Tick t0 = counter ? DKTimer::SystemTick() : 0;
+	uint32_t spins = 0;
+	uint32_t parks = 0;
+	bool acquired = false;
+
+	// spin with exponential backoff.
+	for (uint32_t backoff = 1; backoff <= SpinLockMaxBackoff && !acquired; backoff = backoff << 1)
+	{
+		LockSpinPause(backoff);
+		spins += backoff;
+		if (state == SpinLockStateFree)
+			acquired = state.CompareAndSet(SpinLockStateFree, SpinLockStateLocked);
+	}
+	if (!acquired)
+	{
+#if DKGL_SPINLOCK_USE_FUTEX
+		// mark waiters, unlock will wake one.
+		while (state.Exchange(SpinLockStateLockedWithWaiters) != SpinLockStateFree)
+		{
+			LockParkThread(AtomicAddress(state), SpinLockStateLockedWithWaiters);
+			parks++;
+		}
+#else
+		while (!state.CompareAndSet(SpinLockStateFree, SpinLockStateLocked))
+		{
+			LockParkThread(AtomicAddress(state), SpinLockStateLocked);
+			parks++;
+		}
+#endif
+	}
+	if (counter)
+	{
+		counter->acquisitions.Increment();
+		counter->contentions.Increment();
+		counter->spins.Add(spins);
+		counter->parks.Add(parks);
+		counter->waitTicks.Add(DKTimer::SystemTick() - t0);
+	}
 }
 
 bool DKSpinLock::TryLock(void) const
 {
-	return state.CompareAndSet(SpinLockStateFree, SpinLockStateLocked);
+	if (state.CompareAndSet(SpinLockStateFree, SpinLockStateLocked))
+	{
+		if (counter)
+			counter->acquisitions.Increment();
+		return true;
+	}
+	return false;
 }
 
 void DKSpinLock::Unlock(void) const
 {
-	state = SpinLockStateFree;
+	if (state.Exchange(SpinLockStateFree) == SpinLockStateLockedWithWaiters)
+		LockUnparkThreads(AtomicAddress(state), 1);
+}
+
+void DKSpinLock::SetContentionCounter(DKLockContentionCounter* c)
+{
+	counter = c;
 }
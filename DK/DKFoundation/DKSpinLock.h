@@ -8,6 +8,7 @@
 #pragma once
 #include "../DKInclude.h"
 #include "DKAtomicNumber32.h"
+#include "DKAtomicNumber64.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 // DKSpinLock
@@ -15,10 +16,33 @@
 // atomic variable used internally.
 // use this class for short period locking.
 // (such as small computation, without I/O.)
+//
+// contended lock spins with exponential backoff for a while, and then
+// parks calling thread. (futex on Linux/Android, yield on other platforms)
+//
+// DKLockContentionCounter
+// optional statistics for finding hot locks. counter is not owned by lock,
+// you can share one counter object with multiple locks.
+//
+// Example:
+//	static DKLockContentionCounter counter;
+//	lock.SetContentionCounter(&counter);
+//	...
+//	DKLog("acquisitions:%lld, contentions:%lld\n",
+//		(int64_t)counter.acquisitions, (int64_t)counter.contentions);
 ////////////////////////////////////////////////////////////////////////////////
 
 namespace DKFoundation
 {
+	struct DKLockContentionCounter
+	{
+		DKAtomicNumber64 acquisitions;	// number of lock acquired.
+		DKAtomicNumber64 contentions;	// number of lock acquired after waiting.
+		DKAtomicNumber64 spins;			// number of spins (pause) while waiting.
+		DKAtomicNumber64 parks;			// number of thread parked while waiting.
+		DKAtomicNumber64 waitTicks;		// total waiting time. (DKTimer::SystemTick unit)
+	};
+
 	class DKGL_API DKSpinLock
 	{
 	public:
@@ -28,9 +52,15 @@ namespace DKFoundation
 		bool TryLock(void) const;
 		void Unlock(void) const;
 
+		// set NULL to disable counting. (default)
+		void SetContentionCounter(DKLockContentionCounter* counter);
+		DKLockContentionCounter* ContentionCounter(void) const	{ return counter; }
+
 	private:
 		DKSpinLock(const DKSpinLock&);
 		DKSpinLock& operator = (const DKSpinLock&);
+		void LockContended(void) const;
 		mutable DKAtomicNumber32 state;
+		DKLockContentionCounter* counter;
 	};
 }
@@ -88,6 +88,23 @@ namespace DKFoundation
 				return LowercaseChar(*p) - LowercaseChar(*q);
 			}
 
+			// FNV-1a hash of characters, never returns 0. (0 is reserved for 'not computed')
+			inline uint32_t StringHash(const DKUniCharW* str, size_t len)
+			{
+				uint32_t h = 2166136261U;
+				for (size_t i = 0; i < len; ++i)
+				{
+					uint32_t c = (uint32_t)str[i];
+					for (int k = 0; k < (int)sizeof(DKUniCharW); ++k)
+					{
+						h ^= (c & 0xff);
+						h *= 16777619U;
+						c >>= 8;
+					}
+				}
+				return h ? h : 1;
+			}
+
 			inline int CompareCaseSensitive(const DKUniCharW* a, const DKUniCharW* b)
 			{
 				if (a == b)
@@ -123,57 +140,66 @@ DKStringEncoding DKStringW::SystemEncoding(void)
 
 // DKStringW class
 DKStringW::DKStringW(void)
-	: stringData(NULL)
+	: length(0), hash(0)
 {
+	inlineData[0] = 0;
 }
 
 DKStringW::DKStringW(DKStringW&& str)
-	: stringData(NULL)
+	: length(str.length), hash(str.hash.load(std::memory_order_relaxed))
 {
-	stringData = str.stringData;
-	str.stringData = NULL;
+	memcpy(inlineData, str.inlineData, sizeof(inlineData));
+	str.inlineData[0] = 0;
+	str.length = 0;
+	str.hash.store(0, std::memory_order_relaxed);
 }
 
 DKStringW::DKStringW(const DKStringW& str)
-	: stringData(NULL)
+	: length(0), hash(0)
 {
+	inlineData[0] = 0;
 	this->SetValue(str);
 }
 
 DKStringW::DKStringW(const DKUniCharW* str, size_t len)
-	: stringData(NULL)
+	: length(0), hash(0)
 {
+	inlineData[0] = 0;
 	this->SetValue(str, len);
 }
 
 DKStringW::DKStringW(const DKUniChar8* str, size_t len)
-	: stringData(NULL)
+	: length(0), hash(0)
 {
+	inlineData[0] = 0;
 	this->SetValue(str, len);
 }
 
 DKStringW::DKStringW(const void* str, size_t len, DKStringEncoding e)
-	: stringData(NULL)
+	: length(0), hash(0)
 {
+	inlineData[0] = 0;
 	this->SetValue(str, len, e);
 }
 
 DKStringW::DKStringW(DKUniCharW c)
-	: stringData(NULL)
+	: length(0), hash(0)
 {
+	inlineData[0] = 0;
 	this->SetValue(&c, 1);
 }
 
 DKStringW::DKStringW(DKUniChar8 c)
-	: stringData(NULL)
+	: length(0), hash(0)
 {
+	inlineData[0] = 0;
 	this->SetValue(&c, 1);
 }
 
 DKStringW::~DKStringW(void)
 {
-	if (stringData)
-		DKMemoryDefaultAllocator::Free(stringData);
+	if (!IsInline())
+		DKMemoryDefaultAllocator::Free(heapData);
 }
 
 DKStringW DKStringW::Format(const DKUniChar8* fmt, ...)
@@ -238,13 +264,7 @@ DKStringW DKStringW::FormatV(const DKUniCharW* fmt, va_list v)
 
 size_t DKStringW::Length(void) const
 {
-	size_t len = 0;
-	if (stringData)
-	{
-		while (stringData[len])
-			len++;
-	}
-	return len;
+	return length;
 }
 
 size_t DKStringW::Bytes(void) const
@@ -252,11 +272,56 @@ size_t DKStringW::Bytes(void) const
 	return Length() * sizeof(DKUniCharW);
 }
 
+uint32_t DKStringW::Hash(void) const
+{
+	// computed value is same for all threads, relaxed order is enough.
+	uint32_t h = hash.load(std::memory_order_relaxed);
+	if (h == 0)
+	{
+		h = Private::StringHash(Data(), length);
+		hash.store(h, std::memory_order_relaxed);
+	}
+	return h;
+}
+
+bool DKStringW::IsEqual(const DKStringW& str) const
+{
+	if (this == &str)
+		return true;
+	if (length != str.length)
+		return false;
+	const uint32_t h1 = hash.load(std::memory_order_relaxed);
+	const uint32_t h2 = str.hash.load(std::memory_order_relaxed);
+	if (h1 && h2 && h1 != h2)
+		return false;
+	return memcmp(Data(), str.Data(), length * sizeof(DKUniCharW)) == 0;
+}
+
+void DKStringW::SetData(const DKUniCharW* str, size_t len)
+{
+	DKASSERT_DEBUG(len < (uint32_t)-1);
+
+	// str can be part of this string, release old buffer after copying.
+	DKUniCharW* oldData = IsInline() ? NULL : heapData;
+	DKUniCharW* buff = inlineData;
+	if (len >= InlineCapacity)
+		buff = (DKUniCharW*)DKMemoryDefaultAllocator::Alloc((len+1) * sizeof(DKUniCharW));
+	if (len > 0)
+		memmove(buff, str, len * sizeof(DKUniCharW));
+	buff[len] = 0;
+	if (oldData)
+		DKMemoryDefaultAllocator::Free(oldData);
+	if (len >= InlineCapacity)
+		heapData = buff;
+	length = (uint32_t)len;
+	hash.store(0, std::memory_order_relaxed);
+}
+
 long DKStringW::Find(DKUniCharW c, long begin) const
 {
 	if (begin < 0)	begin = 0;
 
-	const DKUniCharW *data = stringData;
+	const DKUniCharW *data = Data();
 	size_t len = Length();
 	for (long i = begin; i < (long)len; ++i)
 	{
@@ -278,7 +343,7 @@ long DKStringW::Find(const DKUniCharW* str, long begin) const
 
 	for (long i = begin; i <= maxLength; ++i)
 	{
-		if (wcsncmp(&stringData[i], str, strLength) == 0)
+		if (wcsncmp(&Data()[i], str, strLength) == 0)
 			return (long)i;
 	}
 	return -1;
@@ -301,7 +366,7 @@ long DKStringW::FindAnyCharactersInSet(const CharacterSet& cs, long begin) const
 		size_t len = Length();
 		for (size_t i = begin; i < len; ++i)
 		{
-			if (cs.Contains(this->stringData[i]))
+			if (cs.Contains(Data()[i]))
 				return (long)i;
 		}
 	}
@@ -317,17 +382,7 @@ DKStringW DKStringW::Right(long index) const
 		if (index < 0)
 			index = 0;
 
-		int count = len - index;
-		if (count < 0)
-			count = 0;
-
-		DKUniCharW* tmp = (DKUniCharW*)DKMemoryDefaultAllocator::Alloc((len+1) * sizeof(DKUniCharW));
-		memset(tmp, 0, sizeof(DKUniCharW) * (len+1));
-		wcsncpy(tmp, &stringData[index], count);
-
-		string = tmp;
-
-		DKMemoryDefaultAllocator::Free(tmp);
+		string.SetData(&Data()[index], len - index);
 	}
 	return string;
 }
@@ -341,13 +396,7 @@ DKStringW DKStringW::Left(size_t count) const
 		if (count > len)
 			count = len;
 
-		DKUniCharW* tmp = (DKUniCharW*)DKMemoryDefaultAllocator::Alloc((len+1) * sizeof(DKUniCharW));
-		memset(tmp, 0 , sizeof(DKUniCharW) * (len+1));
-		wcsncpy(tmp, stringData, count);
-
-		string = tmp;
-
-		DKMemoryDefaultAllocator::Free(tmp);
+		string.SetData(Data(), count);
 	}
 	return string;
 }
@@ -362,13 +411,7 @@ DKStringW DKStringW::Mid(long index, size_t count) const
 
 	if (count > 0 && index + count < len)
 	{
-		DKUniCharW* buff = (DKUniCharW*)DKMemoryDefaultAllocator::Alloc((count+1) * sizeof(DKUniCharW));
-		wcsncpy(buff, &stringData[index], count);
-		buff[count] = 0;
-
-		string = buff;
-
-		DKMemoryDefaultAllocator::Free(buff);
+		string.SetData(&Data()[index], count);
 	}
 	else
 	{
@@ -379,65 +422,51 @@ DKStringW DKStringW::Mid(long index, size_t count) const
 
 DKStringW DKStringW::LowercaseString(void) const
 {
-	if (stringData)
+	DKStringW ret = *this;
+	DKUniCharW* buff = ret.Data();
+	ret.hash.store(0, std::memory_order_relaxed);
+	for (size_t i = 0; i < ret.length; ++i)
 	{
-		DKUniCharW *buff = (DKUniCharW*)DKMemoryDefaultAllocator::Alloc((Length()+1) * sizeof(DKUniCharW));
-		int i;
-		for (i = 0 ; stringData[i] != 0; ++i)
-		{
-			buff[i] = towlower(stringData[i]);
-		}
-		buff[i] = 0;
-
-		DKStringW ret = buff;
-		DKMemoryDefaultAllocator::Free(buff);
-		return ret;
+		buff[i] = towlower(buff[i]);
 	}
-	return DKStringW(L"");			
+	return ret;			
 }
 
 DKStringW DKStringW::UppercaseString(void) const
 {
-	if (stringData)
+	DKStringW ret = *this;
+	DKUniCharW* buff = ret.Data();
+	ret.hash.store(0, std::memory_order_relaxed);
+	for (size_t i = 0; i < ret.length; ++i)
 	{
-		DKUniCharW *buff = (DKUniCharW*)DKMemoryDefaultAllocator::Alloc((Length()+1) * sizeof(DKUniCharW));
-		int i;
-		for (i = 0 ; stringData[i] != 0; ++i)
-		{
-			buff[i] = towupper(stringData[i]);
-		}
-		buff[i] = 0;
-
-		DKStringW ret = buff;
-		DKMemoryDefaultAllocator::Free(buff);
-		return ret;
+		buff[i] = towupper(buff[i]);
 	}
-	return DKStringW(L"");			
+	return ret;			
 }
 
 int DKStringW::Compare(const DKUniCharW* str) const
 {
-	return Private::CompareCaseSensitive(stringData, str);
+	return Private::CompareCaseSensitive(Data(), str);
 }
 
 int DKStringW::Compare(const DKStringW& str) const
 {
-	return Private::CompareCaseSensitive(stringData, str.stringData);
+	return Private::CompareCaseSensitive(Data(), str.Data());
 }
 
 int DKStringW::CompareNoCase(const DKUniCharW* str) const
 {
-	return Private::CompareCaseInsensitive(stringData, str);
+	return Private::CompareCaseInsensitive(Data(), str);
 }
 
 int DKStringW::CompareNoCase(const DKStringW& str) const
 {
-	return Private::CompareCaseInsensitive(stringData, str.stringData);
+	return Private::CompareCaseInsensitive(Data(), str.Data());
 }
 
 int DKStringW::Replace(const DKUniCharW c1, const DKUniCharW c2)
 {
-	if (!stringData)
+	if (length == 0)
 		return 0;
 	if (c1 == c2)
 		return 0;
@@ -446,26 +475,30 @@ int DKStringW::Replace(const DKUniCharW c1, const DKUniCharW c2)
 	{
 		if (c2)
 		{
-			for (size_t i = 0; stringData[i]; ++i)
+			DKUniCharW* data = Data();
+			for (size_t i = 0; i < length; ++i)
 			{
-				if (stringData[i] == c1)
+				if (data[i] == c1)
 				{
-					stringData[i] = c2;
+					data[i] = c2;
 					++result;
 				}
 			}
+			if (result > 0)
+				hash.store(0, std::memory_order_relaxed);
 		}
 		else
 		{
 			size_t len = Length();
 			DKUniCharW* tmp = (DKUniCharW*)DKMemoryDefaultAllocator::Alloc((len+1) * sizeof(DKUniCharW));
 			size_t tmpLen = 0;
-			for (size_t i = 0; stringData[i]; ++i)
+			const DKUniCharW* data = Data();
+			for (size_t i = 0; i < len; ++i)
 			{
-				if (stringData[i] == c1)
+				if (data[i] == c1)
 					++result;
 				else
-					tmp[tmpLen++] = stringData[i];
+					tmp[tmpLen++] = data[i];
 			}
 			tmp[tmpLen] = 0;
 			this->SetValue(tmp, tmpLen);
@@ -527,10 +560,10 @@ DKStringW& DKStringW::Insert(long index, const DKUniCharW* str)
 		memset(tmp, 0, sizeof(DKUniCharW) * (len + newStrLen + 4));
 		if (index > 0)
 		{
-			wcsncpy(tmp, stringData, index);
+			wcsncpy(tmp, Data(), index);
 		}
 		wcscat(tmp, str);
-		wcscat(tmp, &stringData[index]);
+		wcscat(tmp, &Data()[index]);
 
 		this->SetValue(tmp);
 
@@ -606,7 +639,7 @@ DKStringW::StringArray DKStringW::PathComponents(void) const
 bool DKStringW::IsWhitespaceCharacterAtIndex(long index) const
 {
 	DKASSERT_DEBUG(Length() > index);
-	return Private::WhitespaceCharacterSet().Contains(stringData[index]);
+	return Private::WhitespaceCharacterSet().Contains(Data()[index]);
 }
 
 DKStringW& DKStringW::TrimWhitespaces(void)
@@ -672,7 +705,7 @@ DKStringW& DKStringW::RemoveWhitespaces(long begin, long count)
 	{
 		if (!IsWhitespaceCharacterAtIndex(i + begin))
 		{
-			buffer[bufferIndex++] = stringData[i+begin];
+			buffer[bufferIndex++] = Data()[i+begin];
 		}
 	}
 	buffer[bufferIndex] = NULL;
@@ -721,30 +754,32 @@ DKStringW& DKStringW::Append(const DKUniCharW* str, size_t len)
 {
 	if (str && str[0])
 	{
-		size_t len1 = Length();
+		size_t len1 = length;
 		size_t len2 = 0;
 		for (len2 = 0; str[len2] && len2 < len; len2++) {}
 
 		size_t totalLen = len1 + len2;
+		DKASSERT_DEBUG(totalLen < (uint32_t)-1);
 
-		if (totalLen > 0)
+		if (totalLen < InlineCapacity)
 		{
-			DKUniCharW* buff = (DKUniCharW*)DKMemoryDefaultAllocator::Alloc((len1 + len2 + 1) * sizeof(DKUniCharW));
-			memset(buff, 0, sizeof(DKUniCharW) * (len1 + len2 + 1));
-
-			if (stringData && stringData[0])
-			{
-				wcscat(buff, stringData);
-				//wcscat_s(pNewBuff, nLen+nLen2+4, stringData);
-			}
-
-			wcscat(buff, str);
-			//wcscat_s(pNewBuff, nLen+nLen2+4, str);
-
-			if (stringData)
-				DKMemoryDefaultAllocator::Free(stringData);
-			stringData = buff;
+			// str cannot overlap with destination range.
+			memcpy(&inlineData[len1], str, len2 * sizeof(DKUniCharW));
+			inlineData[totalLen] = 0;
 		}
+		else
+		{
+			DKUniCharW* buff = (DKUniCharW*)DKMemoryDefaultAllocator::Alloc((totalLen + 1) * sizeof(DKUniCharW));
+			memcpy(buff, Data(), len1 * sizeof(DKUniCharW));
+			memcpy(&buff[len1], str, len2 * sizeof(DKUniCharW));
+			buff[totalLen] = 0;
+
+			if (!IsInline())
+				DKMemoryDefaultAllocator::Free(heapData);
+			heapData = buff;
+		}
+		length = (uint32_t)totalLen;
+		hash.store(0, std::memory_order_relaxed);
 	}
 	return *this;
 }
@@ -765,29 +800,19 @@ DKStringW& DKStringW::Append(const void* str, size_t bytes, DKStringEncoding e)
 
 DKStringW& DKStringW::SetValue(const DKStringW& str)
 {
-	if (str.stringData == this->stringData)
+	if (&str == this)
 		return *this;
 
-	if (this->stringData)
-		DKMemoryDefaultAllocator::Free(this->stringData);
-	this->stringData = NULL;
-
-	size_t len = str.Length();
-	if (len > 0)
-	{
-		DKASSERT_DEBUG(str.stringData != NULL);
-		this->stringData = (DKUniCharW*)DKMemoryDefaultAllocator::Alloc((len+1) * sizeof(DKUniCharW));
-		wcscpy(this->stringData, str.stringData);
-	}
+	SetData(str.Data(), str.length);
+	hash.store(str.hash.load(std::memory_order_relaxed), std::memory_order_relaxed);
 	return *this;
 }
 
 DKStringW& DKStringW::SetValue(const DKUniCharW* str, size_t len)
 {
-	if (str == stringData && len >= this->Length())
+	if (str == Data() && len >= this->Length())
 		return *this;
 
-	DKUniCharW* buff = NULL;
 	if (str && str[0])
 	{
 		for (size_t i = 0; i < len; ++i)
@@ -798,17 +823,12 @@ DKStringW& DKStringW::SetValue(const DKUniCharW* str, size_t len)
 				break;
 			}
 		}
-
-		if (len > 0)
-		{
-			buff = (DKUniCharW*)DKMemoryDefaultAllocator::Alloc((len+1) * sizeof(DKUniCharW));
-			memcpy(buff, str, len * sizeof(DKUniCharW));
-			buff[len] = NULL;
-		}
 	}
-	if (stringData)
-		DKMemoryDefaultAllocator::Free(stringData);
-	stringData = buff;
+	else
+	{
+		len = 0;
+	}
+	SetData(str, len);
 
 	return *this;
 }
@@ -834,11 +854,15 @@ DKStringW& DKStringW::operator = (DKStringW&& str)
 {
 	if (this != &str)
 	{
-		if (stringData)
-			DKMemoryDefaultAllocator::Free(stringData);
-
-		stringData = str.stringData;
-		str.stringData = NULL;
+		if (!IsInline())
+			DKMemoryDefaultAllocator::Free(heapData);
+
+		memcpy(inlineData, str.inlineData, sizeof(inlineData));
+		length = str.length;
+		hash.store(str.hash.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		str.inlineData[0] = 0;
+		str.length = 0;
+		str.hash.store(0, std::memory_order_relaxed);
 	}
 	return *this;
 }
@@ -873,8 +897,8 @@ DKStringW& DKStringW::operator = (DKUniChar8 ch)
 // conversion operators
 DKStringW::operator const DKUniCharW*(void) const
 {
-	if (this && this->stringData)
-		return (const DKUniCharW*)this->stringData;
+	if (this)
+		return this->Data();
 	return L"";
 }
 
@@ -938,22 +962,22 @@ DKObject<DKData> DKStringW::Encode(DKStringEncoding e) const
 
 int64_t DKStringW::ToInteger(void) const
 {
-	if (stringData && stringData[0])
-		return wcstoll(stringData, 0, 0);
+	if (length > 0)
+		return wcstoll(Data(), 0, 0);
 	return 0LL;
 }
 
 uint64_t DKStringW::ToUnsignedInteger(void) const
 {
-	if (stringData && stringData[0])
-		return wcstoull(stringData, 0, 0);
+	if (length > 0)
+		return wcstoull(Data(), 0, 0);
 	return 0ULL;
 }
 
 double DKStringW::ToRealNumber(void) const
 {
-	if (stringData && stringData[0])
-		return wcstod(stringData, 0);
+	if (length > 0)
+		return wcstod(Data(), 0);
 	return 0.0;
 }
 
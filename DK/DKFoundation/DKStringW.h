@@ -8,6 +8,7 @@
 #pragma once
 #include "../DKInclude.h"
 #include <stdarg.h>		// for va_list
+#include <atomic>
 #include "DKObject.h"
 #include "DKSet.h"
 #include "DKArray.h"
@@ -18,6 +19,11 @@
 // a unicode string class with wchar_t character string.
 // UTF-8, CP367 (ISO-8859, ASCII) are available also.
 // (but convert and store with wchar_t string internally.)
+//
+// Short strings (less than InlineCapacity characters) are stored inside
+// the object without heap allocation. Length and hash value are cached,
+// so Length() is O(1) and inequality of different lengths or hashes can be
+// determined without comparing characters.
 ////////////////////////////////////////////////////////////////////////////////
 
 namespace DKFoundation
@@ -62,6 +68,8 @@ namespace DKFoundation
 
 		size_t Length(void) const;
 		size_t Bytes(void) const;
+		// hash value of characters. computed once and cached until modified.
+		uint32_t Hash(void) const;
 
 		long Find(DKUniCharW c, long begin = 0) const;
 		long Find(const DKUniCharW* str, long begin = 0) const;
@@ -148,9 +156,9 @@ namespace DKFoundation
 		bool operator >= (const DKUniCharW* str) const			{return Compare(str) >= 0;}
 		bool operator <= (const DKStringW& str) const			{return Compare(str) <= 0;}
 		bool operator <= (const DKUniCharW* str) const			{return Compare(str) <= 0;}
-		bool operator == (const DKStringW& str) const			{return Compare(str) == 0;}
+		bool operator == (const DKStringW& str) const			{return IsEqual(str);}
 		bool operator == (const DKUniCharW* str) const			{return Compare(str) == 0;}
-		bool operator != (const DKStringW& str) const			{return Compare(str) != 0;}
+		bool operator != (const DKStringW& str) const			{return !IsEqual(str);}
 		bool operator != (const DKUniCharW* str) const			{return Compare(str) != 0;}
 
 		// convert numeric values.
@@ -168,6 +176,22 @@ namespace DKFoundation
 		StringArray SplitByWhitespace(void) const;
 
 	private:
-		CharT* stringData;
+		enum { InlineCapacity = 24 / sizeof(CharT) };
+
+		bool IsInline(void) const			{return length < InlineCapacity;}
+		CharT* Data(void)					{return IsInline() ? inlineData : heapData;}
+		const CharT* Data(void) const		{return IsInline() ? inlineData : heapData;}
+		bool IsEqual(const DKStringW& str) const;
+		// replace contents with str (str can be part of this string)
+		void SetData(const CharT* str, size_t len);
+
+		// no pointer refers to object itself, object can be relocated by memcpy.
+		union
+		{
+			CharT* heapData;
+			CharT inlineData[InlineCapacity];
+		};
+		uint32_t length;
+		mutable std::atomic<uint32_t> hash;	// 0 if not computed. (cached by Hash() const)
 	};
 }
@@ -41,6 +41,7 @@ namespace DKFoundation
 		static inline void PerformOperationInsidePool(DKOperation* op) {op->Perform();}
 #endif
 		void PerformOperationWithErrorHandler(const DKOperation*, size_t);
+		void ReleaseThreadLocalPoolCache(void);
 
 		struct ThreadCreationInfo
 		{
@@ -105,6 +106,9 @@ namespace DKFoundation
 			threadCond.Broadcast();
 			threadCond.Unlock();
 
+			// return units cached by this thread to memory pool.
+			ReleaseThreadLocalPoolCache();
+
 			// terminate thread.
 #ifdef _WIN32
 			//ExitThread(0);
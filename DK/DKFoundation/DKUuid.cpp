@@ -53,6 +53,11 @@ void DKUuid::SetZero(void)
 	v[3] = 0;
 }
 
+void DKUuid::SetBytes(const unsigned char* bytes)
+{
+	memcpy(this->data, bytes, sizeof(this->data));
+}
+
 DKUuid::DKUuid(const DKString& str)
 {
 	memset(this->data, 0, sizeof(this->data));
@@ -42,6 +42,10 @@ namespace DKFoundation
 
 		void SetZero(void);
 
+		// binary representation. (16 bytes)
+		const unsigned char* Bytes(void) const	{return data;}
+		void SetBytes(const unsigned char* bytes);
+
 	private:
 		unsigned char data[16];
 	};
@@ -10,6 +10,8 @@
 #include "DKZipUnarchiver.h"
 #include "DKString.h"
 #include "DKLog.h"
+#include "DKDataStream.h"
+#include "DKFunction.h"
 
 namespace DKFoundation
 {
@@ -164,23 +166,309 @@ namespace DKFoundation
 			const unz_file_info64	fileInfo;
 			DKArray<char>			password;
 		};
+
+		// read little-endian values from archive.
+		inline unsigned int ZipReadUInt16(const unsigned char* p)
+		{
+			return (unsigned int)p[0] | ((unsigned int)p[1] << 8);
+		}
+		inline uint32_t ZipReadUInt32(const unsigned char* p)
+		{
+			return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+		}
+		inline uint64_t ZipReadUInt64(const unsigned char* p)
+		{
+			return (uint64_t)ZipReadUInt32(p) | ((uint64_t)ZipReadUInt32(p + 4) << 32);
+		}
+		// zlib counts input and output with uInt, larger length is
+		// processed in chunks.
+		inline uInt ZipChunkLength(size_t length)
+		{
+			return (uInt)Min(length, (size_t)(uInt)-1);
+		}
+		inline uLong ZipCRC32(const unsigned char* p, size_t length)
+		{
+			uLong crc = crc32(0L, Z_NULL, 0);
+			while (length > 0)
+			{
+				uInt n = ZipChunkLength(length);
+				crc = crc32(crc, p, n);
+				p += n;
+				length -= n;
+			}
+			return crc;
+		}
+		enum : uint32_t
+		{
+			ZipLocalFileHeaderSignature = 0x04034b50,
+			ZipCentralFileHeaderSignature = 0x02014b50,
+			ZipEndOfCentralDirSignature = 0x06054b50,
+			Zip64EndOfCentralDirSignature = 0x06064b50,
+			Zip64EndOfCentralDirLocatorSignature = 0x07064b50,
+		};
+		enum
+		{
+			ZipLocalFileHeaderSize = 30,
+			ZipCentralFileHeaderSize = 46,
+			ZipEndOfCentralDirSize = 22,
+			Zip64EndOfCentralDirLocatorSize = 20,
+			Zip64EndOfCentralDirSize = 56,
+		};
+
+		// inflating deflated file from mapped archive.
+		// decompressed data is written to window (last 32KB of output) and
+		// copied to caller. state of inflater is saved as checkpoint at
+		// deflate block boundary (see zran.c in zlib examples), seeking
+		// restores nearest checkpoint and inflates from there.
+		class ZipInflateStream : public DKStream
+		{
+		public:
+			enum {WindowSize = 32768};
+
+			ZipInflateStream(DKObject<DKFileMap> map, size_t offset, size_t compressedSize, uint64_t uncompressedSize)
+				: fileMap(map)
+				, sourceLength(compressedSize)
+				, totalLength(uncompressedSize)
+				, position(0)
+				, outPos(0)
+				, streamEnd(false)
+			{
+				DKASSERT_DEBUG(fileMap);
+				source = reinterpret_cast<const unsigned char*>(fileMap->LockShared()) + offset;
+				memset(&stream, 0, sizeof(z_stream));
+				initialized = inflateInit2(&stream, -MAX_WBITS) == Z_OK;
+				if (initialized)
+				{
+					stream.next_in = const_cast<Bytef*>(source);
+					stream.avail_in = ZipChunkLength(sourceLength);
+				}
+			}
+			~ZipInflateStream(void)
+			{
+				if (initialized)
+					inflateEnd(&stream);
+				fileMap->UnlockShared();
+			}
+			Position SetPos(Position p)
+			{
+				if (p > totalLength || !initialized)
+					return PositionError;
+
+				// last output is still in window.
+				Position windowBegin = outPos > WindowSize ? outPos - WindowSize : 0;
+				if (p >= windowBegin && p <= outPos)
+				{
+					position = p;
+					return position;
+				}
+
+				// find nearest checkpoint, restart inflater if it is closer
+				// than current output or seeking backward.
+				const Checkpoint* cp = NULL;
+				for (const Checkpoint& c : checkpoints)
+				{
+					if (c.out > p)
+						break;
+					cp = &c;
+				}
+				if (p < outPos || (cp && cp->out > outPos))
+				{
+					if (!Restart(cp))
+						return PositionError;
+				}
+				// skip forward.
+				while (outPos < p)
+				{
+					position = outPos;
+					if (Inflate() == 0)
+						return PositionError;
+				}
+				position = p;
+				return position;
+			}
+			Position GetPos(void) const
+			{
+				return position;
+			}
+			Position RemainLength(void) const
+			{
+				return totalLength - position;
+			}
+			Position TotalLength(void) const
+			{
+				return totalLength;
+			}
+			size_t Read(void* p, size_t s)
+			{
+				if (p == NULL || !initialized)
+					return 0;
+
+				unsigned char* dst = reinterpret_cast<unsigned char*>(p);
+				size_t totalRead = 0;
+				s = (size_t)Min((Position)s, totalLength - position);
+				while (s > 0)
+				{
+					if (position < outPos)
+					{
+						size_t offset = (size_t)(position % WindowSize);
+						size_t n = (size_t)Min(outPos - position, (Position)(WindowSize - offset));
+						n = Min(n, s);
+						memcpy(dst, &window[offset], n);
+						dst += n;
+						s -= n;
+						totalRead += n;
+						position += n;
+					}
+					else if (Inflate() == 0)
+					{
+						break;
+					}
+				}
+				return totalRead;
+			}
+			size_t Write(const void* p, size_t s)
+			{
+				return 0;
+			}
+
+			bool IsReadable(void) const	{return true;}
+			bool IsWritable(void) const	{return false;}
+			bool IsSeekable(void) const	{return true;}
+
+		private:
+			struct Checkpoint
+			{
+				Position out;		// uncompressed offset
+				size_t in;			// compressed offset
+				int bits;			// number of bits of in-1 byte, used by next block.
+				DKArray<unsigned char> dictionary;
+			};
+
+			// inflate into window, returns bytes decompressed.
+			size_t Inflate(void)
+			{
+				DKASSERT_DEBUG(position == outPos);
+				if (streamEnd)
+					return 0;
+
+				const size_t offset = (size_t)(outPos % WindowSize);
+				stream.next_out = &window[offset];
+				stream.avail_out = (uInt)(WindowSize - offset);
+
+				size_t produced = 0;
+				while (stream.avail_out > 0)
+				{
+					if (stream.avail_in == 0)
+						stream.avail_in = ZipChunkLength(sourceLength - (stream.next_in - source));
+					int err = inflate(&stream, Z_BLOCK);
+					produced = (WindowSize - offset) - stream.avail_out;
+					if (err == Z_STREAM_END)
+					{
+						streamEnd = true;
+						break;
+					}
+					if (err != Z_OK)
+					{
+						if (err != Z_BUF_ERROR)
+							DKLog("[%s] inflate failed: %d\n", DKGL_FUNCTION_NAME, err);
+						streamEnd = true;
+						break;
+					}
+					// end of deflate block, save checkpoint if needed.
+					if ((stream.data_type & 128) && !(stream.data_type & 64))
+					{
+						Position out = outPos + produced;
+						Position last = checkpoints.Count() > 0 ? checkpoints.Value(checkpoints.Count() - 1).out : 0;
+						if (out >= last + DKZipUnarchiver::CheckpointInterval)
+							AddCheckpoint(out, offset + produced);
+					}
+				}
+				outPos += produced;
+				return produced;
+			}
+			void AddCheckpoint(Position out, size_t windowEnd)
+			{
+				// windowEnd: end of output in window (may be WindowSize)
+				Checkpoint c;
+				c.out = out;
+				c.in = stream.next_in - source;
+				c.bits = stream.data_type & 7;
+				size_t length = (size_t)Min(out, (Position)WindowSize);
+				c.dictionary.Reserve(length);
+				const size_t end = windowEnd % WindowSize;
+				if (out >= WindowSize)	// window is full, oldest byte is at end.
+				{
+					c.dictionary.Add(&window[end], WindowSize - end);
+					c.dictionary.Add(&window[0], end);
+				}
+				else
+				{
+					c.dictionary.Add(&window[0], length);
+				}
+				DKASSERT_DEBUG(c.dictionary.Count() == length);
+				checkpoints.Add(c);
+			}
+			bool Restart(const Checkpoint* cp)
+			{
+				if (inflateReset(&stream) != Z_OK)
+					return false;
+				streamEnd = false;
+				if (cp)
+				{
+					stream.next_in = const_cast<Bytef*>(source + cp->in);
+					stream.avail_in = ZipChunkLength(sourceLength - cp->in);
+					if (cp->bits)
+					{
+						int value = source[cp->in - 1] >> (8 - cp->bits);
+						if (inflatePrime(&stream, cp->bits, value) != Z_OK)
+							return false;
+					}
+					const unsigned char* dict = cp->dictionary;
+					const size_t dictLength = cp->dictionary.Count();
+					if (inflateSetDictionary(&stream, dict, (uInt)dictLength) != Z_OK)
+						return false;
+					// restore window also, can be read after seeking.
+					for (size_t i = 0; i < dictLength; ++i)
+						window[(size_t)((cp->out - dictLength + i) % WindowSize)] = dict[i];
+					outPos = cp->out;
+				}
+				else
+				{
+					stream.next_in = const_cast<Bytef*>(source);
+					stream.avail_in = ZipChunkLength(sourceLength);
+					outPos = 0;
+				}
+				position = outPos;
+				return true;
+			}
+
+			DKObject<DKFileMap> fileMap;
+			const unsigned char* source;
+			const size_t sourceLength;
+			const Position totalLength;
+			Position position;		// read position
+			Position outPos;		// inflated position
+			z_stream stream;
+			bool initialized;
+			bool streamEnd;
+			unsigned char window[WindowSize];
+			DKArray<Checkpoint> checkpoints;
+		};
 	}
 }
 
 using namespace DKFoundation;
 
 DKZipUnarchiver::DKZipUnarchiver(void)
-: zipHandle(NULL)
+: archiveData(NULL)
+, archiveLength(0)
 {
 }
 
 DKZipUnarchiver::~DKZipUnarchiver(void)
 {
-	if (zipHandle)
-	{
-		if (unzClose(zipHandle) != UNZ_OK)
-			DKERROR_THROW_DEBUG("unzClose failed!");
-	}
+	if (fileMap)
+		fileMap->UnlockShared();
 }
 
 DKObject<DKZipUnarchiver> DKZipUnarchiver::Create(const DKString& file)
@@ -190,130 +478,326 @@ DKObject<DKZipUnarchiver> DKZipUnarchiver::Create(const DKString& file)
 
 	DKString filename = file.FilePathString();
 
-	unzFile uf = NULL;
-#ifdef _WIN32
+	DKObject<DKFileMap> fileMap = DKFileMap::Open(filename, 0, false);
+	if (fileMap == NULL)
 	{
-		zlib_filefunc64_def ffunc;
-		fill_win32_filefunc64W(&ffunc);
-		uf = unzOpen2_64((const wchar_t*)filename, &ffunc); // UTF16LE
+		DKLog("[%s] Cannot open file: %ls.\n", DKGL_FUNCTION_NAME, (const wchar_t*)file);
+		return NULL;
 	}
-#else
+
+	DKObject<DKZipUnarchiver> unarchiver = DKObject<DKZipUnarchiver>::New();
+	unarchiver->fileMap = fileMap;
+	unarchiver->archiveData = reinterpret_cast<const unsigned char*>(fileMap->LockShared());
+	unarchiver->archiveLength = fileMap->Length();
+	unarchiver->filename = filename;
+
+	const unsigned char* data = unarchiver->archiveData;
+	const size_t length = unarchiver->archiveLength;
+	if (data == NULL || length < Private::ZipEndOfCentralDirSize)
 	{
-		DKStringU8 filenameUTF8(filename);
-		if (filenameUTF8.Bytes() > 0)
-			uf = unzOpen64((const char*)filenameUTF8); // UTF8
+		DKLog("[%s] Invalid file: %ls.\n", DKGL_FUNCTION_NAME, (const wchar_t*)file);
+		return NULL;
 	}
-#endif
-	if (uf)
+
+	// find end of central directory record. (followed by comment up to 64KB)
+	const unsigned char* eocd = NULL;
+	for (size_t i = length - Private::ZipEndOfCentralDirSize; ; --i)
 	{
-		DKArray<FileInfo>	filesArray;
-		unz_global_info64 gi;
-		int err = unzGetGlobalInfo64(uf,&gi);
-		if (err == UNZ_OK)
+		if (Private::ZipReadUInt32(&data[i]) == Private::ZipEndOfCentralDirSignature)
 		{
-			filesArray.Reserve(gi.number_entry);
-			for (int i = 0; i < gi.number_entry; i++)
-			{
-				DKUniChar8 filename_inzip[1024];
-				unz_file_info64 file_info;
-				err = unzGetCurrentFileInfo64(uf,&file_info,filename_inzip,sizeof(filename_inzip),NULL,0,NULL,0);
-				if (err == UNZ_OK)
-				{
-					FileInfo	file;
-					size_t len = strlen(filename_inzip);
-					if (len > 0 && filename_inzip[len-1] == '/')
-					{
-						file.directory = true;
-						filename_inzip[len-1] = 0; // ignore last path separator
-					}
-					else
-						file.directory = false;
-					file.name = DKString(filename_inzip);
-					if (len > 0 && file.name.Length() > 0)
-					{
-						file.uncompressedSize = file_info.uncompressed_size;
-						file.compressedSize = file_info.compressed_size;
-						file.crypted = file_info.flag & 1;
-						file.compressLevel = 0;
-						switch (file_info.compression_method)
-						{
-						case 0:
-							file.method = MethodStored;
-							break;
-						case Z_DEFLATED:
-							file.method = MethodDeflated;
-							file.compressLevel = (file_info.flag & 0x6) / 2;
-							break;
-						case Z_BZIP2ED:
-							file.method = MethodBZip2ed;
-							break;
-						default:
-							file.method = MethodUnknown;
-							break;
-						}
-						file.crc32 = file_info.crc;
-						file.date = DKDateTime(file_info.tmu_date.tm_year, file_info.tmu_date.tm_mon, file_info.tmu_date.tm_mday, file_info.tmu_date.tm_hour, file_info.tmu_date.tm_min, file_info.tmu_date.tm_sec, 0);
-						filesArray.Add(file);
-					}
-				}
-				else
-				{
-					DKLog("zip[%d] error.\n", i);
-				}
+			eocd = &data[i];
+			break;
+		}
+		if (i == 0 || length - i > 0xffff + Private::ZipEndOfCentralDirSize)
+			break;
+	}
+	if (eocd == NULL)
+	{
+		DKLog("[%s] Invalid zip file: %ls.\n", DKGL_FUNCTION_NAME, (const wchar_t*)file);
+		return NULL;
+	}
 
-				err = unzGoToNextFile(uf);
-				if (err == UNZ_END_OF_LIST_OF_FILE)
-					break;
-				if (err != UNZ_OK)
-				{
-					DKLog("error %d with zipfile in unzGoToNextFile\n",err);
-					return NULL;
-				}
+	uint64_t numEntries = Private::ZipReadUInt16(eocd + 10);
+	uint64_t cdSize = Private::ZipReadUInt32(eocd + 12);
+	uint64_t cdOffset = Private::ZipReadUInt32(eocd + 16);
+
+	// zip64 end of central directory.
+	const size_t eocdOffset = eocd - data;
+	if (eocdOffset >= Private::Zip64EndOfCentralDirLocatorSize)
+	{
+		const unsigned char* locator = eocd - Private::Zip64EndOfCentralDirLocatorSize;
+		if (Private::ZipReadUInt32(locator) == Private::Zip64EndOfCentralDirLocatorSignature)
+		{
+			uint64_t offset = Private::ZipReadUInt64(locator + 8);
+			if (offset <= length && Private::Zip64EndOfCentralDirSize <= length - offset &&
+				Private::ZipReadUInt32(&data[offset]) == Private::Zip64EndOfCentralDirSignature)
+			{
+				numEntries = Private::ZipReadUInt64(&data[offset + 32]);
+				cdSize = Private::ZipReadUInt64(&data[offset + 40]);
+				cdOffset = Private::ZipReadUInt64(&data[offset + 48]);
 			}
+		}
+	}
+	if (cdOffset > length || cdSize > length - cdOffset)
+	{
+		DKLog("[%s] Invalid central directory: %ls.\n", DKGL_FUNCTION_NAME, (const wchar_t*)file);
+		return NULL;
+	}
+
+	unarchiver->files.Reserve(numEntries);
+	unarchiver->locations.Reserve(numEntries);
+	unarchiver->fileIndex.Reserve(numEntries);
+
+	const unsigned char* p = &data[cdOffset];
+	const unsigned char* cdEnd = p + cdSize;
+	for (uint64_t i = 0; i < numEntries; ++i)
+	{
+		if ((size_t)(cdEnd - p) < Private::ZipCentralFileHeaderSize ||
+			Private::ZipReadUInt32(p) != Private::ZipCentralFileHeaderSignature)
+		{
+			DKLog("zip[%llu] error.\n", (unsigned long long)i);
+			break;
+		}
+		const unsigned int flags = Private::ZipReadUInt16(p + 8);
+		const unsigned int method = Private::ZipReadUInt16(p + 10);
+		const unsigned int dosTime = Private::ZipReadUInt16(p + 12);
+		const unsigned int dosDate = Private::ZipReadUInt16(p + 14);
+		const uint32_t crc = Private::ZipReadUInt32(p + 16);
+		uint64_t compressedSize = Private::ZipReadUInt32(p + 20);
+		uint64_t uncompressedSize = Private::ZipReadUInt32(p + 24);
+		const size_t nameLength = Private::ZipReadUInt16(p + 28);
+		const size_t extraLength = Private::ZipReadUInt16(p + 30);
+		const size_t commentLength = Private::ZipReadUInt16(p + 32);
+		uint64_t localHeaderOffset = Private::ZipReadUInt32(p + 42);
 
-			DKObject<DKZipUnarchiver> unarchiver = DKObject<DKZipUnarchiver>::New();
-			unarchiver->zipHandle = uf;
-			unarchiver->filename = filename;
-			unarchiver->files = filesArray;
+		if ((size_t)(cdEnd - p) - Private::ZipCentralFileHeaderSize < nameLength + extraLength + commentLength)
+		{
+			DKLog("zip[%llu] error.\n", (unsigned long long)i);
+			break;
+		}
+		const unsigned char* name = p + Private::ZipCentralFileHeaderSize;
+		const unsigned char* extra = name + nameLength;
+		const unsigned char* extraEnd = extra + extraLength;
+		const unsigned char* next = extraEnd + commentLength;
+
+		// zip64 extended information. (values of 0xffffffff in header)
+		for (const unsigned char* e = extra; extraEnd - e >= 4; )
+		{
+			const unsigned int id = Private::ZipReadUInt16(e);
+			const size_t size = Private::ZipReadUInt16(e + 2);
+			const unsigned char* v = e + 4;
+			const unsigned char* vEnd = v + Min(size, (size_t)(extraEnd - v));
+			if (id == 0x0001)
+			{
+				if (uncompressedSize == 0xffffffff && vEnd - v >= 8)	{ uncompressedSize = Private::ZipReadUInt64(v); v += 8; }
+				if (compressedSize == 0xffffffff && vEnd - v >= 8)		{ compressedSize = Private::ZipReadUInt64(v); v += 8; }
+				if (localHeaderOffset == 0xffffffff && vEnd - v >= 8)	{ localHeaderOffset = Private::ZipReadUInt64(v); v += 8; }
+				break;
+			}
+			e = vEnd;
+		}
 
-			return unarchiver;
+		FileInfo info;
+		size_t len = nameLength;
+		if (len > 0 && name[len-1] == '/')
+		{
+			info.directory = true;
+			len--;		// ignore last path separator
 		}
 		else
+			info.directory = false;
+		info.name = DKString((const DKUniChar8*)name, len);
+		if (info.name.Length() > 0)
 		{
-			DKLog("[%s] error %d with file: %ls.\n", DKGL_FUNCTION_NAME, err, (const wchar_t*)file);
+			info.uncompressedSize = (size_t)uncompressedSize;
+			info.compressedSize = (size_t)compressedSize;
+			info.crypted = (flags & 1) != 0;
+			info.compressLevel = 0;
+			switch (method)
+			{
+			case 0:
+				info.method = MethodStored;
+				break;
+			case Z_DEFLATED:
+				info.method = MethodDeflated;
+				info.compressLevel = (flags & 0x6) / 2;
+				break;
+			case Z_BZIP2ED:
+				info.method = MethodBZip2ed;
+				break;
+			default:
+				info.method = MethodUnknown;
+				break;
+			}
+			info.crc32 = crc;
+			info.date = DKDateTime((int)((dosDate >> 9) & 0x7f) + 1980, (int)((dosDate >> 5) & 0xf), (int)(dosDate & 0x1f),
+								   (int)(dosTime >> 11), (int)((dosTime >> 5) & 0x3f), (int)((dosTime & 0x1f) * 2), 0);
+
+			EntryLocation loc;
+			loc.localHeaderOffset = localHeaderOffset;
+			loc.flags = flags;
+			loc.method = method;
+
+			size_t index = unarchiver->files.Add(info);
+			unarchiver->locations.Add(loc);
+			unarchiver->fileIndex.Insert(info.name.LowercaseString(), index);	// first one wins.
 		}
+		p = next;
 	}
-	else
-	{
-		DKLog("[%s] Cannot open file: %ls.\n", DKGL_FUNCTION_NAME, (const wchar_t*)file);
-	}
+	return unarchiver;
+}
 
-	return NULL;
+size_t DKZipUnarchiver::FindFileIndex(const DKString& file) const
+{
+	auto p = fileIndex.Find(file.LowercaseString());
+	if (p)
+		return p->value;
+	return (size_t)-1;
+}
+
+const unsigned char* DKZipUnarchiver::FileContent(size_t index) const
+{
+	const FileInfo& info = files.Value(index);
+	const EntryLocation& loc = locations.Value(index);
+
+	// local file header, size of name and extra field can be differ from
+	// central directory.
+	const uint64_t offset = loc.localHeaderOffset;
+	if (offset > archiveLength || Private::ZipLocalFileHeaderSize > archiveLength - offset ||
+		Private::ZipReadUInt32(&archiveData[offset]) != Private::ZipLocalFileHeaderSignature)
+		return NULL;
+
+	const uint64_t dataOffset = offset + Private::ZipLocalFileHeaderSize +
+		Private::ZipReadUInt16(&archiveData[offset + 26]) +
+		Private::ZipReadUInt16(&archiveData[offset + 28]);
+	if (dataOffset > archiveLength || info.compressedSize > archiveLength - dataOffset)
+		return NULL;
+	return &archiveData[dataOffset];
 }
 
 const DKZipUnarchiver::FileInfo* DKZipUnarchiver::GetFileInfo(const DKString& file) const
 {
-	for (int i = 0; i < files.Count(); i++)
-	{
-		if (file.CompareNoCase(files.Value(i).name) == 0)
-			return &(files.Value(i));
-	}
+	size_t index = FindFileIndex(file);
+	if (index != (size_t)-1)
+		return &(files.Value(index));
 	return NULL;
 }
 
 DKObject<DKStream> DKZipUnarchiver::OpenFileStream(const DKString& file, const char* password) const
 {
-	// check file is exists, open if file exists.
-	DKStringU8 fileUTF8(file);
+	size_t index = FindFileIndex(file);
+	if (index == (size_t)-1)
+		return NULL;
+
+	const FileInfo& info = files.Value(index);
+	if (info.directory || info.uncompressedSize == 0)
+		return NULL;
+
+	if (!info.crypted)
+	{
+		if (info.method == MethodStored)
+		{
+			DKObject<DKData> data = OpenFileData(file, password);
+			if (data)
+				return DKOBJECT_NEW DKDataStream(data);
+			return NULL;
+		}
+		if (info.method == MethodDeflated)
+		{
+			const unsigned char* content = FileContent(index);
+			if (content == NULL)
+				return NULL;
+			return DKOBJECT_NEW Private::ZipInflateStream(fileMap, content - archiveData, info.compressedSize, info.uncompressedSize);
+		}
+	}
+	// encrypted or not supported method, use minizip.
+	return Private::UnZipFile::Create(filename, info.name, password).SafeCast<DKStream>();
+}
+
+DKObject<DKData> DKZipUnarchiver::OpenFileData(const DKString& file, const char* password) const
+{
+	size_t index = FindFileIndex(file);
+	if (index == (size_t)-1)
+		return NULL;
 
-	unz_file_info64 file_info;
+	const FileInfo& info = files.Value(index);
+	if (info.directory || info.uncompressedSize == 0)
+		return NULL;
 
-	if (fileUTF8.Bytes() > 0 &&
-		unzLocateFile(zipHandle, (const char*)fileUTF8, 0) == UNZ_OK &&
-		unzGetCurrentFileInfo64(zipHandle, &file_info, NULL, 0, NULL, 0, NULL, 0) == UNZ_OK &&
-		file_info.uncompressed_size > 0)
+	if (!info.crypted)
 	{
-		return Private::UnZipFile::Create(filename, file, password).SafeCast<DKStream>();
+		if (info.method == MethodStored)
+		{
+			const unsigned char* content = FileContent(index);
+			if (content == NULL || info.compressedSize != info.uncompressedSize)
+				return NULL;
+
+			// view of mapped archive, archive stays mapped while data is alive.
+			DKObject<DKFileMap> map = fileMap;
+			const unsigned char* base = reinterpret_cast<const unsigned char*>(map->LockShared());
+			return DKData::StaticData(base + (content - archiveData), info.uncompressedSize, DKFunction([map]
+			{
+				map->UnlockShared();
+			})->Invocation());
+		}
+		if (info.method == MethodDeflated)
+		{
+			const unsigned char* content = FileContent(index);
+			if (content == NULL)
+				return NULL;
+
+			DKObject<DKBuffer> buffer = DKBuffer::Create(NULL, info.uncompressedSize);
+			if (buffer == NULL)
+				return NULL;
+
+			bool succeeded = false;
+			z_stream stream;
+			memset(&stream, 0, sizeof(z_stream));
+			if (inflateInit2(&stream, -MAX_WBITS) == Z_OK)
+			{
+				unsigned char* output = reinterpret_cast<unsigned char*>(buffer->LockExclusive());
+				stream.next_in = const_cast<Bytef*>(content);
+				stream.next_out = output;
+				size_t inputRemain = info.compressedSize;
+				size_t outputRemain = info.uncompressedSize;
+				int err = Z_OK;
+				while (err == Z_OK)
+				{
+					if (stream.avail_in == 0)
+					{
+						stream.avail_in = Private::ZipChunkLength(inputRemain);
+						inputRemain -= stream.avail_in;
+					}
+					if (stream.avail_out == 0)
+					{
+						stream.avail_out = Private::ZipChunkLength(outputRemain);
+						outputRemain -= stream.avail_out;
+					}
+					err = inflate(&stream, Z_NO_FLUSH);
+				}
+				if (err == Z_STREAM_END && (size_t)(stream.next_out - output) == info.uncompressedSize)
+				{
+					uLong crc = Private::ZipCRC32(output, info.uncompressedSize);
+					if (crc == info.crc32)
+						succeeded = true;
+					else
+						DKLog("[%s] CRC error: %ls.\n", DKGL_FUNCTION_NAME, (const wchar_t*)info.name);
+				}
+				else
+				{
+					DKLog("[%s] inflate failed (%d): %ls.\n", DKGL_FUNCTION_NAME, err, (const wchar_t*)info.name);
+				}
+				buffer->UnlockExclusive();
+				inflateEnd(&stream);
+			}
+			if (succeeded)
+				return buffer.SafeCast<DKData>();
+			return NULL;
+		}
 	}
+	// encrypted or not supported method, use minizip.
+	DKObject<DKStream> stream = Private::UnZipFile::Create(filename, info.name, password).SafeCast<DKStream>();
+	if (stream)
+		return DKBuffer::Create(stream).SafeCast<DKData>();
 	return NULL;
 }
@@ -12,11 +12,28 @@
 #include "DKDateTime.h"
 #include "DKArray.h"
 #include "DKStream.h"
+#include "DKData.h"
+#include "DKFileMap.h"
+#include "DKHashMap.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 // DKZipUnarchiver
 // a zip file reader.
 // read and decompress from zip-archive file.
+//
+// Archive file is memory-mapped, central directory is parsed once and
+// indexed by file name (case-insensitive), opening file does not search
+// or read archive file again.
+//
+// OpenFileData() returns stored (not compressed) file as read-only view of
+// mapped archive without copy, compressed file is decompressed into buffer.
+// OpenFileStream() inflates deflated file while reading, stream records
+// checkpoints (decompressor state) at every CheckpointInterval bytes,
+// seeking backward resumes from nearest checkpoint instead of beginning.
+//
+// Archive object is immutable after created, files can be opened and
+// decompressed from multiple threads simultaneously.
+// Encrypted or bzip2 compressed files are read with minizip.
 ////////////////////////////////////////////////////////////////////////////////
 
 namespace DKFoundation
@@ -53,11 +70,28 @@ namespace DKFoundation
 		const FileInfo* GetFileInfo(const DKString& file) const;
 
 		DKObject<DKStream> OpenFileStream(const DKString& file, const char* password = NULL) const;
+		DKObject<DKData> OpenFileData(const DKString& file, const char* password = NULL) const;
 
 		const DKString& GetArchiveName(void) const		{return filename;}
+
+		enum {CheckpointInterval = 0x100000};	// 1MB (uncompressed)
+
 	private:
-		void*							zipHandle;
+		struct EntryLocation
+		{
+			uint64_t		localHeaderOffset;
+			unsigned int	flags;
+			unsigned int	method;
+		};
+		size_t FindFileIndex(const DKString& file) const;
+		const unsigned char* FileContent(size_t index) const;	// compressed data in archive.
+
 		DKArray<FileInfo>				files;
+		DKArray<EntryLocation>			locations;
+		DKHashMap<DKString, size_t>		fileIndex;		// lowercase name, index of files.
+		DKObject<DKFileMap>				fileMap;
+		const unsigned char*			archiveData;
+		size_t							archiveLength;
 		DKString						filename;
 	};
 }
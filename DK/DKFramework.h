@@ -7,6 +7,7 @@
 #include "DKFramework/DKAffineTransform3.h"
 #include "DKFramework/DKAnimation.h"
 #include "DKFramework/DKAnimationController.h"
+#include "DKFramework/DKAnimationPose.h"
 #include "DKFramework/DKApplication.h"
 #include "DKFramework/DKAudioListener.h"
 #include "DKFramework/DKAudioPlayer.h"
@@ -61,6 +62,7 @@
 #include "DKFramework/DKQuaternion.h"
 #include "DKFramework/DKRect.h"
 #include "DKFramework/DKRenderer.h"
+#include "DKFramework/DKRenderQueue.h"
 #include "DKFramework/DKRenderState.h"
 #include "DKFramework/DKRenderTarget.h"
 #include "DKFramework/DKResource.h"
@@ -102,6 +104,7 @@
 #include "DKFramework/DKVertexStream.h"
 #include "DKFramework/DKVKey.h"
 #include "DKFramework/DKVoxel32FileStorage.h"
+#include "DKFramework/DKVoxel32Mesher.h"
 #include "DKFramework/DKVoxel32SparseVolume.h"
 #include "DKFramework/DKVoxel32Storage.h"
 #include "DKFramework/DKVoxelIsosurfacePolygonizer.h"
@@ -9,9 +9,12 @@
 #include "DKAabb.h"
 #include "DKLine.h"
 #include "DKBox.h"
+#include "DKMatrix4.h"
+#include "Private/SimdMath.h"
 
 using namespace DKFoundation;
 using namespace DKFramework;
+using namespace DKFramework::Private;
 
 DKAabb::DKAabb(void)
 	: positionMin(DKVector3(FLT_MAX, FLT_MAX, FLT_MAX))
@@ -64,6 +67,30 @@ DKAabb DKAabb::Union(const DKAabb& b1, const DKAabb& b2)
 	return DKAabb();
 }
 
+void DKAabb::Transform(const DKAabb* input, const DKMatrix4& m, DKAabb* output, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const DKAabb& box = input[i];
+		if (box.IsValid())
+			SimdAabbTransform(box.positionMin.val, box.positionMax.val, m.val, output[i].positionMin.val, output[i].positionMax.val);
+		else
+			output[i] = box;
+	}
+}
+
+void DKAabb::Transform(const DKAabb* input, const DKMatrix4* matrices, DKAabb* output, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const DKAabb& box = input[i];
+		if (box.IsValid())
+			SimdAabbTransform(box.positionMin.val, box.positionMax.val, matrices[i].val, output[i].positionMin.val, output[i].positionMax.val);
+		else
+			output[i] = box;
+	}
+}
+
 bool DKAabb::IsValid(void) const
 {
 	return positionMax.x >= positionMin.x && positionMax.y >= positionMin.y && positionMax.z >= positionMin.z;
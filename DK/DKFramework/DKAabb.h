@@ -20,6 +20,7 @@ namespace DKFramework
 {
 	class DKLine;
 	class DKBox;
+	class DKMatrix4;
 	class DKGL_API DKAabb
 	{
 	public:
@@ -30,6 +31,12 @@ namespace DKFramework
 		static DKAabb Intersection(const DKAabb& b1, const DKAabb& b2);
 		static DKAabb Union(const DKAabb& b1, const DKAabb& b2);
 
+		// batch transform, output boxes enclose transformed boxes.
+		// matrices should be affine. invalid boxes are not transformed.
+		// (output can be same as input)
+		static void Transform(const DKAabb* input, const DKMatrix4& m, DKAabb* output, size_t count);
+		static void Transform(const DKAabb* input, const DKMatrix4* matrices, DKAabb* output, size_t count);
+
 		bool IsValid(void) const;
 		bool IsPointInside(const DKVector3& pos) const;
 		DKVector3 Center(void) const;
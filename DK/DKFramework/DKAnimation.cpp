@@ -7,6 +7,7 @@
 
 #include "DKMath.h"
 #include "DKAnimation.h"
+#include "DKAnimationPose.h"
 
 using namespace DKFoundation;
 namespace DKFramework
@@ -103,9 +104,9 @@ namespace DKFramework
 			{
 				return ClipKeyframeTimeScale((const T*)frame, frame.Count());
 			}
-			// finding nearest two key frames (before the first, after the last)
-			// with (begin <= t < end)
-			template <typename T> inline bool FindNearKeyFrames(const DKArray<T>& frames, size_t begin, size_t count, T& prev, T& next, float time)
+			// find key-frame index (i) which satisfies (frames[i].time < time <= frames[i+1].time)
+			// in range of (begin ~ begin+count), result is clamped to range.
+			template <typename T> inline size_t SearchKeyFrameIndex(const DKArray<T>& frames, size_t begin, size_t count, float time)
 			{
 				while (count > 2)
 				{
@@ -120,6 +121,14 @@ namespace DKFramework
 						count = middle - begin + 1;
 					}
 				}
+				return begin;
+			}
+			// finding nearest two key frames (before the first, after the last)
+			template <typename T> inline bool FindNearKeyFrames(const DKArray<T>& frames, size_t begin, size_t count, T& prev, T& next, float time)
+			{
+				size_t end = begin + count;
+				begin = SearchKeyFrameIndex(frames, begin, count, time);
+				count = Min(end - begin, 2);
 				if (count > 1)
 				{
 					prev = frames.Value(begin);
@@ -132,6 +141,41 @@ namespace DKFramework
 			{
 				return FindNearKeyFrames(frames, 0, frames.Count(), prev, next, time);
 			}
+			// interpolate key-frames, key-frame index is searched from cursor (last result).
+			// time is moving forward usually, step forward a few times from cursor,
+			// and then search whole key-frames if not found.
+			template <typename T> inline T InterpolateKeyFrames(const DKArray<DKAnimation::KeyframeNode::Key<T>>& frames, size_t& cursor, float time)
+			{
+				enum { MaxCursorSteps = 4 };
+				const size_t count = frames.Count();
+				if (count > 1)
+				{
+					const size_t last = count - 2;
+					size_t index = Min(cursor, last);
+					if (index == 0 || frames.Value(index).time < time)
+					{
+						for (int step = 0; index < last && frames.Value(index+1).time < time; ++step)
+						{
+							if (step >= MaxCursorSteps)
+							{
+								index = SearchKeyFrameIndex(frames, 0, count, time);
+								break;
+							}
+							index++;
+						}
+					}
+					else
+					{
+						index = SearchKeyFrameIndex(frames, 0, count, time);
+					}
+					cursor = index;
+
+					const DKAnimation::KeyframeNode::Key<T>& k1 = frames.Value(index);
+					const DKAnimation::KeyframeNode::Key<T>& k2 = frames.Value(index+1);
+					return Interpolate(k1.key, k2.key, (time - k1.time) / (k2.time - k1.time));
+				}
+				return frames.Value(0).key;
+			}
 		}
 	}
 }
@@ -142,6 +186,7 @@ using namespace DKFramework::Private;
 
 DKAnimation::DKAnimation(void)
 	: duration(0)
+	, nodeGeneration(0)
 {
 }
 
@@ -277,6 +322,7 @@ bool DKAnimation::AddSamplingNode(const DKString& name, const DKTransformUnit* f
 		node->name = name;
 		node->frames.Add(frames, numFrames);
 		nodeIndexMap.Update(node->name, nodes.Add(node)); // add new node, and update indexes.
+		nodeGeneration++;
 		return true;
 	}
 	return false;
@@ -302,6 +348,7 @@ bool DKAnimation::AddKeyframeNode(const DKString& name,
 		if (!node->IsEmpty())
 		{
 			nodeIndexMap.Update(node->name, nodes.Add(node));
+			nodeGeneration++;
 			return true;
 		}
 		node->~KeyframeNode();
@@ -320,8 +367,13 @@ void DKAnimation::RemoveNode(const DKFoundation::DKString& name)
 		nodes.Remove(index);
 		n->~Node();
 		DKMemoryDefaultAllocator::Free(n);
+		nodeIndexMap.Remove(name);
+
+		// indexes of following nodes are changed.
+		for (size_t i = index; i < nodes.Count(); ++i)
+			nodeIndexMap.Update(nodes.Value(i)->name, i);
+		nodeGeneration++;
 	}
-	nodeIndexMap.Remove(name);
 }
 
 void DKAnimation::RemoveAllNodes(void)
@@ -334,6 +386,7 @@ void DKAnimation::RemoveAllNodes(void)
 	}
 	nodes.Clear();
 	nodeIndexMap.Clear();
+	nodeGeneration++;
 }
 
 size_t DKAnimation::NodeCount(void) const
@@ -432,6 +485,34 @@ DKTransformUnit DKAnimation::GetTransform(const Node& node, float time)
 	return output;
 }
 
+DKTransformUnit DKAnimation::GetTransform(const Node& node, float time, KeyframeCursor& cursor)
+{
+	if (node.type == Node::NodeTypeKeyframe)
+	{
+		const KeyframeNode& keyframe = static_cast<const KeyframeNode&>(node);
+		DKTransformUnit output;
+
+		if (keyframe.translationKeys.IsEmpty())
+			output.translation = DKVector3(0,0,0);
+		else
+			output.translation = InterpolateKeyFrames(keyframe.translationKeys, cursor.translation, time);
+
+		if (keyframe.rotationKeys.IsEmpty())
+			output.rotation.Identity();
+		else
+			output.rotation = InterpolateKeyFrames(keyframe.rotationKeys, cursor.rotation, time);
+
+		if (keyframe.scaleKeys.IsEmpty())
+			output.scale = DKVector3(1,1,1);
+		else
+			output.scale = InterpolateKeyFrames(keyframe.scaleKeys, cursor.scale, time);
+
+		return output;
+	}
+	// sampling node does not need to search.
+	return GetTransform(node, time);
+}
+
 bool DKAnimation::ResampleNode(const Node& source, unsigned int frames, KeyframeNode& output, float threshold)
 {
 	if (source.IsEmpty())
@@ -554,9 +635,12 @@ bool DKAnimation::ResampleNode(const Node& source, unsigned int frames, Sampling
 
 DKObject<DKAnimationController> DKAnimation::CreateLoopController(void)
 {
+	// controller evaluates whole pose once per frame.
+	// pose binds nodes again if nodes of animation has been changed.
 	struct Controller : public DKAnimationController
 	{
 		DKObject<DKAnimation> animation;
+		DKAnimationPose pose;
 		float frameTime;
 		bool playing;
 
@@ -568,12 +652,24 @@ DKObject<DKAnimationController> DKAnimation::CreateLoopController(void)
 				frameTime = frame / duration;
 				if (frameTime > 1.0 || frameTime < 0.0)
 					frameTime -= floor(frameTime);
+				pose.Evaluate(frameTime);
 			}
 		}
 		bool GetTransform(const NodeId& key, DKTransformUnit& out)
 		{
-			if (animation)
-				return animation->GetNodeTransform(key, frameTime, out);
+			return GetTransformAtIndex(pose.IndexOfSlot(key), out);
+		}
+		NodeIndex ResolveNodeIndex(const NodeId& key)
+		{
+			return pose.IndexOfSlot(key);
+		}
+		bool GetTransformAtIndex(NodeIndex index, DKTransformUnit& out)
+		{
+			if (pose.IsSlotBound(index))
+			{
+				out = pose.TransformAtIndex(index);
+				return true;
+			}
 			return false;
 		}
 		bool IsPlaying(void) const
@@ -599,6 +695,8 @@ DKObject<DKAnimationController> DKAnimation::CreateLoopController(void)
 
 	DKObject<Controller> con = DKObject<Controller>::New();
 	con->animation = this;
+	con->pose.Bind(this);
+	con->pose.Evaluate(0);
 	con->frameTime = 0;
 	con->playing = false;
 
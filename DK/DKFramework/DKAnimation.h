@@ -72,6 +72,12 @@ namespace DKFramework
 			KeyframeNode(void) : Node(NodeTypeKeyframe) {}
 			bool IsEmpty(void) const		{return translationKeys.IsEmpty() && rotationKeys.IsEmpty() && scaleKeys.IsEmpty();}
 		};
+		struct KeyframeCursor	// last key-frame indices of KeyframeNode (see GetTransform)
+		{
+			size_t scale;
+			size_t rotation;
+			size_t translation;
+		};
 		struct NodeSnapshot
 		{
 			DKFoundation::DKString	name;
@@ -95,6 +101,8 @@ namespace DKFramework
 		size_t		NodeCount(void) const;
 		NodeIndex	IndexOfNode(const DKFoundation::DKString& name) const;
 		const Node*	NodeAtIndex(NodeIndex index) const;
+		// incremented when nodes are added or removed. (node index, pointer could be changed)
+		unsigned int NodeGeneration(void) const		{return nodeGeneration;}
 
 		// calculate transform at time ( 0.0 <= t <= 1.0 )
 		bool GetNodeTransform(NodeIndex index, float t, DKTransformUnit& output) const;
@@ -110,6 +118,9 @@ namespace DKFramework
 
 		// get affine-transform of specified node at time.
 		static DKTransformUnit GetTransform(const Node& node, float time);
+		// get affine-transform of node at time, key-frames are searched from cursor.
+		// faster than above when time is moving forward. (cursor should be zero initially)
+		static DKTransformUnit GetTransform(const Node& node, float time, KeyframeCursor& cursor);
 
 		// convert node (keyframe to sampling, or vice versa.)
 		// for converting to key-frame, timing tick is 1.0/(frames-1) unit. (first frame:0, last frame:frames-1)
@@ -121,12 +132,14 @@ namespace DKFramework
 		float	Duration(void) const;
 
 		// create loop controller. (useful to apply repeated animation to DKModel)
+		// controller evaluates nodes with DKAnimationPose, nodes are bound by name.
 		DKFoundation::DKObject<DKAnimationController> CreateLoopController(void);
 
 		// serializer object.
 		DKFoundation::DKObject<DKSerializer> Serializer(void);
 	private:
 		float	duration;
+		unsigned int nodeGeneration;
 
 		DKFoundation::DKMap<DKFoundation::DKString, size_t> nodeIndexMap; // for fast search
 		DKFoundation::DKArray<Node*>	nodes;
@@ -25,6 +25,7 @@ DKAnimationController::~DKAnimationController(void)
 
 void DKAnimationController::Update(double timeDelta, DKTimeTick tick)
 {
+	DKCriticalSection<DKSpinLock> guard(updateLock);
 	if (tick == this->lastUpdatedTick)
 		return;
 
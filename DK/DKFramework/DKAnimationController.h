@@ -23,9 +23,18 @@ namespace DKFramework
 	{
 	public:
 		typedef DKFoundation::DKString NodeId;
+		typedef long NodeIndex;
+		static const NodeIndex invalidNodeIndex = -1;		// node not exists.
+		static const NodeIndex unresolvedNodeIndex = -2;	// index not supported, use NodeId.
+
 		virtual ~DKAnimatedTransform(void) {}
 		virtual void Update(double timeDelta, DKFoundation::DKTimeTick tick) {}
 		virtual bool GetTransform(const NodeId& key, DKTransformUnit& out) = 0;
+
+		// optional indexed access. (DKModel resolves index once, not every frame)
+		// return unresolvedNodeIndex if not supported, GetTransform(NodeId) will be used.
+		virtual NodeIndex ResolveNodeIndex(const NodeId& key)						{ return unresolvedNodeIndex; }
+		virtual bool GetTransformAtIndex(NodeIndex index, DKTransformUnit& out)	{ return false; }
 	};
 
 	class DKGL_API DKAnimationController : public DKAnimatedTransform
@@ -56,5 +65,9 @@ namespace DKFramework
 		float			speed;
 
 		DKFoundation::DKTimeTick lastUpdatedTick;
+
+	private:
+		// Update() can be called from multiple trees being updated in parallel.
+		DKFoundation::DKSpinLock updateLock;
 	};
 }
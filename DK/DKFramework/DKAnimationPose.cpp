@@ -0,0 +1,262 @@
+//
+//  File: DKAnimationPose.cpp
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2015 Hongtae Kim. All rights reserved.
+//
+
+#include <algorithm>
+#include "DKMath.h"
+#include "DKAnimationPose.h"
+#include "DKModel.h"
+#include "DKSkinMesh.h"
+
+using namespace DKFoundation;
+namespace DKFramework
+{
+	namespace Private
+	{
+		namespace
+		{
+			void CollectModelNames(const DKModel* model, DKArray<DKString>& names, DKArray<DKTransformUnit>& transforms)
+			{
+				const DKNSTransform& t = model->LocalTransform();
+				names.Add(model->Name());
+				transforms.Add(DKTransformUnit(DKVector3(1,1,1), t.orientation, t.position));
+
+				for (size_t i = 0; i < model->NumberOfChildren(); ++i)
+					CollectModelNames(model->ChildAtIndex(i), names, transforms);
+			}
+		}
+	}
+}
+
+using namespace DKFramework;
+using namespace DKFramework::Private;
+
+
+DKAnimationPose::DKAnimationPose(void)
+	: nodeGeneration(0)
+	, bindAllNodes(false)
+{
+}
+
+DKAnimationPose::~DKAnimationPose(void)
+{
+}
+
+bool DKAnimationPose::Bind(DKAnimation* anim)
+{
+	Unbind();
+	if (anim)
+	{
+		size_t count = anim->NodeCount();
+		slots.Reserve(count);
+		for (size_t i = 0; i < count; ++i)
+			AddSlot(anim->NodeAtIndex(i)->name);
+		transforms.Add(DKTransformUnit::identity, count);
+		bindAllNodes = true;
+		return BindSlots(anim);
+	}
+	return false;
+}
+
+bool DKAnimationPose::Bind(DKAnimation* anim, const DKModel* root)
+{
+	Unbind();
+	if (anim && root)
+	{
+		DKArray<DKString> names;
+		names.Reserve(root->NumberOfDescendants() + 1);
+		transforms.Reserve(root->NumberOfDescendants() + 1);
+		CollectModelNames(root, names, transforms);
+
+		slots.Reserve(names.Count());
+		for (const DKString& name : names)
+			AddSlot(name);
+		return BindSlots(anim);
+	}
+	return false;
+}
+
+bool DKAnimationPose::Bind(DKAnimation* anim, const DKSkinMesh* mesh)
+{
+	Unbind();
+	if (anim && mesh)
+	{
+		size_t count = mesh->NumberOfBones();
+		slots.Reserve(count);
+		for (size_t i = 0; i < count; ++i)
+			AddSlot(mesh->BoneAtIndex(i).id);
+		transforms.Add(DKTransformUnit::identity, count);
+		return BindSlots(anim);
+	}
+	return false;
+}
+
+bool DKAnimationPose::Bind(DKAnimation* anim, const DKString* names, size_t count)
+{
+	Unbind();
+	if (anim && names)
+	{
+		slots.Reserve(count);
+		for (size_t i = 0; i < count; ++i)
+			AddSlot(names[i]);
+		transforms.Add(DKTransformUnit::identity, count);
+		return BindSlots(anim);
+	}
+	return false;
+}
+
+void DKAnimationPose::AddSlot(const DKString& name)
+{
+	Slot s = { name, DKAnimation::invalidNodeIndex, {0, 0, 0} };
+	SlotIndex index = (SlotIndex)slots.Add(s);
+	if (name.Length() > 0 && slotIndexMap.Find(name) == NULL)
+		slotIndexMap.Insert(name, index);	// first slot of same name.
+}
+
+bool DKAnimationPose::BindSlots(DKAnimation* anim)
+{
+	DKASSERT_DEBUG(slots.Count() == transforms.Count());
+
+	this->animation = anim;
+	return BindSlots();
+}
+
+bool DKAnimationPose::BindSlots(void)
+{
+	if (bindAllNodes)
+	{
+		// append slots for nodes added after binding.
+		size_t count = animation->NodeCount();
+		for (size_t i = 0; i < count; ++i)
+		{
+			const DKString& name = animation->NodeAtIndex(i)->name;
+			if (slotIndexMap.Find(name) == NULL)
+			{
+				AddSlot(name);
+				transforms.Add(DKTransformUnit::identity);
+			}
+		}
+	}
+
+	size_t numBound = 0;
+	for (Slot& s : slots)
+	{
+		s.nodeIndex = animation->IndexOfNode(s.name);
+		s.cursor.scale = 0;
+		s.cursor.rotation = 0;
+		s.cursor.translation = 0;
+		if (s.nodeIndex != DKAnimation::invalidNodeIndex)
+			numBound++;
+	}
+	nodeGeneration = animation->NodeGeneration();
+	return numBound > 0;
+}
+
+void DKAnimationPose::Unbind(void)
+{
+	animation = NULL;
+	nodeGeneration = 0;
+	bindAllNodes = false;
+	slots.Clear();
+	transforms.Clear();
+	slotIndexMap.Clear();
+}
+
+DKAnimationPose::SlotIndex DKAnimationPose::IndexOfSlot(const DKString& name) const
+{
+	const DKHashMap<DKString, SlotIndex>::Pair* p = slotIndexMap.Find(name);
+	if (p)
+		return p->value;
+	return invalidSlotIndex;
+}
+
+const DKString& DKAnimationPose::SlotName(SlotIndex index) const
+{
+	return slots.Value(index).name;
+}
+
+bool DKAnimationPose::IsSlotBound(SlotIndex index) const
+{
+	if (index >= 0 && (size_t)index < slots.Count())
+	{
+		const Slot& s = slots.Value(index);
+		if (animation && animation->NodeGeneration() != nodeGeneration)	// not bound again yet.
+			return animation->IndexOfNode(s.name) != DKAnimation::invalidNodeIndex;
+		return s.nodeIndex != DKAnimation::invalidNodeIndex;
+	}
+	return false;
+}
+
+void DKAnimationPose::Evaluate(float t)
+{
+	if (animation == NULL)
+		return;
+	if (animation->NodeGeneration() != nodeGeneration)
+		BindSlots();
+
+	const DKAnimation* anim = animation;
+	const size_t count = slots.Count();
+	Slot* slot = slots;
+	DKTransformUnit* output = transforms;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		Slot& s = slot[i];
+		const DKAnimation::Node* node = anim->NodeAtIndex(s.nodeIndex);
+		if (node)
+			output[i] = DKAnimation::GetTransform(*node, t, s.cursor);
+	}
+}
+
+void DKAnimationPose::ResetCursors(void)
+{
+	for (Slot& s : slots)
+	{
+		s.cursor.scale = 0;
+		s.cursor.rotation = 0;
+		s.cursor.translation = 0;
+	}
+}
+
+bool DKAnimationPose::Blend(const DKAnimationPose& target, float weight)
+{
+	if (transforms.Count() == target.transforms.Count())
+	{
+		Blend(transforms, target.transforms, weight, transforms, transforms.Count());
+		return true;
+	}
+	return false;
+}
+
+bool DKAnimationPose::CrossFade(const DKAnimationPose& from, const DKAnimationPose& to, float weight)
+{
+	size_t count = transforms.Count();
+	if (from.transforms.Count() == count && to.transforms.Count() == count)
+	{
+		Blend(from.transforms, to.transforms, weight, transforms, count);
+		return true;
+	}
+	return false;
+}
+
+void DKAnimationPose::Blend(const DKTransformUnit* from, const DKTransformUnit* to, float weight, DKTransformUnit* output, size_t count)
+{
+	if (weight <= 0.0f)
+	{
+		if (output != from)
+			std::copy(from, from + count, output);
+	}
+	else if (weight >= 1.0f)
+	{
+		if (output != to)
+			std::copy(to, to + count, output);
+	}
+	else
+	{
+		for (size_t i = 0; i < count; ++i)
+			output[i] = from[i].Interpolate(to[i], weight);
+	}
+}
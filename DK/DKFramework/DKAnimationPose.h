@@ -0,0 +1,109 @@
+//
+//  File: DKAnimationPose.h
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2015 Hongtae Kim. All rights reserved.
+//
+
+#pragma once
+#include "../DKInclude.h"
+#include "../DKFoundation.h"
+#include "DKTransform.h"
+#include "DKAnimation.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// DKAnimationPose
+// compiled pose evaluator of DKAnimation.
+// animation nodes are bound to slots once (by name), and whole pose is
+// evaluated into contiguous DKTransformUnit array at once.
+//
+// slots can be bound with
+//   - all nodes of animation (slot index is animation's node index)
+//   - model hierarchy (DKModel, depth-first order, root is slot 0)
+//   - bones of skin mesh (DKSkinMesh, slot index is bone index)
+//   - array of node names
+//
+// each slot keeps key-frame cursors. sequential evaluation (normal playback)
+// finds key-frames with a few steps from last position, instead of searching
+// whole keys. cursors are reset with binary search when time jumps.
+//
+// poses which have same slot layout (bound with same model, skin mesh or
+// same name array) can be blended or cross-faded.
+//
+// slots refer animation nodes by node index, not by pointer. If nodes of
+// animation has been added or removed (see DKAnimation::NodeGeneration),
+// slots are bound again by name at next Evaluate. Slot layout is not changed,
+// except pose bound with all nodes of animation, new nodes are appended.
+//
+// Note:
+//   slot which is not bound (animation does not have node) keeps it's
+//   initial transform. (model's local transform or identity)
+//   slot which node has been removed keeps last evaluated transform.
+//
+//   This class is not thread-safe.
+////////////////////////////////////////////////////////////////////////////////
+
+namespace DKFramework
+{
+	class DKModel;
+	class DKSkinMesh;
+	class DKGL_API DKAnimationPose
+	{
+	public:
+		typedef DKAnimation::NodeIndex NodeIndex;
+		typedef long SlotIndex;
+		static const SlotIndex invalidSlotIndex = -1;
+
+		DKAnimationPose(void);
+		~DKAnimationPose(void);
+
+		bool Bind(DKAnimation* animation);
+		bool Bind(DKAnimation* animation, const DKModel* root);
+		bool Bind(DKAnimation* animation, const DKSkinMesh* mesh);
+		bool Bind(DKAnimation* animation, const DKFoundation::DKString* names, size_t count);
+		void Unbind(void);
+
+		DKAnimation* Animation(void)				{ return animation; }
+		const DKAnimation* Animation(void) const	{ return animation; }
+
+		size_t NumberOfSlots(void) const			{ return slots.Count(); }
+		SlotIndex IndexOfSlot(const DKFoundation::DKString& name) const;
+		const DKFoundation::DKString& SlotName(SlotIndex index) const;
+		bool IsSlotBound(SlotIndex index) const;
+
+		// evaluate all bound slots at time ( 0.0 <= t <= 1.0 )
+		void Evaluate(float t);
+		// reset cursors of all slots. (next Evaluate will search keys)
+		void ResetCursors(void);
+
+		DKTransformUnit* Transforms(void)						{ return transforms; }
+		const DKTransformUnit* Transforms(void) const			{ return transforms; }
+		const DKTransformUnit& TransformAtIndex(SlotIndex index) const	{ return transforms.Value(index); }
+
+		// blend to target pose with weight. (0.0: this, 1.0: target)
+		bool Blend(const DKAnimationPose& target, float weight);
+		// set cross-faded pose of two poses. (0.0: from, 1.0: to)
+		bool CrossFade(const DKAnimationPose& from, const DKAnimationPose& to, float weight);
+
+		// blend transform arrays. (output can be same as one of inputs)
+		static void Blend(const DKTransformUnit* from, const DKTransformUnit* to, float weight, DKTransformUnit* output, size_t count);
+
+	private:
+		struct Slot
+		{
+			DKFoundation::DKString name;
+			NodeIndex nodeIndex;
+			DKAnimation::KeyframeCursor cursor;
+		};
+		void AddSlot(const DKFoundation::DKString& name);
+		bool BindSlots(DKAnimation* animation);
+		bool BindSlots(void);
+
+		DKFoundation::DKObject<DKAnimation> animation;
+		unsigned int nodeGeneration;	// animation's node generation of bound slots.
+		bool bindAllNodes;
+		DKFoundation::DKArray<Slot> slots;
+		DKFoundation::DKArray<DKTransformUnit> transforms;
+		DKFoundation::DKHashMap<DKFoundation::DKString, SlotIndex> slotIndexMap;
+	};
+}
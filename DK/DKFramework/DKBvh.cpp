@@ -9,13 +9,70 @@
 #include <cstdlib>
 #include "DKMath.h"
 #include "DKBvh.h"
+#include "Private/SimdMath.h"
 
 #define MAX_NODE_COUNT (0x7fffffff >> 1)
 
+namespace DKFramework
+{
+	namespace Private
+	{
+		namespace
+		{
+			// node stack for ordered traversal, uses heap if tree is too deep.
+			struct BvhTraversalStack
+			{
+				struct Entry
+				{
+					int nodeIndex;
+					float tnear;
+				};
+				enum { LocalCapacity = 64 };
+
+				BvhTraversalStack(void) : count(0) {}
+
+				void Push(int nodeIndex, float tnear)
+				{
+					Entry e = { nodeIndex, tnear };
+					if (count < LocalCapacity)
+						local[count] = e;
+					else
+						heap.Add(e);
+					count++;
+				}
+				bool Pop(int& nodeIndex, float& tnear)
+				{
+					if (count == 0)
+						return false;
+					count--;
+					Entry e;
+					if (count < LocalCapacity)
+					{
+						e = local[count];
+					}
+					else
+					{
+						e = heap.Value(heap.Count() - 1);
+						heap.Remove(heap.Count() - 1);
+					}
+					nodeIndex = e.nodeIndex;
+					tnear = e.tnear;
+					return true;
+				}
+
+				Entry local[LocalCapacity];
+				DKFoundation::DKArray<Entry> heap;
+				size_t count;
+			};
+		}
+	}
+}
+
 using namespace DKFoundation;
 using namespace DKFramework;
+using namespace DKFramework::Private;
 
-DKBvh::DKBvh(void) : volume(NULL)
+DKBvh::DKBvh(void) : volume(NULL), mode(BuildModeMedian), numObjects(0)
 {
 }
 
@@ -23,18 +80,19 @@ DKBvh::~DKBvh(void)
 {
 }
 
-void DKBvh::Build(VolumeInterface* vi)
+void DKBvh::Build(VolumeInterface* vi, BuildMode mode, DKOperationQueue* queue)
 {
 	this->volume = vi;
-	BuildInternal();
+	this->mode = mode;
+	BuildInternal(queue);
 }
 
-void DKBvh::Rebuild(void)
+void DKBvh::Rebuild(DKOperationQueue* queue)
 {
-	BuildInternal();
+	BuildInternal(queue);
 }
 
-void DKBvh::BuildInternal(void)
+void DKBvh::BuildInternal(DKOperationQueue* queue)
 {
 	if (this->volume)
 	{
@@ -45,6 +103,7 @@ void DKBvh::BuildInternal(void)
 
 		// Query all leaf-nodes (all triangles)
 		int numTriangles = this->volume->NumberOfObjects();
+		this->numObjects = numTriangles;
 		if (numTriangles > 0)
 		{
 			struct LeafNode
@@ -89,31 +148,120 @@ void DKBvh::BuildInternal(void)
 			quantizedLeafNodes.Reserve(leafNodes.Count());
 			for (LeafNode& n : leafNodes)
 			{
-				DKVector3 aabbMin = (n.aabb.positionMin - this->aabbOffset) / this->aabbScale * float(0xffff);
-				DKVector3 aabbMax = (n.aabb.positionMax - this->aabbOffset) / this->aabbScale * float(0xffff);
-
 				QuantizedAabbNode node;
-				node.aabbMin[0] = aabbMin.val[0];
-				node.aabbMin[1] = aabbMin.val[1];
-				node.aabbMin[2] = aabbMin.val[2];
-				node.aabbMax[0] = aabbMax.val[0];
-				node.aabbMax[1] = aabbMax.val[1];
-				node.aabbMax[2] = aabbMax.val[2];
+				Quantize(n.aabb, node);
 				node.objectIndex = n.objectIndex;
 				quantizedLeafNodes.Add(node);
 			}
 		}
+		this->volume->Unlock();
 
 		if (quantizedLeafNodes.Count() > 0 && quantizedLeafNodes.Count() < MAX_NODE_COUNT)
 		{
-			nodes.Reserve(quantizedLeafNodes.Count() * 2);
-			BuildTree(quantizedLeafNodes, (int)quantizedLeafNodes.Count());
+			// tree of N leaf-nodes has (2N-1) nodes.
+			int count = (int)quantizedLeafNodes.Count();
+			nodes.Add(QuantizedAabbNode(), count * 2 - 1);
+			BuildTree(quantizedLeafNodes, count, nodes, this->mode, queue, NULL);
 		}
-
-		this->volume->Unlock();
 	}
 	else
+	{
 		nodes.Clear();
+		numObjects = 0;
+	}
+}
+
+bool DKBvh::Refit(void)
+{
+	if (this->volume == NULL)
+		return false;
+
+	this->volume->Lock();
+	if (this->volume->NumberOfObjects() != this->numObjects)
+	{
+		this->volume->Unlock();
+		return false;
+	}
+
+	int nodeCount = (int)this->nodes.Count();
+	QuantizedAabbNode* treeNodes = this->nodes;
+
+	DKArray<DKAabb> leafAabbs;
+	leafAabbs.Reserve(nodeCount / 2 + 1);
+	DKAabb aabb;
+	for (int i = 0; i < nodeCount; ++i)
+	{
+		if (treeNodes[i].objectIndex >= 0)
+		{
+			DKAabb box = this->volume->AabbForObjectAtIndex(treeNodes[i].objectIndex);
+			leafAabbs.Add(box);
+			aabb = DKAabb::Union(aabb, box);
+		}
+	}
+	this->volume->Unlock();
+
+	if (aabb.IsValid())
+	{
+		DKVector3 scale = aabb.positionMax - aabb.positionMin;
+
+		this->aabbScale.x = Max(scale.x, 0.00001);
+		this->aabbScale.y = Max(scale.y, 0.00001);
+		this->aabbScale.z = Max(scale.z, 0.00001);
+		this->aabbOffset = aabb.positionMin;
+	}
+
+	// update leaf-nodes, object which has invalid AABB never overlaps.
+	size_t leafIndex = 0;
+	for (int i = 0; i < nodeCount; ++i)
+	{
+		QuantizedAabbNode& node = treeNodes[i];
+		if (node.objectIndex >= 0)
+		{
+			const DKAabb& box = leafAabbs.Value(leafIndex++);
+			if (box.IsValid())
+			{
+				Quantize(box, node);
+			}
+			else
+			{
+				for (int k = 0; k < 3; ++k)
+				{
+					node.aabbMin[k] = 0xffff;
+					node.aabbMax[k] = 0;
+				}
+			}
+		}
+	}
+
+	// update sub-nodes from bottom. (children are placed after parent)
+	for (int i = nodeCount - 1; i >= 0; --i)
+	{
+		QuantizedAabbNode& node = treeNodes[i];
+		if (node.objectIndex < 0)
+		{
+			const QuantizedAabbNode& left = treeNodes[i + 1];
+			const QuantizedAabbNode& right = treeNodes[i + 1 + (left.objectIndex >= 0 ? 1 : -left.negativeTreeSize)];
+			for (int k = 0; k < 3; ++k)
+			{
+				node.aabbMin[k] = Min(left.aabbMin[k], right.aabbMin[k]);
+				node.aabbMax[k] = Max(left.aabbMax[k], right.aabbMax[k]);
+			}
+		}
+	}
+	return true;
+}
+
+void DKBvh::Quantize(const DKAabb& aabb, QuantizedAabbNode& node) const
+{
+	DKVector3 aabbMin = (aabb.positionMin - this->aabbOffset) / this->aabbScale * float(0xffff);
+	DKVector3 aabbMax = (aabb.positionMax - this->aabbOffset) / this->aabbScale * float(0xffff);
+
+	node.aabbMin[0] = aabbMin.val[0];
+	node.aabbMin[1] = aabbMin.val[1];
+	node.aabbMin[2] = aabbMin.val[2];
+	node.aabbMax[0] = aabbMax.val[0];
+	node.aabbMax[1] = aabbMax.val[1];
+	node.aabbMax[2] = aabbMax.val[2];
 }
 
 DKAabb DKBvh::Aabb(void) const
@@ -126,18 +274,55 @@ DKAabb DKBvh::Aabb(void) const
 }
 
 #define BVH_PARTITION_FULL_SORT	1
+#define BVH_SAH_NUM_BINS		16
+#define BVH_PARALLEL_BUILD_MIN	4096	// minimum leaf-nodes to build sub trees in parallel.
 
-void DKBvh::BuildTree(QuantizedAabbNode* leafNodes, int count)
+void DKBvh::BuildTree(QuantizedAabbNode* leafNodes, int count, QuantizedAabbNode* output, BuildMode mode, DKOperationQueue* queue, TaskGroup* group)
 {
 	DKASSERT_DEBUG(leafNodes);
 	DKASSERT_DEBUG(count > 0);
 
 	if (count == 1)	// leaf-node
 	{
-		this->nodes.Add(leafNodes[0]);
+		output[0] = leafNodes[0];
 		return;
 	}
 
+	int splitIndex = (mode == BuildModeSAH) ? SplitSAH(leafNodes, count) : SplitMedian(leafNodes, count);
+	DKASSERT_DEBUG(splitIndex > 0 && splitIndex < count);
+
+	// sub tree of N leaf-nodes has (2N-1) nodes, left sub tree is placed
+	// after current node, and right sub tree is placed after left sub tree.
+	QuantizedAabbNode* left = &output[1];
+	QuantizedAabbNode* right = &output[splitIndex * 2];
+
+	if (queue && count >= BVH_PARALLEL_BUILD_MIN)
+	{
+		TaskGroup subGroup(queue, group);
+		subGroup.Post(DKFunction([=, &subGroup]
+		{
+			BuildTree(leafNodes, splitIndex, left, mode, queue, &subGroup);
+		})->Invocation());
+		BuildTree(&leafNodes[splitIndex], count - splitIndex, right, mode, queue, &subGroup);
+		subGroup.Wait();
+	}
+	else
+	{
+		BuildTree(leafNodes, splitIndex, left, mode, NULL, NULL);
+		BuildTree(&leafNodes[splitIndex], count - splitIndex, right, mode, NULL, NULL);
+	}
+
+	QuantizedAabbNode& node = output[0];
+	for (int i = 0; i < 3; ++i)
+	{
+		node.aabbMin[i] = Min(left->aabbMin[i], right->aabbMin[i]);
+		node.aabbMax[i] = Max(left->aabbMax[i], right->aabbMax[i]);
+	}
+	node.negativeTreeSize = 1 - count * 2;
+}
+
+int DKBvh::SplitMedian(QuantizedAabbNode* leafNodes, int count)
+{
 	using VectorI64 = int64_t[3];
 	using VectorI32 = int32_t[3];
 	using VectorI16 = int16_t[3];
@@ -212,26 +397,133 @@ void DKBvh::BuildTree(QuantizedAabbNode* leafNodes, int count)
 	}
 	DKASSERT_DEBUG(splitIndex < count);
 #endif
-	// recursion
-	int currentNodeIndex = (int)nodes.Add(QuantizedAabbNode());
+	return splitIndex;
+}
 
-	// build left sub tree
-	int leftChildNodeIndex = (int)nodes.Count();
-	BuildTree(leafNodes, splitIndex);
+int DKBvh::SplitSAH(QuantizedAabbNode* leafNodes, int count)
+{
+	// binned SAH, bins are placed on centroid range of each axis.
+	// (centroid values are doubled, aabbMin + aabbMax)
+	struct Bin
+	{
+		int count;
+		int32_t aabbMin[3];
+		int32_t aabbMax[3];
 
-	// build right sub tree
-	int rightChildNodeIndex = (int)nodes.Count();
-	BuildTree(&leafNodes[splitIndex], count - splitIndex);
+		void Reset(void)
+		{
+			count = 0;
+			aabbMin[0] = aabbMin[1] = aabbMin[2] = 0xffff;
+			aabbMax[0] = aabbMax[1] = aabbMax[2] = 0;
+		}
+		void Merge(const int32_t* bmin, const int32_t* bmax)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				aabbMin[k] = Min(aabbMin[k], bmin[k]);
+				aabbMax[k] = Max(aabbMax[k], bmax[k]);
+			}
+		}
+		double HalfArea(void) const
+		{
+			double x = aabbMax[0] - aabbMin[0];
+			double y = aabbMax[1] - aabbMin[1];
+			double z = aabbMax[2] - aabbMin[2];
+			return x * y + y * z + z * x;
+		}
+	};
+	const int numBins = BVH_SAH_NUM_BINS;
 
-	QuantizedAabbNode& node = nodes.Value(currentNodeIndex);
-	QuantizedAabbNode& left = nodes.Value(leftChildNodeIndex);
-	QuantizedAabbNode& right = nodes.Value(rightChildNodeIndex);
-	for (int i = 0; i < 3; ++i)
+	int32_t centroidMin[3] = { 0x1ffff, 0x1ffff, 0x1ffff };
+	int32_t centroidMax[3] = { 0, 0, 0 };
+	for (int i = 0; i < count; ++i)
 	{
-		node.aabbMin[i] = Min(left.aabbMin[i], right.aabbMin[i]);
-		node.aabbMax[i] = Max(left.aabbMax[i], right.aabbMax[i]);
+		const QuantizedAabbNode& node = leafNodes[i];
+		for (int k = 0; k < 3; ++k)
+		{
+			int32_t c = node.aabbMin[k] + node.aabbMax[k];
+			centroidMin[k] = Min(centroidMin[k], c);
+			centroidMax[k] = Max(centroidMax[k], c);
+		}
 	}
-	node.negativeTreeSize = currentNodeIndex - static_cast<int>(nodes.Count());
+
+	auto binIndex = [&](const QuantizedAabbNode& node, int axis)->int
+	{
+		int64_t c = node.aabbMin[axis] + node.aabbMax[axis] - centroidMin[axis];
+		return (int)(c * numBins / (int64_t(centroidMax[axis] - centroidMin[axis]) + 1));
+	};
+
+	int bestAxis = -1;
+	int bestBin = 0;
+	double bestCost = DBL_MAX;
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		if (centroidMax[axis] <= centroidMin[axis])
+			continue;
+
+		Bin bins[numBins];
+		for (Bin& b : bins)
+			b.Reset();
+
+		for (int i = 0; i < count; ++i)
+		{
+			const QuantizedAabbNode& node = leafNodes[i];
+			int32_t bmin[3] = { node.aabbMin[0], node.aabbMin[1], node.aabbMin[2] };
+			int32_t bmax[3] = { node.aabbMax[0], node.aabbMax[1], node.aabbMax[2] };
+			Bin& b = bins[binIndex(node, axis)];
+			b.count++;
+			b.Merge(bmin, bmax);
+		}
+
+		// sweep from right, cost of right side of split after bin (i)
+		double rightCost[numBins];
+		int rightCount[numBins];
+		Bin acc;
+		acc.Reset();
+		for (int i = numBins - 1; i > 0; --i)
+		{
+			if (bins[i].count > 0)
+			{
+				acc.count += bins[i].count;
+				acc.Merge(bins[i].aabbMin, bins[i].aabbMax);
+			}
+			rightCount[i - 1] = acc.count;
+			rightCost[i - 1] = acc.count > 0 ? acc.HalfArea() * acc.count : 0.0;
+		}
+		// sweep from left
+		acc.Reset();
+		for (int i = 0; i < numBins - 1; ++i)
+		{
+			if (bins[i].count > 0)
+			{
+				acc.count += bins[i].count;
+				acc.Merge(bins[i].aabbMin, bins[i].aabbMax);
+			}
+			if (acc.count > 0 && rightCount[i] > 0)
+			{
+				double cost = acc.HalfArea() * acc.count + rightCost[i];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestBin = i;
+				}
+			}
+		}
+	}
+
+	if (bestAxis < 0)	// all centroids are same.
+		return count / 2;
+
+	QuantizedAabbNode* mid = std::partition(leafNodes, leafNodes + count,
+		[&](const QuantizedAabbNode& node)->bool
+	{
+		return binIndex(node, bestAxis) <= bestBin;
+	});
+	int splitIndex = (int)(mid - leafNodes);
+	DKASSERT_DEBUG(splitIndex > 0 && splitIndex < count);
+	return splitIndex;
 }
 
 template <typename T>
@@ -316,6 +608,104 @@ bool DKBvh::RayTest(const DKLine& ray, RayCastResultCallback* cb) const
 	return false;
 }
 
+int DKBvh::RayTestClosest(const DKLine& ray, RayHitFractionCallback* cb, float* hitFraction) const
+{
+	int closestObject = -1;
+	float closest = 1.0f;
+
+	const int nodeCount = (int)this->nodes.Count();
+	if (this->volume && cb && nodeCount > 0)
+	{
+		const QuantizedAabbNode* treeNodes = this->nodes;
+
+		// transform ray into quantized space. (ray = origin + dir * t, 0 <= t <= 1)
+		float origin[4] = { 0, 0, 0, 0 };
+		float invDir[4] = { 0, 0, 0, 0 };
+		for (int i = 0; i < 3; ++i)
+		{
+			DKASSERT_DEBUG(this->aabbScale.val[i] > 0.0f);
+			origin[i] = (ray.begin.val[i] - this->aabbOffset.val[i]) / this->aabbScale.val[i] * float(0xffff);
+			float d = (ray.end.val[i] - ray.begin.val[i]) / this->aabbScale.val[i] * float(0xffff);
+			// clamp magnitude with sign kept, inverse of zero or denormal is infinite.
+			if (fabs(d) < FLT_MIN)
+				d = copysignf(FLT_MIN, d);
+			invDir[i] = 1.0f / d;
+		}
+
+		// quantized values are truncated, expand max by one.
+		auto rayTestNode = [&](const QuantizedAabbNode& node, float& tnear)->bool
+		{
+			const float nodeMin[4] = { float(node.aabbMin[0]), float(node.aabbMin[1]), float(node.aabbMin[2]), 0.0f };
+			const float nodeMax[4] = { float(node.aabbMax[0]) + 1.0f, float(node.aabbMax[1]) + 1.0f, float(node.aabbMax[2]) + 1.0f, 0.0f };
+			return SimdRayAabbTest(origin, invDir, nodeMin, nodeMax, closest, &tnear);
+		};
+
+		BvhTraversalStack stack;
+		int index = 0;
+		float tnear = 0.0f;
+		bool traverse = rayTestNode(treeNodes[0], tnear);
+		while (traverse)
+		{
+			const QuantizedAabbNode& node = treeNodes[index];
+			if (node.objectIndex >= 0)	// leaf-node
+			{
+				float f = cb->Invoke(node.objectIndex, ray, closest);
+				if (f >= 0.0f && f <= closest && (closestObject < 0 || f < closest))
+				{
+					closest = f;
+					closestObject = node.objectIndex;
+				}
+			}
+			else
+			{
+				// visit nearer child first, push farther child.
+				int left = index + 1;
+				int right = left + (treeNodes[left].objectIndex >= 0 ? 1 : -treeNodes[left].negativeTreeSize);
+				float tl, tr;
+				bool hitLeft = rayTestNode(treeNodes[left], tl);
+				bool hitRight = rayTestNode(treeNodes[right], tr);
+				if (hitLeft && hitRight)
+				{
+					if (tl <= tr)
+					{
+						stack.Push(right, tr);
+						index = left;
+					}
+					else
+					{
+						stack.Push(left, tl);
+						index = right;
+					}
+					continue;
+				}
+				else if (hitLeft)
+				{
+					index = left;
+					continue;
+				}
+				else if (hitRight)
+				{
+					index = right;
+					continue;
+				}
+			}
+			// pop next node, skip nodes behind closest hit.
+			traverse = false;
+			while (stack.Pop(index, tnear))
+			{
+				if (tnear <= closest)
+				{
+					traverse = true;
+					break;
+				}
+			}
+		}
+	}
+	if (closestObject >= 0 && hitFraction)
+		*hitFraction = closest;
+	return closestObject;
+}
+
 bool DKBvh::AabbOverlapTest(const DKAabb& aabb, AabbOverlapResultCallback* cb) const
 {
 	if (this->volume && aabb.IsValid())
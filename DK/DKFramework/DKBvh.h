@@ -15,6 +15,19 @@
 ////////////////////////////////////////////////////////////////////////////////
 // DKBvh
 // implementation of BVH (Bounding volume hierarchy) to perform ray-test fast.
+//
+// Build modes
+//   BuildModeMedian: split nodes at median of centroids, on axis which has
+//                    largest deviation. (default, same tree as before)
+//   BuildModeSAH: split nodes with binned Surface-Area-Heuristic.
+//                 (better tree for irregular geometry, slower to build)
+//
+// tree can be built with operation queue, sub trees of large object set
+// are built in parallel. (AABBs of objects are queried from calling thread)
+//
+// Refit() updates bounds of nodes from AABBs of objects without rebuild.
+// tree structure is not changed, you should rebuild tree if objects moved
+// too far. (tree quality gets worse)
 ////////////////////////////////////////////////////////////////////////////////
 
 #pragma pack(push, 4)
@@ -34,11 +47,23 @@ namespace DKFramework
 			virtual void Unlock(void) {}
 		};
 
+		enum BuildMode
+		{
+			BuildModeMedian = 0,
+			BuildModeSAH,
+		};
+
 		DKBvh(void);
 		~DKBvh(void);
 
-		void Build(VolumeInterface*);
-		void Rebuild(void);
+		void Build(VolumeInterface*, BuildMode mode = BuildModeMedian, DKFoundation::DKOperationQueue* queue = NULL);
+		void Rebuild(DKFoundation::DKOperationQueue* queue = NULL);
+		// update bounds of nodes. returns false if number of objects changed.
+		// (objects which had invalid AABB on build are not included until rebuild)
+		bool Refit(void);
+
+		BuildMode Mode(void) const { return mode; }
+		size_t NumberOfNodes(void) const { return nodes.Count(); }
 
 		VolumeInterface* Volume(void) { return volume;}
 		const VolumeInterface* Volume(void) const { return volume;}
@@ -54,6 +79,15 @@ namespace DKFramework
 		using RayCastResultCallback = DKFoundation::DKFunctionSignature<bool (int, const DKLine&)>;
 		bool RayTest(const DKLine& ray, RayCastResultCallback*) const;
 
+		// RayHitFractionCallback : hit-test callback for closest hit query.
+		//   return hit fraction of object (0.0: ray.begin, 1.0: ray.end),
+		//   or negative value if object is not hit.
+		// Nodes are visited front-to-back, nodes farther than closest hit are skipped.
+		// parameter: (object-index, ray, fraction of closest hit so far)
+		// returns object index of closest hit, or -1 if nothing hit.
+		using RayHitFractionCallback = DKFoundation::DKFunctionSignature<float (int, const DKLine&, float)>;
+		int RayTestClosest(const DKLine& ray, RayHitFractionCallback*, float* hitFraction = NULL) const;
+
 		// AabbCastResultCallback : filter-callback function.
 		//   return false if aabb-overlap test no longer necessary.
 		//   return true if callback needs next overlapped object continously.
@@ -74,11 +108,18 @@ namespace DKFramework
 			};
 		};
 
-		void BuildInternal(void);
-		void BuildTree(QuantizedAabbNode* nodes, int count);
+		using TaskGroup = DKFoundation::DKOperationQueue::TaskGroup;
+
+		void BuildInternal(DKFoundation::DKOperationQueue* queue);
+		void Quantize(const DKAabb& aabb, QuantizedAabbNode& node) const;
+		static void BuildTree(QuantizedAabbNode* leafNodes, int count, QuantizedAabbNode* output, BuildMode mode, DKFoundation::DKOperationQueue* queue, TaskGroup* group);
+		static int SplitMedian(QuantizedAabbNode* leafNodes, int count);
+		static int SplitSAH(QuantizedAabbNode* leafNodes, int count);
 
 		DKFoundation::DKObject<VolumeInterface> volume;
 		DKFoundation::DKArray<QuantizedAabbNode> nodes;
+		BuildMode mode;
+		int numObjects;
 		DKVector3 aabbOffset;
 		DKVector3 aabbScale;
 	};
@@ -333,6 +333,10 @@ DKObject<DKSerializer> DKCollisionShape::SerializeHelper::Serializer(void)
 					pairs.Insert(L"indexSize", (DKVariant::VInteger)indexSize);
 					pairs.Insert(L"aabbMin", (const DKVariant::VVector3&)aabb.positionMin);
 					pairs.Insert(L"aabbMax", (const DKVariant::VVector3&)aabb.positionMax);
+					// optimized BVH, restored if platform and content are matched.
+					DKObject<DKData> bvhData = meshShape->SerializeBvh();
+					if (bvhData)
+						pairs.Insert(L"optimizedBvh", DKVariant::VData(bvhData));
 				}
 				break;
 			}
@@ -548,6 +552,7 @@ DKObject<DKSerializer> DKCollisionShape::SerializeHelper::Serializer(void)
 					auto indexSize = pairs.Find(L"indexSize");
 					auto aabbMin = pairs.Find(L"aabbMin");
 					auto aabbMax = pairs.Find(L"aabbMax");
+					auto optimizedBvh = pairs.Find(L"optimizedBvh");
 					if (vertices && indices &&  indexSize &&
 						vertices->value.ValueType() == DKVariant::TypeStructData &&
 						indices->value.ValueType() == DKVariant::TypeStructData &&
@@ -571,14 +576,18 @@ DKObject<DKSerializer> DKCollisionShape::SerializeHelper::Serializer(void)
 							{
 								const DKVariant::VStructuredData& vertexData = vertices->value.StructuredData();
 								const DKVariant::VStructuredData& indexData = indices->value.StructuredData();
+								// BVH is restored in-place with copied buffer.
+								DKObject<DKData> bvhData = NULL;
+								if (optimizedBvh && optimizedBvh->value.ValueType() == DKVariant::TypeData)
+									bvhData = DKBuffer::Create(&optimizedBvh->value.Data()).SafeCast<DKData>();
 								if (idxSize == 4)
 								*p = DKOBJECT_NEW DKStaticTriangleMeshShape(
 									(const DKVector3*)vertexData.data.LockShared(), numVerts,
-									(const unsigned int*)indexData.data.LockShared(), numIndices, aabb);
+									(const unsigned int*)indexData.data.LockShared(), numIndices, bvhData, aabb);
 								else
 									*p = DKOBJECT_NEW DKStaticTriangleMeshShape(
 									(const DKVector3*)vertexData.data.LockShared(), numVerts,
-									(const unsigned short*)indexData.data.LockShared(), numIndices, aabb);
+									(const unsigned short*)indexData.data.LockShared(), numIndices, bvhData, aabb);
 								vertexData.data.UnlockShared();
 								indexData.data.UnlockShared();
 							}
@@ -5,6 +5,8 @@
 //  Copyright (c) 2004-2015 Hongtae Kim. All rights reserved.
 //
 
+#include <atomic>
+#include <algorithm>
 #include "Private/BulletUtils.h"
 #include "DKMath.h"
 #include "DKDynamicsScene.h"
@@ -16,18 +18,72 @@ namespace DKFramework
 {
 	namespace Private
 	{
+		// convex-convex algorithm which owns simplex solver.
+		// bullet's default algorithms share one simplex solver of collision
+		// configuration, it cannot be used by multiple threads.
+		struct ConvexConvexAlgorithm : public btConvexConvexAlgorithm
+		{
+			btVoronoiSimplexSolver simplexSolver;
+
+			ConvexConvexAlgorithm(const btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, btConvexPenetrationDepthSolver* pdSolver, int numPerturbationIterations, int minimumPointsPerturbationThreshold)
+				: btConvexConvexAlgorithm(ci.m_manifold, ci, body0Wrap, body1Wrap, &simplexSolver, pdSolver, numPerturbationIterations, minimumPointsPerturbationThreshold)
+			{
+			}
+
+			struct CreateFunc : public btConvexConvexAlgorithm::CreateFunc
+			{
+				CreateFunc(btConvexPenetrationDepthSolver* pdSolver) : btConvexConvexAlgorithm::CreateFunc(NULL, pdSolver) {}
+
+				btCollisionAlgorithm* CreateCollisionAlgorithm(btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap) override
+				{
+					void* mem = ci.m_dispatcher1->allocateCollisionAlgorithm(sizeof(ConvexConvexAlgorithm));
+					return new(mem) ConvexConvexAlgorithm(ci, body0Wrap, body1Wrap, m_pdSolver, m_numPerturbationIterations, m_minimumPointsPerturbationThreshold);
+				}
+			};
+		};
+
+		struct CollisionConfiguration : public btDefaultCollisionConfiguration
+		{
+			CollisionConfiguration(void) : btDefaultCollisionConfiguration(ConstructionInfo())
+			{
+				m_convexConvexCreateFunc->~btCollisionAlgorithmCreateFunc();
+				btAlignedFree(m_convexConvexCreateFunc);
+
+				void* mem = btAlignedAlloc(sizeof(ConvexConvexAlgorithm::CreateFunc), 16);
+				m_convexConvexCreateFunc = new(mem) ConvexConvexAlgorithm::CreateFunc(m_pdSolver);
+			}
+			static btDefaultCollisionConstructionInfo ConstructionInfo(void)
+			{
+				btDefaultCollisionConstructionInfo info;
+				info.m_customCollisionAlgorithmMaxElementSize = sizeof(ConvexConvexAlgorithm);
+				return info;
+			}
+		};
+
 		struct CollisionDispatcher : public btCollisionDispatcher
 		{
 			typedef DKFunctionSignature<bool (DKCollisionObject*, DKCollisionObject*)> CollisionHandler;
 			DKObject<CollisionHandler> collisionFunc;
 			DKObject<CollisionHandler> responseFunc;
 
-			CollisionDispatcher(btCollisionConfiguration* config) : btCollisionDispatcher(config) {}
+			DKOperationQueue* queue;	// queue for parallel dispatch, NULL for serial dispatch.
+
+			CollisionDispatcher(btCollisionConfiguration* config)
+				: btCollisionDispatcher(config)
+				, queue(NULL)
+				, parallelDispatch(false)
+				, manifoldSequence(0)
+			{
+			}
 
 			bool needsCollision(const btCollisionObject* body0,const btCollisionObject* body1)
 			{
 				if (btCollisionDispatcher::needsCollision(body0, body1))
 				{
+					// algorithms created by worker (child of compound) check
+					// the pair again, pair has been accepted on calling thread.
+					if (parallelDispatch)
+						return true;
 					if (collisionFunc)
 					{
 						DKCollisionObject* obj0 = (DKCollisionObject*)body0->getUserPointer();
@@ -54,20 +110,403 @@ namespace DKFramework
 				}
 				return false;
 			}
-			//void dispatchAllCollisionPairs(btOverlappingPairCache* pairCache,const btDispatcherInfo& dispatchInfo,btDispatcher* dispatcher)
-			//{
-			//	btCollisionDispatcher::dispatchAllCollisionPairs(pairCache, dispatchInfo, dispatcher);
-			//}
+			void dispatchAllCollisionPairs(btOverlappingPairCache* pairCache,const btDispatcherInfo& dispatchInfo,btDispatcher* dispatcher)
+			{
+				// minimum number of pairs for one operation.
+				enum { MinPairsPerOperation = 64 };
+
+				size_t maxConcurrent = queue ? queue->MaxConcurrentOperations() : 1;
+				if (maxConcurrent <= 1 ||
+					dispatchInfo.m_dispatchFunc != btDispatcherInfo::DISPATCH_DISCRETE ||
+					getNearCallback() != defaultNearCallback)
+				{
+					btCollisionDispatcher::dispatchAllCollisionPairs(pairCache, dispatchInfo, dispatcher);
+					return;
+				}
+
+				// pick out pairs to be processed and create algorithms on calling thread.
+				// (NeedCollision is not called from worker threads)
+				btBroadphasePairArray& pairArray = pairCache->getOverlappingPairArray();
+				collidingPairs.Clear();
+				collidingPairs.Reserve(pairArray.size());
+				ResetManifoldOrder();
+
+				for (int i = 0; i < pairArray.size(); ++i)
+				{
+					btBroadphasePair& pair = pairArray[i];
+					btCollisionObject* colObj0 = (btCollisionObject*)pair.m_pProxy0->m_clientObject;
+					btCollisionObject* colObj1 = (btCollisionObject*)pair.m_pProxy1->m_clientObject;
+
+					if (needsCollision(colObj0, colObj1))
+					{
+						if (pair.m_algorithm == NULL)
+						{
+							btCollisionObjectWrapper obj0Wrap(0, colObj0->getCollisionShape(), colObj0, colObj0->getWorldTransform(), -1, -1);
+							btCollisionObjectWrapper obj1Wrap(0, colObj1->getCollisionShape(), colObj1, colObj1->getWorldTransform(), -1, -1);
+							pair.m_algorithm = findAlgorithm(&obj0Wrap, &obj1Wrap);
+						}
+						if (pair.m_algorithm)
+							collidingPairs.Add(&pair);
+					}
+				}
+
+				size_t count = collidingPairs.Count();
+				if (count >= MinPairsPerOperation * 2)
+				{
+					size_t numOps = Min(count / MinPairsPerOperation, maxConcurrent * 4);
+					PairRange range = { DKThread::invalidId, 0, 0 };
+					pairRanges.Clear();
+					pairRanges.Add(range, numOps);
+
+					parallelDispatch = true;
+					DKOperationQueue::TaskGroup group(queue);
+					for (size_t i = 0; i < numOps; ++i)
+					{
+						size_t begin = count * i / numOps;
+						size_t end = count * (i + 1) / numOps;
+						group.Post(DKFunction([this, &dispatchInfo, i, begin, end]
+						{
+							ProcessPairs(&pairRanges.Value(i), begin, end, dispatchInfo);
+						})->Invocation());
+					}
+					group.Wait();
+					parallelDispatch = false;
+
+					SortManifolds();
+				}
+				else
+				{
+					ProcessPairs(NULL, 0, count, dispatchInfo);
+				}
+				collidingPairs.Clear();
+			}
+			btPersistentManifold* getNewManifold(const btCollisionObject* b0, const btCollisionObject* b1)
+			{
+				DKCriticalSection<DKSpinLock> guard(allocatorLock);
+				btPersistentManifold* manifold = btCollisionDispatcher::getNewManifold(b0, b1);
+				manifold->m_companionIdA = manifoldSequence++;
+				manifold->m_companionIdB = -1;
+				if (parallelDispatch)
+				{
+					// manifold created by worker, ordered after all pairs processed.
+					DKThread::ThreadId tid = DKThread::CurrentThreadId();
+					for (PairRange& range : pairRanges)
+					{
+						if (range.threadId == tid)
+						{
+							NewManifold nm = { manifold, range.pairIndex, range.numManifolds++ };
+							manifold->m_companionIdB = (int)newManifolds.Add(nm);
+							break;
+						}
+					}
+					DKASSERT_DEBUG(manifold->m_companionIdB >= 0);
+				}
+				return manifold;
+			}
+			void releaseManifold(btPersistentManifold* manifold)
+			{
+				DKCriticalSection<DKSpinLock> guard(allocatorLock);
+				if (parallelDispatch && manifold->m_companionIdB >= 0)
+				{
+					DKASSERT_DEBUG(newManifolds.Value(manifold->m_companionIdB).manifold == manifold);
+					newManifolds.Value(manifold->m_companionIdB).manifold = NULL;
+				}
+				btCollisionDispatcher::releaseManifold(manifold);
+			}
+			void* allocateCollisionAlgorithm(int size)
+			{
+				DKCriticalSection<DKSpinLock> guard(allocatorLock);
+				return btCollisionDispatcher::allocateCollisionAlgorithm(size);
+			}
+			void freeCollisionAlgorithm(void* ptr)
+			{
+				DKCriticalSection<DKSpinLock> guard(allocatorLock);
+				btCollisionDispatcher::freeCollisionAlgorithm(ptr);
+			}
+
+		private:
+			// pair range of an operation, to identify pair which creates manifold.
+			struct PairRange
+			{
+				DKThread::ThreadId threadId;
+				size_t pairIndex;
+				size_t numManifolds;
+			};
+			struct NewManifold
+			{
+				btPersistentManifold* manifold;
+				size_t pairIndex;
+				size_t sequence;
+			};
+			DKArray<btBroadphasePair*> collidingPairs;
+			DKArray<PairRange> pairRanges;
+			DKArray<NewManifold> newManifolds;
+			DKSpinLock allocatorLock;
+			bool parallelDispatch;
+			int manifoldSequence;	// order key of manifold. (m_companionIdA)
+
+			void ProcessPairs(PairRange* range, size_t begin, size_t end, const btDispatcherInfo& dispatchInfo)
+			{
+				if (range)
+				{
+					DKCriticalSection<DKSpinLock> guard(allocatorLock);
+					range->threadId = DKThread::CurrentThreadId();
+				}
+				for (size_t i = begin; i < end; ++i)
+				{
+					btBroadphasePair& pair = *collidingPairs.Value(i);
+					if (range)
+					{
+						range->pairIndex = i;
+						range->numManifolds = 0;
+					}
+					btCollisionObject* colObj0 = (btCollisionObject*)pair.m_pProxy0->m_clientObject;
+					btCollisionObject* colObj1 = (btCollisionObject*)pair.m_pProxy1->m_clientObject;
+
+					btCollisionObjectWrapper obj0Wrap(0, colObj0->getCollisionShape(), colObj0, colObj0->getWorldTransform(), -1, -1);
+					btCollisionObjectWrapper obj1Wrap(0, colObj1->getCollisionShape(), colObj1, colObj1->getWorldTransform(), -1, -1);
+					btManifoldResult contactPointResult(&obj0Wrap, &obj1Wrap);
+					pair.m_algorithm->processCollision(&obj0Wrap, &obj1Wrap, dispatchInfo, &contactPointResult);
+				}
+				if (range)
+				{
+					DKCriticalSection<DKSpinLock> guard(allocatorLock);
+					range->threadId = DKThread::invalidId;
+				}
+			}
+			// manifold companion ids are not used by bullet's sequential
+			// pipeline, m_companionIdA is used as order key and m_companionIdB
+			// is index of newManifolds while dispatching pairs in parallel.
+			void ResetManifoldOrder(void)
+			{
+				for (int i = 0; i < m_manifoldsPtr.size(); ++i)
+				{
+					btPersistentManifold* manifold = m_manifoldsPtr[i];
+					manifold->m_index1a = i;
+					manifold->m_companionIdA = i;
+					manifold->m_companionIdB = -1;
+				}
+				manifoldSequence = m_manifoldsPtr.size();
+			}
+			// manifolds created or released by workers leave manifold array in
+			// timing dependent order, which changes order of contact solving.
+			// reorder manifolds with creation order of pairs (not threads).
+			void SortManifolds(void)
+			{
+				newManifolds.Sort([](const NewManifold& lhs, const NewManifold& rhs)
+				{
+					if (lhs.pairIndex == rhs.pairIndex)
+						return lhs.sequence < rhs.sequence;
+					return lhs.pairIndex < rhs.pairIndex;
+				});
+				for (const NewManifold& nm : newManifolds)
+				{
+					if (nm.manifold)
+						nm.manifold->m_companionIdA = manifoldSequence++;
+				}
+				newManifolds.Clear();
+
+				m_manifoldsPtr.quickSort([](const btPersistentManifold* lhs, const btPersistentManifold* rhs)
+				{
+					return lhs->m_companionIdA < rhs->m_companionIdA;
+				});
+				ResetManifoldOrder();
+			}
+		};
+
+		struct DynamicsWorld : public btDiscreteDynamicsWorld
+		{
+			DKOperationQueue* queue;	// queue for parallel solving, NULL for serial solving.
+
+			DynamicsWorld(btDispatcher* dispatcher, btBroadphaseInterface* broadphase, btConstraintSolver* solver, btCollisionConfiguration* config)
+				: btDiscreteDynamicsWorld(dispatcher, broadphase, solver, config)
+				, queue(NULL)
+			{
+			}
+			~DynamicsWorld(void)
+			{
+				for (IslandBatch* batch : batchPool)
+					delete batch;
+				for (btConstraintSolver* solver : islandSolvers)
+					delete solver;
+			}
+
+			void solveConstraints(btContactSolverInfo& solverInfo)
+			{
+				size_t maxConcurrent = queue ? queue->MaxConcurrentOperations() : 1;
+				if (maxConcurrent <= 1 ||
+					!m_islandManager->getSplitIslands() ||
+					m_constraintSolver->getSolverType() != BT_SEQUENTIAL_IMPULSE_SOLVER)
+				{
+					btDiscreteDynamicsWorld::solveConstraints(solverInfo);
+					return;
+				}
+
+				m_sortedConstraints.resize(m_constraints.size());
+				for (int i = 0; i < m_constraints.size(); ++i)
+					m_sortedConstraints[i] = m_constraints[i];
+				m_sortedConstraints.quickSort([](const btTypedConstraint* lhs, const btTypedConstraint* rhs)
+				{
+					return ConstraintIslandId(lhs) < ConstraintIslandId(rhs);
+				});
+
+				// collect islands into batches, and then solve batches in parallel.
+				kinematicBatch.Reset();
+				IslandCollector collector(this, solverInfo.m_minimumSolverBatchSize);
+				m_constraintSolver->prepareSolve(getNumCollisionObjects(), getDispatcher()->getNumManifolds());
+				m_islandManager->buildAndProcessIslands(getDispatcher(), this, &collector);
+
+				batches.Clear();
+				for (size_t i = 0; i < collector.numBatches; ++i)
+					batches.Add(batchPool.Value(i));
+				if (!kinematicBatch.IsEmpty())
+					batches.Add(&kinematicBatch);
+
+				size_t numBatches = batches.Count();
+				size_t numOps = Min(numBatches, maxConcurrent);
+				if (numOps > 1)
+				{
+					while (islandSolvers.Count() < numOps)
+						islandSolvers.Add(new btSequentialImpulseConstraintSolver());
+
+					DKOperationQueue::TaskGroup group(queue);
+					for (size_t i = 0; i < numOps; ++i)
+					{
+						group.Post(DKFunction([this, &solverInfo, i, numOps, numBatches]
+						{
+							for (size_t k = i; k < numBatches; k += numOps)
+								SolveBatch(islandSolvers.Value(i), batches.Value(k), solverInfo);
+						})->Invocation());
+					}
+					group.Wait();
+				}
+				else
+				{
+					for (IslandBatch* batch : batches)
+						SolveBatch(m_constraintSolver, batch, solverInfo);
+				}
+				batches.Clear();
+				m_constraintSolver->allSolved(solverInfo, m_debugDrawer);
+			}
+
+		private:
+			// islands to be solved with one solver call.
+			struct IslandBatch
+			{
+				btAlignedObjectArray<btCollisionObject*> bodies;
+				btAlignedObjectArray<btPersistentManifold*> manifolds;
+				btAlignedObjectArray<btTypedConstraint*> constraints;
+
+				void Reset(void)
+				{
+					bodies.resize(0);
+					manifolds.resize(0);
+					constraints.resize(0);
+				}
+				bool IsEmpty(void) const
+				{
+					return manifolds.size() == 0 && constraints.size() == 0;
+				}
+				int Size(void) const
+				{
+					return manifolds.size() + constraints.size();
+				}
+			};
+			DKArray<IslandBatch*> batchPool;	// reused in every step.
+			DKArray<IslandBatch*> batches;
+			IslandBatch kinematicBatch;
+			DKArray<btConstraintSolver*> islandSolvers;
+
+			static int ConstraintIslandId(const btTypedConstraint* c)
+			{
+				const btCollisionObject& obj0 = c->getRigidBodyA();
+				const btCollisionObject& obj1 = c->getRigidBodyB();
+				return obj0.getIslandTag() >= 0 ? obj0.getIslandTag() : obj1.getIslandTag();
+			}
+			void SolveBatch(btConstraintSolver* solver, IslandBatch* batch, btContactSolverInfo& solverInfo)
+			{
+				btCollisionObject** bodies = batch->bodies.size() ? &batch->bodies[0] : NULL;
+				btPersistentManifold** manifolds = batch->manifolds.size() ? &batch->manifolds[0] : NULL;
+				btTypedConstraint** constraints = batch->constraints.size() ? &batch->constraints[0] : NULL;
+
+				// reset random seed, result should not depend on which solver is used.
+				solver->reset();
+				solver->solveGroup(bodies, batch->bodies.size(), manifolds, batch->manifolds.size(), constraints, batch->constraints.size(), solverInfo, NULL, getDispatcher());
+			}
+
+			// collect islands into batches, like bullet's InplaceSolverIslandCallback.
+			// batches are independent of number of threads.
+			// islands connected with kinematic objects are collected into one
+			// batch, because solver writes companion id of kinematic object.
+			struct IslandCollector : public btSimulationIslandManager::IslandCallback
+			{
+				DynamicsWorld* world;
+				int minimumBatchSize;
+				int constraintCursor;
+				size_t numBatches;
+				IslandBatch* batch;
+
+				IslandCollector(DynamicsWorld* w, int batchSize)
+					: world(w), minimumBatchSize(batchSize), constraintCursor(0), numBatches(0), batch(NULL)
+				{
+				}
+				void processIsland(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds, int numManifolds, int islandId)
+				{
+					// constraints are sorted by island id, islands are processed in order of id.
+					const btAlignedObjectArray<btTypedConstraint*>& constraints = world->m_sortedConstraints;
+					while (constraintCursor < constraints.size() && ConstraintIslandId(constraints[constraintCursor]) < islandId)
+						constraintCursor++;
+					int constraintBegin = constraintCursor;
+					while (constraintCursor < constraints.size() && ConstraintIslandId(constraints[constraintCursor]) == islandId)
+						constraintCursor++;
+					int constraintEnd = constraintCursor;
+
+					bool kinematic = false;
+					for (int i = 0; i < numManifolds && !kinematic; ++i)
+					{
+						kinematic = manifolds[i]->getBody0()->isKinematicObject() ||
+							manifolds[i]->getBody1()->isKinematicObject();
+					}
+					for (int i = constraintBegin; i < constraintEnd && !kinematic; ++i)
+					{
+						kinematic = constraints[i]->getRigidBodyA().isKinematicObject() ||
+							constraints[i]->getRigidBodyB().isKinematicObject();
+					}
+
+					IslandBatch* target = &world->kinematicBatch;
+					if (!kinematic)
+					{
+						if (batch == NULL)
+						{
+							if (world->batchPool.Count() <= numBatches)
+								world->batchPool.Add(new IslandBatch());
+							batch = world->batchPool.Value(numBatches++);
+							batch->Reset();
+						}
+						target = batch;
+					}
+
+					for (int i = 0; i < numBodies; ++i)
+						target->bodies.push_back(bodies[i]);
+					for (int i = 0; i < numManifolds; ++i)
+						target->manifolds.push_back(manifolds[i]);
+					for (int i = constraintBegin; i < constraintEnd; ++i)
+						target->constraints.push_back(constraints[i]);
+
+					if (batch && batch->Size() > minimumBatchSize)
+						batch = NULL;	// next island goes to new batch.
+				}
+			};
 		};
 
 		CollisionWorldContext* CreateDynamicsWorldContext(void)
 		{
 			CollisionWorldContext* ctxt = new CollisionWorldContext;
-			ctxt->configuration = new btDefaultCollisionConfiguration();
+			ctxt->configuration = new CollisionConfiguration();
 			ctxt->dispatcher = new CollisionDispatcher(ctxt->configuration);
 			ctxt->broadphase = new btDbvtBroadphase();
 			ctxt->solver = new btSequentialImpulseConstraintSolver();
-			ctxt->world = new btDiscreteDynamicsWorld(ctxt->dispatcher, ctxt->broadphase, ctxt->solver, ctxt->configuration);
+			ctxt->world = new DynamicsWorld(ctxt->dispatcher, ctxt->broadphase, ctxt->solver, ctxt->configuration);
 			ctxt->tick = 0;
 			return ctxt;
 		}
@@ -82,15 +521,110 @@ namespace DKFramework
 			void updateAction( btCollisionWorld*, btScalar delta)	{updater->Invoke(delta);}
 			void debugDraw(btIDebugDraw* debugDrawer)				{}
 		};
+
+		inline double SystemTime(void)
+		{
+			return (double)DKTimer::SystemTick() / (double)DKTimer::SystemTickFrequency();
+		}
 	}
 }
 
 using namespace DKFramework;
 using namespace DKFramework::Private;
 
+// state of asynchronous simulation and snapshots of rigid body transforms.
+// snapshots are written by simulation thread and read by other threads
+// without lock. (sequence lock)
+// readers use latest two snapshots, writer overwrites oldest one.
+// reader validates sequence of snapshots after reading, retries if one of
+// them has been overwritten while reading.
+// snapshot block is not released until scene is destroyed, reader can read
+// replaced block safely before validation.
+// entries are keyed by serial of rigid body instead of address, address of
+// removed body can be reused by new one.
+// simulation thread steps dynamics world only, objects are updated by
+// Update() with latest snapshot.
+struct DKDynamicsScene::AsyncSimulation
+{
+	enum { NumSnapshots = 4 };
+	enum { MaxCatchUpSteps = 5 };	// drop steps if simulation falls behind more than this.
+	static constexpr double defaultFrameRate = 60.0;
+
+	struct Entry
+	{
+		int64_t serial;
+		DKNSTransform transform;
+	};
+	struct Block
+	{
+		size_t capacity;
+		size_t count;
+		Entry* Entries(void)				{ return reinterpret_cast<Entry*>(this + 1); }
+		const Entry* Entries(void) const	{ return reinterpret_cast<const Entry*>(this + 1); }
+
+		// entries are sorted by serial.
+		const DKNSTransform* Find(int64_t serial) const
+		{
+			const Entry* e = Entries();
+			size_t begin = 0;
+			size_t end = Min(count, capacity);
+			while (begin < end)
+			{
+				size_t middle = begin + (end - begin) / 2;
+				if (e[middle].serial == serial)
+					return &e[middle].transform;
+				if (e[middle].serial < serial)
+					begin = middle + 1;
+				else
+					end = middle;
+			}
+			return NULL;
+		}
+	};
+	struct Snapshot
+	{
+		std::atomic<int64_t> sequence;	// -1 while writing.
+		std::atomic<Block*> block;
+		double time;
+	};
+
+	AsyncSimulation(void) : published(-1), stepping(false), running(false)
+	{
+		for (Snapshot& s : snapshots)
+		{
+			s.sequence.store(-1);
+			s.block.store(NULL);
+			s.time = 0.0;
+		}
+	}
+	~AsyncSimulation(void)
+	{
+		for (Snapshot& s : snapshots)
+		{
+			if (s.block.load())
+				DKMemoryHeapFree(s.block.load());
+		}
+		for (Block* b : retiredBlocks)
+			DKMemoryHeapFree(b);
+	}
+
+	Snapshot snapshots[NumSnapshots];
+	std::atomic<int64_t> published;	// sequence of latest snapshot.
+	DKArray<Block*> retiredBlocks;
+
+	bool stepping;	// world is being stepped by simulation thread.
+	DKObject<DKOperationQueue> queue;
+
+	DKMutex threadLock;
+	DKObject<DKThread> thread;
+	std::atomic<bool> running;
+};
+
 DKDynamicsScene::DKDynamicsScene(void)
 	: DKScene(CreateDynamicsWorldContext())
 	, dynamicsFixedFPS(0.0)
+	, parallelDynamics(false)
+	, asyncSimulation(new AsyncSimulation())
 	, actionInterface(NULL)
 {
 	DKASSERT_DEBUG(context);
@@ -122,6 +656,7 @@ DKDynamicsScene::~DKDynamicsScene(void)
 	DKASSERT_DEBUG(context && context->world);
 	DKASSERT_DEBUG(dynamic_cast<btDiscreteDynamicsWorld*>(context->world));
 
+	this->StopAsyncSimulation();
 	this->RemoveAllObjects();
 
 	btDiscreteDynamicsWorld* world = static_cast<btDiscreteDynamicsWorld*>(context->world);
@@ -133,6 +668,7 @@ DKDynamicsScene::~DKDynamicsScene(void)
 	DKASSERT_DEBUG(world->getNumConstraints() == 0);
 
 	delete this->actionInterface;
+	delete this->asyncSimulation;
 }
 
 void DKDynamicsScene::PreTickCallback(void* world, float delta)
@@ -140,7 +676,9 @@ void DKDynamicsScene::PreTickCallback(void* world, float delta)
 	DKDynamicsScene* scene = static_cast<DKDynamicsScene*>(static_cast<btDynamicsWorld*>(world)->getWorldUserInfo());
 
 	scene->context->internalTick++;
-	scene->UpdateObjectKinematics(delta, scene->context->internalTick);
+	// kinematics are updated by Update() in asynchronous mode.
+	if (!scene->asyncSimulation->stepping)
+		scene->UpdateObjectKinematics(delta, scene->context->internalTick);
 }
 
 void DKDynamicsScene::PostTickCallback(void* world, float delta)
@@ -153,14 +691,53 @@ void DKDynamicsScene::Update(double tickDelta, DKTimeTick tick)
 	DKASSERT_DEBUG(context && context->world);
 	DKASSERT_DEBUG(dynamic_cast<btDiscreteDynamicsWorld*>(context->world));
 
+	if (IsAsyncSimulationRunning())
+	{
+		// world is stepped by simulation thread.
+		// update kinematics and scene states of objects here with latest snapshot.
+		if (true)
+		{
+			DKCriticalSection<DKSpinLock> guard(context->lock);
+			if (tick && tick == context->tick)
+				return;
+			context->tick = tick;
+		}
+		PrepareUpdateNode();
+		if (true)
+		{
+			DKCriticalSection<DKSpinLock> guard(context->lock);
+			UpdateObjectKinematics(tickDelta, tick);
+			ApplySnapshot();
+		}
+		UpdateObjectSceneStates();
+		CleanupUpdateNode();
+		return;
+	}
+
 	if (tick && tick == context->tick)
 		return;
 
 	DKCriticalSection<DKSpinLock> guard(context->lock);
+	StepSimulation(tickDelta, tick);
+}
 
+void DKDynamicsScene::StepSimulation(double tickDelta, DKTimeTick tick)
+{
 	context->tick = tick;
 
 	PrepareUpdateNode();
+	StepWorld(tickDelta, parallelDynamics ? PendingUpdateQueue() : NULL);
+	UpdateObjectSceneStates();
+	CleanupUpdateNode();
+}
+
+void DKDynamicsScene::StepWorld(double tickDelta, DKOperationQueue* queue)
+{
+	// narrow-phase and constraint solving with update queue.
+	CollisionDispatcher* dispatcher = static_cast<CollisionDispatcher*>(context->dispatcher);
+	DynamicsWorld* world = static_cast<DynamicsWorld*>(context->world);
+	dispatcher->queue = queue;
+	world->queue = queue;
 
 	if (dynamicsFixedFPS > 0.001)	// fixed frame rate for calculate physics (frame per second)
 	{
@@ -168,15 +745,15 @@ void DKDynamicsScene::Update(double tickDelta, DKTimeTick tick)
 		int maxSubStep = ceil(tickDelta * dynamicsFixedFPS) + 1;
 		DKASSERT_DEBUG( maxSubStep > 0 );
 		DKASSERT_DEBUG( tickDelta < maxSubStep * fixedTimeStep );
-		static_cast<btDiscreteDynamicsWorld*>(context->world)->stepSimulation(tickDelta, maxSubStep, fixedTimeStep);
+		world->stepSimulation(tickDelta, maxSubStep, fixedTimeStep);
 	}
 	else
 	{
-		static_cast<btDiscreteDynamicsWorld*>(context->world)->stepSimulation(tickDelta);
+		world->stepSimulation(tickDelta);
 	}
 
-	UpdateObjectSceneStates();
-	CleanupUpdateNode();
+	dispatcher->queue = NULL;
+	world->queue = NULL;
 }
 
 void DKDynamicsScene::SetFixedFrameRate(double fps)
@@ -189,6 +766,218 @@ double DKDynamicsScene::FixedFrameRate(void) const
 	return dynamicsFixedFPS;
 }
 
+bool DKDynamicsScene::StartAsyncSimulation(void)
+{
+	AsyncSimulation* async = this->asyncSimulation;
+	DKCriticalSection<DKMutex> guard(async->threadLock);
+	if (async->thread)
+		return true;
+
+	async->queue = UpdateQueue();
+	async->running.store(true, std::memory_order_release);
+	async->thread = DKThread::Create(DKFunction(this, &DKDynamicsScene::AsyncSimulationProc)->Invocation());
+	if (async->thread == NULL)
+	{
+		async->running.store(false, std::memory_order_release);
+		async->queue = NULL;
+		DKLog("DKDynamicsScene: Failed to create simulation thread.\n");
+		return false;
+	}
+	return true;
+}
+
+void DKDynamicsScene::StopAsyncSimulation(void)
+{
+	AsyncSimulation* async = this->asyncSimulation;
+	DKCriticalSection<DKMutex> guard(async->threadLock);
+	if (async->thread)
+	{
+		async->running.store(false, std::memory_order_release);
+		async->thread->WaitTerminate();
+		async->thread = NULL;
+		async->queue = NULL;
+	}
+}
+
+bool DKDynamicsScene::IsAsyncSimulationRunning(void) const
+{
+	return asyncSimulation->running.load(std::memory_order_acquire);
+}
+
+void DKDynamicsScene::AsyncSimulationProc(void)
+{
+	AsyncSimulation* async = this->asyncSimulation;
+	double nextTime = SystemTime();
+
+	while (async->running.load(std::memory_order_acquire))
+	{
+		const double fps = dynamicsFixedFPS > 0.001 ? dynamicsFixedFPS : AsyncSimulation::defaultFrameRate;
+		const double step = 1.0 / fps;
+
+		double now = SystemTime();
+		if (now < nextTime)
+		{
+			DKThread::Sleep(nextTime - now);
+			continue;
+		}
+		if (now - nextTime > step * AsyncSimulation::MaxCatchUpSteps)
+			nextTime = now;
+
+		DKCriticalSection<DKSpinLock> guard(context->lock);
+		async->stepping = true;
+		StepWorld(step, parallelDynamics ? (DKOperationQueue*)async->queue : NULL);
+		async->stepping = false;
+		PublishSnapshot(nextTime);
+		nextTime += step;
+	}
+}
+
+void DKDynamicsScene::PublishSnapshot(double time)
+{
+	typedef AsyncSimulation::Block Block;
+	typedef AsyncSimulation::Entry Entry;
+
+	AsyncSimulation* async = this->asyncSimulation;
+	const int64_t seq = async->published.load(std::memory_order_relaxed) + 1;
+	AsyncSimulation::Snapshot& snapshot = async->snapshots[seq % AsyncSimulation::NumSnapshots];
+
+	snapshot.sequence.store(-1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	const size_t count = rigidBodies.Count();
+	Block* block = snapshot.block.load(std::memory_order_relaxed);
+	if (block == NULL || block->capacity < count)
+	{
+		// previous block can be read by other threads, keep it until scene destroyed.
+		size_t capacity = Max(count, block ? block->capacity * 2 : (size_t)16);
+		Block* newBlock = (Block*)DKMemoryHeapAlloc(sizeof(Block) + sizeof(Entry) * capacity);
+		if (newBlock == NULL)
+			throw std::bad_alloc();
+		newBlock->capacity = capacity;
+		newBlock->count = 0;
+		if (block)
+			async->retiredBlocks.Add(block);
+		snapshot.block.store(newBlock, std::memory_order_relaxed);
+		block = newBlock;
+	}
+
+	// transforms are taken from motion states, objects are not updated
+	// on simulation thread.
+	Entry* entries = block->Entries();
+	size_t n = 0;
+	rigidBodies.EnumerateForward([&](const DKRigidBody* rb)
+	{
+		if (n < block->capacity)
+		{
+			btTransform trans;
+			rb->motionState->getWorldTransform(trans);
+			entries[n].serial = rb->serial;
+			entries[n].transform = BulletTransform(trans);
+			n++;
+		}
+	});
+	std::sort(entries, entries + n, [](const Entry& lhs, const Entry& rhs) { return lhs.serial < rhs.serial; });
+	block->count = n;
+	snapshot.time = time;
+
+	snapshot.sequence.store(seq, std::memory_order_release);
+	async->published.store(seq, std::memory_order_release);
+}
+
+void DKDynamicsScene::ApplySnapshot(void)
+{
+	// called with context->lock, snapshot is not being written.
+	const AsyncSimulation* async = this->asyncSimulation;
+	const int64_t seq = async->published.load(std::memory_order_acquire);
+	const AsyncSimulation::Block* block = NULL;
+	if (seq >= 0)
+		block = async->snapshots[seq % AsyncSimulation::NumSnapshots].block.load(std::memory_order_acquire);
+
+	rigidBodies.EnumerateForward([block](DKRigidBody* rb)
+	{
+		// kinematic body and body added after latest snapshot use motion state.
+		const DKNSTransform* t = NULL;
+		if (block && !rb->IsKinematic())
+			t = block->Find(rb->serial);
+		if (t)
+		{
+			rb->snapshotTransform = *t;
+		}
+		else
+		{
+			btTransform trans;
+			rb->motionState->getWorldTransform(trans);
+			rb->snapshotTransform = BulletTransform(trans);
+		}
+		rb->snapshotTransformValid = true;
+	});
+}
+
+size_t DKDynamicsScene::InterpolatedTransforms(const DKRigidBody* const* bodies, DKNSTransform* transforms, size_t count) const
+{
+	typedef AsyncSimulation::Block Block;
+	typedef AsyncSimulation::Snapshot Snapshot;
+
+	const AsyncSimulation* async = this->asyncSimulation;
+	const double now = SystemTime();
+	while (true)
+	{
+		const int64_t seq1 = async->published.load(std::memory_order_acquire);
+		if (seq1 < 0)
+			return 0;
+		const int64_t seq0 = seq1 > 0 ? seq1 - 1 : seq1;
+
+		const Snapshot& s1 = async->snapshots[seq1 % AsyncSimulation::NumSnapshots];
+		const Snapshot& s0 = async->snapshots[seq0 % AsyncSimulation::NumSnapshots];
+		if (s1.sequence.load(std::memory_order_acquire) != seq1 ||
+			s0.sequence.load(std::memory_order_acquire) != seq0)
+			continue;
+
+		const Block* b1 = s1.block.load(std::memory_order_acquire);
+		const Block* b0 = s0.block.load(std::memory_order_acquire);
+		const double t1 = s1.time;
+		const double t0 = s0.time;
+
+		float alpha = 1.0f;
+		if (t1 > t0)
+			alpha = (float)Clamp((now - t1) / (t1 - t0), 0.0, 1.0);
+
+		size_t found = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			const DKNSTransform* p1 = b1->Find(bodies[i]->serial);
+			if (p1)
+			{
+				const DKNSTransform* p0 = b0->Find(bodies[i]->serial);
+				transforms[i] = p0 ? p0->Interpolate(*p1, alpha) : *p1;
+				found++;
+			}
+		}
+
+		// validate snapshots have not been overwritten while reading.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (s1.sequence.load(std::memory_order_relaxed) == seq1 &&
+			s0.sequence.load(std::memory_order_relaxed) == seq0)
+			return found;
+	}
+}
+
+bool DKDynamicsScene::InterpolatedTransform(const DKRigidBody* body, DKNSTransform& transform) const
+{
+	return InterpolatedTransforms(&body, &transform, 1) > 0;
+}
+
+void DKDynamicsScene::SetParallelDynamics(bool enable)
+{
+	DKCriticalSection<DKSpinLock> guard(context->lock);
+	parallelDynamics = enable;
+}
+
+bool DKDynamicsScene::IsParallelDynamics(void) const
+{
+	return parallelDynamics;
+}
+
 void DKDynamicsScene::UpdateActions(double tickDelta)
 {
 	this->actions.EnumerateForward([=](const DKActionController* p)
@@ -356,11 +1145,12 @@ void DKDynamicsScene::RemoveAllObjects(void)
 		btCollisionObject* obj = world->getCollisionObjectArray()[i];
 		world->removeCollisionObject(obj);
 	}
-	context->lock.Unlock();
+	// cleared with lock, simulation thread enumerates bodies.
 	this->rigidBodies.Clear();
 	this->softBodies.Clear();
 	this->constraints.Clear();
 	this->actions.Clear();
+	context->lock.Unlock();
 	DKScene::RemoveAllObjects();
 }
 
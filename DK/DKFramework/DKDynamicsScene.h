@@ -41,6 +41,36 @@ namespace DKFramework
 		void SetFixedFrameRate(double fps);
 		double FixedFrameRate(void) const;
 
+		// parallel dynamics mode, uses update queue. (see DKScene::SetUpdateQueue)
+		// narrow-phase collision of overlapping pairs and constraint solving
+		// of simulation islands are processed by operation queue.
+		// NeedCollision, NeedResponse are still called on updating thread.
+		// result does not depend on number of threads. (deterministic)
+		void SetParallelDynamics(bool enable);
+		bool IsParallelDynamics(void) const;
+
+		// asynchronous simulation mode.
+		// dynamics world is stepped on separated thread with fixed frame rate.
+		// (FixedFrameRate, 60 fps if not set)
+		// world transforms of rigid bodies are published to snapshot after
+		// each step, use InterpolatedTransforms to get transforms for rendering.
+		// Update() does not step world while simulation thread is running,
+		// it updates kinematics and scene states of objects with latest
+		// snapshot. (objects are updated on calling thread only)
+		// Note:
+		//   derived class should stop simulation before destruction.
+		bool StartAsyncSimulation(void);
+		void StopAsyncSimulation(void);
+		bool IsAsyncSimulationRunning(void) const;
+
+		// world transforms of rigid bodies interpolated between latest two
+		// snapshots by current time. (one step behind simulation)
+		// lock-free, all transforms are taken from same snapshots.
+		// returns number of bodies found. transform of body not found in
+		// snapshot is not modified.
+		size_t InterpolatedTransforms(const DKRigidBody* const* bodies, DKNSTransform* transforms, size_t count) const;
+		bool InterpolatedTransform(const DKRigidBody* body, DKNSTransform& transform) const;
+
 		void RemoveAllObjects(void) override;
 
 	protected:
@@ -64,6 +94,14 @@ namespace DKFramework
 
 	private:
 		double dynamicsFixedFPS; // fixed time stepping unit.
+		bool parallelDynamics;
+		void StepSimulation(double tickDelta, DKFoundation::DKTimeTick tick);
+		void StepWorld(double tickDelta, DKFoundation::DKOperationQueue* queue);
+		void AsyncSimulationProc(void);
+		void PublishSnapshot(double time);
+		void ApplySnapshot(void);
+		struct AsyncSimulation;
+		AsyncSimulation* asyncSimulation;
 		static void PreTickCallback(void*, float);
 		static void PostTickCallback(void*, float);
 		class btActionInterface* actionInterface;
@@ -864,6 +864,7 @@ bool DKFrame::RenderInternal(void)
 						DKASSERT_DEBUG(frame->Texture() != NULL);
 						renderer->RenderTexturedRect(DKRect(0,0,1,1), frame->Transform(), DKRect(0,0,1,1), DKMatrix3::identity, frame->Texture(), NULL, frame->color, frame->blendState);
 					}
+					renderer->Flush();
 					drawSurface = false;
 					return true;
 				}
@@ -884,6 +885,7 @@ bool DKFrame::RenderInternal(void)
 				continue;
 			renderer->RenderTexturedRect(DKRect(0,0,1,1), frame->Transform(), DKRect(0,0,1,1), DKMatrix3::identity, frame->Texture(), NULL, frame->color, frame->blendState);
 		}
+		renderer->Flush();	// draw pending batch before texture is used.
 		return true;
 	}
 	return false;
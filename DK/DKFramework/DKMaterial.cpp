@@ -32,6 +32,28 @@ namespace DKFramework
 				DKFoundation::DKLog("Warning: DepthFunc (%x) invalid or not supported.\n", d);
 				return GL_NEVER;
 			}
+			// number of scalar values of one element.
+			inline size_t GetElementSize(DKShaderConstant::Type t)
+			{
+				switch (t)
+				{
+				case DKShaderConstant::TypeFloat2x2:	return 4;
+				case DKShaderConstant::TypeFloat3x3:	return 9;
+				case DKShaderConstant::TypeFloat4x4:	return 16;
+				case DKShaderConstant::TypeFloat4:
+				case DKShaderConstant::TypeInt4:
+				case DKShaderConstant::TypeBool4:		return 4;
+				case DKShaderConstant::TypeFloat3:
+				case DKShaderConstant::TypeInt3:
+				case DKShaderConstant::TypeBool3:		return 3;
+				case DKShaderConstant::TypeFloat2:
+				case DKShaderConstant::TypeInt2:
+				case DKShaderConstant::TypeBool2:		return 2;
+				default:
+					break;
+				}
+				return 1;
+			}
 		}
 	}
 }
@@ -73,7 +95,10 @@ bool DKMaterial::Bind(int programIndex, PropertyCallback* callback, const DKBlen
 			else
 				rp.blendState.Bind();
 
-			auto BindSampler = [&](const DKShaderConstant& sc)->bool
+			const DKShaderProgram* program = rp.program;
+			DKArray<GLint> boundTexStages; // texture stage id has been bound
+
+			auto BindSampler = [&](const DKShaderConstant& sc, const UniformBinding& binding)->bool
 			{
 				const TextureArray* texArray = NULL;
 				const DKTextureSampler* texSampler = NULL;
@@ -87,18 +112,14 @@ bool DKMaterial::Bind(int programIndex, PropertyCallback* callback, const DKBlen
 						texSampler = sampler->sampler;
 					}
 				}
-				if (texArray == NULL)
+				if (texArray == NULL && binding.samplerProperty)
 				{
-					auto p = this->samplerProperties.Find(sc.name);
-					if (p)
-					{
-						texArray = &p->value.textures;
-						texSampler = p->value.sampler;
-					}
+					texArray = &binding.samplerProperty->textures;
+					texSampler = binding.samplerProperty->sampler;
 				}
 				if (texArray)
 				{
-					DKArray<GLint> boundTexStages; // texture stage id has been bound
+					boundTexStages.Clear();
 					boundTexStages.Reserve(sc.components);
 					for (size_t i = 0; i < texArray->Count(); ++i)
 					{
@@ -125,13 +146,14 @@ bool DKMaterial::Bind(int programIndex, PropertyCallback* callback, const DKBlen
 					size_t numStages = Min<size_t>(boundTexStages.Count(), sc.components);
 					if (numStages > 0)
 					{
-						glUniform1iv(sc.location, numStages, (GLint*)boundTexStages);
+						if (program->UpdateUniformValue(binding.index, (const GLint*)boundTexStages, sizeof(GLint) * numStages))
+							glUniform1iv(sc.location, numStages, (const GLint*)boundTexStages);
 						return true;
 					}
 				}
 				return false;
 			};
-			auto BindIntProperty = [&](const DKShaderConstant& sc)->bool
+			auto BindIntProperty = [&](const DKShaderConstant& sc, const UniformBinding& binding)->bool
 			{
 				const GLint* values = NULL;
 				size_t count = 0;
@@ -141,41 +163,42 @@ bool DKMaterial::Bind(int programIndex, PropertyCallback* callback, const DKBlen
 					values = v;
 					count = v.Count();
 				}
-				if (values == NULL)
+				if (values == NULL && binding.shadingProperty)
 				{
-					auto p = this->shadingProperties.Find(sc.name);
-					if (p)
-					{
-						values = p->value.value.integers;
-						count = p->value.value.integers.Count();
-					}
+					values = binding.shadingProperty->value.integers;
+					count = binding.shadingProperty->value.integers.Count();
 				}
 				if (values && count > 0)
 				{
-					switch (sc.type)
+					const size_t elementSize = Private::GetElementSize(sc.type);
+					const GLsizei numElements = Min<GLsizei>(count / elementSize, sc.components);
+					if (program->UpdateUniformValue(binding.index, values, sizeof(GLint) * elementSize * numElements))
 					{
-					case DKShaderConstant::TypeBool1:
-					case DKShaderConstant::TypeInt1:
-						glUniform1iv(sc.location, Min<GLsizei>(count / 1, sc.components), values);
-						break;
-					case DKShaderConstant::TypeBool2:
-					case DKShaderConstant::TypeInt2:
-						glUniform2iv(sc.location, Min<GLsizei>(count / 2, sc.components), values);
-						break;
-					case DKShaderConstant::TypeBool3:
-					case DKShaderConstant::TypeInt3:
-						glUniform3iv(sc.location, Min<GLsizei>(count / 3, sc.components), values);
-						break;
-					case DKShaderConstant::TypeBool4:
-					case DKShaderConstant::TypeInt4:
-						glUniform4iv(sc.location, Min<GLsizei>(count / 4, sc.components), values);
-						break;
+						switch (sc.type)
+						{
+						case DKShaderConstant::TypeBool1:
+						case DKShaderConstant::TypeInt1:
+							glUniform1iv(sc.location, numElements, values);
+							break;
+						case DKShaderConstant::TypeBool2:
+						case DKShaderConstant::TypeInt2:
+							glUniform2iv(sc.location, numElements, values);
+							break;
+						case DKShaderConstant::TypeBool3:
+						case DKShaderConstant::TypeInt3:
+							glUniform3iv(sc.location, numElements, values);
+							break;
+						case DKShaderConstant::TypeBool4:
+						case DKShaderConstant::TypeInt4:
+							glUniform4iv(sc.location, numElements, values);
+							break;
+						}
 					}
 					return true;
 				}
 				return false;
 			};
-			auto BindFloatProperty = [&](const DKShaderConstant& sc)->bool
+			auto BindFloatProperty = [&](const DKShaderConstant& sc, const UniformBinding& binding)->bool
 			{
 				const GLfloat* values = NULL;
 				size_t count = 0;
@@ -185,65 +208,61 @@ bool DKMaterial::Bind(int programIndex, PropertyCallback* callback, const DKBlen
 					values = v;
 					count = v.Count();
 				}
-				if (values == NULL)
+				if (values == NULL && binding.shadingProperty)
 				{
-					auto p = this->shadingProperties.Find(sc.name);
-					if (p)
-					{
-						values = p->value.value.floatings;
-						count = p->value.value.floatings.Count();
-					}
+					values = binding.shadingProperty->value.floatings;
+					count = binding.shadingProperty->value.floatings.Count();
 				}
 				if (values && count > 0)
 				{
-					switch (sc.type)
+					const size_t elementSize = Private::GetElementSize(sc.type);
+					const GLsizei numElements = Min<GLsizei>(count / elementSize, sc.components);
+					if (program->UpdateUniformValue(binding.index, values, sizeof(GLfloat) * elementSize * numElements))
 					{
-						case DKShaderConstant::TypeFloat1:
-							glUniform1fv(sc.location, Min<GLsizei>(count / 1, sc.components), values);
-							break;
-						case DKShaderConstant::TypeFloat2:
-							glUniform2fv(sc.location, Min<GLsizei>(count / 2, sc.components), values);
-							break;
-						case DKShaderConstant::TypeFloat3:
-							glUniform3fv(sc.location, Min<GLsizei>(count / 3, sc.components), values);
-							break;
-						case DKShaderConstant::TypeFloat4:
-							glUniform4fv(sc.location, Min<GLsizei>(count / 4, sc.components), values);
-							break;
-						case DKShaderConstant::TypeFloat2x2:
-							glUniformMatrix2fv(sc.location, Min<GLsizei>(count / 4, sc.components), GL_FALSE, values);
-							break;
-						case DKShaderConstant::TypeFloat3x3:
-							glUniformMatrix3fv(sc.location, Min<GLsizei>(count / 9, sc.components), GL_FALSE, values);
-							break;
-						case DKShaderConstant::TypeFloat4x4:
-							glUniformMatrix4fv(sc.location, Min<GLsizei>(count / 16, sc.components), GL_FALSE, values);
-							break;
+						switch (sc.type)
+						{
+							case DKShaderConstant::TypeFloat1:
+								glUniform1fv(sc.location, numElements, values);
+								break;
+							case DKShaderConstant::TypeFloat2:
+								glUniform2fv(sc.location, numElements, values);
+								break;
+							case DKShaderConstant::TypeFloat3:
+								glUniform3fv(sc.location, numElements, values);
+								break;
+							case DKShaderConstant::TypeFloat4:
+								glUniform4fv(sc.location, numElements, values);
+								break;
+							case DKShaderConstant::TypeFloat2x2:
+								glUniformMatrix2fv(sc.location, numElements, GL_FALSE, values);
+								break;
+							case DKShaderConstant::TypeFloat3x3:
+								glUniformMatrix3fv(sc.location, numElements, GL_FALSE, values);
+								break;
+							case DKShaderConstant::TypeFloat4x4:
+								glUniformMatrix4fv(sc.location, numElements, GL_FALSE, values);
+								break;
+						}
 					}
 					return true;
 				}
 				return false;
 			};
-
-			// bind Uinform, Sampler into shader program.
-			for (const DKShaderConstant& sc : rp.program->uniforms)
+			auto BindUniform = [&](const UniformBinding& binding)
 			{
-				if (sc.components == 0 || sc.location < 0)
-					continue;
-
+				const DKShaderConstant& sc = program->uniforms.Value(binding.index);
 				bool result = false;
-				DKShaderConstant::BaseType baseType = DKShaderConstant::GetBaseType(sc.type);
-				switch (baseType)
+				switch (binding.baseType)
 				{
 				case DKShaderConstant::BaseTypeSampler:
-					result = BindSampler(sc);
+					result = BindSampler(sc, binding);
 					break;
 				case DKShaderConstant::BaseTypeBoolean:
 				case DKShaderConstant::BaseTypeInteger:
-					result = BindIntProperty(sc);
+					result = BindIntProperty(sc, binding);
 					break;
 				case DKShaderConstant::BaseTypeFloating:
-					result = BindFloatProperty(sc);
+					result = BindFloatProperty(sc, binding);
 					break;
 				default:
 					DKLog("Warning: uniform:(%ls) is unknown type.\n", (const wchar_t*)sc.name);
@@ -254,7 +273,18 @@ bool DKMaterial::Bind(int programIndex, PropertyCallback* callback, const DKBlen
 				{
 					DKLog("Warning: uniform:(%ls) bind failed.\n", (const wchar_t*)sc.name);
 				}
-			}
+			};
+
+			// rebuild binding table if program or properties has been changed.
+			UniformBindingTable& table = rp.uniformBindings;
+			if (table.program != program ||
+				table.shadingGeneration != shadingProperties.Generation() ||
+				table.samplerGeneration != samplerProperties.Generation())
+				BuildUniformBindings(program, table);
+
+			// bind Uinform, Sampler into shader program.
+			for (const UniformBinding& binding : table.bindings)
+				BindUniform(binding);
 			return true;
 		}
 	}
@@ -369,7 +399,7 @@ bool DKMaterial::BuildProgram(int index, BuildLog* log)
 				DKLog("Warning: attribute \"%ls\" not found!\n", (const wchar_t*)s.name);
 			}
 		}
-		for (int i = 0; i < rp.program->uniforms.Count(); i++)
+		for (size_t i = 0; i < rp.program->uniforms.Count(); i++)
 		{
 			DKShaderConstant& s = rp.program->uniforms.Value(i);
 			if (DKShaderConstant::GetBaseType(s.type) == DKShaderConstant::BaseTypeSampler)
@@ -394,11 +424,51 @@ bool DKMaterial::BuildProgram(int index, BuildLog* log)
 					DKLog("Warning: uniform \"%ls\" not found!\n", (const wchar_t*)s.name);
 			}
 		}
+		BuildUniformBindings(rp.program, rp.uniformBindings);
 		return true;
 	}
 	return false;
 }
 
+bool DKMaterial::ResolveUniform(const DKShaderConstant& sc, size_t index, UniformBinding& binding) const
+{
+	if (sc.components == 0 || sc.location < 0)
+		return false;
+
+	binding.index = index;
+	binding.baseType = DKShaderConstant::GetBaseType(sc.type);
+	binding.shadingProperty = NULL;
+	binding.samplerProperty = NULL;
+	if (binding.baseType == DKShaderConstant::BaseTypeSampler)
+	{
+		const SamplerPropertyMap::Pair* p = samplerProperties.Find(sc.name);
+		if (p)
+			binding.samplerProperty = &p->value;
+	}
+	else
+	{
+		const ShadingPropertyMap::Pair* p = shadingProperties.Find(sc.name);
+		if (p)
+			binding.shadingProperty = &p->value;
+	}
+	return true;
+}
+
+void DKMaterial::BuildUniformBindings(const DKShaderProgram* program, UniformBindingTable& table) const
+{
+	table.bindings.Clear();
+	table.bindings.Reserve(program->uniforms.Count());
+	for (size_t i = 0; i < program->uniforms.Count(); i++)
+	{
+		UniformBinding binding;
+		if (ResolveUniform(program->uniforms.Value(i), i, binding))
+			table.bindings.Add(binding);
+	}
+	table.program = const_cast<DKShaderProgram*>(program);
+	table.shadingGeneration = shadingProperties.Generation();
+	table.samplerGeneration = samplerProperties.Generation();
+}
+
 bool DKMaterial::Build(BuildLog* log)
 {
 	for (int i = 0; i < renderingProperties.Count(); i++)
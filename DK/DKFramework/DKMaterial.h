@@ -34,6 +34,11 @@
 // provides any of shader composing feature. You need to write your own shader
 // code. (codes can be serialized)
 //
+// Uniforms of each program are resolved by BuildProgram, Bind does not
+// check type and location of uniforms again. Default properties are looked up
+// by name when binding, only if callback does not provide value.
+// Unchanged uniform values are not uploaded again. (see DKShaderProgram)
+//
 // Note:
 //   Matrix will be transposed (as Column-major order) when transfer to shader.
 ////////////////////////////////////////////////////////////////////////////////
@@ -106,6 +111,60 @@ namespace DKFramework
 			DKShader::Type						type;
 			DKFoundation::DKObject<DKShader>	shader;
 		};
+		// PropertyMap
+		// map of default properties. generation is increased when property
+		// has been added or removed, binding tables built with previous
+		// generation are rebuilt on next binding.
+		template <typename T> class PropertyMap : public DKFoundation::DKMap<DKFoundation::DKString, T>
+		{
+		public:
+			typedef DKFoundation::DKMap<DKFoundation::DKString, T> Map;
+			typedef typename Map::Pair Pair;
+
+			PropertyMap(void) : generation(0) {}
+			PropertyMap(const PropertyMap& m) : Map(m), generation(0) {}
+
+			bool Insert(const Pair& p)									{ generation++; return Map::Insert(p); }
+			bool Insert(const DKFoundation::DKString& k, const T& v)	{ generation++; return Map::Insert(k, v); }
+			void Update(const Pair& p)									{ generation++; Map::Update(p); }
+			void Update(const DKFoundation::DKString& k, const T& v)	{ generation++; Map::Update(k, v); }
+			void Remove(const DKFoundation::DKString& k)				{ generation++; Map::Remove(k); }
+			void Clear(void)											{ generation++; Map::Clear(); }
+			T& Value(const DKFoundation::DKString& k)
+			{
+				if (this->Find(k) == NULL)
+					generation++;
+				return Map::Value(k);
+			}
+			PropertyMap& operator = (const PropertyMap& m)
+			{
+				generation++;
+				Map::operator = (m);
+				return *this;
+			}
+			unsigned int Generation(void) const							{ return generation; }
+
+		private:
+			unsigned int generation;
+		};
+		// UniformBinding
+		// uniform of program resolved with default property.
+		// property is referenced by address, valid until property removed.
+		struct UniformBinding
+		{
+			size_t							index;		// index of program's uniforms
+			DKShaderConstant::BaseType		baseType;
+			const ShadingProperty*			shadingProperty;	// NULL if not exist.
+			const SamplerProperty*			samplerProperty;	// NULL if not exist.
+		};
+		struct UniformBindingTable
+		{
+			UniformBindingTable(void) : program(NULL), shadingGeneration(0), samplerGeneration(0) {}
+			DKFoundation::DKArray<UniformBinding>		bindings;
+			DKFoundation::DKObject<DKShaderProgram>		program;	// program which table built with.
+			unsigned int								shadingGeneration;
+			unsigned int								samplerGeneration;
+		};
 		// RenderingProperty
 		// Used when rendering. This class has shader program which used by
 		// scene drawing. This class can have shader sources also.
@@ -130,6 +189,10 @@ namespace DKFramework
 			DKBlendState								blendState;
 			DKFoundation::DKArray<ShaderSource>			shaders;
 			DKFoundation::DKObject<DKShaderProgram>		program;
+
+			// binding table of program, built by BuildProgram. (not serialized)
+			// table is rebuilt if program or properties has been changed.
+			mutable UniformBindingTable					uniformBindings;
 		};
 
 		class PropertyCallback
@@ -170,8 +233,8 @@ namespace DKFramework
 
 		DKFoundation::DKObject<DKSerializer> Serializer(void);
 
-		typedef DKFoundation::DKMap<DKFoundation::DKString, ShadingProperty>	ShadingPropertyMap;
-		typedef DKFoundation::DKMap<DKFoundation::DKString, SamplerProperty>	SamplerPropertyMap;
+		typedef PropertyMap<ShadingProperty>									ShadingPropertyMap;
+		typedef PropertyMap<SamplerProperty>									SamplerPropertyMap;
 		typedef DKFoundation::DKMap<DKFoundation::DKString, StreamProperty>		StreamPropertyMap;
 		typedef DKFoundation::DKArray<ShaderSource>								ShaderSourceArray;
 		typedef DKFoundation::DKArray<RenderingProperty>						RenderingPropertyArray;
@@ -186,5 +249,9 @@ namespace DKFramework
 
 		bool Validate(void) override;
 		bool IsValid(void) const;
+
+	private:
+		bool ResolveUniform(const DKShaderConstant& sc, size_t index, UniformBinding& binding) const;
+		void BuildUniformBindings(const DKShaderProgram* program, UniformBindingTable& table) const;
 	};
 }
@@ -10,9 +10,11 @@
 #include "DKVector3.h"
 #include "DKVector4.h"
 #include "DKQuaternion.h"
+#include "Private/SimdMath.h"
 
 using namespace DKFoundation;
 using namespace DKFramework;
+using namespace DKFramework::Private;
 
 const DKMatrix4 DKMatrix4::identity = DKMatrix4().Identity();
 
@@ -82,22 +84,7 @@ bool DKMatrix4::IsDiagonal(void) const
 DKMatrix4 DKMatrix4::operator * (const DKMatrix4& m) const
 {
 	DKMatrix4 mat;
-	mat.m[0][0] = (this->m[0][0] * m.m[0][0]) + (this->m[0][1] * m.m[1][0]) + (this->m[0][2] * m.m[2][0]) + (this->m[0][3] * m.m[3][0]);
-	mat.m[0][1] = (this->m[0][0] * m.m[0][1]) + (this->m[0][1] * m.m[1][1]) + (this->m[0][2] * m.m[2][1]) + (this->m[0][3] * m.m[3][1]);
-	mat.m[0][2] = (this->m[0][0] * m.m[0][2]) + (this->m[0][1] * m.m[1][2]) + (this->m[0][2] * m.m[2][2]) + (this->m[0][3] * m.m[3][2]);
-	mat.m[0][3] = (this->m[0][0] * m.m[0][3]) + (this->m[0][1] * m.m[1][3]) + (this->m[0][2] * m.m[2][3]) + (this->m[0][3] * m.m[3][3]);
-	mat.m[1][0] = (this->m[1][0] * m.m[0][0]) + (this->m[1][1] * m.m[1][0]) + (this->m[1][2] * m.m[2][0]) + (this->m[1][3] * m.m[3][0]);
-	mat.m[1][1] = (this->m[1][0] * m.m[0][1]) + (this->m[1][1] * m.m[1][1]) + (this->m[1][2] * m.m[2][1]) + (this->m[1][3] * m.m[3][1]);
-	mat.m[1][2] = (this->m[1][0] * m.m[0][2]) + (this->m[1][1] * m.m[1][2]) + (this->m[1][2] * m.m[2][2]) + (this->m[1][3] * m.m[3][2]);
-	mat.m[1][3] = (this->m[1][0] * m.m[0][3]) + (this->m[1][1] * m.m[1][3]) + (this->m[1][2] * m.m[2][3]) + (this->m[1][3] * m.m[3][3]);
-	mat.m[2][0] = (this->m[2][0] * m.m[0][0]) + (this->m[2][1] * m.m[1][0]) + (this->m[2][2] * m.m[2][0]) + (this->m[2][3] * m.m[3][0]);
-	mat.m[2][1] = (this->m[2][0] * m.m[0][1]) + (this->m[2][1] * m.m[1][1]) + (this->m[2][2] * m.m[2][1]) + (this->m[2][3] * m.m[3][1]);
-	mat.m[2][2] = (this->m[2][0] * m.m[0][2]) + (this->m[2][1] * m.m[1][2]) + (this->m[2][2] * m.m[2][2]) + (this->m[2][3] * m.m[3][2]);
-	mat.m[2][3] = (this->m[2][0] * m.m[0][3]) + (this->m[2][1] * m.m[1][3]) + (this->m[2][2] * m.m[2][3]) + (this->m[2][3] * m.m[3][3]);
-	mat.m[3][0] = (this->m[3][0] * m.m[0][0]) + (this->m[3][1] * m.m[1][0]) + (this->m[3][2] * m.m[2][0]) + (this->m[3][3] * m.m[3][0]);
-	mat.m[3][1] = (this->m[3][0] * m.m[0][1]) + (this->m[3][1] * m.m[1][1]) + (this->m[3][2] * m.m[2][1]) + (this->m[3][3] * m.m[3][1]);
-	mat.m[3][2] = (this->m[3][0] * m.m[0][2]) + (this->m[3][1] * m.m[1][2]) + (this->m[3][2] * m.m[2][2]) + (this->m[3][3] * m.m[3][2]);
-	mat.m[3][3] = (this->m[3][0] * m.m[0][3]) + (this->m[3][1] * m.m[1][3]) + (this->m[3][2] * m.m[2][3]) + (this->m[3][3] * m.m[3][3]);
+	SimdMatrix4Multiply(this->val, m.val, mat.val);
 	return mat;
 }
 
@@ -192,23 +179,7 @@ DKMatrix4 DKMatrix4::operator / (float f) const
 
 DKMatrix4& DKMatrix4::operator *= (const DKMatrix4& m)
 {
-	DKMatrix4 mat(*this);
-	this->m[0][0] = (mat.m[0][0] * m.m[0][0]) + (mat.m[0][1] * m.m[1][0]) + (mat.m[0][2] * m.m[2][0]) + (mat.m[0][3] * m.m[3][0]);
-	this->m[0][1] = (mat.m[0][0] * m.m[0][1]) + (mat.m[0][1] * m.m[1][1]) + (mat.m[0][2] * m.m[2][1]) + (mat.m[0][3] * m.m[3][1]);
-	this->m[0][2] = (mat.m[0][0] * m.m[0][2]) + (mat.m[0][1] * m.m[1][2]) + (mat.m[0][2] * m.m[2][2]) + (mat.m[0][3] * m.m[3][2]);
-	this->m[0][3] = (mat.m[0][0] * m.m[0][3]) + (mat.m[0][1] * m.m[1][3]) + (mat.m[0][2] * m.m[2][3]) + (mat.m[0][3] * m.m[3][3]);
-	this->m[1][0] = (mat.m[1][0] * m.m[0][0]) + (mat.m[1][1] * m.m[1][0]) + (mat.m[1][2] * m.m[2][0]) + (mat.m[1][3] * m.m[3][0]);
-	this->m[1][1] = (mat.m[1][0] * m.m[0][1]) + (mat.m[1][1] * m.m[1][1]) + (mat.m[1][2] * m.m[2][1]) + (mat.m[1][3] * m.m[3][1]);
-	this->m[1][2] = (mat.m[1][0] * m.m[0][2]) + (mat.m[1][1] * m.m[1][2]) + (mat.m[1][2] * m.m[2][2]) + (mat.m[1][3] * m.m[3][2]);
-	this->m[1][3] = (mat.m[1][0] * m.m[0][3]) + (mat.m[1][1] * m.m[1][3]) + (mat.m[1][2] * m.m[2][3]) + (mat.m[1][3] * m.m[3][3]);
-	this->m[2][0] = (mat.m[2][0] * m.m[0][0]) + (mat.m[2][1] * m.m[1][0]) + (mat.m[2][2] * m.m[2][0]) + (mat.m[2][3] * m.m[3][0]);
-	this->m[2][1] = (mat.m[2][0] * m.m[0][1]) + (mat.m[2][1] * m.m[1][1]) + (mat.m[2][2] * m.m[2][1]) + (mat.m[2][3] * m.m[3][1]);
-	this->m[2][2] = (mat.m[2][0] * m.m[0][2]) + (mat.m[2][1] * m.m[1][2]) + (mat.m[2][2] * m.m[2][2]) + (mat.m[2][3] * m.m[3][2]);
-	this->m[2][3] = (mat.m[2][0] * m.m[0][3]) + (mat.m[2][1] * m.m[1][3]) + (mat.m[2][2] * m.m[2][3]) + (mat.m[2][3] * m.m[3][3]);
-	this->m[3][0] = (mat.m[3][0] * m.m[0][0]) + (mat.m[3][1] * m.m[1][0]) + (mat.m[3][2] * m.m[2][0]) + (mat.m[3][3] * m.m[3][0]);
-	this->m[3][1] = (mat.m[3][0] * m.m[0][1]) + (mat.m[3][1] * m.m[1][1]) + (mat.m[3][2] * m.m[2][1]) + (mat.m[3][3] * m.m[3][1]);
-	this->m[3][2] = (mat.m[3][0] * m.m[0][2]) + (mat.m[3][1] * m.m[1][2]) + (mat.m[3][2] * m.m[2][2]) + (mat.m[3][3] * m.m[3][2]);
-	this->m[3][3] = (mat.m[3][0] * m.m[0][3]) + (mat.m[3][1] * m.m[1][3]) + (mat.m[3][2] * m.m[2][3]) + (mat.m[3][3] * m.m[3][3]);
+	SimdMatrix4Multiply(this->val, m.val, this->val);
 	return *this;
 }
 
@@ -415,26 +386,23 @@ DKMatrix4& DKMatrix4::Transpose(void)
 
 DKMatrix4& DKMatrix4::Multiply(const DKMatrix4& m)
 {
-	DKMatrix4 mat(*this);
-	this->m[0][0] = (mat.m[0][0] * m.m[0][0]) + (mat.m[0][1] * m.m[1][0]) + (mat.m[0][2] * m.m[2][0]) + (mat.m[0][3] * m.m[3][0]);
-	this->m[0][1] = (mat.m[0][0] * m.m[0][1]) + (mat.m[0][1] * m.m[1][1]) + (mat.m[0][2] * m.m[2][1]) + (mat.m[0][3] * m.m[3][1]);
-	this->m[0][2] = (mat.m[0][0] * m.m[0][2]) + (mat.m[0][1] * m.m[1][2]) + (mat.m[0][2] * m.m[2][2]) + (mat.m[0][3] * m.m[3][2]);
-	this->m[0][3] = (mat.m[0][0] * m.m[0][3]) + (mat.m[0][1] * m.m[1][3]) + (mat.m[0][2] * m.m[2][3]) + (mat.m[0][3] * m.m[3][3]);
-	this->m[1][0] = (mat.m[1][0] * m.m[0][0]) + (mat.m[1][1] * m.m[1][0]) + (mat.m[1][2] * m.m[2][0]) + (mat.m[1][3] * m.m[3][0]);
-	this->m[1][1] = (mat.m[1][0] * m.m[0][1]) + (mat.m[1][1] * m.m[1][1]) + (mat.m[1][2] * m.m[2][1]) + (mat.m[1][3] * m.m[3][1]);
-	this->m[1][2] = (mat.m[1][0] * m.m[0][2]) + (mat.m[1][1] * m.m[1][2]) + (mat.m[1][2] * m.m[2][2]) + (mat.m[1][3] * m.m[3][2]);
-	this->m[1][3] = (mat.m[1][0] * m.m[0][3]) + (mat.m[1][1] * m.m[1][3]) + (mat.m[1][2] * m.m[2][3]) + (mat.m[1][3] * m.m[3][3]);
-	this->m[2][0] = (mat.m[2][0] * m.m[0][0]) + (mat.m[2][1] * m.m[1][0]) + (mat.m[2][2] * m.m[2][0]) + (mat.m[2][3] * m.m[3][0]);
-	this->m[2][1] = (mat.m[2][0] * m.m[0][1]) + (mat.m[2][1] * m.m[1][1]) + (mat.m[2][2] * m.m[2][1]) + (mat.m[2][3] * m.m[3][1]);
-	this->m[2][2] = (mat.m[2][0] * m.m[0][2]) + (mat.m[2][1] * m.m[1][2]) + (mat.m[2][2] * m.m[2][2]) + (mat.m[2][3] * m.m[3][2]);
-	this->m[2][3] = (mat.m[2][0] * m.m[0][3]) + (mat.m[2][1] * m.m[1][3]) + (mat.m[2][2] * m.m[2][3]) + (mat.m[2][3] * m.m[3][3]);
-	this->m[3][0] = (mat.m[3][0] * m.m[0][0]) + (mat.m[3][1] * m.m[1][0]) + (mat.m[3][2] * m.m[2][0]) + (mat.m[3][3] * m.m[3][0]);
-	this->m[3][1] = (mat.m[3][0] * m.m[0][1]) + (mat.m[3][1] * m.m[1][1]) + (mat.m[3][2] * m.m[2][1]) + (mat.m[3][3] * m.m[3][1]);
-	this->m[3][2] = (mat.m[3][0] * m.m[0][2]) + (mat.m[3][1] * m.m[1][2]) + (mat.m[3][2] * m.m[2][2]) + (mat.m[3][3] * m.m[3][2]);
-	this->m[3][3] = (mat.m[3][0] * m.m[0][3]) + (mat.m[3][1] * m.m[1][3]) + (mat.m[3][2] * m.m[2][3]) + (mat.m[3][3] * m.m[3][3]);
+	SimdMatrix4Multiply(this->val, m.val, this->val);
 	return *this;
 }
 
+void DKMatrix4::Multiply(const DKMatrix4* lhs, const DKMatrix4& rhs, DKMatrix4* output, size_t count)
+{
+	const DKMatrix4 m = rhs;	// rhs can be one of output.
+	for (size_t i = 0; i < count; ++i)
+		SimdMatrix4Multiply(lhs[i].val, m.val, output[i].val);
+}
+
+void DKMatrix4::Multiply(const DKMatrix4* lhs, const DKMatrix4* rhs, DKMatrix4* output, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		SimdMatrix4Multiply(lhs[i].val, rhs[i].val, output[i].val);
+}
+
 DKVector4 DKMatrix4::Row1(void) const
 {
 	return DKVector4(m[0][0], m[0][1], m[0][2], m[0][3]);
@@ -39,6 +39,12 @@ namespace DKFramework
 		DKMatrix4& Transpose(void);
 		DKMatrix4& Multiply(const DKMatrix4& m);
 
+		// batch multiplication. (output can be same as lhs or rhs)
+		// output[i] = lhs[i] * rhs
+		static void Multiply(const DKMatrix4* lhs, const DKMatrix4& rhs, DKMatrix4* output, size_t count);
+		// output[i] = lhs[i] * rhs[i]
+		static void Multiply(const DKMatrix4* lhs, const DKMatrix4* rhs, DKMatrix4* output, size_t count);
+
 		float Determinant(void) const;
 		bool GetInverseMatrix(DKMatrix4& matOut, float *pDeterminant) const;
 
@@ -12,7 +12,8 @@ using namespace DKFoundation;
 using namespace DKFramework;
 
 DKModel::DKModel(Type t)
-: type(t), parent(NULL), scene(NULL), hideDescendants(false), needResolveTree(true)
+: type(t), parent(NULL), scene(NULL), hideDescendants(false), serialUpdate(false), needResolveTree(true)
+, animationNodeIndex(DKAnimatedTransform::unresolvedNodeIndex)
 {
 }
 
@@ -258,6 +259,7 @@ void DKModel::SetAnimation(DKAnimatedTransform* anim, bool recursive)
 	if (this->animation != anim)
 	{
 		this->animation = anim;
+		this->animationNodeIndex = anim ? anim->ResolveNodeIndex(this->Name()) : DKAnimatedTransform::unresolvedNodeIndex;
 		this->OnSetAnimation(anim);
 	}
 
@@ -268,6 +270,13 @@ void DKModel::SetAnimation(DKAnimatedTransform* anim, bool recursive)
 	}
 }
 
+void DKModel::SetName(const DKString& name)
+{
+	DKResource::SetName(name);
+	if (this->animation)
+		this->animationNodeIndex = this->animation->ResolveNodeIndex(this->Name());
+}
+
 void DKModel::SetWorldTransform(const DKNSTransform& t)
 {
 	worldTransform = t;
@@ -353,7 +362,12 @@ void DKModel::OnUpdateKinematic(double timeDelta, DKTimeTick tick)
 	{
 		this->animation->Update(timeDelta, tick);
 		DKTransformUnit tu;
-		if (this->animation->GetTransform(this->Name(), tu))
+		bool animated;
+		if (this->animationNodeIndex == DKAnimatedTransform::unresolvedNodeIndex)
+			animated = this->animation->GetTransform(this->Name(), tu);
+		else
+			animated = this->animation->GetTransformAtIndex(this->animationNodeIndex, tu);
+		if (animated)
 		{
 			DKNSTransform trans = DKNSTransform(tu.rotation, tu.translation);
 			this->SetLocalTransform(trans);
@@ -461,6 +475,7 @@ DKModel* DKModel::Copy(UUIDObjectMap& uuids, const DKModel* obj)
 		this->SetName(obj->Name());
 		this->localTransform = obj->localTransform;
 		this->worldTransform = obj->worldTransform;
+		this->serialUpdate = obj->serialUpdate;
 
 		for (const DKModel* m : obj->children)
 		{
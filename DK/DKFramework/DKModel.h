@@ -83,6 +83,12 @@ namespace DKFramework
 		bool AreDescendantsHidden(void) const			{ return hideDescendants; }
 		bool DidAncestorHideDescendants(void) const;
 
+		// serial update: tree that contains this object will be updated on
+		// scene's calling thread, not in parallel with other trees.
+		// set this flag if object refers other trees while updating.
+		void SetSerialUpdate(bool serial)				{ serialUpdate = serial; }
+		bool IsSerialUpdate(void) const					{ return serialUpdate; }
+
 		void Enumerate(Enumerator* e)					{ EnumerateInternal(e); }
 		void Enumerate(EnumeratorLoop* e)				{ EnumerateInternal(e); }
 		void Enumerate(ConstEnumerator* e) const		{ EnumerateInternal(e); }
@@ -92,6 +98,8 @@ namespace DKFramework
 		const DKAnimatedTransform* Animation(void) const	{ return animation; }
 		void SetAnimation(DKAnimatedTransform*, bool recursive = true);
 
+		void SetName(const DKFoundation::DKString&) override;
+
 		virtual void SetWorldTransform(const DKNSTransform&);
 		virtual void SetLocalTransform(const DKNSTransform&);
 		const DKNSTransform& WorldTransform(void) const		{ return worldTransform; }
@@ -169,10 +177,14 @@ namespace DKFramework
 		DKFoundation::DKObject<DKAnimatedTransform> animation;
 
 		bool hideDescendants;
+		bool serialUpdate;
 
 		// set true to call OnUpdateTreeReferences() when next update.
 		bool needResolveTree;
 
+		// node index of animation, resolved when animation or name has changed.
+		DKAnimatedTransform::NodeIndex animationNodeIndex;
+
 		bool EnumerateInternal(Enumerator* e);
 		void EnumerateInternal(EnumeratorLoop* e);
 		bool EnumerateInternal(ConstEnumerator* e) const;
@@ -0,0 +1,255 @@
+//
+//  File: DKRenderQueue.cpp
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2015 Hongtae Kim. All rights reserved.
+//
+
+#include "DKMath.h"
+#include "DKRenderQueue.h"
+#include "DKStaticMesh.h"
+
+using namespace DKFoundation;
+
+namespace DKFramework
+{
+	namespace Private
+	{
+		namespace
+		{
+			// bits of sort key
+			const int PassBits = 7;
+			const int IndexBits = 10;
+			const int DepthBits = 16;
+			const int MaxPass = (1 << PassBits) - 1;
+			const uint64_t MaxIndex = (1 << IndexBits) - 1;
+			const uint64_t MaxIndexTranslucent = (1 << 12) - 1;
+
+			// float to unsigned integer which has same order.
+			inline uint32_t SortableDepth(float f)
+			{
+				uint32_t u;
+				memcpy(&u, &f, sizeof(u));
+				if (u & 0x80000000U)
+					return ~u;
+				return u | 0x80000000U;
+			}
+
+			template <typename Map, typename Key> uint32_t IndexOfKey(Map& map, const Key& k)
+			{
+				auto p = map.Find(k);
+				if (p)
+					return p->value;
+				uint32_t index = (uint32_t)map.Count();
+				map.Insert(k, index);
+				return index;
+			}
+
+			inline uint64_t HashPointer(uint64_t hash, const void* p)
+			{
+				// FNV-1a
+				uint64_t v = (uint64_t)p;
+				for (int i = 0; i < 8; ++i)
+				{
+					hash ^= (v >> (i * 8)) & 0xff;
+					hash *= 0x100000001b3ULL;
+				}
+				return hash;
+			}
+
+			uint64_t TextureSetHash(const DKMesh* mesh)
+			{
+				const DKMesh::TextureSamplerMap& samplers = mesh->SamplerMap();
+				if (samplers.Count() == 0)
+					return 0;
+
+				uint64_t hash = 0xcbf29ce484222325ULL;
+				samplers.EnumerateForward([&hash](const DKMesh::TextureSamplerMap::Pair& pair)
+				{
+					for (const DKTexture* tex : pair.value.textures)
+						hash = HashPointer(hash, tex);
+					hash = HashPointer(hash, (const DKTextureSampler*)pair.value.sampler);
+				});
+				return hash;
+			}
+
+			struct SortKey
+			{
+				uint64_t key;
+				uint32_t index;
+			};
+
+			// LSD radix sort with 8-bit digits, digits which are same for all
+			// keys are skipped. result is stored in keys. (stable)
+			void RadixSort(SortKey* keys, SortKey* temp, size_t count)
+			{
+				size_t histogram[8][256] = {};
+				for (size_t i = 0; i < count; ++i)
+				{
+					uint64_t k = keys[i].key;
+					for (int d = 0; d < 8; ++d)
+						histogram[d][(k >> (d * 8)) & 0xff]++;
+				}
+
+				SortKey* src = keys;
+				SortKey* dst = temp;
+				for (int d = 0; d < 8; ++d)
+				{
+					size_t* h = histogram[d];
+					if (h[(src[0].key >> (d * 8)) & 0xff] == count)
+						continue;
+
+					size_t offset = 0;
+					for (int i = 0; i < 256; ++i)
+					{
+						size_t c = h[i];
+						h[i] = offset;
+						offset += c;
+					}
+					for (size_t i = 0; i < count; ++i)
+						dst[h[(src[i].key >> (d * 8)) & 0xff]++] = src[i];
+
+					SortKey* t = src;
+					src = dst;
+					dst = t;
+				}
+				if (src != keys)
+					memcpy(keys, src, sizeof(SortKey) * count);
+			}
+		}
+	}
+}
+
+using namespace DKFramework;
+using namespace DKFramework::Private;
+
+
+DKRenderQueue::DKRenderQueue(void)
+{
+}
+
+DKRenderQueue::~DKRenderQueue(void)
+{
+}
+
+bool DKRenderQueue::Add(const DKMesh* mesh, int pass, float depth)
+{
+	if (mesh == NULL || pass < 0)
+		return false;
+
+	const DKMaterial* material = mesh->Material();
+	if (material == NULL || (size_t)pass >= material->renderingProperties.Count())
+		return false;
+
+	const DKMaterial::RenderingProperty& rp = material->renderingProperties.Value(pass);
+	const DKBlendState& blend = rp.blendState;
+
+	Item item;
+	item.mesh = mesh;
+	item.program = rp.program;
+	item.material = material;
+	item.buffer = NULL;
+	item.textureSet = TextureSetHash(mesh);
+	item.depth = depth;
+	item.pass = pass;
+	item.opaque = blend.dstBlendRGB == DKBlendState::BlendModeZero && blend.dstBlendAlpha == DKBlendState::BlendModeZero;
+
+	const DKStaticMesh* staticMesh = dynamic_cast<const DKStaticMesh*>(mesh);
+	if (staticMesh && staticMesh->NumberOfVertexBuffers() > 0)
+		item.buffer = staticMesh->VertexBufferAtIndex(0);
+
+	const uint64_t programIndex = IndexOfKey(programs, (const void*)item.program);
+	const uint64_t materialIndex = IndexOfKey(materials, (const void*)item.material);
+
+	uint64_t key = (uint64_t)Min(pass, MaxPass) << (64 - PassBits);
+	if (item.opaque)
+	{
+		const uint64_t textureIndex = IndexOfKey(textureSets, item.textureSet);
+		const uint64_t bufferIndex = IndexOfKey(buffers, item.buffer);
+
+		key |= Min(programIndex, MaxIndex) << (DepthBits + IndexBits * 3);
+		key |= Min(materialIndex, MaxIndex) << (DepthBits + IndexBits * 2);
+		key |= Min(textureIndex, MaxIndex) << (DepthBits + IndexBits);
+		key |= Min(bufferIndex, MaxIndex) << DepthBits;
+		key |= SortableDepth(depth) >> (32 - DepthBits);		// near to far
+	}
+	else
+	{
+		key |= (uint64_t)1 << (63 - PassBits);
+		key |= (uint64_t)(~SortableDepth(depth)) << 24;			// far to near
+		key |= Min(programIndex, MaxIndexTranslucent) << 12;
+		key |= Min(materialIndex, MaxIndexTranslucent);
+	}
+	item.key = key;
+
+	items.Add(item);
+	return true;
+}
+
+void DKRenderQueue::Sort(void)
+{
+	const size_t count = items.Count();
+	if (count < 2)
+		return;
+
+	DKArray<SortKey> keys;
+	keys.Reserve(count * 2);
+	for (size_t i = 0; i < count; ++i)
+	{
+		SortKey k = { items.Value(i).key, (uint32_t)i };
+		keys.Add(k);
+	}
+	keys.Resize(count * 2);
+	RadixSort(keys, &keys.Value(count), count);
+
+	DKArray<Item> sorted;
+	sorted.Reserve(count);
+	for (size_t i = 0; i < count; ++i)
+		sorted.Add(items.Value(keys.Value(i).index));
+
+	items = static_cast<DKArray<Item>&&>(sorted);
+}
+
+DKRenderQueue::Statistics DKRenderQueue::Submit(Backend& backend) const
+{
+	Statistics stats = { 0, 0, 0, 0, 0, 0 };
+	const Item* prev = NULL;
+	for (const Item& item : items)
+	{
+		unsigned int changes = StateChangePass | StateChangeProgram | StateChangeMaterial | StateChangeTextures | StateChangeBuffers;
+		if (prev)
+		{
+			changes = 0;
+			if (item.pass != prev->pass)
+				changes |= StateChangePass;
+			if (item.program != prev->program)
+				changes |= StateChangeProgram;
+			if (item.material != prev->material)
+				changes |= StateChangeMaterial;
+			if (item.textureSet != prev->textureSet)
+				changes |= StateChangeTextures;
+			if (item.buffer != prev->buffer)
+				changes |= StateChangeBuffers;
+		}
+
+		stats.draws++;
+		if (changes & StateChangePass)		stats.passChanges++;
+		if (changes & StateChangeProgram)	stats.programChanges++;
+		if (changes & StateChangeMaterial)	stats.materialChanges++;
+		if (changes & StateChangeTextures)	stats.textureChanges++;
+		if (changes & StateChangeBuffers)	stats.bufferChanges++;
+
+		backend.Draw(item, changes);
+		prev = &item;
+	}
+	return stats;
+}
+
+void DKRenderQueue::Clear(void)
+{
+	items.Clear();
+	programs.Clear();
+	materials.Clear();
+	buffers.Clear();
+	textureSets.Clear();
+}
@@ -0,0 +1,104 @@
+//
+//  File: DKRenderQueue.h
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2015 Hongtae Kim. All rights reserved.
+//
+
+#pragma once
+#include "../DKInclude.h"
+#include "../DKFoundation.h"
+#include "DKMesh.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// DKRenderQueue
+// sorts meshes with 64-bit sort keys to minimize rendering state changes.
+//
+// key is composed of (from most significant bits)
+//   pass (scene index), translucent flag,
+//   opaque mesh: program, material, texture set, vertex buffer, depth
+//   translucent mesh: depth (far to near), program, material
+//
+// opaque meshes are grouped by state and drawn near to far in same state.
+// translucent meshes are drawn after opaque meshes, far to near.
+// keys are sorted with radix sort.
+//
+// sorted items can be submitted to Backend, backend receives state groups
+// which have been changed from previous item. backend can be implemented
+// without rendering device to count draws and state changes. (headless)
+//
+// Note:
+//   program, material, texture set and vertex buffer are numbered in order
+//   of appearance until Clear() called.
+////////////////////////////////////////////////////////////////////////////////
+
+namespace DKFramework
+{
+	class DKGL_API DKRenderQueue
+	{
+	public:
+		enum StateChange : unsigned int
+		{
+			StateChangePass			= 1,
+			StateChangeProgram		= 1 << 1,
+			StateChangeMaterial		= 1 << 2,
+			StateChangeTextures		= 1 << 3,
+			StateChangeBuffers		= 1 << 4,
+		};
+
+		struct Item
+		{
+			uint64_t					key;
+			const DKMesh*				mesh;
+			const DKShaderProgram*		program;
+			const DKMaterial*			material;
+			const void*					buffer;		// first vertex buffer of mesh
+			uint64_t					textureSet;	// hash of mesh's textures
+			float						depth;		// z value of view-projection applied
+			int							pass;
+			bool						opaque;
+		};
+
+		struct Statistics
+		{
+			size_t draws;
+			size_t passChanges;
+			size_t programChanges;
+			size_t materialChanges;
+			size_t textureChanges;
+			size_t bufferChanges;
+		};
+
+		struct Backend
+		{
+			virtual ~Backend(void) {}
+			// changes: StateChange bits, all bits are set for first item.
+			virtual void Draw(const Item& item, unsigned int changes) = 0;
+		};
+
+		DKRenderQueue(void);
+		~DKRenderQueue(void);
+
+		// add mesh with pass (index of material's rendering property)
+		// returns false if mesh cannot be drawn with pass.
+		bool Add(const DKMesh* mesh, int pass, float depth);
+		// sort items, items should be sorted before submit.
+		void Sort(void);
+		// submit items to backend in order, returns counts of state changes.
+		Statistics Submit(Backend& backend) const;
+		void Clear(void);
+
+		size_t Count(void) const						{ return items.Count(); }
+		const Item& ItemAtIndex(size_t index) const		{ return items.Value(index); }
+
+	private:
+		typedef DKFoundation::DKHashMap<const void*, uint32_t> PointerIndexMap;
+		typedef DKFoundation::DKHashMap<uint64_t, uint32_t> HashIndexMap;
+
+		DKFoundation::DKArray<Item> items;
+		PointerIndexMap programs;
+		PointerIndexMap materials;
+		PointerIndexMap buffers;
+		HashIndexMap textureSets;
+	};
+}
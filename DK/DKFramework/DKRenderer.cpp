@@ -242,7 +242,7 @@ namespace DKFramework
 				DKMaterial::RenderingProperty rp =
 				{
 					name, DKMaterial::RenderingProperty::DepthFuncAlways, false,
-					DKBlendState::defaultAlpha, DKArray<DKMaterial::ShaderSource>(), NULL
+					DKBlendState::defaultAlpha, DKArray<DKMaterial::ShaderSource>(), NULL, DKMaterial::UniformBindingTable()
 				};
 				for (const DKMaterial::ShaderSource* s : shaders)
 				{
@@ -316,7 +316,7 @@ namespace DKFramework
 				DKMaterial::RenderingProperty rp =
 				{
 					name, DKMaterial::RenderingProperty::DepthFuncLessEqual, true,
-					DKBlendState::defaultAlpha, DKArray<DKMaterial::ShaderSource>(), NULL
+					DKBlendState::defaultAlpha, DKArray<DKMaterial::ShaderSource>(), NULL, DKMaterial::UniformBindingTable()
 				};
 				for (const DKMaterial::ShaderSource* s : shaders)
 				{
@@ -385,6 +385,107 @@ namespace DKFramework
 		static DKSpinLock						reusableBufferSpinLock;
 		static DKArray<DKRenderer::Vertex2D>	reusableVert2DBuffer;   // vertex buffer for 2d
 		static DKArray<DKRenderer::Vertex3D>	reusableVert3DBuffer;   // vertex buffer for 3d
+
+		// primitive type of batch, strips, fans and loops are merged as list.
+		static DKPrimitive::Type BatchPrimitiveType(DKPrimitive::Type p)
+		{
+			switch (p)
+			{
+			case DKPrimitive::TypePoints:
+				return DKPrimitive::TypePoints;
+			case DKPrimitive::TypeLines:
+			case DKPrimitive::TypeLineStrip:
+			case DKPrimitive::TypeLineLoop:
+				return DKPrimitive::TypeLines;
+			case DKPrimitive::TypeTriangles:
+			case DKPrimitive::TypeTriangleStrip:
+			case DKPrimitive::TypeTriangleFan:
+				return DKPrimitive::TypeTriangles;
+			default:
+				break;
+			}
+			return DKPrimitive::TypeUnknown;
+		}
+		// number of vertices to be converted to list.
+		static size_t BatchVertexCount(DKPrimitive::Type p, size_t count)
+		{
+			switch (p)
+			{
+			case DKPrimitive::TypePoints:			return count;
+			case DKPrimitive::TypeLines:			return count - (count % 2);
+			case DKPrimitive::TypeLineStrip:		return count > 1 ? (count - 1) * 2 : 0;
+			case DKPrimitive::TypeLineLoop:			return count > 1 ? count * 2 : 0;
+			case DKPrimitive::TypeTriangles:		return count - (count % 3);
+			case DKPrimitive::TypeTriangleStrip:
+			case DKPrimitive::TypeTriangleFan:		return count > 2 ? (count - 2) * 3 : 0;
+			default:
+				break;
+			}
+			return 0;
+		}
+		// append vertices to buffer as list (points, lines, triangles)
+		template <typename Vertex, typename Convert>
+		static void AppendBatchVertices(DKArray<Vertex>& buffer, DKPrimitive::Type p, const Vertex* v, size_t count, Convert&& conv)
+		{
+			buffer.Reserve(buffer.Count() + BatchVertexCount(p, count));
+			switch (p)
+			{
+			case DKPrimitive::TypePoints:
+			case DKPrimitive::TypeLines:
+			case DKPrimitive::TypeTriangles:
+				for (size_t i = 0, n = BatchVertexCount(p, count); i < n; ++i)
+					buffer.Add(conv(v[i]));
+				break;
+			case DKPrimitive::TypeLineStrip:
+			case DKPrimitive::TypeLineLoop:
+				for (size_t i = 1; i < count; ++i)
+				{
+					buffer.Add(conv(v[i - 1]));
+					buffer.Add(conv(v[i]));
+				}
+				if (p == DKPrimitive::TypeLineLoop && count > 1)
+				{
+					buffer.Add(conv(v[count - 1]));
+					buffer.Add(conv(v[0]));
+				}
+				break;
+			case DKPrimitive::TypeTriangleStrip:
+				for (size_t i = 2; i < count; ++i)
+				{
+					if (i % 2)	// keep winding order
+					{
+						buffer.Add(conv(v[i - 1]));
+						buffer.Add(conv(v[i - 2]));
+					}
+					else
+					{
+						buffer.Add(conv(v[i - 2]));
+						buffer.Add(conv(v[i - 1]));
+					}
+					buffer.Add(conv(v[i]));
+				}
+				break;
+			case DKPrimitive::TypeTriangleFan:
+				for (size_t i = 2; i < count; ++i)
+				{
+					buffer.Add(conv(v[0]));
+					buffer.Add(conv(v[i - 1]));
+					buffer.Add(conv(v[i]));
+				}
+				break;
+			default:
+				break;
+			}
+		}
+		static bool IsEqualBlendState(const DKBlendState& b1, const DKBlendState& b2)
+		{
+			return b1.colorWriteR == b2.colorWriteR && b1.colorWriteG == b2.colorWriteG &&
+				b1.colorWriteB == b2.colorWriteB && b1.colorWriteA == b2.colorWriteA &&
+				b1.srcBlendRGB == b2.srcBlendRGB && b1.srcBlendAlpha == b2.srcBlendAlpha &&
+				b1.dstBlendRGB == b2.dstBlendRGB && b1.dstBlendAlpha == b2.dstBlendAlpha &&
+				b1.blendFuncRGB == b2.blendFuncRGB && b1.blendFuncAlpha == b2.blendFuncAlpha &&
+				b1.constantColor.value == b2.constantColor.value;
+		}
 	}
 }
 
@@ -437,13 +538,87 @@ public:
 	DKSpinLock								lock;			// lock for DKRenderer
 };
 
+struct DKRenderer::PrimitiveBatch
+{
+	enum Kind
+	{
+		KindNone = 0,
+		Kind2D,
+		Kind3D,
+	};
+	static const size_t maxVertices = 0x10000;	// batch will be drawn when exceeded.
+
+	PrimitiveBatch(void)
+		: enabled(false)
+		, backend(NULL)
+		, kind(KindNone)
+		, primitive(DKPrimitive::TypeUnknown)
+		, sceneIndex(0)
+		, color(1, 1, 1, 1)
+		, transform(DKMatrix4::identity)
+		, numCalls(0)
+	{
+		memset(&stats, 0, sizeof(stats));
+	}
+	size_t Count(void) const
+	{
+		if (kind == Kind2D)
+			return vertices2D.Count();
+		if (kind == Kind3D)
+			return vertices3D.Count();
+		return 0;
+	}
+	bool CanMerge(Kind k, DKPrimitive::Type p, int index, const DKTexture* tex, const DKTextureSampler* smp, const DKBlendState& bs) const
+	{
+		return kind == k && primitive == p && sceneIndex == index &&
+			(const DKTexture*)texture == tex && (const DKTextureSampler*)sampler == smp &&
+			IsEqualBlendState(blend, bs);
+	}
+	void Begin(Kind k, DKPrimitive::Type p, int index, const DKTexture* tex, const DKTextureSampler* smp, const DKBlendState& bs)
+	{
+		kind = k;
+		primitive = p;
+		sceneIndex = index;
+		texture = const_cast<DKTexture*>(tex);
+		sampler = const_cast<DKTextureSampler*>(smp);
+		blend = bs;
+	}
+	void Reset(void)
+	{
+		kind = KindNone;
+		numCalls = 0;
+		texture = NULL;
+		sampler = NULL;
+		vertices2D.Clear();		// capacity is retained.
+		vertices3D.Clear();
+	}
+
+	bool							enabled;
+	BatchBackend*					backend;
+	BatchStatistics					stats;
+
+	// pending batch
+	Kind							kind;
+	DKPrimitive::Type				primitive;
+	int								sceneIndex;
+	DKObject<DKTexture>				texture;
+	DKObject<DKTextureSampler>		sampler;
+	DKBlendState					blend;
+	DKColor							color;			// 2D only
+	DKMatrix4						transform;		// 3D only
+	size_t							numCalls;
+	DKArray<DKRenderer::Vertex2D>	vertices2D;
+	DKArray<DKRenderer::Vertex3D>	vertices3D;
+};
+
 const float DKRenderer::minimumScaleFactor = 0.000001f;
 
 DKRenderer::DKRenderer(DKRenderTarget* rt)
-	: renderTarget(rt)
+	: batch(DKObject<PrimitiveBatch>::New())
+	, renderTarget(rt)
 	, context(RendererContext::SharedInstance().SafeCast<DKUnknown>())
-	, viewport(0, 0, 1, 1)
 	, contentBounds(0, 0, 1, 1)
+	, viewport(0, 0, 1, 1)
 	, contentTM(DKMatrix3::identity)
 	, screenTM(DKMatrix3::identity)
 	, polygonOffset({ 0.0, 0.0 })
@@ -469,6 +644,12 @@ DKRenderer::RendererContext* DKRenderer::GetContext(void) const
 	return const_cast<RendererContext*>(context.StaticCast<RendererContext>());
 }
 
+DKRenderer::PrimitiveBatch* DKRenderer::GetBatch(void) const
+{
+	DKASSERT_DEBUG(batch);
+	return const_cast<PrimitiveBatch*>((const PrimitiveBatch*)batch);
+}
+
 const DKRect& DKRenderer::Viewport(void) const
 {
 	return viewport;
@@ -476,6 +657,7 @@ const DKRect& DKRenderer::Viewport(void) const
 
 void DKRenderer::SetViewport(const DKRect& rc)
 {
+	SubmitBatch();
 	viewport = rc;
 	this->UpdateTransform();
 }
@@ -509,6 +691,7 @@ const DKMatrix3& DKRenderer::ContentTransform(void) const
 
 void DKRenderer::SetPolygonOffset(float factor, float units)
 {
+	SubmitBatch();
 	this->polygonOffset.factor = factor;
 	this->polygonOffset.units = units;
 }
@@ -589,6 +772,7 @@ DKRenderState* DKRenderer::Bind(void) const
 
 void DKRenderer::Clear(const DKColor& color) const
 {
+	SubmitBatch();
 	DKRenderState* state = this->Bind();
 	if (state)
 	{
@@ -601,6 +785,7 @@ void DKRenderer::Clear(const DKColor& color) const
 
 void DKRenderer::ClearColorBuffer(const DKColor& color) const
 {
+	SubmitBatch();
 	DKRenderState* state = this->Bind();
 	if (state)
 	{
@@ -612,6 +797,7 @@ void DKRenderer::ClearColorBuffer(const DKColor& color) const
 
 void DKRenderer::ClearDepthBuffer(void) const
 {
+	SubmitBatch();
 	DKRenderState* state = this->Bind();
 	if (state)
 	{
@@ -625,6 +811,11 @@ void DKRenderer::RenderPrimitive(DKPrimitive::Type p, const Vertex2D* vertices,
 	if (vertices == NULL || count == 0)
 		return;
 
+	const bool textured = texture && texture->IsValid();
+	if (BatchPrimitive(p, vertices, count, textured ? texture : NULL, textured ? sampler : NULL, color, blend, textured ? Private::RP2Textured : Private::RP2Colored, false))
+		return;
+	SubmitBatch();
+
 	if (IsDrawable() && this->Bind())
 	{
 		RendererContext* ctxt = GetContext();
@@ -660,6 +851,11 @@ void DKRenderer::RenderPrimitive(DKPrimitive::Type p, const Vertex3D* vertices,
 	if (vertices == NULL || count == 0)
 		return;
 
+	const bool textured = texture && texture->IsValid();
+	if (BatchPrimitive(p, vertices, count, tm, textured ? texture : NULL, textured ? sampler : NULL, blend))
+		return;
+	SubmitBatch();
+
 	if (IsDrawable() && this->Bind())
 	{
 		RendererContext* ctxt = GetContext();
@@ -1038,6 +1234,7 @@ void DKRenderer::RenderSolidEllipse(const DKRect& bounds, const DKColor& color,
 			const DKVector2 radius((prb - plb).Length() / 2, (plt - plb).Length() / 2);
 			const float radiusSq[2] = { radius.x * radius.x, radius.y * radius.y };
 
+			SubmitBatch();
 			if (this->Bind())
 			{
 				RendererContext* ctxt = GetContext();
@@ -1393,6 +1590,7 @@ void DKRenderer::RenderTexturedEllipse(const DKRect& bounds, const DKRect& texBo
 			const DKVector2 radius((prb - plb).Length() / 2, (plt - plb).Length() / 2);
 			const float radiusSq[2] = { radius.x * radius.x, radius.y * radius.y };
 
+			SubmitBatch();
 			if (this->Bind())
 			{
 				RendererContext* ctxt = GetContext();
@@ -2022,6 +2220,17 @@ void DKRenderer::RenderText(const DKRect& bounds, const DKMatrix3& transform, co
 	// sort by texture (same texture first)
 	quads.Sort(0, quads.Count(), TextureQuad::OrderByTextureASC);
 
+	if (GetBatch()->enabled)
+	{
+		// quads of same texture will be merged.
+		for (const TextureQuad& q : quads)
+		{
+			const Vertex2D vf[6] = { q.topLeft, q.bottomLeft, q.topRight, q.topRight, q.bottomLeft, q.bottomRight };
+			BatchPrimitive(DKPrimitive::TypeTriangles, vf, 6, q.texture, NULL, color, blend, Private::RP2AlphaTextured, true);
+		}
+		return;
+	}
+
 	if (this->Bind())
 	{
 		RendererContext* ctxt = GetContext();
@@ -2111,6 +2320,8 @@ void DKRenderer::RenderText(const DKPoint& baselineBegin, const DKPoint& baselin
 
 size_t DKRenderer::RenderMesh(const DKMesh* mesh, DKSceneState& st, const DKBlendState* blend) const
 {
+	SubmitBatch();
+
 	size_t numInstancesDrawn = 0;
 
 	if (mesh && IsDrawable() && this->Bind())
@@ -2258,3 +2469,168 @@ void DKRenderer::RenderScene(const DKScene* scene, const DKCamera& camera, int s
 		scene->Render(camera, sceneIndex, drawModes, groupFilter, enableCulling, cb);
 	}
 }
+
+bool DKRenderer::BatchPrimitive(DKPrimitive::Type p, const Vertex2D* vertices, size_t count, const DKTexture* texture, const DKTextureSampler* sampler, const DKColor& color, const DKBlendState& blend, int sceneIndex, bool screenSpace) const
+{
+	PrimitiveBatch* b = GetBatch();
+	const DKPrimitive::Type type = BatchPrimitiveType(p);
+	if (!b->enabled || type == DKPrimitive::TypeUnknown)
+		return false;
+
+	const size_t numVerts = BatchVertexCount(p, count);
+	if (numVerts == 0 || !IsDrawable())
+		return true;
+
+	if (!b->CanMerge(PrimitiveBatch::Kind2D, type, sceneIndex, texture, sampler, blend) ||
+		!(b->color == color) || b->Count() + numVerts > PrimitiveBatch::maxVertices)
+	{
+		SubmitBatch();
+		b->Begin(PrimitiveBatch::Kind2D, type, sceneIndex, texture, sampler, blend);
+		b->color = color;
+	}
+
+	if (screenSpace)
+	{
+		AppendBatchVertices(b->vertices2D, p, vertices, count, [](const Vertex2D& v) -> const Vertex2D&
+		{
+			return v;
+		});
+	}
+	else
+	{
+		const DKMatrix3& tm = this->screenTM;
+		AppendBatchVertices(b->vertices2D, p, vertices, count, [&tm](const Vertex2D& v)
+		{
+			return Vertex2D(DKVector2(v.position.x, v.position.y).Transform(tm), v.texcoord);
+		});
+	}
+	b->numCalls++;
+	b->stats.calls++;
+	return true;
+}
+
+bool DKRenderer::BatchPrimitive(DKPrimitive::Type p, const Vertex3D* vertices, size_t count, const DKMatrix4& tm, const DKTexture* texture, const DKTextureSampler* sampler, const DKBlendState& blend) const
+{
+	PrimitiveBatch* b = GetBatch();
+	const DKPrimitive::Type type = BatchPrimitiveType(p);
+	if (!b->enabled || type == DKPrimitive::TypeUnknown)
+		return false;
+
+	const size_t numVerts = BatchVertexCount(p, count);
+	if (numVerts == 0 || !IsDrawable())
+		return true;
+
+	const int sceneIndex = texture ? Private::RP3Textured : Private::RP3Colored;
+	if (!b->CanMerge(PrimitiveBatch::Kind3D, type, sceneIndex, texture, sampler, blend) ||
+		!(b->transform == tm) || b->Count() + numVerts > PrimitiveBatch::maxVertices)
+	{
+		SubmitBatch();
+		b->Begin(PrimitiveBatch::Kind3D, type, sceneIndex, texture, sampler, blend);
+		b->transform = tm;
+	}
+
+	AppendBatchVertices(b->vertices3D, p, vertices, count, [](const Vertex3D& v) -> const Vertex3D&
+	{
+		return v;
+	});
+	b->numCalls++;
+	b->stats.calls++;
+	return true;
+}
+
+void DKRenderer::SubmitBatch(void) const
+{
+	PrimitiveBatch* b = GetBatch();
+	const size_t count = b->Count();
+	if (count == 0)
+	{
+		b->Reset();
+		return;
+	}
+
+	b->stats.batches++;
+	b->stats.vertices += count;
+
+	if (b->backend)
+	{
+		Batch info;
+		info.primitive = b->primitive;
+		info.vertices2D = b->kind == PrimitiveBatch::Kind2D ? (const Vertex2D*)b->vertices2D : NULL;
+		info.vertices3D = b->kind == PrimitiveBatch::Kind3D ? (const Vertex3D*)b->vertices3D : NULL;
+		info.numVerts = count;
+		info.numCalls = b->numCalls;
+		info.texture = b->texture;
+		info.sampler = b->sampler;
+		info.blend = &b->blend;
+		info.color = b->color;
+		info.transform = b->transform;
+		b->backend->Draw(info);
+	}
+	else if (this->Bind())
+	{
+		// keep states, batch should be reset before RenderMesh.
+		DKObject<DKTexture> texture = b->texture;
+		DKObject<DKTextureSampler> sampler = b->sampler;
+		const DKBlendState blend = b->blend;
+
+		RendererContext* ctxt = GetContext();
+		RendererContext::CriticalSection section(ctxt->lock);
+
+		DKStaticMesh* mesh = NULL;
+		if (b->kind == PrimitiveBatch::Kind2D)
+		{
+			ctxt->Update2DMeshStream(b->primitive, b->vertices2D, count);
+			ctxt->mesh2D->SetMaterialProperty(L"color", DKMaterial::PropertyArray(b->color.val, 4));
+			mesh = ctxt->mesh2D;
+		}
+		else
+		{
+			ctxt->Update3DMeshStream(b->primitive, b->vertices3D, count);
+			ctxt->mesh3D->SetMaterialProperty(L"transform", DKMaterial::PropertyArray(b->transform.val, 16));
+			mesh = ctxt->mesh3D;
+		}
+		ctxt->sceneState.sceneIndex = b->sceneIndex;
+		b->Reset();
+
+		if (texture)
+			mesh->SetSampler(L"tex", texture, sampler);
+		this->RenderMesh(mesh, ctxt->sceneState, &blend);
+		mesh->RemoveSampler(L"tex");
+		return;
+	}
+	b->Reset();
+}
+
+void DKRenderer::SetBatchingEnabled(bool enable)
+{
+	if (!enable)
+		SubmitBatch();
+	GetBatch()->enabled = enable;
+}
+
+bool DKRenderer::IsBatchingEnabled(void) const
+{
+	return batch->enabled;
+}
+
+void DKRenderer::SetBatchBackend(BatchBackend* backend)
+{
+	SubmitBatch();
+	GetBatch()->backend = backend;
+}
+
+void DKRenderer::Flush(void) const
+{
+	GetBatch()->stats.flushes++;
+	SubmitBatch();
+}
+
+DKRenderer::BatchStatistics DKRenderer::BatchingStatistics(void) const
+{
+	return batch->stats;
+}
+
+void DKRenderer::ResetBatchingStatistics(void)
+{
+	memset(&GetBatch()->stats, 0, sizeof(BatchStatistics));
+}
@@ -182,8 +182,51 @@ namespace DKFramework
 		void RenderText(const DKRect& bounds, const DKMatrix3& transform, const DKFoundation::DKString& text, const DKFont* font, const DKColor& color, const DKBlendState& blend = DKBlendState::defaultAlpha) const;
 		void RenderText(const DKPoint& baselineBegin, const DKPoint& baselineEnd, const DKFoundation::DKString& text, const DKFont* font, const DKColor& color, const DKBlendState& blend = DKBlendState::defaultAlpha) const;
 
+		// primitive batching.
+		// if batching enabled, vertices of RenderPrimitive, RenderSolid*,
+		// RenderTextured*, RenderColored* and RenderText are accumulated into
+		// persistent vertex buffer, consecutive calls which have same texture,
+		// sampler, blend state and color (2D) or transform (3D) are merged into
+		// one draw call. strips, fans and loops are converted to lists.
+		// pending batch is drawn when state changed, Flush() called or any
+		// other drawing function (RenderMesh, Clear, ellipses..) called.
+		struct Batch
+		{
+			DKPrimitive::Type			primitive;	// TypePoints, TypeLines or TypeTriangles
+			const Vertex2D*				vertices2D;	// screen space, NULL for 3D batch
+			const Vertex3D*				vertices3D;	// NULL for 2D batch
+			size_t						numVerts;
+			size_t						numCalls;	// number of merged calls
+			const DKTexture*			texture;
+			const DKTextureSampler*		sampler;
+			const DKBlendState*			blend;
+			DKColor						color;		// 2D only
+			DKMatrix4					transform;	// 3D only
+		};
+		struct BatchStatistics
+		{
+			size_t calls;		// primitive calls accumulated
+			size_t batches;		// batches drawn
+			size_t vertices;	// vertices drawn with batches
+			size_t flushes;		// Flush() calls
+		};
+		// backend receives batches instead of drawing with OpenGL.
+		struct BatchBackend
+		{
+			virtual ~BatchBackend(void) {}
+			virtual void Draw(const Batch&) = 0;
+		};
+		void SetBatchingEnabled(bool enable);	// disabling flushes pending batch.
+		bool IsBatchingEnabled(void) const;
+		void SetBatchBackend(BatchBackend* backend);	// NULL to draw with OpenGL (default)
+		void Flush(void) const;
+		BatchStatistics BatchingStatistics(void) const;
+		void ResetBatchingStatistics(void);
+
 	private:
 		class RendererContext;
+		struct PrimitiveBatch;
+		DKFoundation::DKObject<PrimitiveBatch>			batch;
 		DKFoundation::DKObject<DKRenderTarget>			renderTarget;
 		DKFoundation::DKObject<DKFoundation::DKUnknown>	context;
 		DKRect											contentBounds;
@@ -201,5 +244,9 @@ namespace DKFramework
 		bool IsDrawable(void) const;
 		DKRenderState* Bind(void) const;
 		RendererContext* GetContext(void) const;
+		PrimitiveBatch* GetBatch(void) const;
+		bool BatchPrimitive(DKPrimitive::Type p, const Vertex2D* vertices, size_t count, const DKTexture* texture, const DKTextureSampler* sampler, const DKColor& color, const DKBlendState& blend, int sceneIndex, bool screenSpace) const;
+		bool BatchPrimitive(DKPrimitive::Type p, const Vertex3D* vertices, size_t count, const DKMatrix4& tm, const DKTexture* texture, const DKTextureSampler* sampler, const DKBlendState& blend) const;
+		void SubmitBatch(void) const;
 	};
 }
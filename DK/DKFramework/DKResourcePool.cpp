@@ -7,6 +7,7 @@
 
 #include "DKResourcePool.h"
 #include "DKResource.h"
+#include "DKStaticTriangleMeshShape.h"
 
 using namespace DKFoundation;
 using namespace DKFramework;
@@ -241,6 +242,7 @@ void DKResourcePool::RemoveAll(void)
 	DKCriticalSection<DKSpinLock> guard(this->lock);
 	resources.Clear();
 	resourceData.Clear();
+	sharedMeshShapes.Clear();
 }
 
 void DKResourcePool::ClearUnreferencedObjects(void)
@@ -285,6 +287,102 @@ void DKResourcePool::ClearUnreferencedObjects(void)
 		if (d.Ptr() != NULL)
 			resourceData.Update(info.key, d);
 	}
+
+	// shared shapes.
+	using ShapeRef = DKObject<DKStaticTriangleMeshShape>::Ref;
+	struct ShapeInfo
+	{
+		uint32_t key;
+		DKArray<ShapeRef> value;
+	};
+	DKArray<ShapeInfo> shapeRefs;
+	shapeRefs.Reserve(sharedMeshShapes.Count());
+	sharedMeshShapes.EnumerateForward([&shapeRefs](const SharedMeshShapeMap::Pair& pair)
+	{
+		ShapeInfo info;
+		info.key = pair.key;
+		info.value.Reserve(pair.value.Count());
+		for (const DKObject<DKStaticTriangleMeshShape>& shape : pair.value)
+			info.value.Add(shape);
+		shapeRefs.Add(info);
+	});
+	sharedMeshShapes.Clear();
+	for (ShapeInfo& info : shapeRefs)
+	{
+		SharedMeshShapeArray shapes;
+		for (ShapeRef& ref : info.value)
+		{
+			DKObject<DKStaticTriangleMeshShape> shape = ref;
+			if (shape.Ptr() != NULL)
+				shapes.Add(shape);
+		}
+		if (shapes.Count() > 0)
+			sharedMeshShapes.Update(info.key, shapes);
+	}
+}
+
+template <typename IndexType>
+DKObject<DKStaticTriangleMeshShape> DKResourcePool::FindOrCreateMeshShape(const DKVector3* vertices, size_t numVertices, const IndexType* indices, size_t numIndices, DKData* bvhData)
+{
+	if (vertices == NULL || numVertices == 0 || indices == NULL || numIndices < 3)
+		return NULL;
+
+	// hash of vertices and number of indices, content is compared in group.
+	uint64_t count = numIndices;
+	DKHash32 hash;
+	hash.Initialize();
+	hash.Update(vertices, numVertices * sizeof(DKVector3));
+	hash.Update(&count, sizeof(count));
+	hash.Finalize();
+	const uint32_t key = hash.Result().digest[0];
+
+	auto findShape = [&](void)->DKStaticTriangleMeshShape*
+	{
+		SharedMeshShapeMap::Pair* p = sharedMeshShapes.Find(key);
+		if (p)
+		{
+			for (DKStaticTriangleMeshShape* shape : p->value)
+			{
+				if (shape->IsEqualContent(vertices, numVertices, indices, numIndices))
+					return shape;
+			}
+		}
+		return NULL;
+	};
+
+	if (true)
+	{
+		DKCriticalSection<DKSpinLock> guard(this->lock);
+		DKObject<DKStaticTriangleMeshShape> shape = findShape();
+		if (shape)
+			return shape;
+	}
+
+	// create shape without lock. (building BVH takes long time)
+	DKObject<DKStaticTriangleMeshShape> shape = DKOBJECT_NEW DKStaticTriangleMeshShape(vertices, numVertices, indices, numIndices, bvhData);
+
+	DKCriticalSection<DKSpinLock> guard(this->lock);
+	DKObject<DKStaticTriangleMeshShape> existing = findShape();	// created by other thread.
+	if (existing)
+		return existing;
+	sharedMeshShapes.Value(key).Add(shape);
+	return shape;
+}
+
+DKObject<DKStaticTriangleMeshShape> DKResourcePool::SharedStaticTriangleMeshShape(const DKVector3* vertices, size_t numVertices, const unsigned int* indices, size_t numIndices, DKData* bvhData)
+{
+	return FindOrCreateMeshShape(vertices, numVertices, indices, numIndices, bvhData);
+}
+
+DKObject<DKStaticTriangleMeshShape> DKResourcePool::SharedStaticTriangleMeshShape(const DKVector3* vertices, size_t numVertices, const unsigned short* indices, size_t numIndices, DKData* bvhData)
+{
+	return FindOrCreateMeshShape(vertices, numVertices, indices, numIndices, bvhData);
+}
+
+void DKResourcePool::RemoveAllSharedShapes(void)
+{
+	DKCriticalSection<DKSpinLock> guard(this->lock);
+	sharedMeshShapes.Clear();
 }
 
 DKObject<DKResource> DKResourcePool::FindResource(const DKString& name) const
@@ -406,6 +504,7 @@ DKObject<DKResourcePool> DKResourcePool::Clone(void) const
 	pool->allocator = this->allocator;
 	pool->resources = this->resources;
 	pool->resourceData = this->resourceData;
+	pool->sharedMeshShapes = this->sharedMeshShapes;
 	
 	return pool;
 }
@@ -10,6 +10,7 @@
 #include "../DKFoundation.h"
 #include "DKResource.h"
 #include "DKResourceLoader.h"
+#include "DKVector3.h"
 
 #ifdef FindResource
 #undef FindResource
@@ -41,11 +42,17 @@
 //  pool.LoadResource("MyFile.dat");   // load 'MyFile.data' and restore object.
 //  pool.LoadResourceData("MyFile.dat"); // load 'MyFile.data' data only.
 //
+// Shared collision shapes:
+//  SharedStaticTriangleMeshShape() returns shape which has same content
+//  (vertices, indices) if it was created already. Building BVH of large mesh
+//  is expensive, identical meshes share one shape instance.
+//
 ////////////////////////////////////////////////////////////////////////////////
 
 
 namespace DKFramework
 {
+	class DKStaticTriangleMeshShape;
 	class DKGL_API DKResourcePool : public DKResourceLoader
 	{
 	public:
@@ -101,6 +108,13 @@ namespace DKFramework
 		// remove unreferenced objects only.
 		void ClearUnreferencedObjects(void);
 
+		// find or create shape of same content. bvhData is used to restore BVH
+		// of new shape. (see DKStaticTriangleMeshShape)
+		DKFoundation::DKObject<DKStaticTriangleMeshShape> SharedStaticTriangleMeshShape(const DKVector3* vertices, size_t numVertices, const unsigned int* indices, size_t numIndices, DKFoundation::DKData* bvhData = NULL);
+		DKFoundation::DKObject<DKStaticTriangleMeshShape> SharedStaticTriangleMeshShape(const DKVector3* vertices, size_t numVertices, const unsigned short* indices, size_t numIndices, DKFoundation::DKData* bvhData = NULL);
+		// remove all shared shapes from pool.
+		void RemoveAllSharedShapes(void);
+
 		// return absolute file path string, if specified file are exists in file-system directory.
 		DKFoundation::DKString ResourceFilePath(const DKFoundation::DKString& name) const;
 		// open resource as stream.
@@ -125,6 +139,14 @@ namespace DKFramework
 		ResourceMap			resources;
 		DataMap				resourceData;
 
+		// shapes are grouped by content hash.
+		typedef DKFoundation::DKArray<DKFoundation::DKObject<DKStaticTriangleMeshShape>>	SharedMeshShapeArray;
+		typedef DKFoundation::DKMap<uint32_t, SharedMeshShapeArray>						SharedMeshShapeMap;
+		SharedMeshShapeMap	sharedMeshShapes;
+
+		template <typename IndexType>
+		DKFoundation::DKObject<DKStaticTriangleMeshShape> FindOrCreateMeshShape(const DKVector3*, size_t, const IndexType*, size_t, DKFoundation::DKData*);
+
 		DKFoundation::DKSpinLock lock;
 		mutable DKFoundation::DKAllocator* allocator;
 	};
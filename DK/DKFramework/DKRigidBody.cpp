@@ -14,6 +14,8 @@ namespace DKFramework
 {
 	namespace Private
 	{
+		static DKAtomicNumber64 rigidBodySerial;
+
 		struct RigidBodyExt : public btRigidBody
 		{
 			btScalar& linearDamping()							{ return m_linearDamping; }
@@ -119,6 +121,8 @@ bool DKRigidBody::ResetObject(DKCollisionShape* shape, const ObjectData& data)
 DKRigidBody::DKRigidBody(const DKString& name)
 : DKCollisionObject(ObjectType::RigidBody, new btRigidBody(0, 0, 0))
 , motionState(new btDefaultMotionState())
+, serial(Private::rigidBodySerial.Increment() + 1)
+, snapshotTransformValid(false)
 {
 	SetName(name);
 	btRigidBody* body = btRigidBody::upcast(this->impl);
@@ -131,6 +135,8 @@ DKRigidBody::DKRigidBody(const DKString& name)
 DKRigidBody::DKRigidBody(DKCollisionShape* shape, float mass)
 : DKCollisionObject(ObjectType::RigidBody, new btRigidBody(0, 0, 0))
 , motionState(new btDefaultMotionState())
+, serial(Private::rigidBodySerial.Increment() + 1)
+, snapshotTransformValid(false)
 {
 	if (shape)
 	{
@@ -160,6 +166,8 @@ DKRigidBody::DKRigidBody(DKCollisionShape* shape, float mass)
 DKRigidBody::DKRigidBody(DKCollisionShape* shape, float mass, const DKVector3& inertia)
 : DKCollisionObject(ObjectType::RigidBody, new btRigidBody(0, 0, 0))
 , motionState(new btDefaultMotionState())
+, serial(Private::rigidBodySerial.Increment() + 1)
+, snapshotTransformValid(false)
 {
 	btCollisionShape* cs = NULL;
 	if (shape)
@@ -178,6 +186,8 @@ DKRigidBody::DKRigidBody(DKCollisionShape* shape, float mass, const DKVector3& i
 DKRigidBody::DKRigidBody(DKCollisionShape* shape, const ObjectData& data)
 : DKCollisionObject(ObjectType::RigidBody, new btRigidBody(0, 0, 0))
 , motionState(new btDefaultMotionState())
+, serial(Private::rigidBodySerial.Increment() + 1)
+, snapshotTransformValid(false)
 {
 	bool b = ResetObject(shape, data);
 	DKASSERT_DEBUG(b);
@@ -542,9 +552,18 @@ void DKRigidBody::OnUpdateSceneState(const DKNSTransform& parentWorldTransform)
 	{
 		DKASSERT_DEBUG(this->Scene() != NULL);
 
-		btTransform trans;
-		this->motionState->getWorldTransform(trans);
-		DKNSTransform t = BulletTransform(trans);
+		DKNSTransform t;
+		if (this->snapshotTransformValid)
+		{
+			t = this->snapshotTransform;
+			this->snapshotTransformValid = false;
+		}
+		else
+		{
+			btTransform trans;
+			this->motionState->getWorldTransform(trans);
+			t = BulletTransform(trans);
+		}
 		this->worldTransform = t;
 		if (this->Parent())
 			this->localTransform = t * DKNSTransform(parentWorldTransform).Inverse();
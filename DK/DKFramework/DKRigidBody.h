@@ -23,6 +23,7 @@ namespace DKFramework
 	class DKGL_API DKRigidBody : public DKCollisionObject
 	{
 		friend class DKConstraint;
+		friend class DKDynamicsScene;
 	public:
 		struct DKGL_API ObjectData
 		{
@@ -124,5 +125,12 @@ namespace DKFramework
 
 	private:
 		class btMotionState* motionState;
+
+		// unique identifier, never reused. (key of simulation snapshot)
+		const int64_t serial;
+		// world transform applied by DKDynamicsScene while simulation is
+		// running asynchronously, consumed by next OnUpdateSceneState.
+		DKNSTransform snapshotTransform;
+		bool snapshotTransformValid;
 	};
 }
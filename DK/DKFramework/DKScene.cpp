@@ -6,9 +6,11 @@
 //
 
 #include "Private/BulletUtils.h"
+#include "Private/SimdMath.h"
 #include "DKMath.h"
 #include "DKScene.h"
 #include "DKRenderer.h"
+#include "DKRenderQueue.h"
 #include "DKModel.h"
 #include "DKMesh.h"
 
@@ -829,13 +831,8 @@ namespace DKFramework
 			DKTimeTick		tick;
 
 			// data for mesh-rendering
-			struct ZSortedMesh
-			{
-				const DKMesh* mesh;
-				float distance;      // z value of view-projection applied
-				bool opaque;
-			};
-			DKArray<ZSortedMesh> sortedMeshes;  // for sorting
+			DKArray<const DKMesh*> visibleMeshes;	// for culling
+			DKRenderQueue renderQueue;			// for sorting
 			DKArray<const DKMesh*> drawMeshes;  // for drawing
 			DKSceneState sceneState;
 		};
@@ -844,10 +841,245 @@ namespace DKFramework
 using namespace DKFramework;
 using namespace DKFramework::Private;
 
+struct DKScene::MeshVolumeTree
+{
+	struct Volume
+	{
+		const DKMesh* mesh;
+		DKSphere sphere;		// world space bounding sphere
+		btDbvtNode* leaf;		// NULL if mesh has no bounds. (always visible)
+	};
+	typedef SimdPlanes Frustum;	// near, far, left, right, top, bottom
+	struct SubTree
+	{
+		const btDbvtNode* node;
+		unsigned int planeMask;	// planes to be tested, 0 if fully inside.
+	};
+	enum : unsigned int { AllPlanes = 0x3f };
+
+	// minimum number of leaves to traverse in parallel.
+	enum { MinLeavesForParallelCulling = 1024 };
+
+	btDbvt tree;
+	DKMap<const DKMesh*, Volume*> volumes;
+	DKSet<Volume*> unboundedVolumes;
+	size_t numLeaves;
+
+	DKArray<SubTree> subTrees;
+	DKArray<DKArray<const DKMesh*>> subTreeResults;
+
+	MeshVolumeTree(void) : numLeaves(0) {}
+	~MeshVolumeTree(void)
+	{
+		Clear();
+	}
+	void Insert(const DKMesh* mesh)
+	{
+		DKASSERT_DEBUG(volumes.Find(mesh) == NULL);
+		Volume* v = new Volume();
+		v->mesh = mesh;
+		v->leaf = NULL;
+		volumes.Insert(mesh, v);
+		Refresh(v);
+	}
+	void Remove(const DKMesh* mesh)
+	{
+		auto p = volumes.Find(mesh);
+		if (p)
+		{
+			Volume* v = p->value;
+			if (v->leaf)
+			{
+				tree.remove(v->leaf);
+				numLeaves--;
+			}
+			unboundedVolumes.Remove(v);
+			volumes.Remove(mesh);
+			delete v;
+		}
+	}
+	void Clear(void)
+	{
+		volumes.EnumerateForward([](DKMap<const DKMesh*, Volume*>::Pair& pair)
+		{
+			delete pair.value;
+		});
+		volumes.Clear();
+		unboundedVolumes.Clear();
+		tree.clear();
+		numLeaves = 0;
+	}
+	// update volume of mesh, reinserted if volume left enlarged leaf volume.
+	void Refresh(Volume* v)
+	{
+		DKSphere bs = v->mesh->ScaledBoundingSphere();
+		if (bs.radius > 0.0f)
+		{
+			bs.center.Transform(v->mesh->ScaledWorldTransformMatrix());
+			v->sphere = bs;
+
+			btDbvtVolume volume = btDbvtVolume::FromCR(BulletVector3(bs.center), bs.radius);
+			if (v->leaf)
+			{
+				tree.update(v->leaf, volume, bs.radius * 0.25f);
+			}
+			else
+			{
+				volume.Expand(btVector3(bs.radius, bs.radius, bs.radius) * 0.25f);
+				v->leaf = tree.insert(volume, v);
+				numLeaves++;
+				unboundedVolumes.Remove(v);
+			}
+		}
+		else
+		{
+			if (v->leaf)
+			{
+				tree.remove(v->leaf);
+				numLeaves--;
+			}
+			v->leaf = NULL;
+			v->sphere = bs;
+			unboundedVolumes.Insert(v);
+		}
+	}
+	void RefreshAll(void)
+	{
+		volumes.EnumerateForward([this](DKMap<const DKMesh*, Volume*>::Pair& pair)
+		{
+			Refresh(pair.value);
+		});
+		tree.optimizeIncremental(1);
+	}
+
+	// test aabb with planes in mask, returns false if outside.
+	// planes which volume is fully inside are removed from mask.
+	static bool TestVolume(const btDbvtVolume& volume, const Frustum& f, unsigned int& mask)
+	{
+		const btVector3 c = volume.Center();
+		const btVector3 e = volume.Extents();
+		const float center[3] = { float(c.x()), float(c.y()), float(c.z()) };
+		const float extents[3] = { float(e.x()), float(e.y()), float(e.z()) };
+		return SimdPlanesAabbTest(f, center, extents, mask);
+	}
+	static bool TestSphere(const DKSphere& s, const Frustum& f, unsigned int mask)
+	{
+		return SimdPlanesSphereTest(f, s.center.val, s.radius, mask);
+	}
+	// traverse subtree, adds meshes inside of frustum.
+	static void CullSubTree(const SubTree& subTree, const Frustum& f, DKArray<const DKMesh*>& result)
+	{
+		DKArray<SubTree> stack;
+		stack.Add(subTree);
+		while (stack.Count() > 0)
+		{
+			SubTree st = stack.Value(stack.Count() - 1);
+			stack.Remove(stack.Count() - 1);
+
+			if (st.planeMask && !TestVolume(st.node->volume, f, st.planeMask))
+				continue;
+
+			if (st.node->isleaf())
+			{
+				const Volume* v = static_cast<const Volume*>(st.node->data);
+				if (st.planeMask == 0 || TestSphere(v->sphere, f, st.planeMask))
+					result.Add(v->mesh);
+			}
+			else
+			{
+				SubTree c1 = { st.node->childs[1], st.planeMask };
+				SubTree c0 = { st.node->childs[0], st.planeMask };
+				stack.Add(c1);
+				stack.Add(c0);
+			}
+		}
+	}
+	// collect meshes inside of camera frustum.
+	// top of tree is split into subtrees which are traversed in parallel.
+	void Cull(const DKCamera& camera, DKOperationQueue* queue, DKArray<const DKMesh*>& result)
+	{
+		unboundedVolumes.EnumerateForward([&result](const Volume* v)
+		{
+			result.Add(v->mesh);
+		});
+
+		if (tree.m_root == NULL)
+			return;
+
+		const DKPlane* planes[6] = {
+			&camera.NearFrustumPlane(), &camera.FarFrustumPlane(),
+			&camera.LeftFrustumPlane(), &camera.RightFrustumPlane(),
+			&camera.TopFrustumPlane(), &camera.BottomFrustumPlane()
+		};
+		Frustum f;
+		memset(&f, 0, sizeof(f));
+		for (int i = 0; i < 6; ++i)
+		{
+			f.nx[i] = planes[i]->a;
+			f.ny[i] = planes[i]->b;
+			f.nz[i] = planes[i]->c;
+			f.d[i] = planes[i]->d;
+		}
+
+		SubTree root = { tree.m_root, AllPlanes };
+		size_t maxConcurrent = queue ? queue->MaxConcurrentOperations() : 1;
+		if (maxConcurrent < 2 || numLeaves < MinLeavesForParallelCulling)
+		{
+			CullSubTree(root, f, result);
+			return;
+		}
+
+		// split tree until number of subtrees reaches a few per thread.
+		const size_t numSubTrees = maxConcurrent * 4;
+		subTrees.Clear();
+		subTrees.Add(root);
+		for (size_t i = 0; i < subTrees.Count() && subTrees.Count() < numSubTrees; )
+		{
+			SubTree st = subTrees.Value(i);
+			if (st.node->isleaf())
+			{
+				++i;
+				continue;
+			}
+			subTrees.Remove(i);
+			if (st.planeMask && !TestVolume(st.node->volume, f, st.planeMask))
+				continue;
+			SubTree c0 = { st.node->childs[0], st.planeMask };
+			SubTree c1 = { st.node->childs[1], st.planeMask };
+			subTrees.Add(c0);
+			subTrees.Add(c1);
+		}
+
+		if (subTreeResults.Count() < subTrees.Count())
+			subTreeResults.Resize(subTrees.Count());
+
+		DKOperationQueue::TaskGroup group(queue);
+		for (size_t i = 0; i < subTrees.Count(); ++i)
+		{
+			const SubTree* st = &subTrees.Value(i);
+			DKArray<const DKMesh*>* output = &subTreeResults.Value(i);
+			output->Clear();
+			group.Post(DKFunction([st, &f, output]
+			{
+				CullSubTree(*st, f, *output);
+			})->Invocation());
+		}
+		group.Wait();
+
+		for (size_t i = 0; i < subTrees.Count(); ++i)
+		{
+			const DKArray<const DKMesh*>& output = subTreeResults.Value(i);
+			result.Add(output, output.Count());
+		}
+		subTrees.Clear();
+	}
+};
+
 
 DKScene::DKScene(void)
 : context(NULL)
 , ambientColor(0, 0, 0)
+, meshVolumes(new MeshVolumeTree())
 {
 	context = new CollisionWorldContext();
 	context->configuration = new btDefaultCollisionConfiguration();
@@ -871,6 +1103,7 @@ DKScene::DKScene(void)
 DKScene::DKScene(CollisionWorldContext* ctxt)
 : context(ctxt)
 , ambientColor(0, 0, 0)
+, meshVolumes(new MeshVolumeTree())
 {
 	DKASSERT_DEBUG(context);
 	DKASSERT_DEBUG(context->broadphase);
@@ -911,6 +1144,7 @@ DKScene::~DKScene(void)
 
 	delete context;
 	delete drawer;
+	delete meshVolumes;
 }
 
 void DKScene::Update(double tickDelta, DKTimeTick tick)
@@ -964,6 +1198,12 @@ void DKScene::Update(double tickDelta, DKTimeTick tick)
 	CleanupUpdateNode();
 }
 
+void DKScene::SetUpdateQueue(DKOperationQueue* queue)
+{
+	DKCriticalSection<DKSpinLock> guard(this->lock);
+	this->updateQueue = queue;
+}
+
 void DKScene::PrepareUpdateNode(void)
 {
 	DKASSERT_DEBUG(context);
@@ -972,35 +1212,103 @@ void DKScene::PrepareUpdateNode(void)
 	DKCriticalSection<DKSpinLock> guard(this->lock);
 
 	this->updatePendingObjects.Clear();
+	this->serialUpdatePendingObjects.Clear();
 	this->updatePendingObjects.Reserve(this->sceneObjects.Count());
-	this->sceneObjects.EnumerateForward([=](const DKModel* model)
+	this->pendingUpdateQueue = this->updateQueue;
+
+	if (this->pendingUpdateQueue)
 	{
-		if (model->Parent() == NULL)
+		// pick out trees which should be updated serially.
+		DKSet<const DKModel*> serialRoots;
+		this->sceneObjects.EnumerateForward([&](const DKModel* model)
 		{
-			updatePendingObjects.Add((const_cast<DKModel*>(model)));
-		}
-	});
+			if (model->IsSerialUpdate())
+				serialRoots.Insert(model->RootObject());
+		});
+		this->sceneObjects.EnumerateForward([&](const DKModel* model)
+		{
+			if (model->Parent() == NULL)
+			{
+				if (serialRoots.Contains(model))
+					serialUpdatePendingObjects.Add((const_cast<DKModel*>(model)));
+				else
+					updatePendingObjects.Add((const_cast<DKModel*>(model)));
+			}
+		});
+	}
+	else
+	{
+		this->sceneObjects.EnumerateForward([=](const DKModel* model)
+		{
+			if (model->Parent() == NULL)
+			{
+				updatePendingObjects.Add((const_cast<DKModel*>(model)));
+			}
+		});
+	}
 }
 
 void DKScene::CleanupUpdateNode(void)
 {
 	updatePendingObjects.Clear();
+	serialUpdatePendingObjects.Clear();
+	pendingUpdateQueue = NULL;
+}
+
+template <typename T> void DKScene::UpdatePendingObjects(T&& update)
+{
+	// minimum number of trees for one operation.
+	enum { MinTreesPerOperation = 8 };
+
+	size_t count = updatePendingObjects.Count();
+	DKObject<DKModel>* models = updatePendingObjects;
+	DKOperationQueue* queue = pendingUpdateQueue;
+	size_t maxConcurrent = queue ? queue->MaxConcurrentOperations() : 1;
+
+	if (maxConcurrent > 1 && count >= MinTreesPerOperation * 2)
+	{
+		// split trees into ranges, a few ranges per thread for load balancing.
+		size_t numOps = Min(count / MinTreesPerOperation, maxConcurrent * 4);
+		DKOperationQueue::TaskGroup group(queue);
+		for (size_t i = 0; i < numOps; ++i)
+		{
+			size_t begin = count * i / numOps;
+			size_t end = count * (i + 1) / numOps;
+			group.Post(DKFunction([&update, models, begin, end]
+			{
+				for (size_t k = begin; k < end; ++k)
+					update(models[k]);
+			})->Invocation());
+		}
+		group.Wait();
+	}
+	else
+	{
+		for (size_t i = 0; i < count; ++i)
+			update(models[i]);
+	}
+
+	for (DKModel* m : serialUpdatePendingObjects)
+		update(m);
 }
 
 void DKScene::UpdateObjectKinematics(double tickDelta, DKTimeTick tick)
 {
-	for (DKModel* m : updatePendingObjects)
+	UpdatePendingObjects([tickDelta, tick](DKModel* m)
 	{
 		m->UpdateKinematic(tickDelta, tick);
-	}
+	});
 }
 
 void DKScene::UpdateObjectSceneStates(void)
 {
-	for (DKModel* m : updatePendingObjects)
+	UpdatePendingObjects([](DKModel* m)
 	{
 		m->UpdateSceneState(DKNSTransform::identity);
-	}
+	});
+
+	DKCriticalSection<DKSpinLock> guard(this->lock);
+	meshVolumes->RefreshAll();
 }
 
 void DKScene::Render(const DKCamera& camera, int sceneIndex, unsigned int modes, unsigned int groupFilter, bool enableCulling, DrawCallback& dc) const
@@ -1127,67 +1435,41 @@ void DKScene::Render(const DKCamera& camera, int sceneIndex, unsigned int modes,
 				const DKMaterial* mat = mesh->Material();
 				if (mat && mat->renderingProperties.Count() > sceneIndex)
 				{
+					// z value of view-projection applied
 					const DKMatrix4& nodeTM = mesh->ScaledWorldTransformMatrix();
-					bool visible = true;
-					if (enableCulling)
-					{
-						DKSphere bs = mesh->ScaledBoundingSphere();
-						if (bs.radius > 0.0f)
-						{
-							bs.center.Transform(nodeTM);
-							visible = camera.IsSphereInside(bs);	// frustum culling
-						}
-					}
-					if (visible)
-					{
-						const DKSceneState& sceneState = drawer->sceneState;
-						const DKBlendState* blend = &(mat->renderingProperties.Value(sceneIndex).blendState);
-
-						ShapeDrawer::ZSortedMesh meshInfo = { mesh, 0.0f, true };
-						meshInfo.distance = (nodeTM * sceneState.viewProjectionMatrix).m[3][2];
-						meshInfo.opaque = blend->dstBlendRGB == DKBlendState::BlendModeZero && blend->dstBlendAlpha == DKBlendState::BlendModeZero;
-
-						drawer->sortedMeshes.Add(meshInfo);
-					}
+					float depth = (nodeTM * drawer->sceneState.viewProjectionMatrix).m[3][2];
+					drawer->renderQueue.Add(mesh, sceneIndex, depth);
 				}
 			}
 		};
-		auto sorter = [](const ShapeDrawer::ZSortedMesh& lhs, const ShapeDrawer::ZSortedMesh& rhs)->bool
-		{
-			// sort order:
-			// if opaque is true, shorter distance is front.
-			// if opaque is false, longer distance is front.
-			// for all objects, opaque is front.
-
-			int op1 = rhs.opaque ? 0 : 1;
-			int op2 = lhs.opaque ? 0 : 1;
-			int c = op1 - op2;
-			if (c == 0)
-			{
-				if (rhs.opaque)   // opaque object
-					return rhs.distance < lhs.distance; // shorter is front
-				return rhs.distance > lhs.distance;     // longer is front
-			}
-			return c > 0;
-		};
-
-		drawer->sortedMeshes.Clear();
-		drawer->sortedMeshes.Reserve(this->meshes.Count());
+		// sort meshes by rendering states, opaque meshes are drawn first.
+		// (see DKRenderQueue)
+		drawer->renderQueue.Clear();
 		this->SetSceneState(camera, drawer->sceneState);
-		this->meshes.EnumerateForward(extractMeshes);
-		drawer->sortedMeshes.Sort<decltype(sorter)&>(sorter);
+		if (enableCulling)
+		{
+			// frustum culling with bounding volume hierarchy
+			DKOperationQueue* queue = const_cast<DKOperationQueue*>((const DKOperationQueue*)this->updateQueue);
+			drawer->visibleMeshes.Clear();
+			meshVolumes->Cull(camera, queue, drawer->visibleMeshes);
+			for (const DKMesh* mesh : drawer->visibleMeshes)
+				extractMeshes(mesh);
+			drawer->visibleMeshes.Clear();
+		}
+		else
+		{
+			this->meshes.EnumerateForward(extractMeshes);
+		}
+		drawer->renderQueue.Sort();
 
 		drawer->sceneState.sceneIndex = sceneIndex;
 		drawer->drawMeshes.Clear();
-		drawer->drawMeshes.Reserve(drawer->sortedMeshes.Count());
+		drawer->drawMeshes.Reserve(drawer->renderQueue.Count());
 
-		for (ShapeDrawer::ZSortedMesh& meshInfo : drawer->sortedMeshes)
-		{
-			if (meshInfo.mesh)
-				drawer->drawMeshes.Add(meshInfo.mesh);
-		}
+		for (size_t i = 0; i < drawer->renderQueue.Count(); ++i)
+			drawer->drawMeshes.Add(drawer->renderQueue.ItemAtIndex(i).mesh);
 
-		drawer->sortedMeshes.Clear();
+		drawer->renderQueue.Clear();
 
 		if (drawer->drawMeshes.Count() > 0)
 		{
@@ -1421,6 +1703,7 @@ bool DKScene::AddSingleObject(DKModel* obj)
 		DKMesh* mesh = static_cast<DKMesh*>(obj);
 		DKASSERT_DEBUG(meshes.Contains(mesh) == false);
 		meshes.Insert(mesh);
+		meshVolumes->Insert(mesh);
 		return true;
 	}
 	else if (obj->type == DKModel::TypeCollision)
@@ -1446,6 +1729,7 @@ void DKScene::RemoveSingleObject(DKModel* obj)
 		DKASSERT_DEBUG(dynamic_cast<DKMesh*>(obj) != NULL);
 		DKMesh* mesh = static_cast<DKMesh*>(obj);
 		meshes.Remove(static_cast<DKMesh*>(mesh));
+		meshVolumes->Remove(mesh);
 	}
 	else if (obj->type == DKModel::TypeCollision)
 	{
@@ -1479,6 +1763,7 @@ void DKScene::RemoveAllObjects(void)
 	});
 	this->sceneObjects.Clear();
 	this->meshes.Clear();
+	this->meshVolumes->Clear();
 }
 
 size_t DKScene::NumberOfSceneObjects(void) const
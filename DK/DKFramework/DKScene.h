@@ -19,6 +19,19 @@
 // DKScene
 // compose scene with DKModel tree.
 // you can detect collision with DKModel nodes.
+//
+// Update() can update model trees in parallel with operation queue.
+// (see SetUpdateQueue) each tree (root model and descendants) is updated
+// by one thread, trees are independent.
+// trees which contain serial update model (DKModel::SetSerialUpdate) are
+// updated on calling thread after parallel trees have been updated.
+// synchronization of collision objects is always done on calling thread.
+//
+// meshes are kept in a bounding volume hierarchy for frustum culling.
+// bounding volumes are updated with scene states in Update(), moved meshes
+// are reinserted only if they left their enlarged volumes.
+// Render() rejects subtrees outside of frustum, subtrees are traversed in
+// parallel with update queue if set.
 ////////////////////////////////////////////////////////////////////////////////
 
 namespace DKFramework
@@ -45,6 +58,11 @@ namespace DKFramework
 
 		virtual void Update(double tickDelta, DKFoundation::DKTimeTick tick);
 
+		// set operation queue for parallel update. NULL for serial update. (default)
+		void SetUpdateQueue(DKFoundation::DKOperationQueue* queue);
+		DKFoundation::DKOperationQueue* UpdateQueue(void)				{ return updateQueue; }
+		const DKFoundation::DKOperationQueue* UpdateQueue(void) const	{ return updateQueue; }
+
 		enum : unsigned int
 		{
 			DrawMeshes				= 1,
@@ -101,11 +119,21 @@ namespace DKFramework
 		// picking out nodes to protect between update sequence.
 		void PrepareUpdateNode(void);
 		void CleanupUpdateNode(void);
+		// queue for current update. (valid between PrepareUpdateNode and CleanupUpdateNode)
+		DKFoundation::DKOperationQueue* PendingUpdateQueue(void)	{ return pendingUpdateQueue; }
 
 	private:
 		DKFoundation::DKSpinLock lock;
 
 		DKFoundation::DKArray<DKFoundation::DKObject<DKModel>> updatePendingObjects;
+		DKFoundation::DKArray<DKFoundation::DKObject<DKModel>> serialUpdatePendingObjects;
+		DKFoundation::DKObject<DKFoundation::DKOperationQueue> updateQueue;
+		DKFoundation::DKObject<DKFoundation::DKOperationQueue> pendingUpdateQueue; // queue for current update.
+
+		template <typename T> void UpdatePendingObjects(T&& update);
+
+		struct MeshVolumeTree;
+		MeshVolumeTree* meshVolumes;	// bounding volume hierarchy of meshes
 
 		DKScene(const DKScene&);
 		DKScene& operator = (const DKScene&);
@@ -1876,6 +1876,1270 @@ bool DKSerializer::DeserializeBinary(DKStream* s, DKResourceLoader* p) const
 	return false;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// DKSerializer indexed binary format layout (SerializeFormIndexedBinary)
+//
+// all values are little-endian, all offsets are relative to beginning of
+// serializer data. (nested serializer has own offsets)
+// data is written in single pass, index tables are located at end of data.
+// data can be read in place without copying chunks. (DKFileMap friendly)
+//
+//  HEADER_STRING(fixed) = "DKSerializeI"
+//  Version(uint16), reserved(uint16)
+//
+//  values, data-blobs, nested serializers, embedded resources
+//		blobs and typed arrays are aligned by 16 bytes,
+//		other value-nodes are aligned by 8 bytes.
+//
+//  string table
+//		{offset(uint32), length(uint32)} * numStrings
+//		strings (utf-8, null-terminated)
+//
+//  entity table
+//		{type(uint32), cType(uint32), key(uint32), containerKey(uint32),
+//		 offset(uint64), length(uint64)} * numEntities
+//		type:
+//			'sers'	SerializerEntity (nested indexed serializer)
+//			'extn'	ExternalResource name (filename)
+//			'exts'	regular ExternalResource data
+//		cType:
+//			0		SerializerEntitey, values of ExternalResource(single)
+//			'exta'	ExternalEntityArray
+//			'extm'	ExternalEntityMap
+//		key, containerKey: index of string table
+//
+//  trailer (fixed, end of data)
+//		stringTable(uint64), entityTable(uint64), rootValue(uint64),
+//		length(uint64), numStrings(uint32), numEntities(uint32),
+//		resourceClass(uint32), tag(uint32) = 'idxe'
+//
+// value-node structure
+//		type(uint32) = DKVariant::Type
+//		count(uint32)
+//		payload
+//			TypeUndefined: (none)
+//			TypeInteger, TypeFloat: 8 bytes
+//			TypeVector2 ~ TypeQuaternion: float * count
+//			TypeRational: numerator(int64), denominator(int64)
+//			TypeString: (none) count = index of string table
+//			TypeDateTime: seconds(int64), microseconds(int32), reserved(uint32)
+//			TypeData: offset(uint64), length(uint64) of data-blob
+//			TypeStructData: elementSize(uint64), offset(uint64), length(uint64),
+//							layout(uint8 * count) of data-blob
+//			TypeArray: elementType(uint32), reserved(uint32),
+//					   elements packed (typed array, elementType != 0)
+//					   or offset(uint64) * count (elementType = 0)
+//			TypePairs: {key(uint32), reserved(uint32), offset(uint64)} * count
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#define DKSERIALIZER_INDEXED_VERSION		1
+#define DKSERIALIZER_HEADER_STRING_INDEXED	"DKSerializeI"
+
+namespace DKFramework
+{
+	namespace Private
+	{
+		namespace
+		{
+			enum : uint32_t
+			{
+				IndexedBlobAlignment = 16,
+				IndexedValueAlignment = 8,
+				IndexedHeaderLength = 16,
+				IndexedMaxDepth = 1024,
+				IndexedTrailerTag = 'idxe',
+			};
+			struct IndexedTrailer
+			{
+				uint64_t stringTable;
+				uint64_t entityTable;
+				uint64_t rootValue;		// 0 if not exists.
+				uint64_t length;
+				uint32_t numStrings;
+				uint32_t numEntities;
+				uint32_t resourceClass;
+				uint32_t tag;
+			};
+			struct IndexedEntity
+			{
+				uint32_t type;
+				uint32_t cType;
+				uint32_t key;
+				uint32_t containerKey;
+				uint64_t offset;
+				uint64_t length;
+			};
+			static_assert(sizeof(IndexedTrailer) == 48, "IndexedTrailer should be 48 bytes");
+			static_assert(sizeof(IndexedEntity) == 32, "IndexedEntity should be 32 bytes");
+
+			// size of element, for typed array. (0 for non fixed-size type)
+			size_t IndexedElementSize(DKVariant::Type t)
+			{
+				switch (t)
+				{
+				case DKVariant::TypeInteger:	return sizeof(int64_t);
+				case DKVariant::TypeFloat:		return sizeof(double);
+				case DKVariant::TypeVector2:	return sizeof(float) * 2;
+				case DKVariant::TypeVector3:	return sizeof(float) * 3;
+				case DKVariant::TypeVector4:	return sizeof(float) * 4;
+				case DKVariant::TypeMatrix2:	return sizeof(float) * 4;
+				case DKVariant::TypeMatrix3:	return sizeof(float) * 9;
+				case DKVariant::TypeMatrix4:	return sizeof(float) * 16;
+				case DKVariant::TypeQuaternion:	return sizeof(float) * 4;
+				default:
+					break;
+				}
+				return 0;
+			}
+			size_t IndexedStructElementSize(DKVariant::StructElem e)
+			{
+				switch (e)
+				{
+				case DKVariant::StructElem::Arithmetic1:
+				case DKVariant::StructElem::Bypass1:	return 1;
+				case DKVariant::StructElem::Arithmetic2:
+				case DKVariant::StructElem::Bypass2:	return 2;
+				case DKVariant::StructElem::Arithmetic4:
+				case DKVariant::StructElem::Bypass4:	return 4;
+				case DKVariant::StructElem::Arithmetic8:
+				case DKVariant::StructElem::Bypass8:	return 8;
+				}
+				return 0;
+			}
+#ifdef __BIG_ENDIAN__
+			// swap arithmetic elements of structured data. (big-endian system only)
+			void IndexedSwapStructElements(uint8_t* p, size_t length, size_t elementSize, const DKVariant::StructElem* layout, size_t numLayouts)
+			{
+				for (size_t offset = 0; elementSize > 0 && offset + elementSize <= length; offset += elementSize)
+				{
+					uint8_t* elem = p + offset;
+					for (size_t i = 0; i < numLayouts; ++i)
+					{
+						size_t s = IndexedStructElementSize(layout[i]);
+						if (layout[i] == DKVariant::StructElem::Arithmetic2 ||
+							layout[i] == DKVariant::StructElem::Arithmetic4 ||
+							layout[i] == DKVariant::StructElem::Arithmetic8)
+						{
+							for (size_t k = 0; k < s / 2; ++k)
+							{
+								uint8_t tmp = elem[k];
+								elem[k] = elem[s - k - 1];
+								elem[s - k - 1] = tmp;
+							}
+						}
+						elem += s;
+					}
+				}
+			}
+#endif
+
+			class IndexedWriter
+			{
+			public:
+				enum { BufferSize = 0x4000 };
+
+				IndexedWriter(DKStream* s)
+					: stream(s), position(0), nodeOffset(0), error(false)
+					, buffer(reinterpret_cast<uint8_t*>(DKMemoryDefaultAllocator::Alloc(BufferSize))), bufferedBytes(0)
+				{
+				}
+				~IndexedWriter(void)
+				{
+					DKMemoryDefaultAllocator::Free(buffer);
+				}
+				// small writes are buffered, Flush() should be called before
+				// accessing stream directly.
+				bool Write(const void* p, size_t n)
+				{
+					if (!error && n > 0)
+					{
+						if (bufferedBytes + n > BufferSize)
+						{
+							Flush();
+							if (n >= BufferSize)
+							{
+								if (!error && stream->Write(p, n) != n)
+									error = true;
+								position += n;
+								return !error;
+							}
+						}
+						memcpy(&buffer[bufferedBytes], p, n);
+						bufferedBytes += n;
+						position += n;
+					}
+					return !error;
+				}
+				bool Flush(void)
+				{
+					if (!error && bufferedBytes > 0)
+					{
+						if (stream->Write(buffer, bufferedBytes) != bufferedBytes)
+							error = true;
+					}
+					bufferedBytes = 0;
+					return !error;
+				}
+				template <typename T> bool WriteLE(T v)
+				{
+					v = DKSystemToLittleEndian(v);
+					return Write(&v, sizeof(T));
+				}
+				bool WriteFloats(const float* p, size_t n)
+				{
+#ifdef __LITTLE_ENDIAN__
+					return Write(p, sizeof(float) * n);
+#else
+					for (size_t i = 0; i < n && !error; ++i)
+						WriteLE(reinterpret_cast<const uint32_t*>(p)[i]);
+					return !error;
+#endif
+				}
+				bool Align(size_t a)
+				{
+					static const uint8_t zero[IndexedBlobAlignment] = { 0 };
+					DKASSERT_DEBUG(a <= IndexedBlobAlignment);
+					return Write(zero, static_cast<size_t>((a - (position % a)) % a));
+				}
+				bool WriteNodeHeader(DKVariant::Type type, uint32_t count)
+				{
+					WriteLE(static_cast<uint32_t>(type));
+					return WriteLE(count);
+				}
+				bool WriteBlob(const void* p, size_t n)
+				{
+					Align(IndexedBlobAlignment);
+					return Write(p, n);
+				}
+				uint32_t StringIndex(const DKString& str)
+				{
+					const DKHashMap<DKString, uint32_t>::Pair* p = stringIndices.Find(str);
+					if (p)
+						return p->value;
+					uint32_t index = static_cast<uint32_t>(strings.Count());
+					strings.Add(DKStringU8(str));
+					stringIndices.Insert(str, index);
+					return index;
+				}
+				// write fixed size value. (typed array element or value-node payload)
+				bool WriteFixedValue(const DKVariant& v)
+				{
+					switch (v.ValueType())
+					{
+					case DKVariant::TypeInteger:
+						return WriteLE(static_cast<uint64_t>(v.Integer()));
+					case DKVariant::TypeFloat:
+						if (true)
+						{
+							DKVariant::VFloat f = v.Float();
+							uint64_t u;
+							memcpy(&u, &f, sizeof(u));
+							return WriteLE(u);
+						}
+					case DKVariant::TypeVector2:	return WriteFloats(v.Vector2().val, 2);
+					case DKVariant::TypeVector3:	return WriteFloats(v.Vector3().val, 3);
+					case DKVariant::TypeVector4:	return WriteFloats(v.Vector4().val, 4);
+					case DKVariant::TypeMatrix2:	return WriteFloats(v.Matrix2().val, 4);
+					case DKVariant::TypeMatrix3:	return WriteFloats(v.Matrix3().val, 9);
+					case DKVariant::TypeMatrix4:	return WriteFloats(v.Matrix4().val, 16);
+					case DKVariant::TypeQuaternion:	return WriteFloats(v.Quaternion().val, 4);
+					default:
+						break;
+					}
+					error = true;
+					return false;
+				}
+				// write value-node (children first), returns offset of node. (0 if failed)
+				uint64_t WriteValue(const DKVariant& v)
+				{
+					const DKVariant::Type type = v.ValueType();
+					uint64_t offset = 0;
+					switch (type)
+					{
+					case DKVariant::TypeUndefined:
+						Align(IndexedValueAlignment);
+						offset = position;
+						WriteNodeHeader(type, 0);
+						break;
+					case DKVariant::TypeInteger:
+					case DKVariant::TypeFloat:
+					case DKVariant::TypeVector2:
+					case DKVariant::TypeVector3:
+					case DKVariant::TypeVector4:
+					case DKVariant::TypeMatrix2:
+					case DKVariant::TypeMatrix3:
+					case DKVariant::TypeMatrix4:
+					case DKVariant::TypeQuaternion:
+						Align(IndexedValueAlignment);
+						offset = position;
+						WriteNodeHeader(type, static_cast<uint32_t>(IndexedElementSize(type) / sizeof(float)));
+						WriteFixedValue(v);
+						break;
+					case DKVariant::TypeRational:
+						Align(IndexedValueAlignment);
+						offset = position;
+						WriteNodeHeader(type, 0);
+						WriteLE(static_cast<uint64_t>(v.Rational().Numerator()));
+						WriteLE(static_cast<uint64_t>(v.Rational().Denominator()));
+						break;
+					case DKVariant::TypeString:
+						Align(IndexedValueAlignment);
+						offset = position;
+						WriteNodeHeader(type, StringIndex(v.String()));
+						break;
+					case DKVariant::TypeDateTime:
+						Align(IndexedValueAlignment);
+						offset = position;
+						WriteNodeHeader(type, 0);
+						WriteLE(static_cast<uint64_t>(v.DateTime().SecondsSinceEpoch()));
+						WriteLE(static_cast<uint32_t>(v.DateTime().Microsecond()));
+						WriteLE(static_cast<uint32_t>(0));
+						break;
+					case DKVariant::TypeData:
+						if (true)
+						{
+							const void* p = v.Data().LockShared();
+							uint64_t length = v.Data().Length();
+							WriteBlob(p, length);
+							v.Data().UnlockShared();
+							uint64_t blob = position - length;
+
+							Align(IndexedValueAlignment);
+							offset = position;
+							WriteNodeHeader(type, 0);
+							WriteLE(blob);
+							WriteLE(length);
+						}
+						break;
+					case DKVariant::TypeStructData:
+						if (true)
+						{
+							const DKVariant::VStructuredData& sd = v.StructuredData();
+							const void* p = sd.data.LockShared();
+							uint64_t length = sd.data.Length();
+#ifdef __LITTLE_ENDIAN__
+							WriteBlob(p, length);
+#else
+							DKObject<DKBuffer> tmp = DKBuffer::Create(p, length);
+							uint8_t* p2 = reinterpret_cast<uint8_t*>(tmp->LockExclusive());
+							IndexedSwapStructElements(p2, length, sd.elementSize, sd.layout, sd.layout.Count());
+							WriteBlob(p2, length);
+							tmp->UnlockExclusive();
+#endif
+							sd.data.UnlockShared();
+							uint64_t blob = position - length;
+
+							Align(IndexedValueAlignment);
+							offset = position;
+							WriteNodeHeader(type, static_cast<uint32_t>(sd.layout.Count()));
+							WriteLE(static_cast<uint64_t>(sd.elementSize));
+							WriteLE(blob);
+							WriteLE(length);
+							Write((const DKVariant::StructElem*)sd.layout, sd.layout.Count());
+						}
+						break;
+					case DKVariant::TypeArray:
+						if (true)
+						{
+							const DKVariant::VArray& a = v.Array();
+							if (a.Count() > 0xffffffffU)
+							{
+								error = true;
+								break;
+							}
+							// array of fixed size values can be stored as typed array.
+							DKVariant::Type elementType = a.Count() > 0 ? a.Value(0).ValueType() : DKVariant::TypeUndefined;
+							if (IndexedElementSize(elementType) > 0)
+							{
+								for (const DKVariant& e : a)
+								{
+									if (e.ValueType() != elementType)
+									{
+										elementType = DKVariant::TypeUndefined;
+										break;
+									}
+								}
+							}
+							else
+								elementType = DKVariant::TypeUndefined;
+
+							if (elementType != DKVariant::TypeUndefined)
+							{
+								Align(IndexedBlobAlignment);
+								offset = position;
+								WriteNodeHeader(type, static_cast<uint32_t>(a.Count()));
+								WriteLE(static_cast<uint32_t>(elementType));
+								WriteLE(static_cast<uint32_t>(0));
+								for (size_t i = 0; i < a.Count() && !error; ++i)
+									WriteFixedValue(a.Value(i));
+							}
+							else
+							{
+								DKArray<uint64_t> elements;
+								elements.Reserve(a.Count());
+								for (size_t i = 0; i < a.Count() && !error; ++i)
+									elements.Add(WriteValue(a.Value(i)));
+
+								Align(IndexedValueAlignment);
+								offset = position;
+								WriteNodeHeader(type, static_cast<uint32_t>(a.Count()));
+								WriteLE(static_cast<uint32_t>(0));
+								WriteLE(static_cast<uint32_t>(0));
+								for (size_t i = 0; i < elements.Count() && !error; ++i)
+									WriteLE(elements.Value(i));
+							}
+						}
+						break;
+					case DKVariant::TypePairs:
+						if (true)
+						{
+							struct Element
+							{
+								uint32_t key;
+								uint64_t offset;
+							};
+							const DKVariant::VPairs& pairs = v.Pairs();
+							DKArray<Element> elements;
+							elements.Reserve(pairs.Count());
+							pairs.EnumerateForward([&](const DKVariant::VPairs::Pair& p, bool* stop)
+							{
+								Element e = { StringIndex(p.key), WriteValue(p.value) };
+								elements.Add(e);
+								*stop = error;
+							});
+							WritePairsNode(elements, elements.Count());
+							offset = nodeOffset;
+						}
+						break;
+					default:
+						DKLog("DKSerializer Error: Unknown variant type: 0x%x.\n", type);
+						error = true;
+						break;
+					}
+					return error ? 0 : offset;
+				}
+				// write pairs node with elements which have key, offset.
+				template <typename T> bool WritePairsNode(const T& elements, size_t count)
+				{
+					Align(IndexedValueAlignment);
+					nodeOffset = position;
+					WriteNodeHeader(DKVariant::TypePairs, static_cast<uint32_t>(count));
+					for (size_t i = 0; i < count && !error; ++i)
+					{
+						WriteLE(elements.Value(i).key);
+						WriteLE(static_cast<uint32_t>(0));
+						WriteLE(elements.Value(i).offset);
+					}
+					return !error;
+				}
+				// write string table, returns offset of table.
+				uint64_t WriteStringTable(void)
+				{
+					Align(IndexedValueAlignment);
+					uint64_t offset = position;
+					uint32_t stringOffset = 0;
+					for (size_t i = 0; i < strings.Count() && !error; ++i)
+					{
+						uint32_t length = static_cast<uint32_t>(strings.Value(i).Bytes());
+						WriteLE(stringOffset);
+						WriteLE(length);
+						stringOffset += length + 1;
+					}
+					for (size_t i = 0; i < strings.Count() && !error; ++i)
+					{
+						// write with null-terminator.
+						const DKStringU8& str = strings.Value(i);
+						Write((const char*)str, str.Bytes() + 1);
+					}
+					return offset;
+				}
+
+				DKStream* stream;
+				uint64_t position;
+				uint64_t nodeOffset;
+				bool error;
+				DKArray<DKStringU8> strings;
+				DKHashMap<DKString, uint32_t> stringIndices;
+
+			private:
+				uint8_t* buffer;
+				size_t bufferedBytes;
+			};
+
+			class IndexedReader
+			{
+			public:
+				IndexedReader(const void* p, size_t len)
+					: data(reinterpret_cast<const uint8_t*>(p)), length(len), stringTable(0), numStrings(0)
+				{
+				}
+				// returns pointer of range, NULL if range is invalid.
+				const void* Ptr(uint64_t offset, uint64_t size) const
+				{
+					if (offset <= length && size <= length - offset)
+						return &data[offset];
+					return NULL;
+				}
+				template <typename T> bool Read(uint64_t offset, T& v) const
+				{
+					const void* p = Ptr(offset, sizeof(T));
+					if (p)
+					{
+						memcpy(&v, p, sizeof(T));
+						v = DKLittleEndianToSystem(v);
+						return true;
+					}
+					return false;
+				}
+				bool ReadFloats(uint64_t offset, float* v, size_t n) const
+				{
+					const void* p = Ptr(offset, sizeof(float) * n);
+					if (p)
+					{
+						memcpy(v, p, sizeof(float) * n);
+#ifdef __BIG_ENDIAN__
+						for (size_t i = 0; i < n; ++i)
+							reinterpret_cast<uint32_t*>(v)[i] = DKLittleEndianToSystem(reinterpret_cast<uint32_t*>(v)[i]);
+#endif
+						return true;
+					}
+					return false;
+				}
+				bool ReadTrailer(IndexedTrailer& t) const
+				{
+					if (length < IndexedHeaderLength + sizeof(IndexedTrailer))
+						return false;
+					uint64_t offset = length - sizeof(IndexedTrailer);
+					return Read(offset, t.stringTable) &&
+						Read(offset + 8, t.entityTable) &&
+						Read(offset + 16, t.rootValue) &&
+						Read(offset + 24, t.length) &&
+						Read(offset + 32, t.numStrings) &&
+						Read(offset + 36, t.numEntities) &&
+						Read(offset + 40, t.resourceClass) &&
+						Read(offset + 44, t.tag) &&
+						t.tag == IndexedTrailerTag &&
+						t.length == length;
+				}
+				bool ReadEntity(uint64_t offset, IndexedEntity& e) const
+				{
+					return Read(offset, e.type) &&
+						Read(offset + 4, e.cType) &&
+						Read(offset + 8, e.key) &&
+						Read(offset + 12, e.containerKey) &&
+						Read(offset + 16, e.offset) &&
+						Read(offset + 24, e.length) &&
+						Ptr(e.offset, e.length) != NULL;
+				}
+				bool SetStringTable(uint64_t offset, uint32_t count)
+				{
+					if (Ptr(offset, static_cast<uint64_t>(count) * 8))
+					{
+						stringTable = offset;
+						numStrings = count;
+						return true;
+					}
+					return false;
+				}
+				bool String(uint32_t index, DKString& str) const
+				{
+					uint32_t offset, len;
+					if (index < numStrings &&
+						Read(stringTable + static_cast<uint64_t>(index) * 8, offset) &&
+						Read(stringTable + static_cast<uint64_t>(index) * 8 + 4, len))
+					{
+						const void* p = Ptr(stringTable + static_cast<uint64_t>(numStrings) * 8 + offset, len);
+						if (p)
+						{
+							if (len > 0)
+								str.SetValue(reinterpret_cast<const DKUniChar8*>(p), len);
+							else
+								str = L"";
+							return true;
+						}
+					}
+					return false;
+				}
+				bool ReadFixedValue(uint64_t offset, DKVariant::Type type, DKVariant& v) const
+				{
+					switch (type)
+					{
+					case DKVariant::TypeInteger:
+						if (true)
+						{
+							uint64_t u;
+							if (!Read(offset, u))
+								return false;
+							v.SetInteger(static_cast<DKVariant::VInteger>(u));
+						}
+						return true;
+					case DKVariant::TypeFloat:
+						if (true)
+						{
+							uint64_t u;
+							if (!Read(offset, u))
+								return false;
+							DKVariant::VFloat f;
+							memcpy(&f, &u, sizeof(f));
+							v.SetFloat(f);
+						}
+						return true;
+					case DKVariant::TypeVector2:
+						return ReadFloats(offset, v.SetValueType(type).Vector2().val, 2);
+					case DKVariant::TypeVector3:
+						return ReadFloats(offset, v.SetValueType(type).Vector3().val, 3);
+					case DKVariant::TypeVector4:
+						return ReadFloats(offset, v.SetValueType(type).Vector4().val, 4);
+					case DKVariant::TypeMatrix2:
+						return ReadFloats(offset, v.SetValueType(type).Matrix2().val, 4);
+					case DKVariant::TypeMatrix3:
+						return ReadFloats(offset, v.SetValueType(type).Matrix3().val, 9);
+					case DKVariant::TypeMatrix4:
+						return ReadFloats(offset, v.SetValueType(type).Matrix4().val, 16);
+					case DKVariant::TypeQuaternion:
+						return ReadFloats(offset, v.SetValueType(type).Quaternion().val, 4);
+					default:
+						break;
+					}
+					return false;
+				}
+				bool ReadNodeHeader(uint64_t offset, uint32_t& type, uint32_t& count) const
+				{
+					return Read(offset, type) && Read(offset + 4, count);
+				}
+				bool ReadValue(uint64_t offset, DKVariant& v, uint32_t depth = 0) const
+				{
+					uint32_t type, count;
+					if (depth > IndexedMaxDepth || !ReadNodeHeader(offset, type, count))
+						return false;
+					offset += 8;
+
+					switch (type)
+					{
+					case DKVariant::TypeUndefined:
+						v.SetValueType(DKVariant::TypeUndefined);
+						return true;
+					case DKVariant::TypeInteger:
+					case DKVariant::TypeFloat:
+					case DKVariant::TypeVector2:
+					case DKVariant::TypeVector3:
+					case DKVariant::TypeVector4:
+					case DKVariant::TypeMatrix2:
+					case DKVariant::TypeMatrix3:
+					case DKVariant::TypeMatrix4:
+					case DKVariant::TypeQuaternion:
+						return ReadFixedValue(offset, static_cast<DKVariant::Type>(type), v);
+					case DKVariant::TypeRational:
+						if (true)
+						{
+							uint64_t n, d;
+							if (Read(offset, n) && Read(offset + 8, d))
+							{
+								v.SetRational(DKVariant::VRational(static_cast<int64_t>(n), static_cast<int64_t>(d)));
+								return true;
+							}
+						}
+						break;
+					case DKVariant::TypeString:
+						return String(count, v.SetValueType(DKVariant::TypeString).String());
+					case DKVariant::TypeDateTime:
+						if (true)
+						{
+							uint64_t s;
+							uint32_t us;
+							if (Read(offset, s) && Read(offset + 8, us))
+							{
+								v.SetDateTime(DKDateTime(static_cast<int64_t>(s), static_cast<int32_t>(us)));
+								return true;
+							}
+						}
+						break;
+					case DKVariant::TypeData:
+						if (true)
+						{
+							uint64_t blob, len;
+							if (Read(offset, blob) && Read(offset + 8, len))
+							{
+								const void* p = Ptr(blob, len);
+								if (p)
+								{
+									v.SetData(p, len);
+									return true;
+								}
+							}
+						}
+						break;
+					case DKVariant::TypeStructData:
+						if (true)
+						{
+							uint64_t elementSize, blob, len;
+							if (Read(offset, elementSize) && Read(offset + 8, blob) && Read(offset + 16, len))
+							{
+								const void* p = Ptr(blob, len);
+								const DKVariant::StructElem* layout = reinterpret_cast<const DKVariant::StructElem*>(Ptr(offset + 24, count));
+								if (p && layout)
+								{
+									size_t layoutSize = 0;
+									for (uint32_t i = 0; i < count; ++i)
+									{
+										size_t s = IndexedStructElementSize(layout[i]);
+										if (s == 0)
+											return false;
+										layoutSize += s;
+									}
+									if (layoutSize > elementSize || (elementSize > 0 && len % elementSize))
+										return false;
+
+									DKVariant::VStructuredData& sd = v.SetValueType(DKVariant::TypeStructData).StructuredData();
+									sd.elementSize = elementSize;
+									sd.layout.Clear();
+									sd.layout.Add(layout, count);
+									sd.data.SetContent(p, len);
+#ifdef __BIG_ENDIAN__
+									uint8_t* p2 = reinterpret_cast<uint8_t*>(sd.data.LockExclusive());
+									IndexedSwapStructElements(p2, len, sd.elementSize, sd.layout, sd.layout.Count());
+									sd.data.UnlockExclusive();
+#endif
+									return true;
+								}
+							}
+						}
+						break;
+					case DKVariant::TypeArray:
+						if (true)
+						{
+							uint32_t elementType;
+							if (!Read(offset, elementType))
+								break;
+							offset += 8;
+
+							DKVariant::VArray& a = v.SetValueType(DKVariant::TypeArray).Array();
+							a.Clear();
+							if (elementType != DKVariant::TypeUndefined)
+							{
+								size_t elementSize = IndexedElementSize(static_cast<DKVariant::Type>(elementType));
+								if (elementSize == 0 || Ptr(offset, static_cast<uint64_t>(elementSize) * count) == NULL)
+									break;
+								a.Reserve(count);
+								DKVariant e(static_cast<DKVariant::Type>(elementType));
+								for (uint32_t i = 0; i < count; ++i)
+								{
+									ReadFixedValue(offset, static_cast<DKVariant::Type>(elementType), e);
+									a.Add(e);
+									offset += elementSize;
+								}
+								return true;
+							}
+							else
+							{
+								if (Ptr(offset, static_cast<uint64_t>(count) * 8) == NULL)
+									break;
+								a.Reserve(count);
+								for (uint32_t i = 0; i < count; ++i)
+								{
+									uint64_t elem;
+									Read(offset + static_cast<uint64_t>(i) * 8, elem);
+									a.Add(DKVariant());
+									if (!ReadValue(elem, a.Value(a.Count() - 1), depth + 1))
+										return false;
+								}
+								return true;
+							}
+						}
+						break;
+					case DKVariant::TypePairs:
+						if (Ptr(offset, static_cast<uint64_t>(count) * 16))
+						{
+							DKVariant::VPairs& pairs = v.SetValueType(DKVariant::TypePairs).Pairs();
+							pairs.Clear();
+							DKString key;
+							for (uint32_t i = 0; i < count; ++i)
+							{
+								uint32_t keyIndex;
+								uint64_t elem;
+								Read(offset + static_cast<uint64_t>(i) * 16, keyIndex);
+								Read(offset + static_cast<uint64_t>(i) * 16 + 8, elem);
+								if (!String(keyIndex, key) || !ReadValue(elem, pairs.Value(key), depth + 1))
+									return false;
+							}
+							return true;
+						}
+						break;
+					default:
+						DKLog("DKSerializer Error: Unknown variant type: 0x%x.\n", type);
+						break;
+					}
+					return false;
+				}
+
+				const uint8_t* data;
+				uint64_t length;
+				uint64_t stringTable;
+				uint32_t numStrings;
+			};
+			// returns data from current position to end of stream.
+			DKObject<DKData> IndexedDataFromStream(DKStream* s)
+			{
+				// indexed data should be located at end of stream.
+				DKObject<DKData> data = NULL;
+				DKDataStream* dataStream = DKObject<DKStream>(s).SafeCast<DKDataStream>();
+				if (dataStream && s->IsSeekable() && dataStream->DataSource())
+				{
+					// share source data. (no copy)
+					data = dataStream->DataSource();
+					DKStream::Position pos = s->GetPos();
+					if (pos > 0)
+					{
+						DKObject<DKData> source = data;
+						const char* p = reinterpret_cast<const char*>(source->LockShared());
+						data = DKData::StaticData(p + pos, source->Length() - pos, DKFunction([source]() { source->UnlockShared(); })->Invocation());
+					}
+				}
+				else
+				{
+					data = DKBuffer::Create(s).SafeCast<DKData>();
+				}
+				return data;
+			}
+		}
+	}
+}
+
+using namespace DKFramework::Private;
+
+size_t DKSerializer::SerializeIndexed(DKStream* output, uint64_t* bytesWritten) const
+{
+	if (bytesWritten)
+		*bytesWritten = 0;
+	if (output == NULL || output->IsWritable() == false)
+		return 0;
+
+	// all entities are written into output stream directly. (single pass)
+	// nested serializers and embedded resources are written into same
+	// stream with their own offsets, variants are written without
+	// intermediate buffer.
+
+	struct RootValue
+	{
+		uint32_t key;
+		uint64_t offset;
+	};
+	DKArray<RootValue> rootValues;
+	DKArray<IndexedEntity> entities;
+
+	IndexedWriter writer(output);
+	auto writeSerializer = [&writer](const DKSerializer* s, IndexedEntity& e) -> bool
+	{
+		writer.Align(IndexedBlobAlignment);
+		if (!writer.Flush())
+			return false;
+		e.offset = writer.position;
+		uint64_t wrote = 0;
+		e.length = s->SerializeIndexed(writer.stream, &wrote);
+		writer.position += wrote;	// including failed (partial) data.
+		return e.length > 0;
+	};
+	auto writeExternal = [&](const DKString& key, const DKString& ckey, uint32_t ctype, DKResource* res, ExternalResource ext) -> bool
+	{
+		if (res == NULL)
+			return false;
+
+		IndexedEntity e = { 0, ctype, writer.StringIndex(key), writer.StringIndex(ckey), 0, 0 };
+		DKString resourceName = res->Name();
+		if ((ext == ExternalResourceReferenceIfPossible && resourceName.Length() > 0) || (ext == ExternalResourceForceReference))
+		{
+			// includes filename
+			DKStringU8 filename(resourceName);
+			if (filename.Bytes() == 0)
+				return false;
+			e.type = 'extn';
+			writer.WriteBlob((const char*)filename, filename.Bytes());
+			e.length = filename.Bytes();
+			e.offset = writer.position - e.length;
+		}
+		else
+		{
+			// includes content
+			e.type = 'exts';
+			DKObject<DKSerializer> s = res->Serializer();
+			if (s && s->ResourceClass().Compare(L"DKResource") != 0)
+			{
+				if (!writeSerializer(s, e))
+					return false;
+			}
+			else
+			{
+				DKObject<DKData> data = res->Serialize(SerializeFormIndexedBinary);
+				if (data == NULL || data->Length() == 0)
+					return false;
+				const void* p = data->LockShared();
+				writer.WriteBlob(p, data->Length());
+				e.length = data->Length();
+				e.offset = writer.position - e.length;
+				data->UnlockShared();
+			}
+		}
+		if (writer.error)
+			return false;
+		entities.Add(e);
+		return true;
+	};
+
+	DKCriticalSection<DKSpinLock> guard(this->lock);
+
+	bool serializeSucceed = false;
+
+	if (this->callback)
+		this->callback->Invoke(StateSerializeBegin);
+
+	if (this->resourceClass.Length() > 0)
+	{
+		// writing header (version included)
+		const char header[IndexedHeaderLength] = DKSERIALIZER_HEADER_STRING_INDEXED;
+		writer.Write(header, strlen(DKSERIALIZER_HEADER_STRING_INDEXED));
+		writer.WriteLE(static_cast<uint16_t>(DKSERIALIZER_INDEXED_VERSION));
+		writer.WriteLE(static_cast<uint16_t>(0));
+
+		bool entityError = false;
+		this->entityMap.EnumerateForward([&](const EntityMap::Pair& p, bool* stop)
+		{
+			bool failed = false;
+			const VariantEntity* ve = p.value->Variant();
+			const SerializerEntity* se = p.value->Serializer();
+			const ExternalEntity* ee = p.value->External();
+			const ExternalEntityArray* ea = p.value->ExternalArray();
+			const ExternalEntityMap* em = p.value->ExternalMap();
+			if (ve && ve->getter)
+			{
+				DKVariant v(DKVariant::TypeUndefined);
+				ve->getter->Invoke(v);
+				if (v.ValueType() != DKVariant::TypeUndefined)
+				{
+					RootValue rv = { writer.StringIndex(p.key), writer.WriteValue(v) };
+					rootValues.Add(rv);
+				}
+				else
+					failed = true;
+			}
+			if (se && se->serializer)
+			{
+				IndexedEntity e = { 'sers', 0, writer.StringIndex(p.key), writer.StringIndex(L""), 0, 0 };
+				if (writeSerializer(se->serializer, e))
+					entities.Add(e);
+				else
+					failed = true;
+			}
+			if (ee && ee->getter)
+			{
+				DKObject<DKResource> res = NULL;
+				ee->getter->Invoke(res);
+				if (!writeExternal(p.key, L"", 0, res, ee->external))
+					failed = true;
+			}
+			if (ea && ea->getter)
+			{
+				ExternalArrayType eat;
+				ea->getter->Invoke(eat);
+				for (DKResource* res : eat)
+				{
+					if (res && !writeExternal(L"", p.key, 'exta', res, ea->external))
+						failed = true;
+				}
+			}
+			if (em && em->getter)
+			{
+				ExternalMapType emt;
+				em->getter->Invoke(emt);
+				emt.EnumerateForward([&](ExternalMapType::Pair& pair)
+				{
+					if (pair.value && !writeExternal(pair.key, p.key, 'extm', pair.value, em->external))
+						failed = true;
+				});
+			}
+
+			if (writer.error)
+			{
+				entityError = true;
+			}
+			else if (failed && p.value->faultHandler == NULL)
+			{
+				DKLog("DKSerializer Error: entity(%ls) invalid.\n", (const wchar_t*)p.key);
+				entityError = true;
+			}
+			*stop = entityError;
+		});
+
+		if (!entityError)
+		{
+			IndexedTrailer trailer;
+			trailer.rootValue = 0;
+			if (rootValues.Count() > 0)
+			{
+				writer.WritePairsNode(rootValues, rootValues.Count());
+				trailer.rootValue = writer.nodeOffset;
+			}
+			trailer.resourceClass = writer.StringIndex(this->resourceClass);
+			trailer.numStrings = static_cast<uint32_t>(writer.strings.Count());
+			trailer.stringTable = writer.WriteStringTable();
+
+			writer.Align(IndexedValueAlignment);
+			trailer.entityTable = writer.position;
+			trailer.numEntities = static_cast<uint32_t>(entities.Count());
+			for (const IndexedEntity& e : entities)
+			{
+				writer.WriteLE(e.type);
+				writer.WriteLE(e.cType);
+				writer.WriteLE(e.key);
+				writer.WriteLE(e.containerKey);
+				writer.WriteLE(e.offset);
+				writer.WriteLE(e.length);
+			}
+
+			trailer.length = writer.position + sizeof(IndexedTrailer);
+			trailer.tag = IndexedTrailerTag;
+			writer.WriteLE(trailer.stringTable);
+			writer.WriteLE(trailer.entityTable);
+			writer.WriteLE(trailer.rootValue);
+			writer.WriteLE(trailer.length);
+			writer.WriteLE(trailer.numStrings);
+			writer.WriteLE(trailer.numEntities);
+			writer.WriteLE(trailer.resourceClass);
+			writer.WriteLE(trailer.tag);
+
+			if (!writer.Flush())
+				DKLog("DKSerializer::Serialize failed. (stream write error)\n");
+			else
+				serializeSucceed = true;
+		}
+		else
+		{
+			DKLog("DKSerializer::Serialize failed. (entity error)\n");
+		}
+	}
+	else // resourceClass name error
+	{
+		DKLog("DKSerializer::Serialize failed. (Class-Id invalid)\n");
+	}
+
+	if (this->callback)
+	{
+		if (serializeSucceed)
+			this->callback->Invoke(StateSerializeSucceed);
+		else
+			this->callback->Invoke(StateSerializeFailed);
+	}
+
+	writer.Flush();
+	if (bytesWritten)
+		*bytesWritten = writer.position;
+	return serializeSucceed ? static_cast<size_t>(writer.position) : 0;
+}
+
+bool DKSerializer::DeserializeIndexedOperations(const void* p, size_t length, DKArray<DKObject<DeserializerEntity>>& entities, DKResourceLoader* loader) const
+{
+	if (p == NULL || length < IndexedHeaderLength)
+		return false;
+
+	size_t headerLen = strlen(DKSERIALIZER_HEADER_STRING_INDEXED);
+	if (strncmp(reinterpret_cast<const char*>(p), DKSERIALIZER_HEADER_STRING_INDEXED, headerLen) != 0)
+		return false;
+
+	IndexedReader reader(p, length);
+	uint16_t version;
+	if (!reader.Read(headerLen, version))
+		return false;
+	if (version > DKSERIALIZER_INDEXED_VERSION)
+	{
+		DKLog("DKSerializer::Deserialize failed: wrong binary version: 0x%x.", static_cast<unsigned int>(version));
+		return false;
+	}
+
+	IndexedTrailer trailer;
+	if (!reader.ReadTrailer(trailer) || !reader.SetStringTable(trailer.stringTable, trailer.numStrings) ||
+		reader.Ptr(trailer.entityTable, static_cast<uint64_t>(trailer.numEntities) * sizeof(IndexedEntity)) == NULL)
+	{
+		DKLog("DKSerializer::Deserialize failed: Invalid index.\n");
+		return false;
+	}
+
+	DKString classId = L"";
+	if (!reader.String(trailer.resourceClass, classId))
+		return false;
+
+	DKCriticalSection<DKSpinLock> guard(lock);
+
+	if (this->resourceClass.Compare(classId))
+	{
+		DKLog("DKSerializer::Deserialize failed: ClassId mismatch. (%ls != %ls)\n", (const wchar_t*)this->resourceClass, (const wchar_t*)classId);
+		return false;
+	}
+
+	EntityRestore::Entity restoreEntities;
+
+	// restore variants which are bound only. (unused values are not materialized)
+	if (trailer.rootValue)
+	{
+		uint32_t type, count;
+		if (!reader.ReadNodeHeader(trailer.rootValue, type, count) || type != DKVariant::TypePairs ||
+			reader.Ptr(trailer.rootValue + 8, static_cast<uint64_t>(count) * 16) == NULL)
+		{
+			DKLog("DKSerializer::Deserialize failed: Invalid root value.\n");
+			return false;
+		}
+		DKVariant::VPairs& pairs = restoreEntities.deserializer->rootValue.Pairs();
+		DKString key;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			uint64_t offset = trailer.rootValue + 8 + static_cast<uint64_t>(i) * 16;
+			uint32_t keyIndex;
+			uint64_t value;
+			reader.Read(offset, keyIndex);
+			reader.Read(offset + 8, value);
+			if (!reader.String(keyIndex, key))
+			{
+				DKLog("DKSerializer::Deserialize failed: Invalid string index.\n");
+				return false;
+			}
+			const EntityMap::Pair* ep = this->entityMap.Find(key);
+			if (ep && ep->value->Variant())
+			{
+				if (!reader.ReadValue(value, pairs.Value(key)))
+				{
+					DKLog("DKSerializer::Deserialize failed: Invalid value(%ls).\n", (const wchar_t*)key);
+					return false;
+				}
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < trailer.numEntities; ++i)
+	{
+		IndexedEntity e;
+		DKString key = L"";
+		DKString cKey = L"";
+		if (!reader.ReadEntity(trailer.entityTable + static_cast<uint64_t>(i) * sizeof(IndexedEntity), e) ||
+			!reader.String(e.key, key) || !reader.String(e.containerKey, cKey))
+		{
+			DKLog("DKSerializer::Deserialize failed: Invalid entity.\n");
+			return false;
+		}
+
+		const void* data = reader.Ptr(e.offset, e.length);
+		if (e.type == 'sers')
+		{
+			const EntityMap::Pair* ep = entityMap.Find(key);
+			if (ep)
+			{
+				const SerializerEntity* se = ep->value->Serializer();
+				if (se && se->serializer)
+				{
+					EntityRestore::DeserializerArray de;
+					if (se->serializer->DeserializeIndexedOperations(data, e.length, de, loader))
+						restoreEntities.includes.Insert(key, de);
+				}
+			}
+		}
+		else if (e.type == 'extn' || e.type == 'exts')
+		{
+			DKObject<DKResource> resource = NULL;
+			if (loader)
+			{
+				if (e.type == 'extn')
+				{
+					DKString filename(reinterpret_cast<const char*>(data), e.length);
+					if (filename.Length() > 0)
+						resource = loader->LoadResource(filename);
+				}
+				else
+				{
+					resource = loader->ResourceFromData(DKData::StaticData(data, e.length), key);
+				}
+			}
+			if (resource)
+			{
+				switch (e.cType)
+				{
+				case 0:
+					restoreEntities.deserializer->externals.Insert(key, resource);
+					break;
+				case 'exta':
+					restoreEntities.deserializer->externalArrays.Value(cKey).Add(resource);
+					break;
+				case 'extm':
+					restoreEntities.deserializer->externalMaps.Value(cKey).Update(key, resource);
+					break;
+				}
+			}
+		}
+		else	// unknown type?
+		{
+			DKLog("DKSerializer warning: Unknown type(0x%x) found! (ignored)\n", e.type);
+		}
+	}
+
+	// compare internal type with data that picked out, and generate operations.
+	return EntityRestore().ExtractOperations(this, restoreEntities, entities);
+}
+
+bool DKSerializer::DeserializeIndexed(const DKData* d, DKResourceLoader* p) const
+{
+	DKArray<DKObject<DeserializerEntity>> deserializers;
+
+	const void* ptr = d->LockShared();
+	bool ret = DeserializeIndexedOperations(ptr, d->Length(), deserializers, p);
+	d->UnlockShared();
+
+	if (ret)
+	{
+		for (size_t i = 0; i < deserializers.Count(); ++i)
+		{
+			if (deserializers.Value(i)->callback)
+				deserializers.Value(i)->callback->Invoke(StateDeserializeBegin);
+		}
+
+		for (size_t i = 0; i < deserializers.Count(); ++i)
+		{
+			DeserializerEntity* de = deserializers.Value(i);
+			for (size_t k = 0; k < de->operations.Count(); ++k)
+				de->operations.Value(k)->Perform();
+
+			// clear finished operations.
+			de->operations.Clear();
+			de->rootValue.SetValueType(DKVariant::TypeUndefined);
+		}
+
+		for (size_t i = 0; i < deserializers.Count(); ++i)
+		{
+			if (deserializers.Value(i)->callback)
+				deserializers.Value(i)->callback->Invoke(StateDeserializeSucceed);
+		}
+	}
+	return ret;
+}
+
+bool DKSerializer::DeserializeIndexed(const DKData* d, DKResourceLoader* p, Selector* sel)
+{
+	DKASSERT_DEBUG(d != NULL);
+	DKASSERT_DEBUG(sel != NULL);
+
+	DKObject<DKSerializer> serializer = NULL;
+
+	const void* ptr = d->LockShared();
+	IndexedReader reader(ptr, d->Length());
+	IndexedTrailer trailer;
+	DKString classId = L"";
+	if (reader.ReadTrailer(trailer) && reader.SetStringTable(trailer.stringTable, trailer.numStrings))
+		reader.String(trailer.resourceClass, classId);
+	d->UnlockShared();
+
+	if (classId.Length() > 0)
+		serializer = sel->Invoke(classId);
+	if (serializer)
+		return serializer->DeserializeIndexed(d, p);
+	return false;
+}
+
 bool DKSerializer::Deserialize(DKStream* s, DKResourceLoader* p) const
 {
 	if (s->IsReadable())
@@ -1885,11 +3149,14 @@ bool DKSerializer::Deserialize(DKStream* s, DKResourceLoader* p) const
 		size_t headerLen = strlen(DKSERIALIZER_HEADER_STRING);
 		char name[64];
 		bool validHeader = false;
+		bool indexed = false;
 		if (s->Read(name, headerLen) == headerLen)
 		{
 			if (strncmp(name, DKSERIALIZER_HEADER_STRING_BIG_ENDIAN, headerLen) == 0 ||
 				strncmp(name, DKSERIALIZER_HEADER_STRING_LITTLE_ENDIAN, headerLen) == 0)
 				validHeader = true;
+			else if (strncmp(name, DKSERIALIZER_HEADER_STRING_INDEXED, headerLen) == 0)
+				indexed = true;
 		}
 
 		s->SetPos(pos);
@@ -1897,6 +3164,16 @@ bool DKSerializer::Deserialize(DKStream* s, DKResourceLoader* p) const
 		{
 			return DeserializeBinary(s, p);
 		}
+		else if (indexed)	// format is indexed binary
+		{
+			DKObject<DKData> data = IndexedDataFromStream(s);
+			if (data && DeserializeIndexed(data, p))
+			{
+				s->SetPos(pos + data->Length());
+				return true;
+			}
+			return false;
+		}
 		else // try to open with XMLParser.
 		{
 			DKObject<DKXMLDocument> doc = DKXMLDocument::Open(DKXMLDocument::TypeXML, s);
@@ -1916,15 +3193,22 @@ bool DKSerializer::Deserialize(const DKData* d, DKResourceLoader* p) const
 		size_t len = d->Length();
 		size_t headerLen = strlen(DKSERIALIZER_HEADER_STRING);
 		bool validHeader = false;
+		bool indexed = false;
 		if (len >= headerLen)
 		{
 			if (strncmp(ptr, DKSERIALIZER_HEADER_STRING_BIG_ENDIAN, headerLen) == 0 ||
 				strncmp(ptr, DKSERIALIZER_HEADER_STRING_LITTLE_ENDIAN, headerLen) == 0)
 				validHeader = true;
+			else if (strncmp(ptr, DKSERIALIZER_HEADER_STRING_INDEXED, headerLen) == 0)
+				indexed = true;
 		}
 		d->UnlockShared();
 
-		if (validHeader)		// format is binary
+		if (indexed)		// format is indexed binary (read in place)
+		{
+			return DeserializeIndexed(d, p);
+		}
+		else if (validHeader)		// format is binary
 		{
 			const void* ptr = d->LockShared();
 			DKObject<DKData> data = DKData::StaticData(ptr, d->Length());
@@ -2054,10 +3338,12 @@ bool DKSerializer::RestoreObject(DKStream* s, DKResourceLoader* p, Selector* sel
 		size_t headerLen = strlen(DKSERIALIZER_HEADER_STRING);
 		char name[64];
 		bool validHeader = false;
+		bool indexed = false;
 		if (s->Read(name, headerLen) == headerLen)
 		{
 			validHeader = (strncmp(name, DKSERIALIZER_HEADER_STRING_BIG_ENDIAN, headerLen) == 0 ||
 						   strncmp(name, DKSERIALIZER_HEADER_STRING_LITTLE_ENDIAN, headerLen) == 0);
+			indexed = strncmp(name, DKSERIALIZER_HEADER_STRING_INDEXED, headerLen) == 0;
 		}
 
 		s->SetPos(pos);
@@ -2065,6 +3351,16 @@ bool DKSerializer::RestoreObject(DKStream* s, DKResourceLoader* p, Selector* sel
 		{
 			return DeserializeBinary(s, p, sel);
 		}
+		else if (indexed)	// format is indexed binary
+		{
+			DKObject<DKData> data = IndexedDataFromStream(s);
+			if (data && DeserializeIndexed(data, p, sel))
+			{
+				s->SetPos(pos + data->Length());
+				return true;
+			}
+			return false;
+		}
 		else
 		{
 			DKObject<DKXMLDocument> doc = DKXMLDocument::Open(DKXMLDocument::TypeXML, s);
@@ -2084,15 +3380,21 @@ bool DKSerializer::RestoreObject(const DKData* d, DKResourceLoader* p, Selector*
 		size_t len = d->Length();
 		size_t headerLen = strlen(DKSERIALIZER_HEADER_STRING);
 		bool validHeader = false;
+		bool indexed = false;
 		DKString classId = L"";
 		if (len >= headerLen)
 		{
 			validHeader = (strncmp(ptr, DKSERIALIZER_HEADER_STRING_BIG_ENDIAN, headerLen) == 0 ||
 						   strncmp(ptr, DKSERIALIZER_HEADER_STRING_LITTLE_ENDIAN, headerLen) == 0);
+			indexed = strncmp(ptr, DKSERIALIZER_HEADER_STRING_INDEXED, headerLen) == 0;
 		}
 		d->UnlockShared();
 
-		if (validHeader)
+		if (indexed)
+		{
+			return DeserializeIndexed(d, p, sel);
+		}
+		else if (validHeader)
 		{
 			const void* ptr2 = d->LockShared();
 			DKObject<DKData> data = DKData::StaticData(ptr2, d->Length());
@@ -2125,6 +3427,9 @@ size_t DKSerializer::Serialize(SerializeForm sf, DKFoundation::DKStream* output)
 	case SerializeFormCompressedBinary:
 		s = this->SerializeBinary(sf, output);
 		break;
+	case SerializeFormIndexedBinary:
+		s = this->SerializeIndexed(output, NULL);
+		break;
 	}
 	return s;
 }
@@ -2156,6 +3461,16 @@ DKObject<DKData> DKSerializer::Serialize(SerializeForm sf) const
 			}
 		}
 		break;
+	case SerializeFormIndexedBinary:
+		if (true)
+		{
+			DKBufferStream stream;
+			if (this->SerializeIndexed(&stream, NULL) > 0)
+			{
+				data = stream.DataSource();
+			}
+		}
+		break;
 	}
 	return data;
 }
@@ -87,12 +87,17 @@ namespace DKFramework
 		//     uncompressed binary format. (faster loading)
 		// - SerializeFormCompressedBinary:
 		//     compressed binary format. (smallest, faster than xml)
+		// - SerializeFormIndexedBinary:
+		//     indexed little-endian binary format, written in single pass.
+		//     can be read in place from DKData (DKFileMap) without copying
+		//     chunks. (fastest loading, uncompressed)
 		enum SerializeForm : int
 		{
 			SerializeFormXML				= '_XML',
 			SerializeFormBinXML				= 'bXML',
 			SerializeFormBinary				= '_BIN',
 			SerializeFormCompressedBinary	= 'cBIN',
+			SerializeFormIndexedBinary		= 'iBIN',
 		};
 		// serialize/deserialize callback state
 		enum State
@@ -249,6 +254,10 @@ namespace DKFramework
 		size_t SerializeBinary(SerializeForm sf, DKFoundation::DKStream* output) const;
 		bool DeserializeBinary(DKFoundation::DKStream* s, DKResourceLoader* p) const;
 		static bool DeserializeBinary(DKFoundation::DKStream* s, DKResourceLoader* p, Selector* sel);
+		bool DeserializeIndexedOperations(const void* p, size_t length, DKFoundation::DKArray<DKFoundation::DKObject<DeserializerEntity>>& entities, DKResourceLoader* pool) const;
+		size_t SerializeIndexed(DKFoundation::DKStream* output, uint64_t* bytesWritten) const;
+		bool DeserializeIndexed(const DKFoundation::DKData* d, DKResourceLoader* p) const;
+		static bool DeserializeIndexed(const DKFoundation::DKData* d, DKResourceLoader* p, Selector* sel);
 		
 		// copy constructor not allowed.
 		DKSerializer(const DKSerializer&);
@@ -296,3 +296,22 @@ int DKShaderProgram::GetAttribComponents(const DKFoundation::DKString& name) con
 	}
 	return 0;
 }
+
+bool DKShaderProgram::UpdateUniformValue(size_t index, const void* value, size_t size) const
+{
+	DKASSERT_DEBUG(index < uniforms.Count());
+
+	if (uniformValues.Count() != uniforms.Count())
+	{
+		uniformValues.Clear();
+		uniformValues.Resize(uniforms.Count());
+	}
+
+	DKArray<unsigned char>& last = uniformValues.Value(index);
+	if (last.Count() == size && memcmp((const unsigned char*)last, value, size) == 0)
+		return false;
+
+	last.Clear();
+	last.Add(reinterpret_cast<const unsigned char*>(value), size);
+	return true;
+}
@@ -21,6 +21,8 @@
 // You can inspect Uniforms (with Samplers), Attributes values.
 // If you set value to uniforms or attributes, the value will be retained
 // utill program object being destroyed.
+// Program object keeps last value of each uniform, uploading same value
+// can be skipped. (see UpdateUniformValue)
 //
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -49,7 +51,13 @@ namespace DKFramework
 		int	GetUniformComponents(const DKFoundation::DKString& name) const;
 		int GetAttribComponents(const DKFoundation::DKString& name) const;
 
+		// compare value with last value of uniform (index of uniforms),
+		// and store value. returns false if value has not been changed.
+		// caller should upload value to program when returns true.
+		bool UpdateUniformValue(size_t index, const void* value, size_t size) const;
+
 	private:
 		unsigned int programId;
+		mutable DKFoundation::DKArray<DKFoundation::DKArray<unsigned char>> uniformValues;
 	};
 }
@@ -8,9 +8,12 @@
 #include "DKMath.h"
 #include "DKSphere.h"
 #include "DKLine.h"
+#include "DKMatrix4.h"
+#include "Private/SimdMath.h"
 
 using namespace DKFoundation;
 using namespace DKFramework;
+using namespace DKFramework::Private;
 
 DKSphere::DKSphere(void)
 : center(DKVector3(0,0,0))
@@ -73,6 +76,24 @@ DKSphere DKSphere::Intersection(const DKSphere&s1, const DKSphere& s2)
 	return DKSphere();
 }
 
+void DKSphere::Transform(const DKSphere* input, const DKMatrix4& m, DKSphere* output, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		SimdVector3Transform(input[i].center.val, m.val, output[i].center.val);
+		output[i].radius = input[i].radius;
+	}
+}
+
+void DKSphere::Transform(const DKSphere* input, const DKMatrix4* matrices, DKSphere* output, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		SimdVector3Transform(input[i].center.val, matrices[i].val, output[i].center.val);
+		output[i].radius = input[i].radius;
+	}
+}
+
 bool DKSphere::IsValid(void) const
 {
 	return radius >= 0;
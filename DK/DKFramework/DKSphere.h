@@ -18,6 +18,7 @@
 namespace DKFramework
 {
 	class DKLine;
+	class DKMatrix4;
 	class DKGL_API DKSphere
 	{
 	public:
@@ -29,6 +30,11 @@ namespace DKFramework
 		// smaller sphere, intersection between s1, s2.
 		static DKSphere Intersection(const DKSphere&s1, const DKSphere&s2);
 
+		// batch transform of center, radius is not changed.
+		// (output can be same as input)
+		static void Transform(const DKSphere* input, const DKMatrix4& m, DKSphere* output, size_t count);
+		static void Transform(const DKSphere* input, const DKMatrix4* matrices, DKSphere* output, size_t count);
+
 		bool IsValid(void) const;
 		bool IsPointInside(const DKVector3& pos) const;
 		float Volume(void) const;
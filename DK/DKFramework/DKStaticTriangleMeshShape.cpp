@@ -8,6 +8,34 @@
 #include "Private/BulletUtils.h"
 #include "DKStaticTriangleMeshShape.h"
 
+namespace DKFramework
+{
+	namespace Private
+	{
+		namespace
+		{
+			// header of serialized BVH data, btOptimizedBvh follows header.
+			struct SerializedBvhHeader
+			{
+				char tag[4];			// "DKBV"
+				uint32_t byteOrder;		// 0x01020304 (native)
+				uint16_t version;
+				uint8_t pointerSize;
+				uint8_t scalarSize;
+				uint32_t bvhSize;		// size of serialized btOptimizedBvh
+				uint32_t meshHash;		// CRC32 of mesh content
+				uint32_t numTriangles;
+				uint32_t reserved[2];
+			};
+			static_assert(sizeof(SerializedBvhHeader) == 32, "header size must be 32 (alignment of bvh)");
+
+			const char serializedBvhTag[4] = {'D', 'K', 'B', 'V'};
+			const uint16_t serializedBvhVersion = 1;
+			const uint32_t serializedBvhByteOrder = 0x01020304;
+		}
+	}
+}
+
 using namespace DKFoundation;
 using namespace DKFramework;
 using namespace DKFramework::Private;
@@ -22,8 +50,17 @@ public:
 	size_t numIndices;
 	PHY_ScalarType indexType;
 
+	// restored BVH. (not built)
+	btOptimizedBvh* bvh;
+	void* bvhBuffer;				// copied data
+
 	~IndexedTriangleData(void)
 	{
+		if (bvh)
+			bvh->~btOptimizedBvh();
+		if (bvhBuffer)
+			btAlignedFree(bvhBuffer);
+
 		if (vertices)
 			free(vertices);
 		if (indices)
@@ -35,12 +72,15 @@ public:
 						size_t numVertices,
 						const IndexType* indices,
 						size_t numIndices,
-						const DKAabb& aabb)
+						const DKAabb& aabb,
+						DKData* serializedBvh = NULL)
 		: vertices(NULL)
 		, numVertices(0)
 		, indices(NULL)
 		, numIndices(0)
 		, indexType(PHY_INTEGER)
+		, bvh(NULL)
+		, bvhBuffer(NULL)
 		, aabbMin(BulletVector3(aabb.positionMin))
 		, aabbMax(BulletVector3(aabb.positionMax))
 	{
@@ -78,6 +118,112 @@ public:
 
 		if (this->aabbMax.x() < this->aabbMin.x() || this->aabbMax.y() < this->aabbMin.y() || this->aabbMax.z() < this->aabbMin.z())
 			this->calculateAabbBruteForce(this->aabbMin, this->aabbMax);
+
+		if (serializedBvh)
+			RestoreBvh(serializedBvh);
+	}
+
+	size_t IndexSize(void) const
+	{
+		return (this->indexType == PHY_INTEGER) ? sizeof(unsigned int) : sizeof(unsigned short);
+	}
+
+	// hash of mesh content, BVH depends on vertices, indices and aabb.
+	uint32_t ContentHash(void) const
+	{
+		DKVector3 aabb[2] = { BulletVector3(this->aabbMin), BulletVector3(this->aabbMax) };
+		uint32_t idxSize = (uint32_t)IndexSize();
+
+		DKHash32 hash;
+		hash.Initialize();
+		hash.Update(this->vertices, this->numVertices * sizeof(DKVector3));
+		hash.Update(this->indices, this->numIndices * idxSize);
+		hash.Update(&idxSize, sizeof(idxSize));
+		hash.Update(aabb, sizeof(aabb));
+		hash.Finalize();
+		return hash.Result().digest[0];
+	}
+
+	bool IsValidBvhHeader(const SerializedBvhHeader* header, size_t length) const
+	{
+		return length >= sizeof(SerializedBvhHeader) &&
+			memcmp(header->tag, serializedBvhTag, sizeof(serializedBvhTag)) == 0 &&
+			header->byteOrder == serializedBvhByteOrder &&
+			header->version == serializedBvhVersion &&
+			header->pointerSize == sizeof(void*) &&
+			header->scalarSize == sizeof(btScalar) &&
+			header->bvhSize >= sizeof(btOptimizedBvh) &&
+			header->bvhSize <= length - sizeof(SerializedBvhHeader) &&
+			header->numTriangles == (uint32_t)this->numTriangles &&
+			header->meshHash == ContentHash();
+	}
+
+	bool RestoreBvh(DKData* data)
+	{
+		DKASSERT_DEBUG(this->bvh == NULL);
+		if (this->numTriangles == 0)
+			return false;
+
+		const size_t length = data->Length();
+		uint32_t bvhSize = 0;
+
+		const SerializedBvhHeader* header = reinterpret_cast<const SerializedBvhHeader*>(data->LockShared());
+		if (header && IsValidBvhHeader(header, length))
+			bvhSize = header->bvhSize;
+		data->UnlockShared();
+
+		if (bvhSize == 0)
+		{
+			DKLog("DKStaticTriangleMeshShape: serialized BVH does not match, rebuild BVH.\n");
+			return false;
+		}
+
+		// copy to aligned buffer, deserializing rewrites pointers of buffer.
+		// (data can be mapped file of caller, should not be modified)
+		this->bvhBuffer = btAlignedAlloc(bvhSize, 16);
+		const unsigned char* p = reinterpret_cast<const unsigned char*>(data->LockShared());
+		memcpy(this->bvhBuffer, p + sizeof(SerializedBvhHeader), bvhSize);
+		data->UnlockShared();
+
+		this->bvh = btOptimizedBvh::deSerializeInPlace(this->bvhBuffer, bvhSize, false);
+		if (this->bvh == NULL)
+		{
+			btAlignedFree(this->bvhBuffer);
+			this->bvhBuffer = NULL;
+			return false;
+		}
+		return true;
+	}
+
+	template <typename IndexType>
+	bool IsEqualContent(const DKVector3* verts, size_t numVerts, const IndexType* idx, size_t numIdx) const
+	{
+		if (numIdx % 3)
+			numIdx -= numIdx % 3;
+		if (numVerts != this->numVertices || numIdx != this->numIndices)
+			return false;
+		if (numVerts > 0 && memcmp(verts, this->vertices, numVerts * sizeof(DKVector3)) != 0)
+			return false;
+
+		if (this->indexType == PHY_INTEGER)
+		{
+			const unsigned int* p = reinterpret_cast<const unsigned int*>(this->indices);
+			for (size_t i = 0; i < numIdx; ++i)
+			{
+				if (p[i] != idx[i])
+					return false;
+			}
+		}
+		else
+		{
+			const unsigned short* p = reinterpret_cast<const unsigned short*>(this->indices);
+			for (size_t i = 0; i < numIdx; ++i)
+			{
+				if (p[i] != idx[i])
+					return false;
+			}
+		}
+		return true;
 	}
 
 	// override from btStridingMeshInterface
@@ -145,10 +291,30 @@ DKStaticTriangleMeshShape::DKStaticTriangleMeshShape(
 {
 }
 
+DKStaticTriangleMeshShape::DKStaticTriangleMeshShape(
+	const DKVector3* verts, size_t numVertices,
+	const unsigned int* indices, size_t numIndices,
+	DKData* bvhData,
+	const DKAabb& precalculatedAabb)
+	: DKStaticTriangleMeshShape(new IndexedTriangleData(verts, numVertices, indices, numIndices, precalculatedAabb, bvhData))
+{
+}
+
+DKStaticTriangleMeshShape::DKStaticTriangleMeshShape(
+	const DKVector3* verts, size_t numVertices,
+	const unsigned short* indices, size_t numIndices,
+	DKData* bvhData,
+	const DKAabb& precalculatedAabb)
+	: DKStaticTriangleMeshShape(new IndexedTriangleData(verts, numVertices, indices, numIndices, precalculatedAabb, bvhData))
+{
+}
+
 DKStaticTriangleMeshShape::DKStaticTriangleMeshShape(IndexedTriangleData* data)
-	: DKConcaveShape(ShapeType::StaticTriangleMesh, new btBvhTriangleMeshShape(data, true, true))
+	: DKConcaveShape(ShapeType::StaticTriangleMesh, new btBvhTriangleMeshShape(data, true, data->bvh == NULL))
 	, meshData(data)
 {
+	if (data->bvh)
+		static_cast<btBvhTriangleMeshShape*>(this->impl)->setOptimizedBvh(data->bvh);
 }
 
 DKStaticTriangleMeshShape::~DKStaticTriangleMeshShape(void)
@@ -168,7 +334,7 @@ size_t DKStaticTriangleMeshShape::NumberOfIndices(void) const
 
 size_t DKStaticTriangleMeshShape::IndexSize(void) const
 {
-	return (this->meshData->indexType == PHY_INTEGER) ? 4 : 2;
+	return this->meshData->IndexSize();
 }
 
 size_t DKStaticTriangleMeshShape::NumberOfTriangles(void) const
@@ -218,3 +384,53 @@ const void* DKStaticTriangleMeshShape::IndexData(void) const
 {
 	return this->meshData->indices;
 }
+
+DKObject<DKData> DKStaticTriangleMeshShape::SerializeBvh(void) const
+{
+	btOptimizedBvh* bvh = static_cast<btBvhTriangleMeshShape*>(this->impl)->getOptimizedBvh();
+	if (bvh)
+	{
+		unsigned int bvhSize = bvh->calculateSerializeBufferSize();
+
+		// serialize into aligned buffer, and copy to output.
+		void* bvhBuffer = btAlignedAlloc(bvhSize, 16);
+		bool result = bvh->serializeInPlace(bvhBuffer, bvhSize, false);
+		DKObject<DKBuffer> output = NULL;
+		if (result)
+		{
+			SerializedBvhHeader header = {};
+			memcpy(header.tag, serializedBvhTag, sizeof(serializedBvhTag));
+			header.byteOrder = serializedBvhByteOrder;
+			header.version = serializedBvhVersion;
+			header.pointerSize = sizeof(void*);
+			header.scalarSize = sizeof(btScalar);
+			header.bvhSize = bvhSize;
+			header.meshHash = this->meshData->ContentHash();
+			header.numTriangles = (uint32_t)this->meshData->numTriangles;
+
+			output = DKBuffer::Create(NULL, sizeof(SerializedBvhHeader) + bvhSize);
+			unsigned char* p = reinterpret_cast<unsigned char*>(output->LockExclusive());
+			memcpy(p, &header, sizeof(SerializedBvhHeader));
+			memcpy(p + sizeof(SerializedBvhHeader), bvhBuffer, bvhSize);
+			output->UnlockExclusive();
+		}
+		btAlignedFree(bvhBuffer);
+		return output.SafeCast<DKData>();
+	}
+	return NULL;
+}
+
+bool DKStaticTriangleMeshShape::IsBvhRestored(void) const
+{
+	return this->meshData->bvh != NULL;
+}
+
+bool DKStaticTriangleMeshShape::IsEqualContent(const DKVector3* vertices, size_t numVertices, const unsigned int* indices, size_t numIndices) const
+{
+	return this->meshData->IsEqualContent(vertices, numVertices, indices, numIndices);
+}
+
+bool DKStaticTriangleMeshShape::IsEqualContent(const DKVector3* vertices, size_t numVertices, const unsigned short* indices, size_t numIndices) const
+{
+	return this->meshData->IsEqualContent(vertices, numVertices, indices, numIndices);
+}
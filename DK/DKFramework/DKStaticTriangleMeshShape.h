@@ -9,6 +9,8 @@
 #include "../DKInclude.h"
 #include "../DKFoundation.h"
 #include "DKConcaveShape.h"
+#include "DKTriangle.h"
+#include "DKAabb.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 // DKStaticTriangleMeshShape
@@ -18,6 +20,11 @@
 // (see DKConvexHullShape.h)
 // If you need collision shape for dynamic triangle mesh,
 // use DKTriangleMeshProxyShape class.
+//
+// Optimized BVH of shape can be serialized with SerializeBvh(), and can be
+// restored without rebuild by passing data to constructor.
+// BVH is copied from data, data is not modified and not retained.
+// BVH is rebuilt if data does not match with mesh. (mesh content, platform)
 ////////////////////////////////////////////////////////////////////////////////
 
 namespace DKFramework
@@ -35,6 +42,19 @@ namespace DKFramework
 								  const unsigned short* indices,
 								  size_t numIndices,
 								  const DKAabb& precalculatedAabb = DKAabb());
+		// restore BVH from bvhData. (serialized with SerializeBvh)
+		DKStaticTriangleMeshShape(const DKVector3* vertices,
+								  size_t numVertices,
+								  const unsigned int* indices,
+								  size_t numIndices,
+								  DKFoundation::DKData* bvhData,
+								  const DKAabb& precalculatedAabb = DKAabb());
+		DKStaticTriangleMeshShape(const DKVector3* vertices,
+								  size_t numVertices,
+								  const unsigned short* indices,
+								  size_t numIndices,
+								  DKFoundation::DKData* bvhData,
+								  const DKAabb& precalculatedAabb = DKAabb());
 
 		~DKStaticTriangleMeshShape(void);
 
@@ -52,6 +72,15 @@ namespace DKFramework
 		const DKVector3* VertexData(void) const;
 		const void* IndexData(void) const;
 
+		// serialize optimized BVH. (platform dependent)
+		DKFoundation::DKObject<DKFoundation::DKData> SerializeBvh(void) const;
+		// true if BVH was restored from data. (not built)
+		bool IsBvhRestored(void) const;
+
+		// compare mesh content. (index type can be different)
+		bool IsEqualContent(const DKVector3* vertices, size_t numVertices, const unsigned int* indices, size_t numIndices) const;
+		bool IsEqualContent(const DKVector3* vertices, size_t numVertices, const unsigned short* indices, size_t numIndices) const;
+
 	private:
 		class IndexedTriangleData;
 		DKStaticTriangleMeshShape(IndexedTriangleData*);
@@ -8,10 +8,50 @@
 #include "DKMath.h"
 #include "DKTriangleMeshBvh.h"
 
+namespace DKFramework
+{
+	namespace Private
+	{
+		namespace
+		{
+			// ray-triangle intersection (Moller-Trumbore, both faces)
+			// ray = begin + dir * t, returns t (0 <= t <= 1) or negative value if not hit.
+			inline float RayTriangleFraction(const DKVector3& begin, const DKVector3& dir, float epsilon, const DKTriangle& tri)
+			{
+				DKVector3 edge1 = tri.position2 - tri.position1;
+				DKVector3 edge2 = tri.position3 - tri.position1;
+				DKVector3 p = DKVector3::Cross(dir, edge2);
+				float det = DKVector3::Dot(edge1, p);
+
+				if (det > -epsilon && det < epsilon)
+					return -1.0f;
+
+				float invDet = 1.0f / det;
+
+				DKVector3 s = begin - tri.position1;
+				float u = DKVector3::Dot(s, p) * invDet;
+				if (u < 0.0f || u > 1.0f)
+					return -1.0f;
+
+				DKVector3 q = DKVector3::Cross(s, edge1);
+				float v = DKVector3::Dot(dir, q) * invDet;
+				if (v < 0.0f || u + v > 1.0f)
+					return -1.0f;
+
+				float t = DKVector3::Dot(edge2, q) * invDet;
+				if (t < 0.0f || t > 1.0f)
+					return -1.0f;
+				return t;
+			}
+		}
+	}
+}
+
 using namespace DKFoundation;
 using namespace DKFramework;
+using namespace DKFramework::Private;
 
-DKTriangleMeshBvh::DKTriangleMeshBvh(void) : mesh(NULL)
+DKTriangleMeshBvh::DKTriangleMeshBvh(void) : mesh(NULL), immutable(false)
 {
 }
 
@@ -24,7 +64,7 @@ DKAabb DKTriangleMeshBvh::Aabb(void) const
 	return bvh.Aabb();
 }
 
-void DKTriangleMeshBvh::Build(DKTriangleMesh* m)
+void DKTriangleMeshBvh::Build(DKTriangleMesh* m, DKBvh::BuildMode mode, DKOperationQueue* queue)
 {
 	struct TriangleAabb : public DKBvh::VolumeInterface
 	{
@@ -52,53 +92,129 @@ void DKTriangleMeshBvh::Build(DKTriangleMesh* m)
 	DKObject<TriangleAabb> vol = DKOBJECT_NEW TriangleAabb();
 	this->mesh = m;
 	vol->mesh = this->mesh;
-	bvh.Build(vol.SafeCast<DKBvh::VolumeInterface>());
+	bvh.Build(vol.SafeCast<DKBvh::VolumeInterface>(), mode, queue);
 }
 
-void DKTriangleMeshBvh::Rebuild(void)
+void DKTriangleMeshBvh::Rebuild(DKOperationQueue* queue)
 {
-	bvh.Rebuild();
+	bvh.Rebuild(queue);
+}
+
+bool DKTriangleMeshBvh::Refit(void)
+{
+	return bvh.Refit();
+}
+
+void DKTriangleMeshBvh::LockMesh(void) const
+{
+	if (!this->immutable)
+		const_cast<DKTriangleMeshBvh*>(this)->mesh->Lock();
+}
+
+void DKTriangleMeshBvh::UnlockMesh(void) const
+{
+	if (!this->immutable)
+		const_cast<DKTriangleMeshBvh*>(this)->mesh->Unlock();
 }
 
 bool DKTriangleMeshBvh::RayTest(const DKLine& ray, DKVector3* hitPoint) const
 {
 	if (this->mesh)
 	{
+		if (hitPoint)
+		{
+			RayHitResult result;
+			if (RayTestClosest(ray, &result))
+			{
+				*hitPoint = result.hitPoint;
+				return true;
+			}
+			return false;
+		}
+
+		// any hit.
 		bool hit = false;
-		bool queryClosestHitPoint = hitPoint != NULL;
-		float closestHitFraction = FLT_MAX;
 		DKTriangle tri;
-		DKVector3 tmp;
-
 		auto triangleRayTest = [&](int index, const DKLine& ray)->bool
 		{
 			if (this->mesh->GetTriangleAtIndex(index, tri))
 			{
-				if (tri.RayTest(ray, &tmp))
+				if (tri.RayTest(ray))
 				{
 					hit = true;
-					if (queryClosestHitPoint)
-					{
-						float f = (tmp - ray.begin).LengthSq();
-						if (closestHitFraction > f)
-							closestHitFraction = f;
-					}
-					return queryClosestHitPoint;
+					return false;
 				}
 			}
 			return true;
 		};
 
-		const_cast<DKTriangleMeshBvh*>(this)->mesh->Lock();
+		LockMesh();
 		this->bvh.RayTest(ray, DKFunction(triangleRayTest));
-		const_cast<DKTriangleMeshBvh*>(this)->mesh->Unlock();
+		UnlockMesh();
+
+		return hit;
+	}
+	return false;
+}
 
-		if (hit)	// set by triangleRayTest()
+bool DKTriangleMeshBvh::RayTestClosest(const DKLine& ray, RayHitResult* result) const
+{
+	RayHitResult r;
+	if (result == NULL)
+		result = &r;
+	return RayTest(&ray, 1, result) > 0;
+}
+
+size_t DKTriangleMeshBvh::RayTest(const DKLine* rays, size_t count, RayHitResult* results) const
+{
+	if (this->mesh && rays && results && count > 0)
+	{
+		LockMesh();
+		size_t numHits = RayTestInternal(rays, count, results);
+		UnlockMesh();
+		return numHits;
+	}
+	for (size_t i = 0; i < count && results; ++i)
+		results[i].triangleIndex = -1;
+	return 0;
+}
+
+size_t DKTriangleMeshBvh::RayTestInternal(const DKLine* rays, size_t count, RayHitResult* results) const
+{
+	DKVector3 rayBegin, rayDir;
+	float epsilon = 0.0f;
+	DKTriangle tri;
+
+	// one callback object for all rays.
+	auto triangleRayTest = DKFunction([&](int index, const DKLine&, float)->float
+	{
+		if (this->mesh->GetTriangleAtIndex(index, tri))
+			return RayTriangleFraction(rayBegin, rayDir, epsilon, tri);
+		return -1.0f;
+	});
+
+	size_t numHits = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const DKLine& ray = rays[i];
+		RayHitResult& result = results[i];
+
+		rayBegin = ray.begin;
+		rayDir = ray.end - ray.begin;
+		epsilon = 0.000001f * rayDir.Length();	// det is scaled by ray length.
+
+		float fraction = 0.0f;
+		result.triangleIndex = this->bvh.RayTestClosest(ray, triangleRayTest, &fraction);
+		if (result.triangleIndex >= 0)
 		{
-			if (hitPoint)
-				*hitPoint = ray.begin + ray.Direction() * sqrt(closestHitFraction);
-			return true;
+			result.hitFraction = fraction;
+			result.hitPoint = rayBegin + rayDir * fraction;
+			if (this->mesh->GetTriangleAtIndex(result.triangleIndex, tri))
+				result.hitNormal = DKVector3::Cross(tri.position2 - tri.position1, tri.position3 - tri.position1).Normalize();
+			else
+				result.hitNormal = DKVector3(0, 0, 0);
+			numHits++;
 		}
 	}
-	return false;
+	return numHits;
 }
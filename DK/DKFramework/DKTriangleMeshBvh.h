@@ -18,6 +18,12 @@
 ////////////////////////////////////////////////////////////////////////////////
 // DKTriangleMeshBvh
 // a triangle mesh class, using BVH tree internally
+//
+// RayTestClosest() and batch RayTest() visit nodes front-to-back and return
+// closest hit with triangle index, hit fraction, position and normal.
+// batch RayTest() locks mesh once for all rays.
+// If mesh is immutable (SetImmutable), mesh is not locked while ray-test,
+// queries can be run from multiple threads concurrently.
 ////////////////////////////////////////////////////////////////////////////////
 
 namespace DKFramework
@@ -28,16 +34,38 @@ namespace DKFramework
 		DKTriangleMeshBvh(void);
 		~DKTriangleMeshBvh(void);
 		
-		void Build(DKTriangleMesh* mesh);
-		void Rebuild(void);
+		void Build(DKTriangleMesh* mesh, DKBvh::BuildMode mode = DKBvh::BuildModeMedian, DKFoundation::DKOperationQueue* queue = NULL);
+		void Rebuild(DKFoundation::DKOperationQueue* queue = NULL);
+		// update bounds of tree after vertices moved. (see DKBvh::Refit)
+		bool Refit(void);
+
+		struct RayHitResult
+		{
+			int triangleIndex;		// -1 if not hit.
+			float hitFraction;		// 0.0: ray.begin, 1.0: ray.end
+			DKVector3 hitPoint;
+			DKVector3 hitNormal;	// normal of CCW face. (p1,p2,p3)
+		};
 
 		DKAabb Aabb(void) const;
 		bool RayTest(const DKLine& ray, DKVector3* hitPoint = NULL) const;
+		bool RayTestClosest(const DKLine& ray, RayHitResult* result) const;
+		// batch ray-test, returns number of rays hit.
+		size_t RayTest(const DKLine* rays, size_t count, RayHitResult* results) const;
+
+		// immutable mesh is not locked while ray-test.
+		void SetImmutable(bool immutable)	{ this->immutable = immutable; }
+		bool IsImmutable(void) const		{ return immutable; }
 
 		const DKBvh& Bvh(void) const { return bvh; }
 
 	private:
 		DKFoundation::DKObject<DKTriangleMesh> mesh;
 		DKBvh bvh;
+		bool immutable;
+
+		void LockMesh(void) const;
+		void UnlockMesh(void) const;
+		size_t RayTestInternal(const DKLine* rays, size_t count, RayHitResult* results) const;
 	};
 }
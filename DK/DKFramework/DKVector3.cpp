@@ -10,9 +10,11 @@
 #include "DKMatrix3.h"
 #include "DKMatrix4.h"
 #include "DKQuaternion.h"
+#include "Private/SimdMath.h"
 
 using namespace DKFoundation;
 using namespace DKFramework;
+using namespace DKFramework::Private;
 
 const DKVector3 DKVector3::zero = DKVector3(0,0,0);
 
@@ -276,18 +278,16 @@ DKVector3& DKVector3::Transform(const DKMatrix3& m)
 
 DKVector3& DKVector3::Transform(const DKMatrix4& m)
 {
-	DKVector3 vec(x, y, z);
-	this->x = (vec.x * m.m[0][0]) + (vec.y * m.m[1][0]) + (vec.z * m.m[2][0]) + m.m[3][0];
-	this->y = (vec.x * m.m[0][1]) + (vec.y * m.m[1][1]) + (vec.z * m.m[2][1]) + m.m[3][1];
-	this->z = (vec.x * m.m[0][2]) + (vec.y * m.m[1][2]) + (vec.z * m.m[2][2]) + m.m[3][2];
-	float w = 1.0f / ((vec.x * m.m[0][3]) + (vec.y * m.m[1][3]) + (vec.z * m.m[2][3]) + m.m[3][3]);
-
-	this->x *= w;
-	this->y *= w;
-	this->z *= w;
+	SimdVector3Transform(this->val, m.val, this->val);
 	return *this;
 }
 
+void DKVector3::Transform(const DKVector3* input, DKVector3* output, size_t count, const DKMatrix4& m)
+{
+	for (size_t i = 0; i < count; ++i)
+		SimdVector3Transform(input[i].val, m.val, output[i].val);
+}
+
 DKVector3& DKVector3::Normalize(void)
 {
 	float lengthSq = x*x + y*y + z*z;
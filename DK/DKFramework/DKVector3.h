@@ -65,6 +65,9 @@ namespace DKFramework
 		DKVector3& Transform(const DKMatrix4& m);	// Homogeneous Transform
 		DKVector3& Normalize(void);
 
+		// batch homogeneous transform. (output can be same as input)
+		static void Transform(const DKVector3* input, DKVector3* output, size_t count, const DKMatrix4& m);
+
 		operator float* (void)				{return val;}
 		operator const float* (void) const	{return val;}
 
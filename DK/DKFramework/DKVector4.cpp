@@ -9,9 +9,11 @@
 #include "DKVector4.h"
 #include "DKMatrix4.h"
 #include "DKQuaternion.h"
+#include "Private/SimdMath.h"
 
 using namespace DKFoundation;
 using namespace DKFramework;
+using namespace DKFramework::Private;
 
 const DKVector4 DKVector4::zero = DKVector4(0,0,0,0);
 
@@ -176,10 +178,12 @@ DKVector4& DKVector4::Normalize(void)
 
 DKVector4& DKVector4::Transform(const DKMatrix4& m)
 {
-	DKVector4 vec(x, y, z, w);
-	this->x = (vec.x * m.m[0][0]) + (vec.y * m.m[1][0]) + (vec.z * m.m[2][0]) + (vec.w * m.m[3][0]);
-	this->y = (vec.x * m.m[0][1]) + (vec.y * m.m[1][1]) + (vec.z * m.m[2][1]) + (vec.w * m.m[3][1]);
-	this->z = (vec.x * m.m[0][2]) + (vec.y * m.m[1][2]) + (vec.z * m.m[2][2]) + (vec.w * m.m[3][2]);
-	this->w = (vec.x * m.m[0][3]) + (vec.y * m.m[1][3]) + (vec.z * m.m[2][3]) + (vec.w * m.m[3][3]);
+	SimdVector4Transform(this->val, m.val, this->val);
 	return *this;
 }
+
+void DKVector4::Transform(const DKVector4* input, DKVector4* output, size_t count, const DKMatrix4& m)
+{
+	for (size_t i = 0; i < count; ++i)
+		SimdVector4Transform(input[i].val, m.val, output[i].val);
+}
@@ -54,6 +54,9 @@ namespace DKFramework
 		DKVector4& Transform(const DKMatrix4& m);
 		DKVector4& Normalize(void);
 
+		// batch transform. (output can be same as input)
+		static void Transform(const DKVector4* input, DKVector4* output, size_t count, const DKMatrix4& m);
+
 		operator float* (void)				{return val;}
 		operator const float* (void) const	{return val;}
 
@@ -7,32 +7,775 @@
 
 #include "DKVoxel32FileStorage.h"
 
+namespace DKFramework
+{
+	namespace Private
+	{
+		namespace
+		{
+			enum : uint32_t
+			{
+				Voxel32FileVersion = 1,
+				Voxel32FilePageSize = 4096,
+				Voxel32FileInitialPages = 256,
+				Voxel32FileMaxRecordPages = (DKVoxel32FileStorage::UnitBytes + Voxel32FilePageSize - 1) / Voxel32FilePageSize,
+				Voxel32PrefetchCacheUnits = 64,
+			};
+			const char voxel32FileMagic[8] = {'D','K','V','O','X','3','2', 0};
+
+			enum Voxel32Encoding : uint32_t
+			{
+				Voxel32EncodingUniform = 0,	// no pages, 'uniform' value only.
+				Voxel32EncodingRaw,
+				Voxel32EncodingLZ4,
+			};
+
+			// file layout
+			//  page 0: header
+			//  page 1 ~ numPages-1: records
+			//  page indexPage ~ : index entries (written by Flush, indexPage >= numPages)
+			// pages referenced by index in file (records and index itself) are not
+			// overwritten or reused until new index is written, previous contents
+			// remain valid if process is interrupted before header is updated.
+			// (DKFileMap does not flush to disk in order, system crash may lose it)
+			// all values are little-endian.
+#pragma pack(push, 4)
+			struct Voxel32FileHeader
+			{
+				char magic[8];
+				uint32_t version;
+				uint32_t pageSize;
+				uint32_t numPages;		// pages used by records, including header page.
+				uint32_t indexPage;
+				uint32_t indexCount;
+				uint32_t reserved;
+			};
+			struct Voxel32FileIndexEntry
+			{
+				unsigned char sid[16];
+				uint32_t page;
+				uint32_t dataSize;
+				uint32_t encoding;
+				uint32_t uniform;
+			};
+#pragma pack(pop)
+			static_assert(sizeof(DKVoxel32FileStorage::StorageId) == 16, "StorageId size mismatch");
+
+			struct Voxel32Record
+			{
+				uint32_t page;			// first page, 0 if record has no pages.
+				uint32_t dataSize;
+				uint32_t encoding;
+				DKVoxel32 uniform;
+				uint32_t revision;		// unique in storage, changed whenever record has been rewritten.
+				bool committed;			// pages are referenced by index in file.
+			};
+			struct Voxel32Unit
+			{
+				DKVoxel32* voxels;
+				uint32_t checksum;		// CRC32 of stored contents
+				bool stored;			// checksum is valid
+			};
+
+			inline uint32_t Voxel32RecordPages(size_t bytes)
+			{
+				return (uint32_t)((bytes + Voxel32FilePageSize - 1) / Voxel32FilePageSize);
+			}
+			inline uint32_t Voxel32Checksum(const DKVoxel32* voxels)
+			{
+				return DKFoundation::DKHashCRC32(voxels, DKVoxel32FileStorage::UnitBytes).digest[0];
+			}
+		}
+	}
+}
+
 using namespace DKFoundation;
 using namespace DKFramework;
+using namespace DKFramework::Private;
+
+struct DKVoxel32FileStorage::StorageFile
+{
+	typedef DKHashMap<StorageId, Voxel32Record> RecordMap;
+	typedef DKHashMap<StorageId, Voxel32Unit> UnitMap;
+	struct CachedUnit
+	{
+		StorageId sid;
+		Voxel32Unit unit;
+	};
+
+	DKString path;
+	bool compression;
+	DKObject<DKFileMap> fileMap;
+	uint32_t mappedPages;
+	uint32_t numPages;
+	uint32_t indexPage;		// index referenced by file header.
+	uint32_t indexPages;
+	uint32_t lastRevision;
+
+	RecordMap records;
+	UnitMap activeUnits;
+	DKArray<CachedUnit> cachedUnits;		// prefetched units, oldest first.
+	DKSet<StorageId> prefetching;			// pending prefetch requests.
+	DKArray<uint32_t> freePages[Voxel32FileMaxRecordPages + 1];	// free extents by length
+	DKArray<uint32_t> releasedPages[Voxel32FileMaxRecordPages + 1];	// freed by next WriteIndex
+
+	DKMutex lock;
+	DKOperationQueue prefetchQueue;
+
+	StorageFile(void) : compression(true), mappedPages(0), numPages(1), indexPage(0), indexPages(0), lastRevision(0)
+	{
+		prefetchQueue.SetMaxConcurrentOperations(1);
+	}
+	~StorageFile(void)
+	{
+		prefetchQueue.CancelAllOperations();
+		prefetchQueue.WaitForCompletion();
+
+		activeUnits.EnumerateForward([](UnitMap::Pair& p) { delete[] p.value.voxels; });
+		for (CachedUnit& c : cachedUnits)
+			delete[] c.unit.voxels;
+	}
+
+	size_t ResidentUnits(void) const
+	{
+		return activeUnits.Count() + cachedUnits.Count();
+	}
+	long FindCachedUnit(const StorageId& sid) const
+	{
+		for (size_t i = 0; i < cachedUnits.Count(); ++i)
+		{
+			if (cachedUnits.Value(i).sid == sid)
+				return (long)i;
+		}
+		return -1;
+	}
+	void RemoveCachedUnit(const StorageId& sid)
+	{
+		long index = FindCachedUnit(sid);
+		if (index >= 0)
+		{
+			delete[] cachedUnits.Value(index).unit.voxels;
+			cachedUnits.Remove(index);
+		}
+	}
+	// discard oldest cached units to keep resident units under maxResident.
+	void TrimCache(size_t maxResident)
+	{
+		size_t n = 0;
+		while (n < cachedUnits.Count() && ResidentUnits() - n > maxResident)
+			delete[] cachedUnits.Value(n++).unit.voxels;
+		if (n > 0)
+			cachedUnits.Remove(0, n);
+	}
+
+	// grow file and mapping to hold given pages. (existing contents are preserved)
+	bool ReserveMapping(uint32_t pages)
+	{
+		if (pages <= mappedPages)
+			return true;
+
+		uint32_t newPages = Max(pages, mappedPages * 2);
+		fileMap = NULL;
+		fileMap = DKFileMap::Open(path, (size_t)newPages * Voxel32FilePageSize, true);
+		if (fileMap)
+		{
+			mappedPages = newPages;
+			return true;
+		}
+		DKLog("DKVoxel32FileStorage: Cannot expand file to %u pages.\n", newPages);
+		fileMap = DKFileMap::Open(path, (size_t)mappedPages * Voxel32FilePageSize, true);
+		return false;
+	}
+	uint32_t AllocPages(uint32_t n)
+	{
+		DKASSERT_DEBUG(n > 0 && n <= Voxel32FileMaxRecordPages);
+		for (uint32_t m = n; m <= Voxel32FileMaxRecordPages; ++m)
+		{
+			DKArray<uint32_t>& extents = freePages[m];
+			if (extents.Count() > 0)
+			{
+				uint32_t page = extents.Value(extents.Count() - 1);
+				extents.Remove(extents.Count() - 1);
+				if (m > n)
+					freePages[m - n].Add(page + n);
+				return page;
+			}
+		}
+		// do not append over index referenced by header, pages before index
+		// become free extents. (index pages are freed by next WriteIndex)
+		uint32_t page = numPages;
+		if (page < indexPage + indexPages)
+			page = indexPage + indexPages;
+		if (!ReserveMapping(page + n))
+			return 0;
+		if (page > numPages)
+		{
+			DKASSERT_DEBUG(indexPage >= numPages);
+			FreePageRange(numPages, indexPage - numPages);
+		}
+		numPages = page + n;
+		return page;
+	}
+	void FreePages(uint32_t page, uint32_t n)
+	{
+		if (page > 0 && n > 0)
+		{
+			DKASSERT_DEBUG(n <= Voxel32FileMaxRecordPages);
+			freePages[n].Add(page);
+		}
+	}
+	// free pages of any length, split into extents of record size.
+	void FreePageRange(uint32_t page, uint32_t n)
+	{
+		while (n > 0)
+		{
+			uint32_t len = Min(n, (uint32_t)Voxel32FileMaxRecordPages);
+			FreePages(page, len);
+			page += len;
+			n -= len;
+		}
+	}
+	void FreeRecordPages(Voxel32Record& rec)
+	{
+		if (rec.page)
+		{
+			uint32_t n = Voxel32RecordPages(rec.dataSize);
+			if (rec.committed)
+				releasedPages[n].Add(rec.page);	// still referenced by index in file.
+			else
+				FreePages(rec.page, n);
+		}
+		rec.page = 0;
+		rec.dataSize = 0;
+		rec.committed = false;
+	}
+
+	// decode record into voxels, file should be locked by caller.
+	bool ReadRecord(const Voxel32Record& rec, DKVoxel32* voxels) const
+	{
+		if (rec.encoding == Voxel32EncodingUniform)
+		{
+			for (size_t i = 0; i < UnitDimensions; ++i)
+				voxels[i] = rec.uniform;
+			return true;
+		}
+		bool result = false;
+		const uint8_t* base = reinterpret_cast<const uint8_t*>(fileMap->LockShared());
+		const uint8_t* data = &base[(size_t)rec.page * Voxel32FilePageSize];
+		if (rec.encoding == Voxel32EncodingRaw)
+		{
+			DKASSERT_DEBUG(rec.dataSize == UnitBytes);
+			memcpy(voxels, data, UnitBytes);
+			result = true;
+		}
+		else if (rec.encoding == Voxel32EncodingLZ4)
+		{
+			DKObject<DKBuffer> decoded = DKBuffer::Decompress(data, rec.dataSize);
+			if (decoded && decoded->CopyContent(voxels, 0, UnitBytes) == UnitBytes)
+				result = true;
+		}
+		fileMap->UnlockShared();
+		if (!result)
+			DKLog("DKVoxel32FileStorage: Failed to decode record (page:%u, size:%u).\n", rec.page, rec.dataSize);
+		return result;
+	}
+	// encode unit into record if contents changed.
+	bool WriteRecord(Voxel32Record& rec, Voxel32Unit& unit)
+	{
+		const DKVoxel32* voxels = unit.voxels;
+		uint32_t checksum = Voxel32Checksum(voxels);
+		if (unit.stored && unit.checksum == checksum)
+			return true;
+
+		bool uniform = true;
+		for (size_t i = 1; i < UnitDimensions && uniform; ++i)
+			uniform = voxels[i].uintValue == voxels[0].uintValue;
+
+		if (uniform)
+		{
+			FreeRecordPages(rec);
+			rec.encoding = Voxel32EncodingUniform;
+			rec.uniform = voxels[0];
+		}
+		else
+		{
+			DKObject<DKBuffer> compressed = NULL;
+			const void* data = voxels;
+			size_t dataSize = UnitBytes;
+			uint32_t encoding = Voxel32EncodingRaw;
+			if (compression)
+			{
+				compressed = DKBuffer::Compress(voxels, UnitBytes, DKCompressor::LZ4);
+				if (compressed && compressed->Length() < UnitBytes)
+				{
+					data = compressed->LockShared();
+					dataSize = compressed->Length();
+					encoding = Voxel32EncodingLZ4;
+				}
+				else
+					compressed = NULL;
+			}
+
+			// committed pages are not overwritten, record moves to new pages.
+			uint32_t pages = Voxel32RecordPages(dataSize);
+			if (rec.page == 0 || rec.committed || Voxel32RecordPages(rec.dataSize) != pages)
+			{
+				FreeRecordPages(rec);
+				rec.page = AllocPages(pages);
+			}
+			if (rec.page)
+			{
+				uint8_t* base = reinterpret_cast<uint8_t*>(fileMap->LockExclusive());
+				memcpy(&base[(size_t)rec.page * Voxel32FilePageSize], data, dataSize);
+				fileMap->UnlockExclusive();
+				rec.dataSize = (uint32_t)dataSize;
+				rec.encoding = encoding;
+			}
+			if (compressed)
+				compressed->UnlockShared();
+			if (rec.page == 0)
+				return false;
+		}
+		rec.revision = ++lastRevision;
+		unit.checksum = checksum;
+		unit.stored = true;
+		return true;
+	}
+
+	bool WriteIndex(void)
+	{
+		size_t indexCount = records.Count();
+		uint32_t pages = Voxel32RecordPages(indexCount * sizeof(Voxel32FileIndexEntry));
+
+		// write to pages not used by current index.
+		uint32_t page = numPages;
+		if (page < indexPage + indexPages && page + pages > indexPage)
+			page = indexPage + indexPages;
+		if (!ReserveMapping(page + pages))
+			return false;
+
+		uint8_t* base = reinterpret_cast<uint8_t*>(fileMap->LockExclusive());
+		Voxel32FileIndexEntry* entry = reinterpret_cast<Voxel32FileIndexEntry*>(&base[(size_t)page * Voxel32FilePageSize]);
+		records.EnumerateForward([&entry](RecordMap::Pair& p)
+		{
+			p.value.committed = p.value.page != 0;
+			memcpy(entry->sid, p.key.Bytes(), sizeof(entry->sid));
+			entry->page = DKSystemToLittleEndian(p.value.page);
+			entry->dataSize = DKSystemToLittleEndian(p.value.dataSize);
+			entry->encoding = DKSystemToLittleEndian(p.value.encoding);
+			entry->uniform = p.value.uniform.uintValue;
+			entry++;
+		});
+
+		Voxel32FileHeader* header = reinterpret_cast<Voxel32FileHeader*>(base);
+		memcpy(header->magic, voxel32FileMagic, sizeof(header->magic));
+		header->version = DKSystemToLittleEndian<uint32_t>(Voxel32FileVersion);
+		header->pageSize = DKSystemToLittleEndian<uint32_t>(Voxel32FilePageSize);
+		header->numPages = DKSystemToLittleEndian(numPages);
+		header->indexPage = DKSystemToLittleEndian(page);
+		header->indexCount = DKSystemToLittleEndian((uint32_t)indexCount);
+		header->reserved = 0;
+		fileMap->UnlockExclusive();
+
+		// previous index has been skipped by AllocPages, it can be reused now.
+		if (indexPage + indexPages <= numPages)
+			FreePageRange(indexPage, indexPages);
+		// pages of previous records are not referenced anymore.
+		for (uint32_t n = 1; n <= Voxel32FileMaxRecordPages; ++n)
+		{
+			freePages[n].Add(releasedPages[n]);
+			releasedPages[n].Clear();
+		}
+		indexPage = page;
+		indexPages = pages;
+		return true;
+	}
+	bool ReadIndex(void)
+	{
+		const uint8_t* base = reinterpret_cast<const uint8_t*>(fileMap->LockShared());
+		const Voxel32FileHeader* header = reinterpret_cast<const Voxel32FileHeader*>(base);
+
+		bool valid = memcmp(header->magic, voxel32FileMagic, sizeof(header->magic)) == 0 &&
+			DKLittleEndianToSystem(header->version) == Voxel32FileVersion &&
+			DKLittleEndianToSystem(header->pageSize) == Voxel32FilePageSize;
+
+		if (valid)
+		{
+			numPages = DKLittleEndianToSystem(header->numPages);
+			indexPage = DKLittleEndianToSystem(header->indexPage);
+			uint32_t indexCount = DKLittleEndianToSystem(header->indexCount);
+			indexPages = Voxel32RecordPages(indexCount * sizeof(Voxel32FileIndexEntry));
+
+			valid = numPages > 0 && numPages <= indexPage && indexPage + indexPages <= mappedPages;
+			if (valid)
+			{
+				// pages not used by any record become free extents.
+				DKArray<bool> used;
+				used.Resize(numPages, false);
+				used.Value(0) = true;
+
+				const Voxel32FileIndexEntry* entry = reinterpret_cast<const Voxel32FileIndexEntry*>(&base[(size_t)indexPage * Voxel32FilePageSize]);
+				for (uint32_t i = 0; i < indexCount && valid; ++i, ++entry)
+				{
+					StorageId sid;
+					sid.SetBytes(entry->sid);
+
+					Voxel32Record rec;
+					rec.page = DKLittleEndianToSystem(entry->page);
+					rec.dataSize = DKLittleEndianToSystem(entry->dataSize);
+					rec.encoding = DKLittleEndianToSystem(entry->encoding);
+					rec.uniform.uintValue = entry->uniform;
+					rec.revision = ++lastRevision;
+					rec.committed = true;
+
+					if (rec.encoding == Voxel32EncodingUniform)
+					{
+						rec.page = 0;
+						rec.dataSize = 0;
+						rec.committed = false;
+					}
+					else
+					{
+						uint32_t pages = Voxel32RecordPages(rec.dataSize);
+						valid = rec.page > 0 && pages > 0 && pages <= Voxel32FileMaxRecordPages && rec.page + pages <= numPages;
+						for (uint32_t p = 0; p < pages && valid; ++p)
+							used.Value(rec.page + p) = true;
+					}
+					if (valid)
+						records.Update(sid, rec);
+				}
+				for (uint32_t page = 1; page < numPages && valid; )
+				{
+					if (used.Value(page))
+					{
+						page++;
+						continue;
+					}
+					uint32_t n = 0;
+					while (page + n < numPages && !used.Value(page + n) && n < Voxel32FileMaxRecordPages)
+						n++;
+					freePages[n].Add(page);
+					page += n;
+				}
+			}
+		}
+		fileMap->UnlockShared();
+		if (!valid)
+			records.Clear();
+		return valid;
+	}
+
+	// decode unit in background, decoded unit will be handed over by Load().
+	// compressed record is copied with lock held, decompressed without lock.
+	void PrefetchUnit(const StorageId& sid, size_t maxResident)
+	{
+		Voxel32Record rec;
+		Voxel32Unit unit;
+		DKObject<DKBuffer> encoded = NULL;
+		if (true)
+		{
+			DKCriticalSection<DKMutex> guard(lock);
+			if (!prefetching.Contains(sid))
+				return;		// cancelled.
+
+			RecordMap::Pair* p = records.Find(sid);
+			if (p == NULL || activeUnits.Find(sid) || FindCachedUnit(sid) >= 0 || ResidentUnits() >= maxResident)
+			{
+				prefetching.Remove(sid);
+				return;
+			}
+			rec = p->value;
+			unit.voxels = new DKVoxel32[UnitDimensions];
+			if (rec.encoding == Voxel32EncodingLZ4)
+			{
+				const uint8_t* base = reinterpret_cast<const uint8_t*>(fileMap->LockShared());
+				encoded = DKBuffer::Create(&base[(size_t)rec.page * Voxel32FilePageSize], rec.dataSize);
+				fileMap->UnlockShared();
+			}
+			else if (!ReadRecord(rec, unit.voxels))
+			{
+				prefetching.Remove(sid);
+				delete[] unit.voxels;
+				return;
+			}
+		}
+
+		bool decoded = true;
+		if (encoded)
+		{
+			DKObject<DKBuffer> data = encoded->Decompress();
+			decoded = data && data->CopyContent(unit.voxels, 0, UnitBytes) == UnitBytes;
+			if (!decoded)
+				DKLog("DKVoxel32FileStorage: Failed to decode record (page:%u, size:%u).\n", rec.page, rec.dataSize);
+		}
+		if (decoded)
+		{
+			unit.checksum = Voxel32Checksum(unit.voxels);
+			unit.stored = true;
+		}
+
+		DKCriticalSection<DKMutex> guard(lock);
+		if (decoded && prefetching.Contains(sid))
+		{
+			// record can be rewritten or loaded while decoding.
+			RecordMap::Pair* p = records.Find(sid);
+			if (p && p->value.revision == rec.revision && activeUnits.Find(sid) == NULL && FindCachedUnit(sid) < 0)
+			{
+				prefetching.Remove(sid);
+				cachedUnits.Add({sid, unit});
+				if (cachedUnits.Count() > Voxel32PrefetchCacheUnits)
+					TrimCache(ResidentUnits() - 1);
+				return;
+			}
+		}
+		prefetching.Remove(sid);
+		delete[] unit.voxels;
+	}
+};
 
 DKVoxel32FileStorage::DKVoxel32FileStorage(void)
-	: maxLoadableUnits(-1)
+	: maxLoadableUnits(1024)
+	, file(NULL)
 {
 }
 
 DKVoxel32FileStorage::~DKVoxel32FileStorage(void)
 {
+	Close();
+}
+
+bool DKVoxel32FileStorage::Open(const DKString& path, bool compression)
+{
+	Close();
+
+	StorageFile* f = new StorageFile();
+	f->path = path;
+	f->compression = compression;
+	f->fileMap = DKFileMap::Open(path, 0, true);
+	if (f->fileMap)
+	{
+		f->mappedPages = (uint32_t)(f->fileMap->Length() / Voxel32FilePageSize);
+		if (!f->ReadIndex())
+		{
+			DKLog("DKVoxel32FileStorage: Invalid storage file: %ls\n", (const wchar_t*)path);
+			delete f;
+			return false;
+		}
+	}
+	else
+	{
+		f->fileMap = DKFileMap::Create(path, (size_t)Voxel32FileInitialPages * Voxel32FilePageSize, false);
+		if (f->fileMap == NULL)
+		{
+			DKLog("DKVoxel32FileStorage: Cannot create file: %ls\n", (const wchar_t*)path);
+			delete f;
+			return false;
+		}
+		f->mappedPages = Voxel32FileInitialPages;
+		f->numPages = 1;
+		f->WriteIndex();
+	}
+	this->file = f;
+	return true;
+}
+
+void DKVoxel32FileStorage::Close(void)
+{
+	if (file)
+	{
+		DKASSERT_DESC_DEBUG(file->activeUnits.Count() == 0, "Units are still in use.");
+		Flush();
+		delete file;
+		file = NULL;
+	}
+}
+
+bool DKVoxel32FileStorage::Flush(void)
+{
+	if (file == NULL)
+		return false;
+
+	DKCriticalSection<DKMutex> guard(file->lock);
+	bool result = true;
+	file->activeUnits.EnumerateForward([this, &result](StorageFile::UnitMap::Pair& p)
+	{
+		StorageFile::RecordMap::Pair* rec = file->records.Find(p.key);
+		DKASSERT_DEBUG(rec);
+		if (!file->WriteRecord(rec->value, p.value))
+			result = false;
+	});
+	if (!file->WriteIndex())
+		result = false;
+	return result;
+}
+
+bool DKVoxel32FileStorage::IsOpened(void) const
+{
+	return file != NULL;
+}
+
+void DKVoxel32FileStorage::SetMaxActiveUnits(size_t num)
+{
+	maxLoadableUnits = Max(num, 1);
+	if (file)
+	{
+		DKCriticalSection<DKMutex> guard(file->lock);
+		file->TrimCache(maxLoadableUnits);
+	}
+}
+
+size_t DKVoxel32FileStorage::NumberOfUnits(void) const
+{
+	if (file)
+		return file->records.Count();
+	return 0;
+}
+
+size_t DKVoxel32FileStorage::NumberOfResidentUnits(void) const
+{
+	if (file)
+	{
+		DKCriticalSection<DKMutex> guard(file->lock);
+		return file->ResidentUnits();
+	}
+	return 0;
 }
 
 DKVoxel32* DKVoxel32FileStorage::Create(const StorageId& sid)
 {
-	return NULL;
+	if (file == NULL)
+	{
+		DKLog("DKVoxel32FileStorage: Storage file not opened.\n");
+		return NULL;
+	}
+
+	DKCriticalSection<DKMutex> guard(file->lock);
+	DKASSERT_DEBUG(file->records.Find(sid) == NULL);
+
+	Voxel32Record rec;
+	rec.page = 0;
+	rec.dataSize = 0;
+	rec.encoding = Voxel32EncodingUniform;
+	rec.uniform.uintValue = 0;
+	rec.revision = ++file->lastRevision;
+	rec.committed = false;
+	file->records.Update(sid, rec);
+
+	Voxel32Unit unit;
+	unit.voxels = new DKVoxel32[UnitDimensions];
+	unit.checksum = 0;
+	unit.stored = false;
+	file->activeUnits.Update(sid, unit);
+	file->TrimCache(maxLoadableUnits);
+	return unit.voxels;
 }
 
 void DKVoxel32FileStorage::Delete(const StorageId& sid)
 {
+	if (file == NULL)
+		return;
+
+	DKCriticalSection<DKMutex> guard(file->lock);
+	file->prefetching.Remove(sid);
+	file->RemoveCachedUnit(sid);
+
+	StorageFile::UnitMap::Pair* unit = file->activeUnits.Find(sid);
+	if (unit)
+	{
+		delete[] unit->value.voxels;
+		file->activeUnits.Remove(sid);
+	}
+	StorageFile::RecordMap::Pair* rec = file->records.Find(sid);
+	if (rec)
+	{
+		file->FreeRecordPages(rec->value);
+		file->records.Remove(sid);
+	}
 }
 
 DKVoxel32* DKVoxel32FileStorage::Load(const StorageId& sid)
 {
-	return NULL;
+	if (file == NULL)
+		return NULL;
+
+	DKCriticalSection<DKMutex> guard(file->lock);
+	DKASSERT_DEBUG(file->activeUnits.Find(sid) == NULL);
+
+	file->prefetching.Remove(sid);	// pending prefetch will be discarded.
+
+	long cached = file->FindCachedUnit(sid);
+	if (cached >= 0)
+	{
+		Voxel32Unit unit = file->cachedUnits.Value(cached).unit;
+		file->cachedUnits.Remove(cached);
+		file->activeUnits.Update(sid, unit);
+		return unit.voxels;
+	}
+
+	StorageFile::RecordMap::Pair* rec = file->records.Find(sid);
+	if (rec == NULL)
+	{
+		DKLog("DKVoxel32FileStorage: SID(%ls) not found.\n", (const wchar_t*)sid.String());
+		return NULL;
+	}
+
+	Voxel32Unit unit;
+	unit.voxels = new DKVoxel32[UnitDimensions];
+	if (!file->ReadRecord(rec->value, unit.voxels))
+	{
+		delete[] unit.voxels;
+		return NULL;
+	}
+	unit.checksum = Voxel32Checksum(unit.voxels);
+	unit.stored = true;
+	file->activeUnits.Update(sid, unit);
+	file->TrimCache(maxLoadableUnits);
+	return unit.voxels;
 }
 
 void DKVoxel32FileStorage::Unload(const StorageId& sid)
 {
-}
\ No newline at end of file
+	if (file == NULL)
+		return;
+
+	DKCriticalSection<DKMutex> guard(file->lock);
+	StorageFile::UnitMap::Pair* unit = file->activeUnits.Find(sid);
+	DKASSERT_DEBUG(unit);
+	if (unit)
+	{
+		StorageFile::RecordMap::Pair* rec = file->records.Find(sid);
+		DKASSERT_DEBUG(rec);
+		if (!file->WriteRecord(rec->value, unit->value))
+			DKLog("DKVoxel32FileStorage: Failed to write SID(%ls).\n", (const wchar_t*)sid.String());
+
+		delete[] unit->value.voxels;
+		file->activeUnits.Remove(sid);
+	}
+}
+
+void DKVoxel32FileStorage::Prefetch(const StorageId& sid)
+{
+	if (file == NULL)
+		return;
+
+	DKCriticalSection<DKMutex> guard(file->lock);
+	if (file->prefetching.Contains(sid) ||
+		file->activeUnits.Find(sid) ||
+		file->FindCachedUnit(sid) >= 0)
+		return;
+
+	StorageFile::RecordMap::Pair* rec = file->records.Find(sid);
+	if (rec == NULL || rec->value.encoding == Voxel32EncodingUniform)
+		return;		// uniform unit is cheap to load.
+
+	size_t maxResident = maxLoadableUnits;
+	if (file->ResidentUnits() + file->prefetching.Count() >= maxResident)
+		return;
+
+	file->prefetching.Insert(sid);
+	StorageFile* f = file;
+	f->prefetchQueue.Post(DKFunction([f, sid, maxResident]
+	{
+		f->PrefetchUnit(sid, maxResident);
+	})->Invocation());
+}
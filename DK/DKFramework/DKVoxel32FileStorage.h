@@ -13,28 +13,62 @@
 ////////////////////////////////////////////////////////////////////////////////
 // DKVoxel32FileStorage
 // a 32bit voxel storage, it store data into file.
+// Each unit (16x16x16 voxels, see DKVoxel32SparseVolume) is stored as a
+// record of file pages in a memory-mapped file (DKFileMap). Records are
+// indexed by StorageId, index is written to file by Flush() or Close().
 //
-// THIS CLASS NOT IMPLEMENTED YET.
-// Use DKVoxel32SparseVolume instead.
+// Units are encoded when unloaded.
+//  - uniform unit (every voxel has same value) is stored in index only,
+//    it takes no file pages.
+//  - other units are compressed with LZ4 (if compression enabled) and
+//    stored raw if compressed data is not smaller.
+//  - unit that has not been changed since loaded is not written again.
+//
+// Prefetch() decodes units in background, decoded units are cached and
+// handed over by Load(). Active units and cached units are counted together,
+// MaxActiveUnits limits number of units resident in memory.
+//
+// Note:
+//  A storage file can be opened by one storage object at a time.
+//  Call Open() before using with DKVoxel32SparseVolume.
 ////////////////////////////////////////////////////////////////////////////////
 
 namespace DKFramework
 {
-	// NOT IMPLEMENTED. (Use DKVoxel32SparseVolume)
 	class DKGL_API DKVoxel32FileStorage : public DKVoxel32Storage
 	{
 	public:
+		enum {UnitDimensions = 16 * 16 * 16};
+		enum {UnitBytes = UnitDimensions * sizeof(DKVoxel32)};
+
 		DKVoxel32FileStorage(void);
 		~DKVoxel32FileStorage(void);
 
+		// open storage file, create new file if file not exists.
+		bool Open(const DKFoundation::DKString& file, bool compression = true);
+		// write back all units and index, close file.
+		void Close(void);
+		// write back active units and index to file.
+		bool Flush(void);
+		bool IsOpened(void) const;
+
 		DKVoxel32* Create(const StorageId&);
 		void Delete(const StorageId&);
 		DKVoxel32* Load(const StorageId&);
 		void Unload(const StorageId&);
+		void Prefetch(const StorageId&);
 
 		size_t MaxActiveUnits(void) const {return maxLoadableUnits;}
+		void SetMaxActiveUnits(size_t);
+
+		size_t NumberOfUnits(void) const;		// number of stored units.
+		size_t NumberOfResidentUnits(void) const; // active units + cached units.
 
 	protected:
 		size_t maxLoadableUnits;
+
+	private:
+		struct StorageFile;
+		StorageFile* file;
 	};
 }
@@ -0,0 +1,487 @@
+//
+//  File: DKVoxel32Mesher.cpp
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2015 Hongtae Kim. All rights reserved.
+//
+
+#include "DKMath.h"
+#include "DKVoxel32Mesher.h"
+#include "DKVoxelPolygonizer.h"
+
+using namespace DKFoundation;
+namespace DKFramework
+{
+	namespace Private
+	{
+		namespace
+		{
+			// integer form of marching cubes tables of DKVoxelPolygonizer.
+			struct MesherCubeTables
+			{
+				int corners[8][3];		// offset of each cube corner
+				int edgeOrigins[12][3];	// offset of lower corner of each edge
+				int edgeAxes[12];		// axis of each edge (0:x, 1:y, 2:z)
+
+				MesherCubeTables(void)
+				{
+					for (int i = 0; i < 8; ++i)
+					{
+						const DKVector3& p = DKVoxelPolygonizer::CubePosition((DKVoxelPolygonizer::CubeIndex)i);
+						corners[i][0] = (int)p.x;
+						corners[i][1] = (int)p.y;
+						corners[i][2] = (int)p.z;
+					}
+					for (int i = 0; i < 12; ++i)
+					{
+						DKVoxelPolygonizer::CubeIndex c1, c2;
+						DKVoxelPolygonizer::EdgeCubeIndices(i, c1, c2);
+						for (int k = 0; k < 3; ++k)
+						{
+							edgeOrigins[i][k] = Min(corners[c1][k], corners[c2][k]);
+							if (corners[c1][k] != corners[c2][k])
+								edgeAxes[i] = k;
+						}
+					}
+				}
+			};
+			const MesherCubeTables& CubeTables(void)
+			{
+				static MesherCubeTables tables;
+				return tables;
+			}
+		}
+	}
+}
+
+using namespace DKFramework;
+using namespace DKFramework::Private;
+
+
+int DKVoxel32Mesher::Mesh::NumberOfTriangles(void) const
+{
+	return (int)(indices.Count() / 3);
+}
+
+bool DKVoxel32Mesher::Mesh::GetTriangleAtIndex(int index, DKTriangle& tri) const
+{
+	if (index >= 0 && index < NumberOfTriangles())
+	{
+		const uint32_t* idx = &indices.Value(index * 3);
+		tri.position1 = vertices.Value(idx[0]).position;
+		tri.position2 = vertices.Value(idx[1]).position;
+		tri.position3 = vertices.Value(idx[2]).position;
+		return true;
+	}
+	return false;
+}
+
+DKVoxel32Mesher::DKVoxel32Mesher(Volume* vol)
+	: volume(NULL)
+	, isoLevel(127.5f)
+	, volumeWidth(0)
+	, volumeHeight(0)
+	, volumeDepth(0)
+	, chunksX(0)
+	, chunksY(0)
+	, chunksZ(0)
+	, numDirtyChunks(0)
+{
+	SetVolume(vol);
+}
+
+DKVoxel32Mesher::~DKVoxel32Mesher(void)
+{
+}
+
+void DKVoxel32Mesher::SetVolume(Volume* vol)
+{
+	this->volume = vol;
+	ResetChunks();
+}
+
+void DKVoxel32Mesher::SetIsoLevel(float level)
+{
+	if (this->isoLevel != level)
+	{
+		this->isoLevel = level;
+		MarkAllDirty();
+	}
+}
+
+void DKVoxel32Mesher::ResetChunks(void)
+{
+	size_t w = 0, h = 0, d = 0;
+	if (volume)
+		volume->GetDimensions(&w, &h, &d);
+
+	DKCriticalSection<DKSpinLock> guard(dirtyLock);
+	volumeWidth = w;
+	volumeHeight = h;
+	volumeDepth = d;
+
+	// cubes are between voxels, volume has (w-1)*(h-1)*(d-1) cubes.
+	if (w > 1 && h > 1 && d > 1)
+	{
+		chunksX = (w - 2) / ChunkSize + 1;
+		chunksY = (h - 2) / ChunkSize + 1;
+		chunksZ = (d - 2) / ChunkSize + 1;
+	}
+	else
+	{
+		chunksX = chunksY = chunksZ = 0;
+	}
+
+	chunks.Clear();
+	chunks.Resize(chunksX * chunksY * chunksZ);
+	for (size_t z = 0; z < chunksZ; ++z)
+	{
+		for (size_t y = 0; y < chunksY; ++y)
+		{
+			for (size_t x = 0; x < chunksX; ++x)
+			{
+				Chunk& c = chunks.Value(x + chunksX * (y + chunksY * z));
+				c.x = (unsigned int)(x * ChunkSize);
+				c.y = (unsigned int)(y * ChunkSize);
+				c.z = (unsigned int)(z * ChunkSize);
+				c.dirty = true;
+			}
+		}
+	}
+	numDirtyChunks = chunks.Count();
+}
+
+void DKVoxel32Mesher::MarkChunks(long x0, long y0, long z0, long x1, long y1, long z1)
+{
+	// x0..x1, y0..y1, z0..z1: range of cubes (inclusive)
+	DKCriticalSection<DKSpinLock> guard(dirtyLock);
+	if (chunks.Count() == 0)
+		return;
+
+	x0 = Max(x0, 0L);
+	y0 = Max(y0, 0L);
+	z0 = Max(z0, 0L);
+	x1 = Min(x1, (long)volumeWidth - 2);
+	y1 = Min(y1, (long)volumeHeight - 2);
+	z1 = Min(z1, (long)volumeDepth - 2);
+	if (x0 > x1 || y0 > y1 || z0 > z1)
+		return;
+
+	for (long z = z0 / ChunkSize; z <= z1 / ChunkSize; ++z)
+	{
+		for (long y = y0 / ChunkSize; y <= y1 / ChunkSize; ++y)
+		{
+			for (long x = x0 / ChunkSize; x <= x1 / ChunkSize; ++x)
+			{
+				Chunk& c = chunks.Value(x + chunksX * (y + chunksY * z));
+				if (!c.dirty)
+				{
+					c.dirty = true;
+					numDirtyChunks++;
+				}
+			}
+		}
+	}
+}
+
+void DKVoxel32Mesher::MarkDirty(unsigned int x, unsigned int y, unsigned int z)
+{
+	MarkRegionDirty(x, y, z, 1, 1, 1);
+}
+
+void DKVoxel32Mesher::MarkRegionDirty(unsigned int x, unsigned int y, unsigned int z, size_t width, size_t height, size_t depth)
+{
+	if (width == 0 || height == 0 || depth == 0)
+		return;
+	// voxel is corner of 8 cubes (x-1 ~ x), and affects normals of
+	// vertices on cubes of one more step. (x-2 ~ x+1)
+	MarkChunks((long)x - 2, (long)y - 2, (long)z - 2,
+			   (long)(x + width), (long)(y + height), (long)(z + depth));
+}
+
+void DKVoxel32Mesher::MarkAllDirty(void)
+{
+	DKCriticalSection<DKSpinLock> guard(dirtyLock);
+	for (Chunk& c : chunks)
+		c.dirty = true;
+	numDirtyChunks = chunks.Count();
+}
+
+bool DKVoxel32Mesher::SetVoxelAtLocation(unsigned int x, unsigned int y, unsigned int z, const DKVoxel32& v)
+{
+	if (volume && volume->SetVoxelAtLocation(x, y, z, v))
+	{
+		MarkDirty(x, y, z);
+		return true;
+	}
+	return false;
+}
+
+bool DKVoxel32Mesher::SetVoxels(unsigned int x, unsigned int y, unsigned int z, size_t width, size_t height, size_t depth, const DKVoxel32* voxels)
+{
+	if (volume && volume->SetVoxels(x, y, z, width, height, depth, voxels))
+	{
+		MarkRegionDirty(x, y, z, width, height, depth);
+		return true;
+	}
+	return false;
+}
+
+size_t DKVoxel32Mesher::Update(DKOperationQueue* queue, DKArray<size_t>* updatedChunks)
+{
+	if (volume == NULL)
+		return 0;
+
+	size_t w, h, d;
+	volume->GetDimensions(&w, &h, &d);
+	if (w != volumeWidth || h != volumeHeight || d != volumeDepth)
+		ResetChunks();
+
+	DKArray<size_t> dirtyChunks;
+	if (true)
+	{
+		DKCriticalSection<DKSpinLock> guard(dirtyLock);
+		if (numDirtyChunks == 0)
+			return 0;
+		dirtyChunks.Reserve(numDirtyChunks);
+		for (size_t i = 0; i < chunks.Count(); ++i)
+		{
+			Chunk& c = chunks.Value(i);
+			if (c.dirty)
+			{
+				dirtyChunks.Add(i);
+				c.dirty = false;
+			}
+		}
+		numDirtyChunks = 0;
+	}
+
+	if (queue && dirtyChunks.Count() > 1)
+	{
+		DKOperationQueue::TaskGroup group(queue);
+		for (size_t index : dirtyChunks)
+		{
+			Chunk* c = &chunks.Value(index);
+			group.Post(DKFunction([this, c]
+			{
+				PolygonizeChunk(*c);
+			})->Invocation());
+		}
+		group.Wait();
+	}
+	else
+	{
+		for (size_t index : dirtyChunks)
+			PolygonizeChunk(chunks.Value(index));
+	}
+
+	if (updatedChunks)
+		updatedChunks->Add(dirtyChunks);
+	return dirtyChunks.Count();
+}
+
+void DKVoxel32Mesher::GetChunkDimensions(size_t* x, size_t* y, size_t* z) const
+{
+	if (x) *x = chunksX;
+	if (y) *y = chunksY;
+	if (z) *z = chunksZ;
+}
+
+const DKVoxel32Mesher::Chunk& DKVoxel32Mesher::ChunkAtIndex(size_t index) const
+{
+	return chunks.Value(index);
+}
+
+void DKVoxel32Mesher::PolygonizeChunk(Chunk& chunk)
+{
+	chunk.mesh.vertices.Clear();
+	chunk.mesh.indices.Clear();
+	chunk.boundaryVertices.Clear();
+	chunk.boundaryEdges.Clear();
+
+	const long width = (long)volumeWidth;
+	const long height = (long)volumeHeight;
+	const long depth = (long)volumeDepth;
+
+	// corners of cubes (inclusive)
+	const long x0 = chunk.x;
+	const long y0 = chunk.y;
+	const long z0 = chunk.z;
+	const long x1 = Min(x0 + (long)ChunkSize, width - 1);
+	const long y1 = Min(y0 + (long)ChunkSize, height - 1);
+	const long z1 = Min(z0 + (long)ChunkSize, depth - 1);
+
+	// sampling region, one more voxel for gradients.
+	const long sx0 = Max(x0 - 1, 0L);
+	const long sy0 = Max(y0 - 1, 0L);
+	const long sz0 = Max(z0 - 1, 0L);
+	const long sx1 = Min(x1 + 1, width - 1);
+	const long sy1 = Min(y1 + 1, height - 1);
+	const long sz1 = Min(z1 + 1, depth - 1);
+	const long sw = sx1 - sx0 + 1;
+	const long sh = sy1 - sy0 + 1;
+	const long sd = sz1 - sz0 + 1;
+
+	DKArray<DKVoxel32> samples;
+	samples.Resize(sw * sh * sd);
+	if (!volume->GetVoxels((unsigned int)sx0, (unsigned int)sy0, (unsigned int)sz0, sw, sh, sd, samples))
+		return;
+
+	const DKVoxel32* sampleData = samples;
+	auto level = [&](long x, long y, long z) -> float
+	{
+		return sampleData[(x - sx0) + sw * ((y - sy0) + sh * (z - sz0))].level;
+	};
+	auto gradient = [&](long x, long y, long z) -> DKVector3
+	{
+		const long xa = Max(x - 1, sx0), xb = Min(x + 1, sx1);
+		const long ya = Max(y - 1, sy0), yb = Min(y + 1, sy1);
+		const long za = Max(z - 1, sz0), zb = Min(z + 1, sz1);
+		return DKVector3((level(xb, y, z) - level(xa, y, z)) / (float)(xb - xa),
+						 (level(x, yb, z) - level(x, ya, z)) / (float)(yb - ya),
+						 (level(x, y, zb) - level(x, y, za)) / (float)(zb - za));
+	};
+
+	const float iso = this->isoLevel;
+	const MesherCubeTables& tables = CubeTables();
+
+	// vertex cache, indexed by edge. (lower corner of edge, axis)
+	const long cw = x1 - x0;
+	const long ch = y1 - y0;
+	const long cd = z1 - z0;
+	const uint32_t invalidIndex = (uint32_t)-1;
+	DKArray<uint32_t> edgeVertices;
+	edgeVertices.Resize((cw + 1) * (ch + 1) * (cd + 1) * 3, invalidIndex);
+
+	auto edgeVertex = [&](long lx, long ly, long lz, int axis) -> uint32_t
+	{
+		uint32_t& index = edgeVertices.Value(((lx + (cw + 1) * (ly + (ch + 1) * lz)) * 3) + axis);
+		if (index != invalidIndex)
+			return index;
+
+		const long ga[3] = { x0 + lx, y0 + ly, z0 + lz };
+		long gb[3] = { ga[0], ga[1], ga[2] };
+		gb[axis]++;
+
+		// interpolate from lower voxel to upper voxel, edge shared with
+		// neighbor chunk is calculated with same values.
+		const float va = level(ga[0], ga[1], ga[2]);
+		const float vb = level(gb[0], gb[1], gb[2]);
+		const float m = (iso - va) / (vb - va);
+
+		Vertex v;
+		v.position = DKVector3((float)ga[0], (float)ga[1], (float)ga[2]);
+		v.position.val[axis] += m;
+		const DKVector3 na = gradient(ga[0], ga[1], ga[2]);
+		const DKVector3 nb = gradient(gb[0], gb[1], gb[2]);
+		v.normal = -(na + (nb - na) * m);
+		if (v.normal.LengthSq() > 0.0f)
+			v.normal.Normalize();
+
+		index = (uint32_t)chunk.mesh.vertices.Add(v);
+
+		// edge on boundary plane of chunk can be shared with neighbor.
+		const long local[3] = { lx, ly, lz };
+		const long cubes[3] = { cw, ch, cd };
+		const long dims[3] = { width, height, depth };
+		for (int k = 0; k < 3; ++k)
+		{
+			if (k == axis)
+				continue;
+			if ((local[k] == 0 && ga[k] > 0) || (local[k] == cubes[k] && ga[k] < dims[k] - 1))
+			{
+				uint64_t key = (((uint64_t)ga[2] * height + ga[1]) * width + ga[0]) * 3 + axis;
+				chunk.boundaryVertices.Add(index);
+				chunk.boundaryEdges.Add(key);
+				break;
+			}
+		}
+		return index;
+	};
+
+	for (long lz = 0; lz < cd; ++lz)
+	{
+		for (long ly = 0; ly < ch; ++ly)
+		{
+			for (long lx = 0; lx < cw; ++lx)
+			{
+				int cubeIndex = 0;
+				for (int i = 0; i < 8; ++i)
+				{
+					if (level(x0 + lx + tables.corners[i][0], y0 + ly + tables.corners[i][1], z0 + lz + tables.corners[i][2]) < iso)
+						cubeIndex |= (1 << i);
+				}
+				const int edges = DKVoxelPolygonizer::IntersectedEdges(cubeIndex);
+				if (edges == 0)
+					continue;
+
+				uint32_t verts[12];
+				for (int i = 0; i < 12; ++i)
+				{
+					if (edges & (1 << i))
+					{
+						verts[i] = edgeVertex(lx + tables.edgeOrigins[i][0],
+											  ly + tables.edgeOrigins[i][1],
+											  lz + tables.edgeOrigins[i][2],
+											  tables.edgeAxes[i]);
+					}
+				}
+				// same winding order as DKVoxelPolygonizer::PolygonizeSurface.
+				const int* tri = DKVoxelPolygonizer::TriangleEdges(cubeIndex);
+				for (int i = 0; tri[i] != -1; i += 3)
+				{
+					chunk.mesh.indices.Add({ verts[tri[i + 2]], verts[tri[i + 1]], verts[tri[i]] });
+				}
+			}
+		}
+	}
+}
+
+void DKVoxel32Mesher::GetMesh(Mesh& mesh) const
+{
+	mesh.vertices.Clear();
+	mesh.indices.Clear();
+
+	size_t numVerts = 0, numIndices = 0;
+	for (const Chunk& c : chunks)
+	{
+		numVerts += c.mesh.vertices.Count();
+		numIndices += c.mesh.indices.Count();
+	}
+	mesh.vertices.Reserve(numVerts);
+	mesh.indices.Reserve(numIndices);
+
+	const uint32_t invalidIndex = (uint32_t)-1;
+	DKHashMap<uint64_t, uint32_t> boundaryVertices;	// global edge, vertex index.
+	DKArray<uint32_t> remap;
+
+	for (const Chunk& c : chunks)
+	{
+		remap.Clear();
+		remap.Resize(c.mesh.vertices.Count(), invalidIndex);
+
+		for (size_t i = 0; i < c.boundaryVertices.Count(); ++i)
+		{
+			uint32_t index = c.boundaryVertices.Value(i);
+			uint64_t key = c.boundaryEdges.Value(i);
+			auto p = boundaryVertices.Find(key);
+			if (p)
+			{
+				remap.Value(index) = p->value;
+			}
+			else
+			{
+				uint32_t index2 = (uint32_t)mesh.vertices.Add(c.mesh.vertices.Value(index));
+				boundaryVertices.Insert(key, index2);
+				remap.Value(index) = index2;
+			}
+		}
+		for (size_t i = 0; i < remap.Count(); ++i)
+		{
+			if (remap.Value(i) == invalidIndex)
+				remap.Value(i) = (uint32_t)mesh.vertices.Add(c.mesh.vertices.Value(i));
+		}
+		for (uint32_t index : c.mesh.indices)
+			mesh.indices.Add(remap.Value(index));
+	}
+}
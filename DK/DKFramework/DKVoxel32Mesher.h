@@ -0,0 +1,127 @@
+//
+//  File: DKVoxel32Mesher.h
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2015 Hongtae Kim. All rights reserved.
+//
+
+#pragma once
+#include "../DKInclude.h"
+#include "../DKFoundation.h"
+#include "DKVector3.h"
+#include "DKTriangle.h"
+#include "DKTriangleMesh.h"
+#include "DKVoxelVolume.h"
+#include "DKVoxel32Storage.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// DKVoxel32Mesher
+// generates indexed triangle mesh of iso-surface from voxel volume, using
+// 'Marching Cubes' algorithm. (see DKVoxelPolygonizer.h)
+//
+// Volume is divided into chunks of ChunkSize^3 cubes, each chunk is
+// polygonized separately and can be polygonized in parallel.
+// Vertices are shared by adjacent cubes in chunk (cached by edge),
+// vertices on chunk boundary are welded when merging chunks with GetMesh().
+//
+// Chunks are polygonized only when marked as dirty. If you modify voxels,
+// call MarkDirty() or MarkRegionDirty() and then call Update(), only
+// affected chunks will be polygonized again. You can use SetVoxelAtLocation()
+// or SetVoxels() of mesher, to modify volume and mark chunks together.
+//
+// Vertex position is voxel coordinates, normal is calculated from gradient
+// of voxel levels.
+//
+// Note:
+//  Update() reads voxels with volume's GetVoxels(), volume should not be
+//  modified while updating.
+//  Calling Update() and accessing chunks (or GetMesh) at the same time
+//  is not safe, Mark functions can be called from any threads.
+////////////////////////////////////////////////////////////////////////////////
+
+namespace DKFramework
+{
+	class DKGL_API DKVoxel32Mesher
+	{
+	public:
+		typedef DKVoxelVolume<DKVoxel32> Volume;
+
+		enum {ChunkSize = 32};	// number of cubes in each axis of chunk.
+
+		struct Vertex
+		{
+			DKVector3 position;
+			DKVector3 normal;
+		};
+		struct Mesh : public DKTriangleMesh
+		{
+			DKFoundation::DKArray<Vertex> vertices;
+			DKFoundation::DKArray<uint32_t> indices;	// three indices per triangle
+
+			int NumberOfTriangles(void) const;
+			bool GetTriangleAtIndex(int index, DKTriangle&) const;
+		};
+		struct Chunk
+		{
+			unsigned int x, y, z;			// origin of chunk (voxel coordinates)
+			Mesh mesh;
+			// vertices on chunk boundary, which can be shared with neighbors.
+			DKFoundation::DKArray<uint32_t> boundaryVertices;
+			DKFoundation::DKArray<uint64_t> boundaryEdges;	// global edge key of boundaryVertices
+			bool dirty;
+		};
+
+		DKVoxel32Mesher(Volume* volume = NULL);
+		~DKVoxel32Mesher(void);
+
+		// set volume, all chunks become dirty.
+		void SetVolume(Volume* volume);
+		Volume* VoxelVolume(void)					{ return volume; }
+		const Volume* VoxelVolume(void) const		{ return volume; }
+
+		// iso-surface level, voxel level is in range of 0 ~ 255. (default: 127.5)
+		void SetIsoLevel(float level);
+		float IsoLevel(void) const					{ return isoLevel; }
+
+		// mark chunks affected by voxel (or region) to be polygonized again.
+		void MarkDirty(unsigned int x, unsigned int y, unsigned int z);
+		void MarkRegionDirty(unsigned int x, unsigned int y, unsigned int z, size_t width, size_t height, size_t depth);
+		void MarkAllDirty(void);
+
+		// modify volume and mark affected chunks.
+		bool SetVoxelAtLocation(unsigned int x, unsigned int y, unsigned int z, const DKVoxel32& v);
+		bool SetVoxels(unsigned int x, unsigned int y, unsigned int z, size_t width, size_t height, size_t depth, const DKVoxel32* voxels);
+
+		// polygonize dirty chunks. chunks are polygonized in parallel with
+		// queue if queue is not NULL.
+		// indices of polygonized chunks are stored in updatedChunks if not NULL.
+		// returns number of polygonized chunks.
+		size_t Update(DKFoundation::DKOperationQueue* queue = NULL, DKFoundation::DKArray<size_t>* updatedChunks = NULL);
+
+		size_t NumberOfChunks(void) const			{ return chunks.Count(); }
+		void GetChunkDimensions(size_t* x, size_t* y, size_t* z) const;
+		const Chunk& ChunkAtIndex(size_t index) const;
+
+		// merge all chunks into one mesh, vertices on chunk boundary are welded.
+		void GetMesh(Mesh& mesh) const;
+
+	private:
+		void ResetChunks(void);
+		void MarkChunks(long x0, long y0, long z0, long x1, long y1, long z1);
+		void PolygonizeChunk(Chunk& chunk);
+
+		DKFoundation::DKObject<Volume> volume;
+		float isoLevel;
+
+		size_t volumeWidth;
+		size_t volumeHeight;
+		size_t volumeDepth;
+
+		size_t chunksX;
+		size_t chunksY;
+		size_t chunksZ;
+		DKFoundation::DKArray<Chunk> chunks;
+		size_t numDirtyChunks;
+		DKFoundation::DKSpinLock dirtyLock;		// lock for dirty flag of chunks.
+	};
+}
@@ -123,7 +123,7 @@ DKVoxel32SparseVolume::DKVoxel32SparseVolume(Storage* stor)
 	, width(0), height(0), depth(0)
 	, storage(stor)
 	, volumeBlocks(NULL)
-	, lastCompactedTS(0)
+	, clockHand(NULL)
 {
 	if (storage == NULL)
 		storage = DKObject<Private::Voxel32MemoryStorage>::New();
@@ -131,23 +131,13 @@ DKVoxel32SparseVolume::DKVoxel32SparseVolume(Storage* stor)
 
 DKVoxel32SparseVolume::~DKVoxel32SparseVolume(void)
 {
-	if (blocksLoaded > 0)
+	while (clockHand)
 	{
-		size_t w = VolumeSizeDiv<size_t>(width, UnitSize);
-		size_t h = VolumeSizeDiv<size_t>(height, UnitSize);
-		size_t d = VolumeSizeDiv<size_t>(depth, UnitSize);
-		size_t numBlocks = w * h * d;
-
-		for (size_t i = 0; i < numBlocks; ++i)
-		{
-			VolumetricBlock& b = volumeBlocks[i];
-			if (b.storageId.IsZero()) continue;
-			if (b.voxels)
-			{
-				storage->Unload(b.storageId);
-				blocksLoaded--;
-			}
-		}
+		VolumetricBlock* b = clockHand;
+		DKASSERT_DEBUG(b->voxels);
+		storage->Unload(b->storageId);
+		b->voxels = NULL;
+		UnlinkResidentBlock(b);
 	}
 	DKASSERT_DEBUG(blocksLoaded == 0);
 
@@ -173,11 +163,13 @@ bool DKVoxel32SparseVolume::ResetContents(void)
 			b.storageId.SetZero();
 		}
 		b.voxels = NULL;
-		b.ts = 0;
+		b.prev = NULL;
+		b.next = NULL;
+		b.referenced = false;
+		b.modified = false;
 	}
 	blocksLoaded = 0;
-
-	lastCompactedTS = 0;
+	clockHand = NULL;
 	return true;
 }
 
@@ -214,19 +206,9 @@ bool DKVoxel32SparseVolume::GetVoxelAtLocation(unsigned int x, unsigned int y, u
 		}
 		else
 		{
-			if (block.voxels == NULL)
-			{
-				size_t maxLoadable = Max<size_t>(storage->MaxActiveUnits(), 1);
-
-				if (blocksLoaded >= maxLoadable)
-					UnloadOldBlocks(maxLoadable - blocksLoaded + 1);
-
-				block.voxels = storage->Load(block.storageId);
-				blocksLoaded++;
-			}
+			LoadBlock(block);
 			size_t idx2 = LocationIndex<size_t>(x % UnitSize, y % UnitSize, z % UnitSize, UnitSize, UnitSize, UnitSize);
 			v = block.voxels[idx2];
-			block.ts = DKTimer::SystemTick();
 		}
 		return true;
 	}
@@ -248,51 +230,151 @@ bool DKVoxel32SparseVolume::SetVoxelAtLocation(unsigned int x, unsigned int y, u
 
 		size_t idx = LocationIndex<size_t>(bx, by, bz, w, h, d);
 		size_t idx2 = LocationIndex<size_t>(x % UnitSize, y % UnitSize, z % UnitSize, UnitSize, UnitSize, UnitSize);
-		const size_t numVoxels = UnitSize * UnitSize * UnitSize;
-
-		size_t maxLoadable = Max<size_t>(storage->MaxActiveUnits(), 1);
 
 		VolumetricBlock& block = volumeBlocks[idx];
 
 		DKCriticalSection<DKSpinLock> blockGuard(block.lock);
 		if (block.storageId.IsZero())
 		{
-			if (block.solid.uintValue != v.uintValue)
+			if (block.solid.uintValue == v.uintValue)
+				return true;
+			CreateBlock(block);
+		}
+		else
+		{
+			LoadBlock(block);
+		}
+		block.voxels[idx2] = v;
+		block.modified = true;
+		return true;
+	}
+	return false;
+}
+
+bool DKVoxel32SparseVolume::GetVoxels(unsigned int x, unsigned int y, unsigned int z, size_t rw, size_t rh, size_t rd, DKVoxel32* voxels)
+{
+	DKSharedLockReadOnlySection guard(volumeLock);
+	if (voxels == NULL || x + rw > width || y + rh > height || z + rd > depth)
+		return false;
+	if (rw == 0 || rh == 0 || rd == 0)
+		return true;
+
+	size_t w = VolumeSizeDiv<size_t>(width, UnitSize);
+	size_t h = VolumeSizeDiv<size_t>(height, UnitSize);
+	size_t d = VolumeSizeDiv<size_t>(depth, UnitSize);
+
+	const size_t x1 = x + rw;
+	const size_t y1 = y + rh;
+	const size_t z1 = z + rd;
+
+	for (size_t bz = z / UnitSize; bz * UnitSize < z1; ++bz)
+	{
+		for (size_t by = y / UnitSize; by * UnitSize < y1; ++by)
+		{
+			for (size_t bx = x / UnitSize; bx * UnitSize < x1; ++bx)
 			{
-				if (blocksLoaded >= maxLoadable)
-					UnloadOldBlocks(maxLoadable - blocksLoaded + 1);
-
-				DKVoxel32 solid = block.solid;
-				block.storageId = DKUuid::Create();
-				block.voxels = storage->Create(block.storageId);
-				DKASSERT_DEBUG(block.voxels);
-				for (size_t i = 0; i < numVoxels; ++i)
+				// intersection of region and block.
+				size_t sx = Max<size_t>(x, bx * UnitSize), ex = Min(x1, (bx + 1) * UnitSize);
+				size_t sy = Max<size_t>(y, by * UnitSize), ey = Min(y1, (by + 1) * UnitSize);
+				size_t sz = Max<size_t>(z, bz * UnitSize), ez = Min(z1, (bz + 1) * UnitSize);
+
+				VolumetricBlock& block = volumeBlocks[LocationIndex<size_t>(bx, by, bz, w, h, d)];
+				DKCriticalSection<DKSpinLock> blockGuard(block.lock);
+
+				const DKVoxel32* src = NULL;
+				if (!block.storageId.IsZero())
+				{
+					LoadBlock(block);
+					src = block.voxels;
+				}
+				for (size_t vz = sz; vz < ez; ++vz)
 				{
-					block.voxels[i] = solid;
+					for (size_t vy = sy; vy < ey; ++vy)
+					{
+						DKVoxel32* dst = &voxels[LocationIndex<size_t>(sx - x, vy - y, vz - z, rw, rh, rd)];
+						if (src)
+						{
+							const DKVoxel32* row = &src[LocationIndex<size_t>(sx % UnitSize, vy % UnitSize, vz % UnitSize, UnitSize, UnitSize, UnitSize)];
+							memcpy(dst, row, (ex - sx) * sizeof(DKVoxel32));
+						}
+						else
+						{
+							for (size_t vx = sx; vx < ex; ++vx)
+								*dst++ = block.solid;
+						}
+					}
 				}
-				block.voxels[idx2] = v;
-				block.ts = DKTimer::SystemTick();
-				blocksLoaded++;
 			}
 		}
-		else
+	}
+	return true;
+}
+
+bool DKVoxel32SparseVolume::SetVoxels(unsigned int x, unsigned int y, unsigned int z, size_t rw, size_t rh, size_t rd, const DKVoxel32* voxels)
+{
+	DKSharedLockReadOnlySection guard(volumeLock);
+	if (voxels == NULL || x + rw > width || y + rh > height || z + rd > depth)
+		return false;
+	if (rw == 0 || rh == 0 || rd == 0)
+		return true;
+
+	size_t w = VolumeSizeDiv<size_t>(width, UnitSize);
+	size_t h = VolumeSizeDiv<size_t>(height, UnitSize);
+	size_t d = VolumeSizeDiv<size_t>(depth, UnitSize);
+
+	const size_t x1 = x + rw;
+	const size_t y1 = y + rh;
+	const size_t z1 = z + rd;
+
+	for (size_t bz = z / UnitSize; bz * UnitSize < z1; ++bz)
+	{
+		for (size_t by = y / UnitSize; by * UnitSize < y1; ++by)
 		{
-			if (block.voxels == NULL)
+			for (size_t bx = x / UnitSize; bx * UnitSize < x1; ++bx)
 			{
-				if (blocksLoaded >= maxLoadable)
-					UnloadOldBlocks(maxLoadable - blocksLoaded + 1);
+				// intersection of region and block.
+				size_t sx = Max<size_t>(x, bx * UnitSize), ex = Min(x1, (bx + 1) * UnitSize);
+				size_t sy = Max<size_t>(y, by * UnitSize), ey = Min(y1, (by + 1) * UnitSize);
+				size_t sz = Max<size_t>(z, bz * UnitSize), ez = Min(z1, (bz + 1) * UnitSize);
 
-				block.voxels = storage->Load(block.storageId);
-				blocksLoaded++;
-			}
-			DKASSERT_DEBUG(block.voxels);
+				VolumetricBlock& block = volumeBlocks[LocationIndex<size_t>(bx, by, bz, w, h, d)];
+				DKCriticalSection<DKSpinLock> blockGuard(block.lock);
 
-			block.voxels[idx2] = v;
-			block.ts = DKTimer::SystemTick();
+				if (block.storageId.IsZero())
+				{
+					// solid-block remains solid if all values are same.
+					bool solid = true;
+					for (size_t vz = sz; vz < ez && solid; ++vz)
+					{
+						for (size_t vy = sy; vy < ey && solid; ++vy)
+						{
+							const DKVoxel32* src = &voxels[LocationIndex<size_t>(sx - x, vy - y, vz - z, rw, rh, rd)];
+							for (size_t vx = sx; vx < ex && solid; ++vx)
+								solid = (src++)->uintValue == block.solid.uintValue;
+						}
+					}
+					if (solid)
+						continue;
+					CreateBlock(block);
+				}
+				else
+				{
+					LoadBlock(block);
+				}
+				for (size_t vz = sz; vz < ez; ++vz)
+				{
+					for (size_t vy = sy; vy < ey; ++vy)
+					{
+						const DKVoxel32* src = &voxels[LocationIndex<size_t>(sx - x, vy - y, vz - z, rw, rh, rd)];
+						DKVoxel32* row = &block.voxels[LocationIndex<size_t>(sx % UnitSize, vy % UnitSize, vz % UnitSize, UnitSize, UnitSize, UnitSize)];
+						memcpy(row, src, (ex - sx) * sizeof(DKVoxel32));
+					}
+				}
+				block.modified = true;
+			}
 		}
-		return true;
 	}
-	return false;
+	return true;
 }
 
 void DKVoxel32SparseVolume::GetDimensions(size_t* w, size_t* h, size_t* d)
@@ -305,7 +387,7 @@ void DKVoxel32SparseVolume::GetDimensions(size_t* w, size_t* h, size_t* d)
 
 bool DKVoxel32SparseVolume::SetDimensions(size_t w, size_t h, size_t d)
 {
-	DKSharedLockReadOnlySection guard(volumeLock);
+	DKCriticalSection<DKSharedLock> guard(volumeLock);	// exclusive lock
 
 	size_t w1 = VolumeSizeDiv<size_t>(width, UnitSize);
 	size_t h1 = VolumeSizeDiv<size_t>(height, UnitSize);
@@ -319,10 +401,10 @@ bool DKVoxel32SparseVolume::SetDimensions(size_t w, size_t h, size_t d)
 		size_t numBlocks1 = w1 * h1 * d1;
 		size_t numBlocks2 = w2 * h2 * d2;
 
-		if (numBlocks1 > 0 && numBlocks2 > 0)
+		VolumetricBlock* volumeBlocks2 = NULL;
+		if (numBlocks2 > 0)
 		{
-			VolumetricBlock* volumeBlocks2 = new VolumetricBlock[numBlocks2];
-
+			volumeBlocks2 = new VolumetricBlock[numBlocks2];
 			for (size_t z = 0; z < d2; ++z)
 			{
 				for (size_t y = 0; y < h2; ++y)
@@ -331,7 +413,10 @@ bool DKVoxel32SparseVolume::SetDimensions(size_t w, size_t h, size_t d)
 					{
 						size_t idx = LocationIndex<size_t>(x,y,z,w2,h2,d2);
 						VolumetricBlock& b = volumeBlocks2[idx];
-						b.ts = 0;
+						b.prev = NULL;
+						b.next = NULL;
+						b.referenced = false;
+						b.modified = false;
 
 						if (x < w1 && y < h1 && z < d1)
 						{
@@ -339,7 +424,7 @@ bool DKVoxel32SparseVolume::SetDimensions(size_t w, size_t h, size_t d)
 							VolumetricBlock& b2 = volumeBlocks[idx2];
 							b.storageId = b2.storageId;
 							b.voxels = b2.voxels;
-							b.ts = DKTimer::SystemTick();
+							b.modified = b2.modified;
 
 							b2.storageId.SetZero();
 							b2.voxels = NULL;
@@ -352,49 +437,24 @@ bool DKVoxel32SparseVolume::SetDimensions(size_t w, size_t h, size_t d)
 					}
 				}
 			}
-			for (size_t i = 0; i < numBlocks1; ++i)
-			{
-				VolumetricBlock& b = volumeBlocks[i];
-				if (b.storageId.IsZero()) continue;
-				if (b.voxels)
-				{
-					blocksLoaded--;
-				}
-				storage->Delete(b.storageId);
-			}
-			delete[] volumeBlocks;
-			volumeBlocks = volumeBlocks2;
-		}
-		else if (numBlocks1 > 0)
-		{
-			for (size_t i = 0; i < numBlocks1; ++i)
-			{
-				VolumetricBlock& b = volumeBlocks[i];
-				if (b.storageId.IsZero()) continue;
-				if (b.voxels)
-				{
-					blocksLoaded--;
-				}
-				storage->Delete(b.storageId);
-			}
-			delete[] volumeBlocks;
-			volumeBlocks = NULL;
 		}
-		else if (numBlocks2 > 0)
+		// delete blocks not moved.
+		for (size_t i = 0; i < numBlocks1; ++i)
 		{
-			DKASSERT_DEBUG(volumeBlocks == NULL);
-			volumeBlocks = new VolumetricBlock[numBlocks2];
-			for (size_t i = 0; i < numBlocks2; ++i)
-			{
-				volumeBlocks[i].storageId.SetZero();
-				volumeBlocks[i].voxels = NULL;
-				volumeBlocks[i].ts = 0;
-			}
+			VolumetricBlock& b = volumeBlocks[i];
+			if (b.storageId.IsZero()) continue;
+			storage->Delete(b.storageId);
 		}
+		if (volumeBlocks)
+			delete[] volumeBlocks;
+		volumeBlocks = volumeBlocks2;
 	}
 	width = w;
 	height = h;
 	depth = d;
+
+	DKCriticalSection<DKSpinLock> residentGuard(residentLock);
+	RebuildResidentBlocks();
 	return true;
 }
 
@@ -406,12 +466,9 @@ void DKVoxel32SparseVolume::Compact(void)
 	size_t h = VolumeSizeDiv<size_t>(height, UnitSize);
 	size_t d = VolumeSizeDiv<size_t>(depth, UnitSize);
 	size_t numBlocks = w * h * d;
-	VolumetricBlock* blocks = this->volumeBlocks;
 
 	const size_t numVoxels = UnitSize * UnitSize * UnitSize;
 
-	TimeStamp ts = DKTimer::SystemTick();
-
 	for (size_t i = 0; i < numBlocks; ++i)
 	{
 		VolumetricBlock& block = this->volumeBlocks[i];
@@ -419,8 +476,10 @@ void DKVoxel32SparseVolume::Compact(void)
 		DKCriticalSection<DKSpinLock> blockGuard(block.lock);
 		if (block.storageId.IsZero())
 			continue;
-		if (block.voxels && block.ts >= lastCompactedTS)
+		if (block.voxels && block.modified)
 		{
+			block.modified = false;
+
 			DKVoxel32 firstValue = block.voxels[0];
 			DKVoxel32 lastValue = block.voxels[numVoxels-1];
 			DKVoxel32 middleValue = block.voxels[numVoxels/2];
@@ -437,76 +496,520 @@ void DKVoxel32SparseVolume::Compact(void)
 			}
 			if (solid) // every voxel's values are equal. change type to solid-block
 			{
+				DKCriticalSection<DKSpinLock> residentGuard(residentLock);
+				UnlinkResidentBlock(&block);
 				storage->Delete(block.storageId);
 				block.storageId.SetZero();
-				block.ts = 0;
 				block.solid = firstValue;
 			}
 		}
 	}
-	lastCompactedTS = ts;
 }
 
-void DKVoxel32SparseVolume::UnloadOldBlocks(size_t num)
+bool DKVoxel32SparseVolume::RayTest(const DKLine& ray, RayHitResult* result, float isoLevel)
+{
+	RayHitResult r;
+	bool hit = RayTest(&ray, 1, &r, isoLevel) > 0;
+	if (result)
+		*result = r;
+	return hit;
+}
+
+size_t DKVoxel32SparseVolume::RayTest(const DKLine* rays, size_t count, RayHitResult* results, float isoLevel, DKOperationQueue* queue)
 {
+	if (rays == NULL || results == NULL || count == 0)
+		return 0;
+
 	DKSharedLockReadOnlySection guard(volumeLock);
 
-	if (blocksLoaded == 0)
-		return;
+	const size_t raysPerTask = 64;
+	if (queue && count > raysPerTask)
+	{
+		DKOperationQueue::TaskGroup group(queue);
+		for (size_t begin = 0; begin < count; begin += raysPerTask)
+		{
+			size_t end = Min(begin + raysPerTask, count);
+			group.Post(DKFunction([this, rays, results, isoLevel, begin, end]
+			{
+				for (size_t i = begin; i < end; ++i)
+					RayTestInternal(rays[i], results[i], isoLevel);
+			})->Invocation());
+		}
+		group.Wait();
+	}
+	else
+	{
+		for (size_t i = 0; i < count; ++i)
+			RayTestInternal(rays[i], results[i], isoLevel);
+	}
+
+	size_t numHits = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (results[i].hit)
+			numHits++;
+	}
+	return numHits;
+}
+
+void DKVoxel32SparseVolume::GetCubeLevels(size_t x, size_t y, size_t z, float* levels)
+{
+	// levels of 8 voxels of cube (x ~ x+1, y ~ y+1, z ~ z+1),
+	// index of levels: dx + dy * 2 + dz * 4
+	DKASSERT_DEBUG(x + 1 < width && y + 1 < height && z + 1 < depth);
 
 	size_t w = VolumeSizeDiv<size_t>(width, UnitSize);
 	size_t h = VolumeSizeDiv<size_t>(height, UnitSize);
 	size_t d = VolumeSizeDiv<size_t>(depth, UnitSize);
-	size_t numBlocks = w * h * d;
 
-	if (num > 0 && numBlocks > 0 )
+	const size_t lx = x % UnitSize;
+	const size_t ly = y % UnitSize;
+	const size_t lz = z % UnitSize;
+	// cube on last layer of block spans next block, lock each block once.
+	const int spanX = (lx == UnitSize - 1) ? 1 : 0;
+	const int spanY = (ly == UnitSize - 1) ? 1 : 0;
+	const int spanZ = (lz == UnitSize - 1) ? 1 : 0;
+
+	for (int bk = 0; bk <= spanZ; ++bk)
 	{
-		if (numBlocks > num)	// sort ascending by timestamp
+		for (int bj = 0; bj <= spanY; ++bj)
 		{
-			typedef VolumetricBlock* Value;
-			auto sortByTSDesc = [](VolumetricBlock* const & lhs, VolumetricBlock* const & rhs)->bool
+			for (int bi = 0; bi <= spanX; ++bi)
 			{
-				return lhs->ts > rhs->ts;
-			};
+				VolumetricBlock& block = volumeBlocks[LocationIndex<size_t>(x / UnitSize + bi, y / UnitSize + bj, z / UnitSize + bk, w, h, d)];
+				DKCriticalSection<DKSpinLock> blockGuard(block.lock);
 
-			DKOrderedArray<VolumetricBlock*> blocks(sortByTSDesc);
-			blocks.Reserve(numBlocks);
-			for (size_t i = 0; i < numBlocks; ++i)
-			{
-				VolumetricBlock& b = this->volumeBlocks[i];
-				DKCriticalSection<DKSpinLock> blockGuard(b.lock);
-				if (b.storageId.IsZero())
-					continue;
-				if (b.voxels)
-					blocks.Insert(&b);
+				const DKVoxel32* voxels = NULL;
+				if (!block.storageId.IsZero())
+				{
+					LoadBlock(block);
+					voxels = block.voxels;
+				}
+				for (int n = 0; n < 8; ++n)
+				{
+					const int dx = n & 1, dy = (n >> 1) & 1, dz = n >> 2;
+					if ((dx & spanX) != bi || (dy & spanY) != bj || (dz & spanZ) != bk)
+						continue;	// voxel of other block.
+					if (voxels)
+						levels[n] = voxels[LocationIndex<size_t>((lx + dx) % UnitSize, (ly + dy) % UnitSize, (lz + dz) % UnitSize, UnitSize, UnitSize, UnitSize)].level;
+					else
+						levels[n] = block.solid.level;
+				}
 			}
+		}
+	}
+}
+
+void DKVoxel32SparseVolume::RayTestInternal(const DKLine& ray, RayHitResult& result, float isoLevel)
+{
+	result.hit = false;
+	result.hitFraction = 1.0f;
+	result.hitPoint = ray.end;
+	result.hitNormal = DKVector3(0, 0, 0);
+
+	if (width < 2 || height < 2 || depth < 2)
+		return;
+
+	const DKVector3 dir = ray.end - ray.begin;
+	const float origin[3] = { ray.begin.x, ray.begin.y, ray.begin.z };
+	const float direction[3] = { dir.x, dir.y, dir.z };
+	const long cubes[3] = { (long)width - 1, (long)height - 1, (long)depth - 1 };
+
+	// clip ray with bounds of cubes.
+	float t = 0.0f;
+	float tEnd = 1.0f;
+	for (int k = 0; k < 3; ++k)
+	{
+		if (direction[k] == 0.0f)
+		{
+			if (origin[k] < 0.0f || origin[k] > (float)cubes[k])
+				return;
+		}
+		else
+		{
+			float ta = -origin[k] / direction[k];
+			float tb = ((float)cubes[k] - origin[k]) / direction[k];
+			t = Max(t, Min(ta, tb));
+			tEnd = Min(tEnd, Max(ta, tb));
+			if (t > tEnd)
+				return;
+		}
+	}
 
-			size_t n = Min(num, blocks.Count());
-			for (size_t i = 0; i < n; ++i)
+	// 3D-DDA through cubes.
+	long cell[3];
+	int step[3];
+	float tMax[3];	// ray fraction of next cube boundary of each axis.
+	auto setCell = [&](int k, long c)
+	{
+		cell[k] = c;
+		if (step[k] > 0)
+			tMax[k] = ((float)(c + 1) - origin[k]) / direction[k];
+		else if (step[k] < 0)
+			tMax[k] = ((float)c - origin[k]) / direction[k];
+		else
+			tMax[k] = FLT_MAX;
+	};
+	for (int k = 0; k < 3; ++k)
+	{
+		step[k] = direction[k] > 0.0f ? 1 : (direction[k] < 0.0f ? -1 : 0);
+		setCell(k, Clamp((long)floor(origin[k] + direction[k] * t), 0L, cubes[k] - 1));
+	}
+	// step to next cube, returns false if ray ends.
+	auto nextCube = [&]() -> bool
+	{
+		int axis = 0;
+		if (tMax[1] < tMax[axis])	axis = 1;
+		if (tMax[2] < tMax[axis])	axis = 2;
+		if (tMax[axis] > tEnd)
+			return false;
+		t = tMax[axis];
+		long c = cell[axis] + step[axis];
+		if (c < 0 || c >= cubes[axis])
+			return false;
+		setCell(axis, c);
+		return true;
+	};
+	// cube on last layer of block shares voxels with next blocks.
+	auto isInnerCube = [&]() -> bool
+	{
+		return cell[0] % UnitSize != UnitSize - 1 && cell[1] % UnitSize != UnitSize - 1 && cell[2] % UnitSize != UnitSize - 1;
+	};
+
+	float levels[8];	// index: dx + dy * 2 + dz * 4
+	// iso-level relative value of trilinear interpolation at ray fraction.
+	auto value = [&](float f) -> float
+	{
+		float u = Clamp(origin[0] + direction[0] * f - (float)cell[0], 0.0f, 1.0f);
+		float v = Clamp(origin[1] + direction[1] * f - (float)cell[1], 0.0f, 1.0f);
+		float w = Clamp(origin[2] + direction[2] * f - (float)cell[2], 0.0f, 1.0f);
+		float c00 = levels[0] + (levels[1] - levels[0]) * u;
+		float c10 = levels[2] + (levels[3] - levels[2]) * u;
+		float c01 = levels[4] + (levels[5] - levels[4]) * u;
+		float c11 = levels[6] + (levels[7] - levels[6]) * u;
+		float c0 = c00 + (c10 - c00) * v;
+		float c1 = c01 + (c11 - c01) * v;
+		return c0 + (c1 - c0) * w - isoLevel;
+	};
+	// find surface in current cube, returns true if hit.
+	auto testCube = [&]() -> bool
+	{
+		float minLevel = levels[0], maxLevel = levels[0];
+		for (int n = 1; n < 8; ++n)
+		{
+			minLevel = Min(minLevel, levels[n]);
+			maxLevel = Max(maxLevel, levels[n]);
+		}
+		if (minLevel >= isoLevel || maxLevel < isoLevel)
+			return false;
+
+		// find first sign change of trilinear function along ray segment.
+		const float tNext = Min(Min(tMax[0], tMax[1]), Min(tMax[2], tEnd));
+		const int subdivisions = 4;
+		float ta = t;
+		float fa = value(ta);
+		for (int i = 1; i <= subdivisions; ++i)
+		{
+			float tb = t + (tNext - t) * (float)i / (float)subdivisions;
+			float fb = value(tb);
+			if ((fa >= 0.0f) != (fb >= 0.0f))
 			{
-				VolumetricBlock* p = blocks.Value(i);
-				DKCriticalSection<DKSpinLock> blockGuard(p->lock);
-				DKASSERT_DEBUG(p->voxels);
-				storage->Unload(p->storageId);
-				p->voxels = NULL;
-				blocksLoaded--;
+				for (int n = 0; n < 12; ++n)	// bisection
+				{
+					float tm = (ta + tb) * 0.5f;
+					float fm = value(tm);
+					if ((fa >= 0.0f) == (fm >= 0.0f))
+					{
+						ta = tm;
+						fa = fm;
+					}
+					else
+					{
+						tb = tm;
+						fb = fm;
+					}
+				}
+				const float tHit = ta + (tb - ta) * (fa / (fa - fb));
+
+				// gradient of trilinear function at hit point.
+				const DKVector3 p = ray.begin + dir * tHit;
+				float u = Clamp(p.x - (float)cell[0], 0.0f, 1.0f);
+				float v = Clamp(p.y - (float)cell[1], 0.0f, 1.0f);
+				float w = Clamp(p.z - (float)cell[2], 0.0f, 1.0f);
+				DKVector3 gradient(
+					((levels[1] - levels[0]) * (1 - v) + (levels[3] - levels[2]) * v) * (1 - w) +
+					((levels[5] - levels[4]) * (1 - v) + (levels[7] - levels[6]) * v) * w,
+					((levels[2] - levels[0]) * (1 - u) + (levels[3] - levels[1]) * u) * (1 - w) +
+					((levels[6] - levels[4]) * (1 - u) + (levels[7] - levels[5]) * u) * w,
+					((levels[4] - levels[0]) * (1 - u) + (levels[5] - levels[1]) * u) * (1 - v) +
+					((levels[6] - levels[2]) * (1 - u) + (levels[7] - levels[3]) * u) * v);
+
+				result.hit = true;
+				result.hitFraction = tHit;
+				result.hitPoint = p;
+				result.hitNormal = -gradient;
+				if (result.hitNormal.LengthSq() > 0.0f)
+					result.hitNormal.Normalize();
+				return true;
 			}
+			ta = tb;
+			fa = fb;
 		}
-		else		// volumeBlocks is smaller, unload all
+		return false;
+	};
+
+	size_t w = VolumeSizeDiv<size_t>(width, UnitSize);
+	size_t h = VolumeSizeDiv<size_t>(height, UnitSize);
+	size_t d = VolumeSizeDiv<size_t>(depth, UnitSize);
+
+	while (true)
+	{
+		if (isInnerCube())
 		{
-			for (size_t i = 0; i < numBlocks; ++i)
+			// all voxels of cube are in one block, lock block once
+			// for all inner cubes of block along the ray.
+			const long block[3] = { cell[0] / UnitSize, cell[1] / UnitSize, cell[2] / UnitSize };
+			VolumetricBlock& vb = volumeBlocks[LocationIndex<size_t>(block[0], block[1], block[2], w, h, d)];
+			DKCriticalSection<DKSpinLock> blockGuard(vb.lock);
+			if (vb.storageId.IsZero())
 			{
-				VolumetricBlock& b = this->volumeBlocks[i];
-				DKCriticalSection<DKSpinLock> blockGuard(b.lock);
-				if (b.storageId.IsZero())
-					continue;
-				if (b.voxels)
+				// solid block has no surface inside, skip inner cubes at once.
+				int axis = -1;
+				float tExit = FLT_MAX;
+				for (int k = 0; k < 3; ++k)
+				{
+					if (step[k] == 0)
+						continue;
+					float plane = (float)(block[k] * UnitSize + (step[k] > 0 ? UnitSize - 1 : 0));
+					float tk = (plane - origin[k]) / direction[k];
+					if (tk < tExit)
+					{
+						tExit = tk;
+						axis = k;
+					}
+				}
+				if (axis < 0 || tExit > tEnd)
+					return;
+
+				t = Max(t, tExit);
+				for (int k = 0; k < 3; ++k)
 				{
-					storage->Unload(b.storageId);
-					b.voxels = NULL;
-					blocksLoaded--;
+					long c;
+					if (k == axis)
+						c = step[k] > 0 ? block[k] * UnitSize + UnitSize - 1 : block[k] * UnitSize - 1;
+					else
+						c = Clamp((long)floor(origin[k] + direction[k] * t), block[k] * UnitSize, block[k] * UnitSize + UnitSize - 2);
+					if (c < 0 || c >= cubes[k])
+						return;
+					setCell(k, c);
 				}
+				continue;
 			}
+
+			LoadBlock(vb);
+			const size_t cornerOffsets[8] =
+			{
+				0, 1, UnitSize, UnitSize + 1,
+				UnitSize * UnitSize, UnitSize * UnitSize + 1, UnitSize * UnitSize + UnitSize, UnitSize * UnitSize + UnitSize + 1,
+			};
+			do
+			{
+				const DKVoxel32* voxels = &vb.voxels[LocationIndex<size_t>(cell[0] % UnitSize, cell[1] % UnitSize, cell[2] % UnitSize, UnitSize, UnitSize, UnitSize)];
+				for (int n = 0; n < 8; ++n)
+					levels[n] = voxels[cornerOffsets[n]].level;
+				if (testCube() || !nextCube())
+					return;
+			} while (isInnerCube());	// next inner cube is always in same block.
+		}
+		else
+		{
+			GetCubeLevels(cell[0], cell[1], cell[2], levels);
+			if (testCube() || !nextCube())
+				return;
 		}
 	}
 }
+
+void DKVoxel32SparseVolume::LoadBlock(VolumetricBlock& block)
+{
+	DKASSERT_DEBUG(!block.storageId.IsZero());
+	if (block.voxels == NULL)
+	{
+		UnloadOldBlocks(1, &block);
+		block.voxels = storage->Load(block.storageId);
+		DKASSERT_DEBUG(block.voxels);
+
+		DKCriticalSection<DKSpinLock> residentGuard(residentLock);
+		LinkResidentBlock(&block);
+	}
+	else
+	{
+		block.referenced = true;
+		return;
+	}
+	PrefetchNeighborBlocks(block);
+}
+
+void DKVoxel32SparseVolume::CreateBlock(VolumetricBlock& block)
+{
+	DKASSERT_DEBUG(block.storageId.IsZero());
+	const size_t numVoxels = UnitSize * UnitSize * UnitSize;
+
+	UnloadOldBlocks(1, &block);
+
+	DKVoxel32 solid = block.solid;
+	block.storageId = DKUuid::Create();
+	block.voxels = storage->Create(block.storageId);
+	DKASSERT_DEBUG(block.voxels);
+	for (size_t i = 0; i < numVoxels; ++i)
+	{
+		block.voxels[i] = solid;
+	}
+
+	DKCriticalSection<DKSpinLock> residentGuard(residentLock);
+	LinkResidentBlock(&block);
+}
+
+// make room for 'num' blocks to be loaded.
+// lockedBlock is being locked by caller, it will not be unloaded.
+void DKVoxel32SparseVolume::UnloadOldBlocks(size_t num, VolumetricBlock* lockedBlock)
+{
+	size_t maxLoadable = Max<size_t>(storage->MaxActiveUnits(), MINIMUM_LOADED_BLOCKS);
+
+	residentLock.Lock();
+	num = (blocksLoaded + num > maxLoadable) ? (blocksLoaded + num - maxLoadable) : 0;
+	residentLock.Unlock();
+
+	while (num > 0)
+	{
+		// CLOCK (second-chance): referenced blocks are skipped once.
+		// blocks being locked by other threads are skipped also.
+		VolumetricBlock* victim = NULL;
+		residentLock.Lock();
+		size_t maxVisits = blocksLoaded * 2 + 1;
+		for (size_t visits = 0; clockHand && visits < maxVisits; ++visits)
+		{
+			VolumetricBlock* b = clockHand;
+			clockHand = b->next;
+
+			if (b == lockedBlock)
+				continue;
+			if (b->referenced)
+			{
+				b->referenced = false;
+				continue;
+			}
+			if (b->lock.TryLock())
+			{
+				UnlinkResidentBlock(b);
+				victim = b;
+				break;
+			}
+		}
+		residentLock.Unlock();
+
+		if (victim == NULL)
+			break;
+
+		// victim is unlinked and locked, unload without holding residentLock.
+		DKASSERT_DEBUG(victim->voxels);
+		storage->Unload(victim->storageId);
+		victim->voxels = NULL;
+		victim->lock.Unlock();
+		num--;
+	}
+}
+
+void DKVoxel32SparseVolume::PrefetchNeighborBlocks(VolumetricBlock& block)
+{
+	size_t w = VolumeSizeDiv<size_t>(width, UnitSize);
+	size_t h = VolumeSizeDiv<size_t>(height, UnitSize);
+	size_t d = VolumeSizeDiv<size_t>(depth, UnitSize);
+
+	size_t idx = &block - volumeBlocks;
+	size_t bx = idx % w;
+	size_t by = (idx / w) % h;
+	size_t bz = idx / (w * h);
+
+	const int offsets[6][3] = {{-1,0,0}, {1,0,0}, {0,-1,0}, {0,1,0}, {0,0,-1}, {0,0,1}};
+	for (const int* o : offsets)
+	{
+		size_t x = bx + o[0];
+		size_t y = by + o[1];
+		size_t z = bz + o[2];
+		if (x >= w || y >= h || z >= d)		// wrapped around if negative.
+			continue;
+
+		VolumetricBlock& b = volumeBlocks[LocationIndex<size_t>(x, y, z, w, h, d)];
+		// block lock of caller is being held, skip busy block to avoid dead-lock.
+		if (b.lock.TryLock())
+		{
+			StorageId sid;
+			bool prefetch = !b.storageId.IsZero() && b.voxels == NULL;
+			if (prefetch)
+				sid = b.storageId;
+			b.lock.Unlock();
+			if (prefetch)
+				storage->Prefetch(sid);
+		}
+	}
+}
+
+void DKVoxel32SparseVolume::LinkResidentBlock(VolumetricBlock* block)
+{
+	DKASSERT_DEBUG(block->next == NULL && block->prev == NULL);
+	if (clockHand)
+	{
+		// insert behind clock-hand, visited last.
+		block->next = clockHand;
+		block->prev = clockHand->prev;
+		clockHand->prev->next = block;
+		clockHand->prev = block;
+	}
+	else
+	{
+		block->next = block;
+		block->prev = block;
+		clockHand = block;
+	}
+	block->referenced = true;
+	blocksLoaded++;
+}
+
+void DKVoxel32SparseVolume::UnlinkResidentBlock(VolumetricBlock* block)
+{
+	DKASSERT_DEBUG(block->next && block->prev);
+	if (block->next == block)
+	{
+		clockHand = NULL;
+	}
+	else
+	{
+		block->prev->next = block->next;
+		block->next->prev = block->prev;
+		if (clockHand == block)
+			clockHand = block->next;
+	}
+	block->next = NULL;
+	block->prev = NULL;
+	blocksLoaded--;
+}
+
+void DKVoxel32SparseVolume::RebuildResidentBlocks(void)
+{
+	size_t w = VolumeSizeDiv<size_t>(width, UnitSize);
+	size_t h = VolumeSizeDiv<size_t>(height, UnitSize);
+	size_t d = VolumeSizeDiv<size_t>(depth, UnitSize);
+	size_t numBlocks = w * h * d;
+
+	clockHand = NULL;
+	blocksLoaded = 0;
+	for (size_t i = 0; i < numBlocks; ++i)
+	{
+		VolumetricBlock& b = volumeBlocks[i];
+		b.prev = NULL;
+		b.next = NULL;
+		if (!b.storageId.IsZero() && b.voxels)
+			LinkResidentBlock(&b);
+	}
+}
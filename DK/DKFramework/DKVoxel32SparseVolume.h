@@ -10,6 +10,8 @@
 #include "../DKFoundation.h"
 #include "DKVoxelVolume.h"
 #include "DKVoxel32Storage.h"
+#include "DKVector3.h"
+#include "DKLine.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 // DKVoxel32SparseVolume
@@ -18,6 +20,19 @@
 // You need to provide storage object, which can be file or memory that can
 // store voxel data. (see DKVoel32Storage.h)
 //
+// Loaded blocks are linked in a ring and evicted by CLOCK algorithm
+// (second-chance), when number of loaded blocks reaches MaxActiveUnits of
+// storage. Eviction cost is proportional to evicted blocks, not volume size.
+//
+// Use GetVoxels, SetVoxels to access voxels in a box region, these functions
+// lock each block once for entire region.
+//
+// RayTest finds first crossing of iso-surface along the ray, without
+// polygonizing volume. Ray is traversed through cubes between voxels by
+// 3D-DDA, cubes inside of solid (uniform) block are skipped at once.
+// Surface is trilinear interpolation of voxel levels, hit point and normal
+// are calculated from that. Ray is in voxel coordinates.
+//
 // Note:
 //   If you want to polygonize voxels, see DKVoxelPolygonizer.h
 ////////////////////////////////////////////////////////////////////////////////
@@ -41,6 +56,11 @@ namespace DKFramework
 		bool GetVoxelAtLocation(unsigned int x, unsigned int y, unsigned int z, DKVoxel32& v);
 		bool SetVoxelAtLocation(unsigned int x, unsigned int y, unsigned int z, const DKVoxel32& v);
 
+		// read, write voxels in box region. region should be inside of volume.
+		// voxels are ordered x-major (index = x + width * y + width * height * z)
+		bool GetVoxels(unsigned int x, unsigned int y, unsigned int z, size_t width, size_t height, size_t depth, DKVoxel32* voxels);
+		bool SetVoxels(unsigned int x, unsigned int y, unsigned int z, size_t width, size_t height, size_t depth, const DKVoxel32* voxels);
+
 		void GetDimensions(size_t* width, size_t* height, size_t* depth);
 		bool SetDimensions(size_t width, size_t height, size_t depth);
 
@@ -51,17 +71,32 @@ namespace DKFramework
 
 		void Compact(void);
 
+		struct RayHitResult
+		{
+			bool hit;
+			float hitFraction;		// 0.0: ray.begin, 1.0: ray.end
+			DKVector3 hitPoint;
+			DKVector3 hitNormal;	// direction to decreasing level. (negated gradient)
+		};
+		bool RayTest(const DKLine& ray, RayHitResult* result, float isoLevel = 127.5f);
+		// batch ray-test, returns number of rays hit.
+		// rays are tested in parallel with queue if queue is not NULL.
+		size_t RayTest(const DKLine* rays, size_t count, RayHitResult* results, float isoLevel = 127.5f, DKFoundation::DKOperationQueue* queue = NULL);
+
 	private:
 		struct VolumetricBlock
 		{
 			DKFoundation::DKSpinLock lock;
 			StorageId storageId;			// zero for solid-block
-			TimeStamp ts;
 			union
 			{
 				DKVoxel32 solid;
 				DKVoxel32* voxels;
 			};
+			VolumetricBlock* prev;			// ring of loaded blocks
+			VolumetricBlock* next;
+			bool referenced;				// accessed since clock-hand passed.
+			bool modified;					// modified since last compaction.
 		};
 
 		size_t width;
@@ -70,11 +105,25 @@ namespace DKFramework
 
 		size_t blocksLoaded;				// number of blocks loaded.
 		VolumetricBlock* volumeBlocks;		// all blocks
+		VolumetricBlock* clockHand;			// next candidate of eviction.
+		DKFoundation::DKSpinLock residentLock;	// lock for blocksLoaded, ring of loaded blocks.
 
 		DKFoundation::DKObject<Storage> storage;
 		DKFoundation::DKSharedLock volumeLock;	// rw-lock for changing volume.
-		TimeStamp lastCompactedTS;
 
-		void UnloadOldBlocks(size_t);
+		// following functions should be called with block locked.
+		void LoadBlock(VolumetricBlock& block);
+		void CreateBlock(VolumetricBlock& block);
+		void UnloadOldBlocks(size_t, VolumetricBlock* lockedBlock);
+		void PrefetchNeighborBlocks(VolumetricBlock& block);
+
+		// following functions should be called with volumeLock locked.
+		void GetCubeLevels(size_t x, size_t y, size_t z, float* levels);
+		void RayTestInternal(const DKLine& ray, RayHitResult& result, float isoLevel);
+
+		// following functions should be called with residentLock locked.
+		void LinkResidentBlock(VolumetricBlock* block);
+		void UnlinkResidentBlock(VolumetricBlock* block);
+		void RebuildResidentBlocks(void);
 	};
 }
@@ -15,6 +15,9 @@
 // abstract class, interface for 32bit voxel storage.
 // using UUID for storage-id, you need to subclass to override load, unload
 // data from your storage that can be file or memory or anything else.
+//
+// Prefetch() is a hint, the storage can prepare the unit to be loaded soon.
+// (DKVoxel32SparseVolume requests neighbor units of loaded unit)
 ////////////////////////////////////////////////////////////////////////////////
 
 namespace DKFramework
@@ -43,5 +46,6 @@ namespace DKFramework
 		virtual void Delete(const StorageId&) = 0;
 		virtual DKVoxel32* Load(const StorageId&) = 0;
 		virtual void Unload(const StorageId&) = 0;
+		virtual void Prefetch(const StorageId&) {}
 	};
 }
@@ -338,6 +338,13 @@ namespace DKFramework
 
 			return VertexInterp(level, p1, p2, val1, val2);
 		}
+		// corners of each edge
+		static const int edgeCorners[12][2] =
+		{
+			{0, 1}, {1, 2}, {2, 3}, {3, 0},
+			{4, 5}, {5, 6}, {6, 7}, {7, 4},
+			{0, 4}, {1, 5}, {2, 6}, {3, 7},
+		};
 	}
 }
 using namespace DKFramework;
@@ -387,3 +394,25 @@ void DKVoxelPolygonizer::PolygonizeSurface(int cubicBits)
 		}
 	}
 }
+
+int DKVoxelPolygonizer::IntersectedEdges(int cubicBits)
+{
+	return edgeTable[cubicBits & 0xff];
+}
+
+const int* DKVoxelPolygonizer::TriangleEdges(int cubicBits)
+{
+	return triTable[cubicBits & 0xff];
+}
+
+void DKVoxelPolygonizer::EdgeCubeIndices(int edge, CubeIndex& c1, CubeIndex& c2)
+{
+	DKASSERT_DEBUG(edge >= 0 && edge < 12);
+	c1 = (CubeIndex)edgeCorners[edge][0];
+	c2 = (CubeIndex)edgeCorners[edge][1];
+}
+
+const DKVector3& DKVoxelPolygonizer::CubePosition(CubeIndex c)
+{
+	return cubePositions[c];
+}
@@ -60,5 +60,12 @@ namespace DKFramework
 		void PolygonizeSurface(int cubicBits);  // cubicBits: bitmask CubicBitMask combinations for each cube
 		virtual void GenerateTriangle(Vertex&, Vertex&, Vertex&) = 0;	// polygonized result
 		virtual DKVector3 Interpolate(const DKVector3& p1, const DKVector3& p2, CubeIndex c1, CubeIndex c2) = 0;
+
+		// marching cubes tables, for polygonizers process cubes in bulk.
+		// (see DKVoxel32Mesher.h)
+		static int IntersectedEdges(int cubicBits);				// bitmask of edges (12 bits)
+		static const int* TriangleEdges(int cubicBits);			// edge indices of triangles, terminated with -1.
+		static void EdgeCubeIndices(int edge, CubeIndex& c1, CubeIndex& c2);
+		static const DKVector3& CubePosition(CubeIndex c);
 	};
 }
@@ -23,6 +23,32 @@ namespace DKFramework
 		virtual bool GetVoxelAtLocation(unsigned int x, unsigned int y, unsigned int z, VoxelType& v) = 0;
 		virtual bool SetVoxelAtLocation(unsigned int x, unsigned int y, unsigned int z, const VoxelType& v) = 0;
 
+		// read, write voxels in box region, ordered x-major.
+		// (index = x + width * y + width * height * z)
+		// subclass can override to access region efficiently.
+		virtual bool GetVoxels(unsigned int x, unsigned int y, unsigned int z, size_t width, size_t height, size_t depth, VoxelType* voxels)
+		{
+			for (size_t k = 0; k < depth; ++k)
+				for (size_t j = 0; j < height; ++j)
+					for (size_t i = 0; i < width; ++i)
+					{
+						if (!GetVoxelAtLocation(x + i, y + j, z + k, *voxels++))
+							return false;
+					}
+			return true;
+		}
+		virtual bool SetVoxels(unsigned int x, unsigned int y, unsigned int z, size_t width, size_t height, size_t depth, const VoxelType* voxels)
+		{
+			for (size_t k = 0; k < depth; ++k)
+				for (size_t j = 0; j < height; ++j)
+					for (size_t i = 0; i < width; ++i)
+					{
+						if (!SetVoxelAtLocation(x + i, y + j, z + k, *voxels++))
+							return false;
+					}
+			return true;
+		}
+
 		virtual void GetDimensions(size_t* width, size_t* height, size_t* depth) = 0;
 		virtual bool SetDimensions(size_t width, size_t height, size_t depth) = 0;
 
@@ -0,0 +1,400 @@
+//
+//  File: SimdMath.h
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2015 Hongtae Kim. All rights reserved.
+//
+
+#pragma once
+#include "../../DKInclude.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// SimdMath.h
+// SIMD kernels for matrix, vector math and ray test. (SSE2, AVX, NEON)
+// instruction set is chosen at compile time, scalar code is used if SIMD is
+// not available or DKGL_DISABLE_SIMD is defined.
+//
+// AVX is used for 4x4 matrix multiplication only. (two rows per 256-bit op)
+// kernels use floating point operations only, AVX2 (integer) and FMA are
+// not used.
+// NEON kernels are used only if DKGL_ENABLE_NEON is defined, they have not
+// been verified with Tests/SimdMathTest.cpp on ARM yet.
+//
+// matrices are row-major 4x4 float array, vectors are row vector. (V * M)
+//
+// Note:
+//   All kernels compute with same operation order of scalar code, without
+//   fused multiply-add. results are bit-compatible with scalar code.
+//   (unless compiler contracts multiply-add of scalar code)
+//   input and output are not required to be aligned.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef DKGL_DISABLE_SIMD
+#	if defined(__AVX__)
+#		define DKGL_SIMD_AVX 1
+#		define DKGL_SIMD_SSE 1
+#		include <immintrin.h>
+#	elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#		define DKGL_SIMD_SSE 1
+#		include <emmintrin.h>
+#	elif defined(DKGL_ENABLE_NEON) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#		define DKGL_SIMD_NEON 1
+#		include <arm_neon.h>
+#	endif
+#endif
+
+namespace DKFramework
+{
+	namespace Private
+	{
+#if defined(DKGL_SIMD_SSE)
+		// r = ((s0 * v0 + s1 * v1) + s2 * v2) + s3 * v3
+		FORCEINLINE __m128 SimdLinearCombine(__m128 s0, __m128 s1, __m128 s2, __m128 s3, __m128 v0, __m128 v1, __m128 v2, __m128 v3)
+		{
+			__m128 r = _mm_add_ps(_mm_mul_ps(s0, v0), _mm_mul_ps(s1, v1));
+			r = _mm_add_ps(r, _mm_mul_ps(s2, v2));
+			return _mm_add_ps(r, _mm_mul_ps(s3, v3));
+		}
+#elif defined(DKGL_SIMD_NEON)
+		FORCEINLINE float32x4_t SimdLinearCombine(float s0, float s1, float s2, float s3, float32x4_t v0, float32x4_t v1, float32x4_t v2, float32x4_t v3)
+		{
+			float32x4_t r = vaddq_f32(vmulq_n_f32(v0, s0), vmulq_n_f32(v1, s1));
+			r = vaddq_f32(r, vmulq_n_f32(v2, s2));
+			return vaddq_f32(r, vmulq_n_f32(v3, s3));
+		}
+#endif
+
+		// output = lhs * rhs (output can be same as lhs or rhs)
+		FORCEINLINE void SimdMatrix4Multiply(const float* lhs, const float* rhs, float* output)
+		{
+#if defined(DKGL_SIMD_AVX)
+			const __m256 r0 = _mm256_broadcast_ps((const __m128*)&rhs[0]);
+			const __m256 r1 = _mm256_broadcast_ps((const __m128*)&rhs[4]);
+			const __m256 r2 = _mm256_broadcast_ps((const __m128*)&rhs[8]);
+			const __m256 r3 = _mm256_broadcast_ps((const __m128*)&rhs[12]);
+
+			__m256 out[2];
+			for (int i = 0; i < 2; ++i)
+			{
+				const float* l = &lhs[i * 8];
+				__m256 r = _mm256_add_ps(_mm256_mul_ps(_mm256_setr_ps(l[0], l[0], l[0], l[0], l[4], l[4], l[4], l[4]), r0),
+										 _mm256_mul_ps(_mm256_setr_ps(l[1], l[1], l[1], l[1], l[5], l[5], l[5], l[5]), r1));
+				r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_setr_ps(l[2], l[2], l[2], l[2], l[6], l[6], l[6], l[6]), r2));
+				out[i] = _mm256_add_ps(r, _mm256_mul_ps(_mm256_setr_ps(l[3], l[3], l[3], l[3], l[7], l[7], l[7], l[7]), r3));
+			}
+			_mm256_storeu_ps(&output[0], out[0]);
+			_mm256_storeu_ps(&output[8], out[1]);
+#elif defined(DKGL_SIMD_SSE)
+			const __m128 r0 = _mm_loadu_ps(&rhs[0]);
+			const __m128 r1 = _mm_loadu_ps(&rhs[4]);
+			const __m128 r2 = _mm_loadu_ps(&rhs[8]);
+			const __m128 r3 = _mm_loadu_ps(&rhs[12]);
+
+			__m128 out[4];
+			for (int i = 0; i < 4; ++i)
+			{
+				const float* l = &lhs[i * 4];
+				out[i] = SimdLinearCombine(_mm_set1_ps(l[0]), _mm_set1_ps(l[1]), _mm_set1_ps(l[2]), _mm_set1_ps(l[3]), r0, r1, r2, r3);
+			}
+			for (int i = 0; i < 4; ++i)
+				_mm_storeu_ps(&output[i * 4], out[i]);
+#elif defined(DKGL_SIMD_NEON)
+			const float32x4_t r0 = vld1q_f32(&rhs[0]);
+			const float32x4_t r1 = vld1q_f32(&rhs[4]);
+			const float32x4_t r2 = vld1q_f32(&rhs[8]);
+			const float32x4_t r3 = vld1q_f32(&rhs[12]);
+
+			float32x4_t out[4];
+			for (int i = 0; i < 4; ++i)
+			{
+				const float* l = &lhs[i * 4];
+				out[i] = SimdLinearCombine(l[0], l[1], l[2], l[3], r0, r1, r2, r3);
+			}
+			for (int i = 0; i < 4; ++i)
+				vst1q_f32(&output[i * 4], out[i]);
+#else
+			float out[16];
+			for (int i = 0; i < 4; ++i)
+			{
+				const float* l = &lhs[i * 4];
+				for (int j = 0; j < 4; ++j)
+					out[i * 4 + j] = (l[0] * rhs[j]) + (l[1] * rhs[4 + j]) + (l[2] * rhs[8 + j]) + (l[3] * rhs[12 + j]);
+			}
+			memcpy(output, out, sizeof(out));
+#endif
+		}
+
+		// output = v(x,y,z,w) * m (output can be same as v)
+		FORCEINLINE void SimdVector4Transform(const float* v, const float* m, float* output)
+		{
+#if defined(DKGL_SIMD_SSE)
+			__m128 r = SimdLinearCombine(_mm_set1_ps(v[0]), _mm_set1_ps(v[1]), _mm_set1_ps(v[2]), _mm_set1_ps(v[3]),
+										 _mm_loadu_ps(&m[0]), _mm_loadu_ps(&m[4]), _mm_loadu_ps(&m[8]), _mm_loadu_ps(&m[12]));
+			_mm_storeu_ps(output, r);
+#elif defined(DKGL_SIMD_NEON)
+			float32x4_t r = SimdLinearCombine(v[0], v[1], v[2], v[3],
+											  vld1q_f32(&m[0]), vld1q_f32(&m[4]), vld1q_f32(&m[8]), vld1q_f32(&m[12]));
+			vst1q_f32(output, r);
+#else
+			float x = v[0], y = v[1], z = v[2], w = v[3];
+			output[0] = (x * m[0]) + (y * m[4]) + (z * m[8]) + (w * m[12]);
+			output[1] = (x * m[1]) + (y * m[5]) + (z * m[9]) + (w * m[13]);
+			output[2] = (x * m[2]) + (y * m[6]) + (z * m[10]) + (w * m[14]);
+			output[3] = (x * m[3]) + (y * m[7]) + (z * m[11]) + (w * m[15]);
+#endif
+		}
+
+		// homogeneous transform of v(x,y,z,1) and divide by w. (output can be same as v)
+		FORCEINLINE void SimdVector3Transform(const float* v, const float* m, float* output)
+		{
+#if defined(DKGL_SIMD_SSE)
+			__m128 r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[0]), _mm_loadu_ps(&m[0])), _mm_mul_ps(_mm_set1_ps(v[1]), _mm_loadu_ps(&m[4])));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(v[2]), _mm_loadu_ps(&m[8])));
+			r = _mm_add_ps(r, _mm_loadu_ps(&m[12]));
+			__m128 w = _mm_div_ss(_mm_set_ss(1.0f), _mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 3, 3, 3)));
+			r = _mm_mul_ps(r, _mm_shuffle_ps(w, w, _MM_SHUFFLE(0, 0, 0, 0)));
+			float out[4];
+			_mm_storeu_ps(out, r);
+			output[0] = out[0];
+			output[1] = out[1];
+			output[2] = out[2];
+#elif defined(DKGL_SIMD_NEON)
+			float32x4_t r = vaddq_f32(vmulq_n_f32(vld1q_f32(&m[0]), v[0]), vmulq_n_f32(vld1q_f32(&m[4]), v[1]));
+			r = vaddq_f32(r, vmulq_n_f32(vld1q_f32(&m[8]), v[2]));
+			r = vaddq_f32(r, vld1q_f32(&m[12]));
+			r = vmulq_n_f32(r, 1.0f / vgetq_lane_f32(r, 3));
+			float out[4];
+			vst1q_f32(out, r);
+			output[0] = out[0];
+			output[1] = out[1];
+			output[2] = out[2];
+#else
+			float x = v[0], y = v[1], z = v[2];
+			float w = 1.0f / ((x * m[3]) + (y * m[7]) + (z * m[11]) + m[15]);
+			output[0] = ((x * m[0]) + (y * m[4]) + (z * m[8]) + m[12]) * w;
+			output[1] = ((x * m[1]) + (y * m[5]) + (z * m[9]) + m[13]) * w;
+			output[2] = ((x * m[2]) + (y * m[6]) + (z * m[10]) + m[14]) * w;
+#endif
+		}
+
+		// affine transform of AABB. (Arvo's method, projective part is ignored)
+		// output is min(3), max(3) of box encloses transformed input box.
+		FORCEINLINE void SimdAabbTransform(const float* posMin, const float* posMax, const float* m, float* outMin, float* outMax)
+		{
+#if defined(DKGL_SIMD_SSE)
+			__m128 lo = _mm_loadu_ps(&m[12]);
+			__m128 hi = lo;
+			for (int i = 0; i < 3; ++i)
+			{
+				__m128 row = _mm_loadu_ps(&m[i * 4]);
+				__m128 a = _mm_mul_ps(_mm_set1_ps(posMin[i]), row);
+				__m128 b = _mm_mul_ps(_mm_set1_ps(posMax[i]), row);
+				lo = _mm_add_ps(lo, _mm_min_ps(a, b));
+				hi = _mm_add_ps(hi, _mm_max_ps(a, b));
+			}
+			float out[8];
+			_mm_storeu_ps(&out[0], lo);
+			_mm_storeu_ps(&out[4], hi);
+#elif defined(DKGL_SIMD_NEON)
+			float32x4_t lo = vld1q_f32(&m[12]);
+			float32x4_t hi = lo;
+			for (int i = 0; i < 3; ++i)
+			{
+				float32x4_t row = vld1q_f32(&m[i * 4]);
+				float32x4_t a = vmulq_n_f32(row, posMin[i]);
+				float32x4_t b = vmulq_n_f32(row, posMax[i]);
+				lo = vaddq_f32(lo, vminq_f32(a, b));
+				hi = vaddq_f32(hi, vmaxq_f32(a, b));
+			}
+			float out[8];
+			vst1q_f32(&out[0], lo);
+			vst1q_f32(&out[4], hi);
+#else
+			float out[8];
+			for (int j = 0; j < 3; ++j)
+			{
+				float lo = m[12 + j];
+				float hi = lo;
+				for (int i = 0; i < 3; ++i)
+				{
+					float a = posMin[i] * m[i * 4 + j];
+					float b = posMax[i] * m[i * 4 + j];
+					lo += (a < b) ? a : b;
+					hi += (a > b) ? a : b;
+				}
+				out[j] = lo;
+				out[4 + j] = hi;
+			}
+#endif
+			outMin[0] = out[0];
+			outMin[1] = out[1];
+			outMin[2] = out[2];
+			outMax[0] = out[4];
+			outMax[1] = out[5];
+			outMax[2] = out[6];
+		}
+
+		// ray-aabb slab test. (x,y,z components are used, 4th component is ignored)
+		// origin, invDir: ray origin and reciprocal of direction, ray is (origin + direction * t)
+		// invDir should be finite value. (use large value for zero direction)
+		// returns true if ray overlaps box within (0 <= t <= tmax), tnear is entry point.
+		FORCEINLINE bool SimdRayAabbTest(const float* origin, const float* invDir, const float* boxMin, const float* boxMax, float tmax, float* tnear)
+		{
+#if defined(DKGL_SIMD_SSE)
+			const __m128 o = _mm_loadu_ps(origin);
+			const __m128 inv = _mm_loadu_ps(invDir);
+			const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(boxMin), o), inv);
+			const __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(boxMax), o), inv);
+			const __m128 lo = _mm_min_ps(t1, t2);
+			const __m128 hi = _mm_max_ps(t1, t2);
+
+			__m128 n = _mm_max_ss(_mm_max_ss(lo, _mm_shuffle_ps(lo, lo, _MM_SHUFFLE(1, 1, 1, 1))),
+								  _mm_max_ss(_mm_shuffle_ps(lo, lo, _MM_SHUFFLE(2, 2, 2, 2)), _mm_setzero_ps()));
+			__m128 f = _mm_min_ss(_mm_min_ss(hi, _mm_shuffle_ps(hi, hi, _MM_SHUFFLE(1, 1, 1, 1))),
+								  _mm_min_ss(_mm_shuffle_ps(hi, hi, _MM_SHUFFLE(2, 2, 2, 2)), _mm_set_ss(tmax)));
+			_mm_store_ss(tnear, n);
+			return _mm_comile_ss(n, f) != 0;
+#elif defined(DKGL_SIMD_NEON)
+			const float32x4_t o = vld1q_f32(origin);
+			const float32x4_t inv = vld1q_f32(invDir);
+			const float32x4_t t1 = vmulq_f32(vsubq_f32(vld1q_f32(boxMin), o), inv);
+			const float32x4_t t2 = vmulq_f32(vsubq_f32(vld1q_f32(boxMax), o), inv);
+			const float32x4_t lo = vminq_f32(t1, t2);
+			const float32x4_t hi = vmaxq_f32(t1, t2);
+
+			float n = vgetq_lane_f32(lo, 0);
+			n = n > vgetq_lane_f32(lo, 1) ? n : vgetq_lane_f32(lo, 1);
+			n = n > vgetq_lane_f32(lo, 2) ? n : vgetq_lane_f32(lo, 2);
+			n = n > 0.0f ? n : 0.0f;
+			float f = vgetq_lane_f32(hi, 0);
+			f = f < vgetq_lane_f32(hi, 1) ? f : vgetq_lane_f32(hi, 1);
+			f = f < vgetq_lane_f32(hi, 2) ? f : vgetq_lane_f32(hi, 2);
+			f = f < tmax ? f : tmax;
+			*tnear = n;
+			return n <= f;
+#else
+			float n = 0.0f;
+			float f = tmax;
+			for (int i = 0; i < 3; ++i)
+			{
+				float t1 = (boxMin[i] - origin[i]) * invDir[i];
+				float t2 = (boxMax[i] - origin[i]) * invDir[i];
+				if (t1 > t2)
+				{
+					float t = t1; t1 = t2; t2 = t;
+				}
+				n = t1 > n ? t1 : n;
+				f = t2 < f ? t2 : f;
+			}
+			*tnear = n;
+			return n <= f;
+#endif
+		}
+
+		// planes for SimdPlanesAabbTest, SimdPlanesSphereTest. (SoA layout)
+		// plane is (nx, ny, nz, d), point p is inside if (n.p + d >= 0).
+		// unused planes should be zero, at most 8 planes can be tested.
+		struct SimdPlanes
+		{
+			enum { MaxPlanes = 8 };
+			float nx[MaxPlanes];
+			float ny[MaxPlanes];
+			float nz[MaxPlanes];
+			float d[MaxPlanes];
+		};
+
+#if defined(DKGL_SIMD_NEON)
+		// bit mask of lanes, same as _mm_movemask_ps.
+		FORCEINLINE unsigned int SimdMoveMask(uint32x4_t v)
+		{
+			return (vgetq_lane_u32(v, 0) & 1) | (vgetq_lane_u32(v, 1) & 2) | (vgetq_lane_u32(v, 2) & 4) | (vgetq_lane_u32(v, 3) & 8);
+		}
+#endif
+
+		// aabb-planes test with planes in mask, returns false if outside of any plane.
+		// center, extents: center and half size of box. (x,y,z components are used)
+		// planes which box is fully inside are removed from mask. (mask is not
+		// modified if box is outside)
+		FORCEINLINE bool SimdPlanesAabbTest(const SimdPlanes& p, const float* center, const float* extents, unsigned int& mask)
+		{
+			unsigned int outside = 0;
+			unsigned int inside = 0;
+#if defined(DKGL_SIMD_SSE)
+			const __m128 signMask = _mm_set1_ps(-0.0f);
+			const __m128 cx = _mm_set1_ps(center[0]), cy = _mm_set1_ps(center[1]), cz = _mm_set1_ps(center[2]);
+			const __m128 ex = _mm_set1_ps(extents[0]), ey = _mm_set1_ps(extents[1]), ez = _mm_set1_ps(extents[2]);
+			for (int i = 0; i < SimdPlanes::MaxPlanes; i += 4)
+			{
+				const __m128 nx = _mm_loadu_ps(&p.nx[i]);
+				const __m128 ny = _mm_loadu_ps(&p.ny[i]);
+				const __m128 nz = _mm_loadu_ps(&p.nz[i]);
+				__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)), _mm_mul_ps(nz, cz));
+				d = _mm_add_ps(d, _mm_loadu_ps(&p.d[i]));
+				__m128 r = _mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, nx), ex), _mm_mul_ps(_mm_andnot_ps(signMask, ny), ey));
+				r = _mm_add_ps(r, _mm_mul_ps(_mm_andnot_ps(signMask, nz), ez));
+				outside |= (unsigned int)_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(d, r), _mm_setzero_ps())) << i;
+				inside |= (unsigned int)_mm_movemask_ps(_mm_cmpge_ps(_mm_sub_ps(d, r), _mm_setzero_ps())) << i;
+			}
+#elif defined(DKGL_SIMD_NEON)
+			const float32x4_t zero = vdupq_n_f32(0.0f);
+			for (int i = 0; i < SimdPlanes::MaxPlanes; i += 4)
+			{
+				const float32x4_t nx = vld1q_f32(&p.nx[i]);
+				const float32x4_t ny = vld1q_f32(&p.ny[i]);
+				const float32x4_t nz = vld1q_f32(&p.nz[i]);
+				float32x4_t d = vaddq_f32(vaddq_f32(vmulq_n_f32(nx, center[0]), vmulq_n_f32(ny, center[1])), vmulq_n_f32(nz, center[2]));
+				d = vaddq_f32(d, vld1q_f32(&p.d[i]));
+				float32x4_t r = vaddq_f32(vmulq_n_f32(vabsq_f32(nx), extents[0]), vmulq_n_f32(vabsq_f32(ny), extents[1]));
+				r = vaddq_f32(r, vmulq_n_f32(vabsq_f32(nz), extents[2]));
+				outside |= SimdMoveMask(vcltq_f32(vaddq_f32(d, r), zero)) << i;
+				inside |= SimdMoveMask(vcgeq_f32(vsubq_f32(d, r), zero)) << i;
+			}
+#else
+			for (int i = 0; i < SimdPlanes::MaxPlanes; ++i)
+			{
+				const float d = (p.nx[i] * center[0]) + (p.ny[i] * center[1]) + (p.nz[i] * center[2]) + p.d[i];
+				const float r = (fabs(p.nx[i]) * extents[0]) + (fabs(p.ny[i]) * extents[1]) + (fabs(p.nz[i]) * extents[2]);
+				if (d + r < 0.0f)
+					outside |= 1U << i;
+				if (d - r >= 0.0f)
+					inside |= 1U << i;
+			}
+#endif
+			if (outside & mask)
+				return false;
+			mask &= ~inside;
+			return true;
+		}
+
+		// sphere-planes test with planes in mask, returns false if outside of any plane.
+		FORCEINLINE bool SimdPlanesSphereTest(const SimdPlanes& p, const float* center, float radius, unsigned int mask)
+		{
+			unsigned int outside = 0;
+#if defined(DKGL_SIMD_SSE)
+			const __m128 cx = _mm_set1_ps(center[0]), cy = _mm_set1_ps(center[1]), cz = _mm_set1_ps(center[2]);
+			const __m128 nr = _mm_set1_ps(-radius);
+			for (int i = 0; i < SimdPlanes::MaxPlanes; i += 4)
+			{
+				__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&p.nx[i]), cx), _mm_mul_ps(_mm_loadu_ps(&p.ny[i]), cy)), _mm_mul_ps(_mm_loadu_ps(&p.nz[i]), cz));
+				d = _mm_add_ps(d, _mm_loadu_ps(&p.d[i]));
+				outside |= (unsigned int)_mm_movemask_ps(_mm_cmplt_ps(d, nr)) << i;
+			}
+#elif defined(DKGL_SIMD_NEON)
+			const float32x4_t nr = vdupq_n_f32(-radius);
+			for (int i = 0; i < SimdPlanes::MaxPlanes; i += 4)
+			{
+				float32x4_t d = vaddq_f32(vaddq_f32(vmulq_n_f32(vld1q_f32(&p.nx[i]), center[0]), vmulq_n_f32(vld1q_f32(&p.ny[i]), center[1])), vmulq_n_f32(vld1q_f32(&p.nz[i]), center[2]));
+				d = vaddq_f32(d, vld1q_f32(&p.d[i]));
+				outside |= SimdMoveMask(vcltq_f32(d, nr)) << i;
+			}
+#else
+			for (int i = 0; i < SimdPlanes::MaxPlanes; ++i)
+			{
+				if ((p.nx[i] * center[0]) + (p.ny[i] * center[1]) + (p.nz[i] * center[2]) + p.d[i] < -radius)
+					outside |= 1U << i;
+			}
+#endif
+			return (outside & mask) == 0;
+		}
+	}
+}
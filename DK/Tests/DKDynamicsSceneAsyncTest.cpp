@@ -0,0 +1,183 @@
+//
+//  File: DKDynamicsSceneAsyncTest.cpp
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2015 Hongtae Kim. All rights reserved.
+//
+
+////////////////////////////////////////////////////////////////////////////////
+// DKDynamicsSceneAsyncTest
+// stand-alone test of DKDynamicsScene asynchronous simulation.
+// build with DK library and run, returns 0 if all tests passed.
+//
+//  - torn read: identical bodies are falling side by side, transforms taken
+//    from one snapshot (InterpolatedTransforms, object transforms after Update)
+//    must have same height.
+//  - continuity: interpolated height must decrease smoothly without jumps
+//    between successive reads.
+//  - body removed and new body added while simulation is running, new body
+//    must not take transform of removed body. (address can be reused)
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <math.h>
+#include "../DK.h"
+
+using namespace DKFoundation;
+using namespace DKFramework;
+
+namespace
+{
+	enum { NumBodies = 64 };
+	const float startHeight = 100.0f;
+	const float gravity = 9.8f;
+	const double duration = 1.5;
+	const double fps = 60.0;
+
+	inline double Now(void)
+	{
+		return (double)DKTimer::SystemTick() / (double)DKTimer::SystemTickFrequency();
+	}
+
+	struct Result
+	{
+		size_t reads = 0;
+		size_t tornReads = 0;
+		size_t jumps = 0;
+		size_t missing = 0;
+	};
+}
+
+int main(int argc, const char* argv[])
+{
+	DKObject<DKDynamicsScene> scene = DKOBJECT_NEW DKDynamicsScene();
+	scene->SetGravity(DKVector3(0, -gravity, 0));
+	scene->SetFixedFrameRate(fps);
+
+	DKObject<DKCollisionShape> shape = DKOBJECT_NEW DKSphereShape(0.5f);
+	DKArray<DKObject<DKRigidBody>> bodies;
+	const DKRigidBody* bodyPtrs[NumBodies];
+	for (int i = 0; i < NumBodies; ++i)
+	{
+		DKObject<DKRigidBody> rb = DKOBJECT_NEW DKRigidBody(shape, 1.0f);
+		rb->SetWorldTransform(DKNSTransform(DKQuaternion::identity, DKVector3(i * 10.0f, startHeight, 0)));
+		scene->AddObject(rb);
+		bodies.Add(rb);
+		bodyPtrs[i] = rb;
+	}
+
+	if (!scene->StartAsyncSimulation())
+	{
+		printf("failed to start simulation.\n");
+		return 1;
+	}
+
+	// reader thread, checks interpolated transforms.
+	Result reader;
+	const double begin = Now();
+	DKObject<DKThread> thread = DKThread::Create(DKFunction([&]()
+	{
+		DKNSTransform transforms[NumBodies];
+		double lastHeight = startHeight;
+		double lastTime = Now();
+		while (Now() - begin < duration)
+		{
+			// last body will be replaced.
+			size_t found = scene->InterpolatedTransforms(bodyPtrs, transforms, NumBodies - 1);
+			double t = Now();
+			if (found == 0)
+				continue;
+			reader.reads++;
+			if (found != NumBodies - 1)
+				reader.missing++;
+
+			const float y = transforms[0].position.y;
+			for (int i = 1; i < NumBodies - 1; ++i)
+			{
+				if (fabs(transforms[i].position.y - y) > 1.0e-4f)
+				{
+					reader.tornReads++;
+					break;
+				}
+			}
+			// height can not go up, and can not move more than falling speed
+			// for elapsed time and one simulation step.
+			const double maxSpeed = gravity * (t - begin + 2.0 / fps);
+			const double maxDelta = maxSpeed * (t - lastTime + 1.0 / fps) + 1.0e-3;
+			const double delta = lastHeight - y;
+			if (delta < -1.0e-3 || delta > maxDelta)
+				reader.jumps++;
+			lastHeight = y;
+			lastTime = t;
+			DKThread::Yield();
+		}
+	})->Invocation());
+
+	// updating thread, checks object transforms updated from snapshot.
+	size_t updates = 0;
+	size_t tornUpdates = 0;
+	size_t reusedTransforms = 0;
+	DKTimeTick tick = 0;
+	double lastUpdate = Now();
+	bool replaced = false;
+	while (Now() - begin < duration)
+	{
+		DKThread::Sleep(0.005);
+		double t = Now();
+		if (++tick == 0)
+			++tick;
+		scene->Update(t - lastUpdate, tick);
+		lastUpdate = t;
+		updates++;
+
+		const float y = bodies.Value(0)->WorldTransform().position.y;
+		for (int i = 1; i < NumBodies - 1; ++i)
+		{
+			if (fabs(bodies.Value(i)->WorldTransform().position.y - y) > 1.0e-4f)
+			{
+				tornUpdates++;
+				break;
+			}
+		}
+
+		if (!replaced && t - begin > duration * 0.5)
+		{
+			// replace last body with static one, placed below.
+			scene->RemoveObject(bodies.Value(NumBodies - 1));
+			bodies.Value(NumBodies - 1) = NULL;
+
+			DKObject<DKRigidBody> rb = DKOBJECT_NEW DKRigidBody(shape, 0.0f);
+			rb->SetWorldTransform(DKNSTransform(DKQuaternion::identity, DKVector3(0, -startHeight, 100.0f)));
+			scene->AddObject(rb);
+			bodies.Value(NumBodies - 1) = rb;
+			replaced = true;
+		}
+		else if (replaced)
+		{
+			const DKRigidBody* rb = bodies.Value(NumBodies - 1);
+			DKNSTransform trans;
+			if (scene->InterpolatedTransform(rb, trans) && fabs(trans.position.y + startHeight) > 1.0e-3f)
+				reusedTransforms++;
+			if (fabs(rb->WorldTransform().position.y + startHeight) > 1.0e-3f)
+				reusedTransforms++;
+		}
+	}
+	thread->WaitTerminate();
+	scene->StopAsyncSimulation();
+
+	const float fallen = startHeight - bodies.Value(0)->WorldTransform().position.y;
+
+	printf("reads: %lu, torn: %lu, jumps: %lu, missing: %lu\n",
+		   (unsigned long)reader.reads, (unsigned long)reader.tornReads,
+		   (unsigned long)reader.jumps, (unsigned long)reader.missing);
+	printf("updates: %lu, torn: %lu, reused: %lu, fallen: %f\n",
+		   (unsigned long)updates, (unsigned long)tornUpdates,
+		   (unsigned long)reusedTransforms, fallen);
+
+	bool passed = reader.reads > 0 && reader.tornReads == 0 && reader.jumps == 0 &&
+		reader.missing == 0 && tornUpdates == 0 && reusedTransforms == 0 && fallen > 1.0f;
+
+	scene->RemoveAllObjects();
+	printf("%s\n", passed ? "passed" : "FAILED");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,311 @@
+//
+//  File: SimdMathTest.cpp
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2015 Hongtae Kim. All rights reserved.
+//
+
+////////////////////////////////////////////////////////////////////////////////
+// SimdMathTest
+// stand-alone test of DKFramework/Private/SimdMath.h kernels.
+// results of kernels are compared with scalar reference code bit by bit,
+// and time of kernels and reference code are measured.
+// returns 0 if all results are identical.
+//
+// scalar reference code should not be contracted, build with
+// -ffp-contract=off (or /fp:precise) for each instruction set.
+//   SSE2:   (default on x86-64)
+//   AVX:    -mavx
+//   NEON:   -DDKGL_ENABLE_NEON (ARM)
+//   scalar: -DDKGL_DISABLE_SIMD
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include "../DKFramework/Private/SimdMath.h"
+
+using namespace DKFramework::Private;
+
+namespace
+{
+	// scalar reference, same operation order of kernels.
+	void RefMatrix4Multiply(const float* lhs, const float* rhs, float* output)
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			const float* l = &lhs[i * 4];
+			for (int j = 0; j < 4; ++j)
+				output[i * 4 + j] = (l[0] * rhs[j]) + (l[1] * rhs[4 + j]) + (l[2] * rhs[8 + j]) + (l[3] * rhs[12 + j]);
+		}
+	}
+	void RefVector4Transform(const float* v, const float* m, float* output)
+	{
+		for (int j = 0; j < 4; ++j)
+			output[j] = (v[0] * m[j]) + (v[1] * m[4 + j]) + (v[2] * m[8 + j]) + (v[3] * m[12 + j]);
+	}
+	void RefVector3Transform(const float* v, const float* m, float* output)
+	{
+		float w = 1.0f / ((v[0] * m[3]) + (v[1] * m[7]) + (v[2] * m[11]) + m[15]);
+		for (int j = 0; j < 3; ++j)
+			output[j] = ((v[0] * m[j]) + (v[1] * m[4 + j]) + (v[2] * m[8 + j]) + m[12 + j]) * w;
+	}
+	void RefAabbTransform(const float* posMin, const float* posMax, const float* m, float* outMin, float* outMax)
+	{
+		for (int j = 0; j < 3; ++j)
+		{
+			float lo = m[12 + j];
+			float hi = lo;
+			for (int i = 0; i < 3; ++i)
+			{
+				float a = posMin[i] * m[i * 4 + j];
+				float b = posMax[i] * m[i * 4 + j];
+				lo += (a < b) ? a : b;
+				hi += (a > b) ? a : b;
+			}
+			outMin[j] = lo;
+			outMax[j] = hi;
+		}
+	}
+	bool RefRayAabbTest(const float* origin, const float* invDir, const float* boxMin, const float* boxMax, float tmax, float* tnear)
+	{
+		float n = 0.0f;
+		float f = tmax;
+		for (int i = 0; i < 3; ++i)
+		{
+			float t1 = (boxMin[i] - origin[i]) * invDir[i];
+			float t2 = (boxMax[i] - origin[i]) * invDir[i];
+			if (t1 > t2)
+			{
+				float t = t1;
+				t1 = t2;
+				t2 = t;
+			}
+			n = t1 > n ? t1 : n;
+			f = t2 < f ? t2 : f;
+		}
+		*tnear = n;
+		return n <= f;
+	}
+	bool RefPlanesAabbTest(const SimdPlanes& p, const float* center, const float* extents, unsigned int& mask)
+	{
+		unsigned int outside = 0;
+		unsigned int inside = 0;
+		for (int i = 0; i < SimdPlanes::MaxPlanes; ++i)
+		{
+			const float d = (p.nx[i] * center[0]) + (p.ny[i] * center[1]) + (p.nz[i] * center[2]) + p.d[i];
+			const float r = (fabs(p.nx[i]) * extents[0]) + (fabs(p.ny[i]) * extents[1]) + (fabs(p.nz[i]) * extents[2]);
+			if (d + r < 0.0f)
+				outside |= 1U << i;
+			if (d - r >= 0.0f)
+				inside |= 1U << i;
+		}
+		if (outside & mask)
+			return false;
+		mask &= ~inside;
+		return true;
+	}
+	bool RefPlanesSphereTest(const SimdPlanes& p, const float* center, float radius, unsigned int mask)
+	{
+		unsigned int outside = 0;
+		for (int i = 0; i < SimdPlanes::MaxPlanes; ++i)
+		{
+			if ((p.nx[i] * center[0]) + (p.ny[i] * center[1]) + (p.nz[i] * center[2]) + p.d[i] < -radius)
+				outside |= 1U << i;
+		}
+		return (outside & mask) == 0;
+	}
+
+	inline float Random(float range)
+	{
+		return (rand() / float(RAND_MAX) * 2.0f - 1.0f) * range;
+	}
+	void RandomArray(float* p, size_t count, float range)
+	{
+		for (size_t i = 0; i < count; ++i)
+			p[i] = Random(range);
+	}
+
+	int failures = 0;
+	void Check(const char* name, bool identical, size_t index)
+	{
+		if (!identical)
+		{
+			if (failures < 20)
+				printf("mismatch: %s at %lu\n", name, (unsigned long)index);
+			failures++;
+		}
+	}
+
+	// measure elapsed time of function, returns nanoseconds per call.
+	template <typename T> double Measure(size_t calls, T&& fn)
+	{
+		auto t0 = std::chrono::high_resolution_clock::now();
+		fn();
+		auto t1 = std::chrono::high_resolution_clock::now();
+		return std::chrono::duration<double, std::nano>(t1 - t0).count() / double(calls);
+	}
+
+	volatile float sink;
+}
+
+int main(int argc, const char* argv[])
+{
+#if defined(DKGL_SIMD_AVX)
+	const char* isa = "AVX";
+#elif defined(DKGL_SIMD_SSE)
+	const char* isa = "SSE2";
+#elif defined(DKGL_SIMD_NEON)
+	const char* isa = "NEON";
+#else
+	const char* isa = "scalar";
+#endif
+	printf("SimdMath: %s\n", isa);
+
+	enum { Count = 4096, Repeat = 200 };
+	srand(1);
+
+	float* matA = new float[Count * 16];
+	float* matB = new float[Count * 16];
+	float* vec = new float[Count * 4];
+	float* out0 = new float[Count * 16];
+	float* out1 = new float[Count * 16];
+	RandomArray(matA, Count * 16, 10.0f);
+	RandomArray(matB, Count * 16, 10.0f);
+	RandomArray(vec, Count * 4, 100.0f);
+
+	// bit-compatibility.
+	for (size_t i = 0; i < Count; ++i)
+	{
+		const float* a = &matA[i * 16];
+		const float* b = &matB[i * 16];
+		const float* v = &vec[i * 4];
+		float r0[16], r1[16];
+
+		SimdMatrix4Multiply(a, b, r0);
+		RefMatrix4Multiply(a, b, r1);
+		Check("Matrix4Multiply", memcmp(r0, r1, sizeof(float) * 16) == 0, i);
+
+		memcpy(r0, a, sizeof(float) * 16);
+		SimdMatrix4Multiply(r0, b, r0);	// in-place
+		Check("Matrix4Multiply (in-place)", memcmp(r0, r1, sizeof(float) * 16) == 0, i);
+
+		SimdVector4Transform(v, a, r0);
+		RefVector4Transform(v, a, r1);
+		Check("Vector4Transform", memcmp(r0, r1, sizeof(float) * 4) == 0, i);
+
+		SimdVector3Transform(v, a, r0);
+		RefVector3Transform(v, a, r1);
+		Check("Vector3Transform", memcmp(r0, r1, sizeof(float) * 3) == 0, i);
+
+		float bmin[3] = { v[0], v[1], v[2] };
+		float bmax[3] = { v[0] + fabs(v[3]), v[1] + fabs(b[0]), v[2] + fabs(b[1]) };
+		SimdAabbTransform(bmin, bmax, a, &r0[0], &r0[4]);
+		RefAabbTransform(bmin, bmax, a, &r1[0], &r1[4]);
+		Check("AabbTransform", memcmp(&r0[0], &r1[0], sizeof(float) * 3) == 0 && memcmp(&r0[4], &r1[4], sizeof(float) * 3) == 0, i);
+
+		float origin[4] = { b[2], b[3], b[4], 0.0f };
+		float invDir[4] = { 1.0f / b[5], 1.0f / b[6], 1.0f / b[7], 0.0f };
+		float boxMin[4] = { bmin[0] * 0.1f, bmin[1] * 0.1f, bmin[2] * 0.1f, 0.0f };
+		float boxMax[4] = { bmax[0] * 0.1f, bmax[1] * 0.1f, bmax[2] * 0.1f, 0.0f };
+		float tn0 = 0.0f, tn1 = 0.0f;
+		bool h0 = SimdRayAabbTest(origin, invDir, boxMin, boxMax, 1.0f, &tn0);
+		bool h1 = RefRayAabbTest(origin, invDir, boxMin, boxMax, 1.0f, &tn1);
+		Check("RayAabbTest", h0 == h1 && (!h0 || memcmp(&tn0, &tn1, sizeof(float)) == 0), i);
+
+		SimdPlanes planes;
+		memset(&planes, 0, sizeof(planes));
+		for (int k = 0; k < 6; ++k)
+		{
+			planes.nx[k] = Random(1.0f);
+			planes.ny[k] = Random(1.0f);
+			planes.nz[k] = Random(1.0f);
+			planes.d[k] = Random(50.0f);
+		}
+		const float extents[3] = { fabs(b[8]), fabs(b[9]), fabs(b[10]) };
+		unsigned int mask0 = (unsigned int)rand() & 0x3f;
+		unsigned int mask1 = mask0;
+		bool p0 = SimdPlanesAabbTest(planes, v, extents, mask0);
+		bool p1 = RefPlanesAabbTest(planes, v, extents, mask1);
+		Check("PlanesAabbTest", p0 == p1 && mask0 == mask1, i);
+
+		p0 = SimdPlanesSphereTest(planes, v, fabs(b[11]), mask1);
+		p1 = RefPlanesSphereTest(planes, v, fabs(b[11]), mask1);
+		Check("PlanesSphereTest", p0 == p1, i);
+	}
+
+	// benchmark.
+	const size_t calls = size_t(Count) * Repeat;
+	double t0, t1;
+
+	t0 = Measure(calls, [&]
+	{
+		for (int r = 0; r < Repeat; ++r)
+			for (size_t i = 0; i < Count; ++i)
+				SimdMatrix4Multiply(&matA[i * 16], &matB[i * 16], &out0[i * 16]);
+	});
+	t1 = Measure(calls, [&]
+	{
+		for (int r = 0; r < Repeat; ++r)
+			for (size_t i = 0; i < Count; ++i)
+				RefMatrix4Multiply(&matA[i * 16], &matB[i * 16], &out1[i * 16]);
+	});
+	sink = out0[Count] + out1[Count];
+	printf("Matrix4Multiply:  %6.2f ns (scalar: %6.2f ns)\n", t0, t1);
+
+	t0 = Measure(calls, [&]
+	{
+		for (int r = 0; r < Repeat; ++r)
+			for (size_t i = 0; i < Count; ++i)
+				SimdVector4Transform(&vec[i * 4], &matA[(i & 63) * 16], &out0[i * 4]);
+	});
+	t1 = Measure(calls, [&]
+	{
+		for (int r = 0; r < Repeat; ++r)
+			for (size_t i = 0; i < Count; ++i)
+				RefVector4Transform(&vec[i * 4], &matA[(i & 63) * 16], &out1[i * 4]);
+	});
+	sink = out0[Count] + out1[Count];
+	printf("Vector4Transform: %6.2f ns (scalar: %6.2f ns)\n", t0, t1);
+
+	t0 = Measure(calls, [&]
+	{
+		for (int r = 0; r < Repeat; ++r)
+			for (size_t i = 0; i < Count; ++i)
+				SimdVector3Transform(&vec[i * 4], &matA[(i & 63) * 16], &out0[i * 4]);
+	});
+	t1 = Measure(calls, [&]
+	{
+		for (int r = 0; r < Repeat; ++r)
+			for (size_t i = 0; i < Count; ++i)
+				RefVector3Transform(&vec[i * 4], &matA[(i & 63) * 16], &out1[i * 4]);
+	});
+	sink = out0[Count] + out1[Count];
+	printf("Vector3Transform: %6.2f ns (scalar: %6.2f ns)\n", t0, t1);
+
+	t0 = Measure(calls, [&]
+	{
+		for (int r = 0; r < Repeat; ++r)
+			for (size_t i = 0; i + 1 < Count; ++i)
+				SimdAabbTransform(&vec[i * 4], &vec[i * 4 + 4], &matA[(i & 63) * 16], &out0[i * 4], &out0[Count * 8 + i * 4]);
+	});
+	t1 = Measure(calls, [&]
+	{
+		for (int r = 0; r < Repeat; ++r)
+			for (size_t i = 0; i + 1 < Count; ++i)
+				RefAabbTransform(&vec[i * 4], &vec[i * 4 + 4], &matA[(i & 63) * 16], &out1[i * 4], &out1[Count * 8 + i * 4]);
+	});
+	sink = out0[Count] + out1[Count];
+	printf("AabbTransform:    %6.2f ns (scalar: %6.2f ns)\n", t0, t1);
+
+	delete[] matA;
+	delete[] matB;
+	delete[] vec;
+	delete[] out0;
+	delete[] out1;
+
+	printf("%s (%d mismatches)\n", failures == 0 ? "passed" : "FAILED", failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -10,6 +10,8 @@
 #include "BulletPhysics/src/BulletCollision/CollisionShapes/btConvexPolyhedron.h"
 
 #include "BulletPhysics/src/BulletCollision/CollisionDispatch/btGhostObject.h"
+#include "BulletPhysics/src/BulletCollision/CollisionDispatch/btConvexConvexAlgorithm.h"
+#include "BulletPhysics/src/BulletCollision/CollisionDispatch/btSimulationIslandManager.h"
 
 #include "BulletPhysics/src/BulletCollision/NarrowPhaseCollision/btGjkPairDetector.h"
 #include "BulletPhysics/src/BulletCollision/NarrowPhaseCollision/btPointCollector.h"
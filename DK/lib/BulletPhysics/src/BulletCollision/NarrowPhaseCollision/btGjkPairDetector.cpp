@@ -17,6 +17,7 @@ subject to the following restrictions:
 #include "BulletCollision/CollisionShapes/btConvexShape.h"
 #include "BulletCollision/NarrowPhaseCollision/btSimplexSolverInterface.h"
 #include "BulletCollision/NarrowPhaseCollision/btConvexPenetrationDepthSolver.h"
+#include "LinearMath/btQuickprof.h"
 
 
 
@@ -34,7 +35,7 @@ subject to the following restrictions:
 #define REL_ERROR2 btScalar(1.0e-6)
 
 //temp globals, to improve GJK/EPA/penetration calculations
-int gNumDeepPenetrationChecks = 0;
+int gNumDeepPenetrationChecks = 0;	// DKGL: counted only if profiling enabled, narrow-phase can run on multiple threads.
 int gNumGjkChecks = 0;
 
 
@@ -100,7 +101,9 @@ void btGjkPairDetector::getClosestPointsNonVirtual(const ClosestPointInput& inpu
 	btScalar marginA = m_marginA;
 	btScalar marginB = m_marginB;
 
+#ifndef BT_NO_PROFILE
 	gNumGjkChecks++;
+#endif
 
 #ifdef DEBUG_SPU_COLLISION_DETECTION
 	spu_printf("inside gjk\n");
@@ -347,7 +350,9 @@ void btGjkPairDetector::getClosestPointsNonVirtual(const ClosestPointInput& inpu
 				// Penetration depth case.
 				btVector3 tmpPointOnA,tmpPointOnB;
 				
+#ifndef BT_NO_PROFILE
 				gNumDeepPenetrationChecks++;
+#endif
 				m_cachedSeparatingAxis.setZero();
 
 				bool isValid2 = m_penetrationDepthSolver->calcPenDepth( 
@@ -16,7 +16,9 @@
 #define BT_QUICK_PROF_H
 
 //To disable built-in profiling, please comment out next line
-//#define BT_NO_PROFILE 1
+// DKGL: profiling is disabled, CProfileManager is not thread-safe and
+// DKDynamicsScene solves islands on multiple threads.
+#define BT_NO_PROFILE 1
 #ifndef BT_NO_PROFILE
 #include <stdio.h>//@todo remove this, backwards compatibility
 #include "btScalar.h"